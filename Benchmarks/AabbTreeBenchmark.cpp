@@ -0,0 +1,82 @@
+#include "pch.h"
+
+#include <random>
+
+#include "Benchmark.h"
+#include "DynamicAabbTree.h"
+
+using namespace DirectX;
+
+namespace
+{
+// Entities are scattered with the same density for every count, about one per 8 cubic units.
+void RunAabbTree(UINT count)
+{
+    std::mt19937 rng(count);
+    const float halfSize = std::cbrt(static_cast<float>(count));
+    std::uniform_real_distribution<float> position(-halfSize, halfSize);
+    std::uniform_real_distribution<float> extent(0.1f, 0.5f);
+    std::uniform_real_distribution<float> jitter(-0.02f, 0.02f);
+
+    std::vector<BoundingBox> boxes(count);
+    for (auto& box : boxes)
+        box = BoundingBox(XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(extent(rng), extent(rng), extent(rng)));
+
+    DynamicAabbTree tree;
+    std::vector<UINT> proxies(count);
+
+    Stopwatch stopwatch;
+    for (UINT i = 0; i < count; ++i)
+        proxies[i] = tree.CreateProxy(boxes[i], EntityHandle{i, 0});
+    PrintResult("insert", count, stopwatch.GetElapsedSeconds());
+
+    // Most entities move a little and stay in their fat AABBs. Every 16th one teleports and is reinserted.
+    for (UINT i = 0; i < count; ++i)
+    {
+        auto& center = boxes[i].Center;
+        if (i % 16 == 0)
+            center = XMFLOAT3(position(rng), position(rng), position(rng));
+        else
+            center = XMFLOAT3(center.x + jitter(rng), center.y + jitter(rng), center.z + jitter(rng));
+    }
+
+    UINT movedOut = 0;
+    stopwatch.Restart();
+    for (UINT i = 0; i < count; ++i)
+    {
+        if (tree.MoveProxy(proxies[i], boxes[i]))
+            ++movedOut;
+    }
+    PrintResult("update", count, stopwatch.GetElapsedSeconds());
+
+    // Query volumes cover a few entities each.
+    constexpr UINT QueryCount = 10000;
+    std::vector<BoundingBox> queries(QueryCount);
+    for (auto& query : queries)
+        query = BoundingBox(XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(2.0f, 2.0f, 2.0f));
+
+    std::vector<EntityHandle> results;
+    std::size_t hitCount = 0;
+    stopwatch.Restart();
+    for (const auto& query : queries)
+    {
+        results.clear();
+        tree.QueryAabb(query, results);
+        hitCount += results.size();
+    }
+    PrintResult("query aabb", QueryCount, stopwatch.GetElapsedSeconds());
+    DoNotOptimize(hitCount);
+
+    std::printf("  height %u, area ratio %.1f, moved out of fat AABB %u, hits per query %.1f\n",
+        tree.GetHeight(), tree.GetAreaRatio(), movedOut, static_cast<double>(hitCount) / QueryCount);
+}
+}
+
+void RunAabbTreeBenchmark()
+{
+    for (UINT count : {10000u, 100000u, 1000000u})
+    {
+        std::printf(" %u entities\n", count);
+        RunAabbTree(count);
+    }
+}
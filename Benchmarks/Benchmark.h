@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Wall clock timer for benchmarks.
+class Stopwatch
+{
+public:
+    Stopwatch()
+        : m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    void Restart()
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double GetElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// One line per measurement : label, operation count, total time and time per operation.
+inline void PrintResult(const char* label, std::size_t count, double seconds)
+{
+    std::printf("  %-24s %10zu ops %10.2f ms %10.1f ns/op\n", label, count, seconds * 1e3, seconds * 1e9 / static_cast<double>(count));
+}
+
+// Keep a result observable, so the measured loop is not optimized away.
+template <typename T>
+void DoNotOptimize(const T& value)
+{
+    static volatile T sink;
+    sink = value;
+}
+
+// Each benchmark prints its own results.
+void RunAabbTreeBenchmark();
+void RunCommandRecordingBenchmark();
+void RunComponentPoolBenchmark();
+void RunDescriptorAllocatorBenchmark();
+void RunDescriptorPageBenchmark();
+void RunDrawListBenchmark();
+void RunFrustumCullerBenchmark();
+void RunJobSystemBenchmark();
+void RunSubresourceMergeBenchmark();
@@ -0,0 +1,40 @@
+#include "pch.h"
+
+#include "BenchmarkDevice.h"
+
+#include <cstdio>
+
+#include "D3DHelper.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace D3DHelper;
+
+extern "C"
+{
+    __declspec(dllexport) extern const UINT D3D12SDKVersion = 717;
+}
+extern "C"
+{
+    __declspec(dllexport) extern const char* D3D12SDKPath = u8".\\D3D12\\";
+}
+
+ComPtr<ID3D12Device> CreateBenchmarkDevice()
+{
+    ComPtr<IDXGIFactory4> factory;
+    ThrowIfFailed(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory)));
+
+    ComPtr<IDXGIAdapter1> hardwareAdapter;
+    GetHardwareAdapter(factory.Get(), hardwareAdapter.GetAddressOf());
+
+    ComPtr<IDXGIAdapter> adapter = hardwareAdapter;
+    if (!adapter)
+        ThrowIfFailed(factory->EnumWarpAdapter(IID_PPV_ARGS(&adapter)));
+
+    DXGI_ADAPTER_DESC desc;
+    ThrowIfFailed(adapter->GetDesc(&desc));
+    std::printf(" %ls\n", desc.Description);
+
+    ComPtr<ID3D12Device> device;
+    ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device)));
+    return device;
+}
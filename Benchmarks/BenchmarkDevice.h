@@ -0,0 +1,7 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+// No window and no swap chain. Hardware adapter if there is one, WARP otherwise.
+Microsoft::WRL::ComPtr<ID3D12Device> CreateBenchmarkDevice();
@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "BenchmarkDevice.h"
+#include "CommandQueue.h"
+#include "D3DHelper.h"
+#include "JobSystem.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace D3DHelper;
+
+namespace
+{
+// Split as in Renderer::PrepareRenderGraph
+constexpr UINT DRAWS_PER_RECORD_TASK = 256;
+constexpr UINT SHADOW_VIEWS_PER_RECORD_TASK = 2;
+
+constexpr UINT DrawCount = 16384;
+constexpr UINT ShadowViewCount = 8;
+constexpr UINT ShadowDrawCount = 4096;
+constexpr UINT FrameCount = 50;
+
+constexpr UINT RootConstantCount = 20; // World matrix and per draw indices
+
+struct RecordTask
+{
+    bool isShadow;
+    UINT first;
+    UINT last;
+    ID3D12CommandAllocator* pCommandAllocator;
+    ID3D12GraphicsCommandList7* pCommandList;
+};
+
+ComPtr<ID3D12RootSignature> CreateRootSignature(ID3D12Device* pDevice)
+{
+    D3D12_ROOT_PARAMETER parameter = {};
+    parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameter.Constants.Num32BitValues = RootConstantCount;
+    parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+    D3D12_ROOT_SIGNATURE_DESC desc = {};
+    desc.NumParameters = 1;
+    desc.pParameters = &parameter;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    ThrowIfFailed(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ThrowIfFailed(pDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
+    return rootSignature;
+}
+
+void AddRecordTasks(std::vector<RecordTask>& tasks, bool isShadow, UINT count, UINT grainSize)
+{
+    for (UINT first = 0; first < count; first += grainSize)
+        tasks.push_back({isShadow, first, (std::min)(first + grainSize, count), nullptr, nullptr});
+}
+
+// State setting only. There is no pipeline state, so nothing is drawn and the GPU side stays trivial.
+void RecordDraws(ID3D12GraphicsCommandList7* pCommandList, UINT first, UINT last)
+{
+    UINT constants[RootConstantCount] = {};
+    for (UINT i = first; i < last; ++i)
+    {
+        constants[0] = i;
+        pCommandList->SetGraphicsRoot32BitConstants(0, RootConstantCount, constants, 0);
+        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+}
+
+void RecordTaskList(CommandQueue& commandQueue, ID3D12RootSignature* pRootSignature, RecordTask& task)
+{
+    std::tie(task.pCommandAllocator, task.pCommandList) = commandQueue.GetAvailableCommandList(JobSystem::GetCurrentThreadIndex());
+    task.pCommandList->SetGraphicsRootSignature(pRootSignature);
+
+    if (task.isShadow)
+    {
+        for (UINT view = task.first; view < task.last; ++view)
+            RecordDraws(task.pCommandList, 0, ShadowDrawCount);
+    }
+    else
+    {
+        RecordDraws(task.pCommandList, task.first, task.last);
+    }
+}
+
+struct FrameTimes
+{
+    double record;
+    double frame;
+};
+
+FrameTimes RunFrames(JobSystem& jobSystem, CommandQueue& commandQueue, ID3D12RootSignature* pRootSignature, std::vector<RecordTask>& tasks)
+{
+    std::vector<std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*>> commandLists;
+    commandLists.reserve(tasks.size());
+
+    FrameTimes times = {};
+    Stopwatch frameStopwatch;
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        Stopwatch recordStopwatch;
+        jobSystem.ParallelFor(
+            0,
+            static_cast<UINT>(tasks.size()),
+            1,
+            [&](UINT i)
+            {
+                RecordTaskList(commandQueue, pRootSignature, tasks[i]);
+            });
+        times.record += recordStopwatch.GetElapsedSeconds();
+
+        commandLists.clear();
+        for (const auto& task : tasks)
+            commandLists.emplace_back(task.pCommandAllocator, task.pCommandList);
+        commandQueue.ExecuteCommandLists(commandLists);
+        commandQueue.Flush();
+    }
+    times.frame = frameStopwatch.GetElapsedSeconds();
+    return times;
+}
+}
+
+// Frame of command lists recorded with 1 to N threads, each taking lists from its own pool of the queue.
+// Measures CPU recording and pool overhead. No draws are issued, so GPU time and driver draw validation are not included.
+void RunCommandRecordingBenchmark()
+{
+    JobSystem jobSystem;
+
+    ComPtr<ID3D12Device> device = CreateBenchmarkDevice();
+    ComPtr<ID3D12RootSignature> rootSignature = CreateRootSignature(device.Get());
+
+    CommandQueue commandQueue;
+    commandQueue.Init(device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+    commandQueue.SetThreadPoolCount(jobSystem.GetWorkerCount() + 1);
+
+    std::vector<RecordTask> tasks;
+    AddRecordTasks(tasks, true, ShadowViewCount, SHADOW_VIEWS_PER_RECORD_TASK);
+    AddRecordTasks(tasks, false, DrawCount, DRAWS_PER_RECORD_TASK);
+
+    const UINT commandsPerFrame = (ShadowViewCount * ShadowDrawCount + DrawCount) * 2;
+
+    std::vector<UINT> workerCounts;
+    for (UINT count = 0; count < jobSystem.GetWorkerCount(); count = (std::max)(count * 2, 1u))
+        workerCounts.push_back(count);
+    workerCounts.push_back(jobSystem.GetWorkerCount());
+
+    // Warm up, so every pool holds enough allocators and lists before measuring.
+    for (UINT workerCount : workerCounts)
+    {
+        jobSystem.SetActiveWorkerCount(workerCount);
+        RunFrames(jobSystem, commandQueue, rootSignature.Get(), tasks);
+    }
+
+    double recordBase = 0.0;
+
+    std::printf(" %u workers available, %zu command lists per frame\n", jobSystem.GetWorkerCount(), tasks.size());
+    for (UINT workerCount : workerCounts)
+    {
+        jobSystem.SetActiveWorkerCount(workerCount);
+
+        FrameTimes times = RunFrames(jobSystem, commandQueue, rootSignature.Get(), tasks);
+
+        if (workerCount == 0)
+            recordBase = times.record;
+
+        std::printf(" %u threads\n", workerCount + 1);
+        PrintResult("record", commandsPerFrame * FrameCount, times.record);
+        PrintResult("record, submit, flush", commandsPerFrame * FrameCount, times.frame);
+        std::printf("  speedup %.2fx\n", recordBase / times.record);
+    }
+}
@@ -0,0 +1,152 @@
+#include "pch.h"
+
+#include <optional>
+#include <random>
+#include <string>
+
+#include "Benchmark.h"
+#include "ComponentPool.h"
+#include "SceneHandles.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+namespace
+{
+struct MeshRenderer
+{
+    MeshHandle mesh;
+    MaterialHandle material;
+    UINT instanceSlot = 0;
+};
+
+// Entity layout before the split. Every system walked this array and skipped absent components.
+struct LegacyEntity
+{
+    std::string name;
+
+    EntityHandle selfHandle;
+    EntityHandle parent;
+    std::vector<EntityHandle> children;
+
+    std::optional<Transform> transform;
+    std::optional<MeshRenderer> meshRenderer;
+    std::optional<UINT> light;
+};
+
+struct Renderable
+{
+    MeshHandle mesh;
+    XMFLOAT4X4 world;
+};
+
+constexpr UINT FrameCount = 100;
+
+// Every entity has a transform. 3 of 4 have a mesh renderer, and 1 of 16 is a light.
+void RunComponents(UINT count)
+{
+    std::mt19937 rng(count);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+    std::vector<LegacyEntity> entities(count);
+    ComponentPool<std::string> names;
+    ComponentPool<Transform> transforms;
+    ComponentPool<MeshRenderer> meshRenderers;
+    ComponentPool<UINT> lights;
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        EntityHandle handle{i, 0};
+        Transform transform(XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(position(rng), position(rng), position(rng)));
+        std::string name = "Entity with a name longer than small string buffer " + std::to_string(i);
+
+        auto& entity = entities[i];
+        entity.name = name;
+        entity.selfHandle = handle;
+        entity.transform = transform;
+
+        names.Add(handle, std::move(name));
+        transforms.Add(handle, std::move(transform));
+
+        if (i % 4 != 0)
+        {
+            entity.meshRenderer = MeshRenderer{{i % 64, 0}, {i % 16, 0}, i};
+            meshRenderers.Add(handle, MeshRenderer{{i % 64, 0}, {i % 16, 0}, i});
+        }
+        if (i % 16 == 0)
+        {
+            entity.light = i;
+            lights.Add(handle, UINT(i));
+        }
+    }
+
+    std::vector<Renderable> renderables;
+    renderables.reserve(count);
+
+    // Snapshot of transforms, as in FixedUpdate
+    Stopwatch stopwatch;
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        for (auto& entity : entities)
+        {
+            if (!entity.transform.has_value())
+                continue;
+            entity.transform->SnapshotState();
+        }
+    }
+    PrintResult("snapshot, entities", count * FrameCount, stopwatch.GetElapsedSeconds());
+
+    stopwatch.Restart();
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        for (auto& transform : transforms.GetDense())
+            transform.SnapshotState();
+    }
+    PrintResult("snapshot, pool", count * FrameCount, stopwatch.GetElapsedSeconds());
+
+    // Gathering mesh and world matrix of renderables, as in world bounds update
+    stopwatch.Restart();
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        renderables.clear();
+        for (const auto& entity : entities)
+        {
+            if (!entity.transform.has_value() || !entity.meshRenderer.has_value())
+                continue;
+            renderables.push_back({entity.meshRenderer->mesh, entity.transform->GetWorldRenderTransform()});
+        }
+    }
+    PrintResult("gather, entities", count * FrameCount, stopwatch.GetElapsedSeconds());
+    DoNotOptimize(renderables.size());
+
+    stopwatch.Restart();
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        renderables.clear();
+        const auto& dense = meshRenderers.GetDense();
+        const auto& owners = meshRenderers.GetOwners();
+        for (UINT i = 0; i < meshRenderers.GetCount(); ++i)
+        {
+            const auto* pTransform = transforms.Get(owners[i]);
+            if (!pTransform)
+                continue;
+            renderables.push_back({dense[i].mesh, pTransform->GetWorldRenderTransform()});
+        }
+    }
+    PrintResult("gather, pool", count * FrameCount, stopwatch.GetElapsedSeconds());
+    DoNotOptimize(renderables.size());
+
+    std::printf("  entity %zu bytes, transform %zu bytes, mesh renderer %zu bytes\n", sizeof(LegacyEntity), sizeof(Transform), sizeof(MeshRenderer));
+}
+}
+
+// Per-frame iteration over entities holding every component inline, against sparse-set component pools.
+// Times are per entity and frame.
+void RunComponentPoolBenchmark()
+{
+    for (UINT count : {10000u, 100000u})
+    {
+        std::printf(" %u entities\n", count);
+        RunComponents(count);
+    }
+}
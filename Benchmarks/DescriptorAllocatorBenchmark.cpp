@@ -0,0 +1,93 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "BenchmarkDevice.h"
+#include "CommandQueue.h"
+#include "DescriptorAllocation.h"
+#include "DescriptorAllocator.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+constexpr UINT32 OperationsPerThread = 400000;
+constexpr std::size_t MaxLiveAllocations = 64;
+
+// Loader thread. Mostly single descriptors, with a table of 3 now and then, which goes through the shared pool.
+void RunLoader(DescriptorAllocator& allocator, UINT32 seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<DescriptorAllocation> live;
+    live.reserve(MaxLiveAllocations);
+
+    for (UINT32 i = 0; i < OperationsPerThread; ++i)
+    {
+        if (live.size() < MaxLiveAllocations && (live.empty() || rng() % 2))
+        {
+            live.push_back(allocator.Allocate(rng() % 8 == 0 ? 3 : 1));
+        }
+        else
+        {
+            live[rng() % live.size()] = std::move(live.back());
+            live.pop_back();
+        }
+    }
+}
+}
+
+// Allocate and free from 1 to 16 threads at once, while a frame thread signals the queue and flushes thread caches.
+// Throughput only scales with cores the machine has. Thread counts above that measure contention under oversubscription.
+void RunDescriptorAllocatorBenchmark()
+{
+    ComPtr<ID3D12Device> device = CreateBenchmarkDevice();
+
+    CommandQueue commandQueue;
+    commandQueue.Init(device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    std::printf(" %u hardware threads\n", std::thread::hardware_concurrency());
+
+    double base = 0.0;
+    for (UINT32 threadCount : {1u, 2u, 4u, 8u, 16u})
+    {
+        DescriptorAllocator allocator;
+        allocator.Init(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        allocator.SetCommandQueue(&commandQueue);
+
+        std::atomic<bool> isDone{false};
+        std::thread frameThread(
+            [&]()
+            {
+                while (!isDone.load())
+                {
+                    commandQueue.Signal();
+                    allocator.FlushThreadCaches();
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                }
+            });
+
+        Stopwatch stopwatch;
+        std::vector<std::thread> loaders;
+        for (UINT32 t = 0; t < threadCount; ++t)
+            loaders.emplace_back(RunLoader, std::ref(allocator), t);
+        for (auto& loader : loaders)
+            loader.join();
+        double seconds = stopwatch.GetElapsedSeconds();
+
+        isDone = true;
+        frameThread.join();
+        commandQueue.Flush();
+
+        // Per operation time of the whole run, so it drops as threads are added when they do not contend.
+        if (threadCount == 1)
+            base = seconds;
+
+        char label[32];
+        std::snprintf(label, sizeof(label), "%u threads", threadCount);
+        PrintResult(label, static_cast<std::size_t>(OperationsPerThread) * threadCount, seconds);
+        std::printf("  %u pages, scaling %.2fx\n", allocator.GetNumPages(), base * threadCount / seconds);
+    }
+}
@@ -0,0 +1,215 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "BenchmarkDevice.h"
+#include "DescriptorAllocatorPage.h"
+
+#include <map>
+#include <queue>
+#include <random>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+constexpr UINT32 OperationCount = 5000000;
+
+// Free list of DescriptorAllocatorPage before TLSF, kept as the baseline. Free blocks are indexed by offset and by size,
+// so allocation and coalescing are O(log n) and every block insertion allocates map nodes. No descriptor heap.
+class MapFreeList
+{
+public:
+    explicit MapFreeList(UINT32 numDescriptors)
+        : m_numFreeHandles(numDescriptors)
+    {
+        AddNewBlock(0, numDescriptors);
+    }
+
+    bool AllocateBlock(UINT32 numDescriptors, UINT32& offset)
+    {
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        if (numDescriptors > m_numFreeHandles)
+            return false;
+
+        auto smallestBlockIt = m_freeListBySize.lower_bound(numDescriptors);
+        if (smallestBlockIt == m_freeListBySize.end())
+            return false;
+
+        auto [blockSize, offsetIt] = *smallestBlockIt;
+        offset = offsetIt->first;
+
+        m_freeListBySize.erase(smallestBlockIt);
+        m_freeListByOffset.erase(offsetIt);
+
+        if (blockSize > numDescriptors)
+            AddNewBlock(offset + numDescriptors, blockSize - numDescriptors);
+
+        m_numFreeHandles -= numDescriptors;
+        return true;
+    }
+
+    void QueueStaleDescriptor(const DescriptorAllocatorPage::StaleDescriptorInfo& info)
+    {
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        m_staleDescriptors.push(info);
+    }
+
+    void ReleaseStaleDescriptors(UINT64 completedFenceValue)
+    {
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        while (!m_staleDescriptors.empty() && m_staleDescriptors.front().fenceValue <= completedFenceValue)
+        {
+            FreeBlock(m_staleDescriptors.front().offset, m_staleDescriptors.front().size);
+            m_staleDescriptors.pop();
+        }
+    }
+
+private:
+    struct FreeBlockInfo;
+    using FreeListByOffset = std::map<UINT32, FreeBlockInfo>;
+    using FreeListBySize = std::multimap<UINT32, FreeListByOffset::iterator>;
+
+    struct FreeBlockInfo
+    {
+        FreeBlockInfo(UINT32 size)
+            : size(size)
+        {
+        }
+
+        UINT32 size;
+        FreeListBySize::iterator freeListBySizeIt;
+    };
+
+    void AddNewBlock(UINT32 offset, UINT32 numDescriptors)
+    {
+        auto offsetIt = m_freeListByOffset.insert({offset, numDescriptors});
+        auto sizeIt = m_freeListBySize.insert({numDescriptors, offsetIt.first});
+        offsetIt.first->second.freeListBySizeIt = sizeIt;
+    }
+
+    void FreeBlock(UINT32 offset, UINT32 numDescriptors)
+    {
+        auto nextBlockIt = m_freeListByOffset.upper_bound(offset);
+
+        auto prevBlockIt = nextBlockIt;
+        if (prevBlockIt != m_freeListByOffset.begin())
+            --prevBlockIt;
+        else
+            prevBlockIt = m_freeListByOffset.end();
+
+        m_numFreeHandles += numDescriptors;
+
+        if (prevBlockIt != m_freeListByOffset.end() && offset == prevBlockIt->first + prevBlockIt->second.size)
+        {
+            offset = prevBlockIt->first;
+            numDescriptors += prevBlockIt->second.size;
+
+            m_freeListBySize.erase(prevBlockIt->second.freeListBySizeIt);
+            m_freeListByOffset.erase(prevBlockIt);
+        }
+
+        if (nextBlockIt != m_freeListByOffset.end() && offset + numDescriptors == nextBlockIt->first)
+        {
+            numDescriptors += nextBlockIt->second.size;
+
+            m_freeListBySize.erase(nextBlockIt->second.freeListBySizeIt);
+            m_freeListByOffset.erase(nextBlockIt);
+        }
+
+        AddNewBlock(offset, numDescriptors);
+    }
+
+    FreeListByOffset m_freeListByOffset;
+    FreeListBySize m_freeListBySize;
+    std::queue<DescriptorAllocatorPage::StaleDescriptorInfo> m_staleDescriptors;
+    UINT32 m_numFreeHandles;
+
+    std::mutex m_allocationMutex;
+};
+
+// Half allocations of 1 to 4 descriptors, half frees of a random live block, released right away.
+// Same seed for both free lists, so they see the same sequence of decisions.
+template <typename FreeList>
+double RunTrace(FreeList& freeList, UINT32 numDescriptors)
+{
+    std::mt19937 rng(7);
+    std::vector<DescriptorAllocatorPage::StaleDescriptorInfo> live;
+    live.reserve(numDescriptors);
+
+    Stopwatch stopwatch;
+    for (UINT32 i = 0; i < OperationCount; ++i)
+    {
+        if (live.empty() || rng() % 2)
+        {
+            UINT32 size = 1 + rng() % 4;
+            UINT32 offset;
+            if (freeList.AllocateBlock(size, offset))
+                live.emplace_back(offset, size, 0);
+        }
+        else
+        {
+            std::size_t k = rng() % live.size();
+            auto info = live[k];
+            live[k] = live.back();
+            live.pop_back();
+
+            freeList.QueueStaleDescriptor(info);
+            freeList.ReleaseStaleDescriptors(0);
+        }
+    }
+    DoNotOptimize(live.size());
+    return stopwatch.GetElapsedSeconds();
+}
+
+// Adapts the page to the interface of the trace. Stale descriptors are queued one at a time, as the baseline does.
+class TlsfFreeList
+{
+public:
+    TlsfFreeList(ID3D12Device* pDevice, UINT32 numDescriptors)
+        : m_page(pDevice, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, numDescriptors, nullptr)
+    {
+    }
+
+    bool AllocateBlock(UINT32 numDescriptors, UINT32& offset)
+    {
+        return m_page.AllocateBlock(numDescriptors, offset);
+    }
+
+    void QueueStaleDescriptor(const DescriptorAllocatorPage::StaleDescriptorInfo& info)
+    {
+        m_page.QueueStaleDescriptors(&info, 1);
+    }
+
+    void ReleaseStaleDescriptors(UINT64 completedFenceValue)
+    {
+        m_page.ReleaseStaleDescriptors(completedFenceValue);
+    }
+
+private:
+    DescriptorAllocatorPage m_page;
+};
+}
+
+// Mixed allocate and free trace on a single page, TLSF against the map and multimap free list it replaced.
+// Pages of DescriptorAllocator are 256 descriptors. Larger pages show how each one scales with the number of free blocks.
+void RunDescriptorPageBenchmark()
+{
+    ComPtr<ID3D12Device> device = CreateBenchmarkDevice();
+
+    for (UINT32 numDescriptors : {256u, 4096u, 65536u})
+    {
+        MapFreeList mapFreeList(numDescriptors);
+        TlsfFreeList tlsfFreeList(device.Get(), numDescriptors);
+
+        double map = RunTrace(mapFreeList, numDescriptors);
+        double tlsf = RunTrace(tlsfFreeList, numDescriptors);
+
+        std::printf(" %u descriptors\n", numDescriptors);
+        PrintResult("map, multimap", OperationCount, map);
+        PrintResult("tlsf", OperationCount, tlsf);
+        std::printf("  speedup %.2fx\n", map / tlsf);
+    }
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+
+#include <random>
+
+#include "Benchmark.h"
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+namespace
+{
+constexpr UINT SphereCount = 100000;
+constexpr UINT FrameCount = 100;
+
+void RunCull(const char* label, const FrustumCuller& culler, const std::vector<XMFLOAT4>& spheres)
+{
+    std::vector<UINT> visible;
+    visible.reserve(SphereCount);
+
+    UINT visibleCount = 0;
+    Stopwatch stopwatch;
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        visible.clear();
+        visibleCount = culler.Cull(spheres.data(), SphereCount, visible);
+    }
+    PrintResult(label, SphereCount * FrameCount, stopwatch.GetElapsedSeconds());
+    std::printf("  %u of %u visible\n", visibleCount, SphereCount);
+    DoNotOptimize(visibleCount);
+}
+}
+
+// Culls 100k synthetic spheres through the 4-wide path, with one sphere at a time through BoundingFrustum for reference.
+// Spheres are scattered around the camera, so under a tenth of them are in the frustum.
+void RunFrustumCullerBenchmark()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> radius(0.5f, 5.0f);
+
+    std::vector<XMFLOAT4> spheres(SphereCount);
+    for (auto& sphere : spheres)
+        sphere = XMFLOAT4(position(rng), position(rng), position(rng), radius(rng));
+
+    // Same camera setup as the renderer, reverse-z
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1000.0f, 0.1f);
+    BoundingFrustum frustum = FrustumCuller::CreateWorldFrustum(view, projection);
+
+    FrustumCuller culler;
+    culler.SetFrustum(frustum);
+    RunCull("4-wide, frustum", culler, spheres);
+
+    // Shadow views cull with planes extracted from the view projection.
+    culler.SetViewProjection(view * projection);
+    RunCull("4-wide, view projection", culler, spheres);
+
+    std::vector<UINT> visible;
+    visible.reserve(SphereCount);
+
+    Stopwatch stopwatch;
+    for (UINT frame = 0; frame < FrameCount; ++frame)
+    {
+        visible.clear();
+        for (UINT i = 0; i < SphereCount; ++i)
+        {
+            const auto& sphere = spheres[i];
+            if (frustum.Intersects(BoundingSphere(XMFLOAT3(sphere.x, sphere.y, sphere.z), sphere.w)))
+                visible.push_back(i);
+        }
+    }
+    PrintResult("BoundingFrustum", SphereCount * FrameCount, stopwatch.GetElapsedSeconds());
+    std::printf("  %zu of %u visible\n", visible.size(), SphereCount);
+    DoNotOptimize(visible.size());
+}
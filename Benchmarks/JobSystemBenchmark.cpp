@@ -0,0 +1,90 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+namespace
+{
+constexpr UINT MatrixCount = 1 << 20;
+constexpr UINT SmallJobCount = 100000;
+constexpr UINT RepeatCount = 10;
+
+// World matrix composition as in the transform update. Compute bound, so it shows scaling of ParallelFor.
+double RunParallelFor(JobSystem& jobSystem, const std::vector<XMFLOAT4X4>& locals, std::vector<XMFLOAT4X4>& worlds)
+{
+    const XMMATRIX parent = XMMatrixRotationRollPitchYaw(0.1f, 0.2f, 0.3f);
+
+    Stopwatch stopwatch;
+    for (UINT repeat = 0; repeat < RepeatCount; ++repeat)
+    {
+        jobSystem.ParallelFor(
+            0,
+            MatrixCount,
+            256,
+            [&](UINT i)
+            {
+                XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4(&locals[i]), parent);
+                XMStoreFloat4x4(&worlds[i], XMMatrixMultiply(world, parent));
+            });
+    }
+    return stopwatch.GetElapsedSeconds();
+}
+
+// Empty jobs. Measures queue, steal and wake overhead.
+double RunSmallJobs(JobSystem& jobSystem)
+{
+    std::atomic<UINT> sum{0};
+
+    Stopwatch stopwatch;
+    for (UINT repeat = 0; repeat < RepeatCount; ++repeat)
+    {
+        JobCounter counter;
+        for (UINT i = 0; i < SmallJobCount; ++i)
+            jobSystem.Run([&sum]() { sum.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        jobSystem.Wait(counter);
+    }
+    DoNotOptimize(sum.load());
+    return stopwatch.GetElapsedSeconds();
+}
+}
+
+// Same work with 1 to N threads. Main thread also runs jobs while waiting, so thread count is active workers + 1.
+void RunJobSystemBenchmark()
+{
+    JobSystem jobSystem;
+
+    std::vector<XMFLOAT4X4> locals(MatrixCount);
+    std::vector<XMFLOAT4X4> worlds(MatrixCount);
+    for (UINT i = 0; i < MatrixCount; ++i)
+        XMStoreFloat4x4(&locals[i], XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f));
+
+    std::vector<UINT> workerCounts;
+    for (UINT count = 0; count < jobSystem.GetWorkerCount(); count = (std::max)(count * 2, 1u))
+        workerCounts.push_back(count);
+    workerCounts.push_back(jobSystem.GetWorkerCount());
+
+    double parallelForBase = 0.0;
+    double smallJobsBase = 0.0;
+
+    std::printf(" %u workers available\n", jobSystem.GetWorkerCount());
+    for (UINT workerCount : workerCounts)
+    {
+        jobSystem.SetActiveWorkerCount(workerCount);
+
+        double parallelFor = RunParallelFor(jobSystem, locals, worlds);
+        double smallJobs = RunSmallJobs(jobSystem);
+
+        if (workerCount == 0)
+        {
+            parallelForBase = parallelFor;
+            smallJobsBase = smallJobs;
+        }
+
+        std::printf(" %u threads\n", workerCount + 1);
+        PrintResult("parallel for", MatrixCount * RepeatCount, parallelFor);
+        PrintResult("small jobs", SmallJobCount * RepeatCount, smallJobs);
+        std::printf("  speedup %.2fx, %.2fx\n", parallelForBase / parallelFor, smallJobsBase / smallJobs);
+    }
+}
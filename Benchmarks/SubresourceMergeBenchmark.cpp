@@ -0,0 +1,75 @@
+#include "pch.h"
+
+#include "Benchmark.h"
+#include "RenderGraph.h"
+#include "SharedConfig.h"
+
+namespace
+{
+constexpr UINT MergeCount = 1000000;
+
+struct MergeCase
+{
+    const char* label;
+    D3D12_BARRIER_SUBRESOURCE_RANGE range;
+};
+
+// Barriers per subresource before merging, against merged ranges, and the time to merge one mask.
+void RunCases(const char* label, const TextureDimension& dimension, std::initializer_list<MergeCase> cases)
+{
+    std::printf(" %s, %u mips x %u slices\n", label, dimension.mipLevels, dimension.arraySize);
+
+    for (const auto& mergeCase : cases)
+    {
+        auto mask = RenderGraph::GetSubresourceMask(mergeCase.range, dimension);
+        UINT unmergedCount = static_cast<UINT>(std::count(mask.begin(), mask.end(), true));
+
+        std::size_t mergedCount = 0;
+        Stopwatch stopwatch;
+        for (UINT i = 0; i < MergeCount; ++i)
+            mergedCount = RenderGraph::MergeSubresourceRanges(mask, dimension.mipLevels, dimension.arraySize, dimension.planeCount).size();
+        double seconds = stopwatch.GetElapsedSeconds();
+        DoNotOptimize(mergedCount);
+
+        PrintResult(mergeCase.label, MergeCount, seconds);
+        std::printf("  %u barriers unmerged, %zu merged\n", unmergedCount, mergedCount);
+    }
+}
+}
+
+// Barrier counts of the texture layouts the renderer transitions in parts, with and without merging subresources.
+// Shadow passes write one cascade or one cube face at a time, and lighting reads the whole map.
+void RunSubresourceMergeBenchmark()
+{
+    const TextureDimension cascades = {MAX_CASCADES, 1, MAX_CASCADES, 1};
+    RunCases(
+        "cascaded shadow map",
+        cascades,
+        {
+            {"one cascade", {0, 1, 1, 1, 0, 1}},
+            {"last cascades", {0, 1, 1, MAX_CASCADES - 1, 0, 1}},
+            {"all cascades", {0xffff'ffff, 0, 0, 0, 0, 0}},
+        });
+
+    const TextureDimension cube = {POINT_LIGHT_ARRAY_SIZE, 1, POINT_LIGHT_ARRAY_SIZE, 1};
+    RunCases(
+        "point light shadow cube",
+        cube,
+        {
+            {"one face", {0, 1, 2, 1, 0, 1}},
+            {"all faces", {0xffff'ffff, 0, 0, 0, 0, 0}},
+        });
+
+    // Mips are filtered one at a time across all faces, and read one face at a time.
+    constexpr UINT MipLevels = 9;
+    const TextureDimension mippedCube = {MipLevels * POINT_LIGHT_ARRAY_SIZE, MipLevels, POINT_LIGHT_ARRAY_SIZE, 1};
+    RunCases(
+        "cube with mip chain",
+        mippedCube,
+        {
+            {"one face, all mips", {0, MipLevels, 2, 1, 0, 1}},
+            {"one mip, all faces", {3, 1, 0, POINT_LIGHT_ARRAY_SIZE, 0, 1}},
+            {"mip tail, all faces", {1, MipLevels - 1, 0, POINT_LIGHT_ARRAY_SIZE, 0, 1}},
+            {"all subresources", {0xffff'ffff, 0, 0, 0, 0, 0}},
+        });
+}
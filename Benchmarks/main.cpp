@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Benchmark.h"
+
+namespace
+{
+struct BenchmarkEntry
+{
+    const char* name;
+    void (*run)();
+};
+
+constexpr BenchmarkEntry Benchmarks[] = {
+    {"aabbtree", RunAabbTreeBenchmark},
+    {"commandrecording", RunCommandRecordingBenchmark},
+    {"components", RunComponentPoolBenchmark},
+    {"descriptorallocator", RunDescriptorAllocatorBenchmark},
+    {"descriptorpage", RunDescriptorPageBenchmark},
+    {"drawlist", RunDrawListBenchmark},
+    {"frustumculler", RunFrustumCullerBenchmark},
+    {"jobsystem", RunJobSystemBenchmark},
+    {"subresourcemerge", RunSubresourceMergeBenchmark},
+};
+}
+
+// Runs every benchmark, or only the ones named in arguments.
+int main(int argc, char* argv[])
+{
+    for (const auto& benchmark : Benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], benchmark.name) == 0)
+                selected = true;
+        }
+
+        if (!selected)
+            continue;
+
+        std::printf("[%s]\n", benchmark.name);
+        benchmark.run();
+        std::printf("\n");
+    }
+
+    return 0;
+}
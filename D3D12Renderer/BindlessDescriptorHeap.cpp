@@ -0,0 +1,94 @@
+#include "pch.h"
+
+#include "BindlessDescriptorHeap.h"
+
+#include "D3DHelper.h"
+
+using namespace D3DHelper;
+
+void BindlessDescriptorHeap::Init(ID3D12Device* pDevice)
+{
+    m_pDevice = pDevice;
+    m_descriptorHandleIncrementSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.NumDescriptors = GetDynamicOffset() + NumDynamicDescriptors;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    ThrowIfFailed(pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_descriptorHeap)));
+
+    m_persistentIndices.Init(NumPersistentDescriptors);
+    m_perFrameIndices.Init(NumPerFrameDescriptors);
+}
+
+BindlessIndex BindlessDescriptorHeap::AllocatePersistent(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+    auto index = m_persistentIndices.Allocate();
+    m_pDevice->CopyDescriptorsSimple(1, GetCpuHandle(index.Get()), srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return index;
+}
+
+BindlessIndex BindlessDescriptorHeap::AllocatePerFrame()
+{
+    return m_perFrameIndices.Allocate();
+}
+
+void BindlessDescriptorHeap::CopyPerFrameDescriptor(UINT index, UINT frameIndex, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
+{
+    assert(index < NumPerFrameDescriptors && frameIndex < FrameCount);
+
+    UINT offsetInHeap = NumPersistentDescriptors + NumPerFrameDescriptors * frameIndex + index;
+    m_pDevice->CopyDescriptorsSimple(1, GetCpuHandle(offsetInHeap), srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetPersistentGpuHandle() const
+{
+    return m_descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetPerFrameGpuHandle(UINT frameIndex) const
+{
+    return GetGpuDescriptorHandle(m_descriptorHeap->GetGPUDescriptorHandleForHeapStart(), NumPersistentDescriptors + NumPerFrameDescriptors * frameIndex, m_descriptorHandleIncrementSize);
+}
+
+ID3D12DescriptorHeap* BindlessDescriptorHeap::GetDescriptorHeap() const
+{
+    return m_descriptorHeap.Get();
+}
+
+UINT BindlessDescriptorHeap::GetDynamicOffset() const
+{
+    return NumPersistentDescriptors + NumPerFrameDescriptors * FrameCount;
+}
+
+UINT BindlessDescriptorHeap::GetNumDynamicDescriptors() const
+{
+    return NumDynamicDescriptors;
+}
+
+void BindlessDescriptorHeap::QueueRetiredIndices(UINT64 signaledFenceValue)
+{
+    m_persistentIndices.QueueRetiredIndices(signaledFenceValue);
+    m_perFrameIndices.QueueRetiredIndices(signaledFenceValue);
+}
+
+void BindlessDescriptorHeap::ReleaseStaleIndices(UINT64 completedFenceValue)
+{
+    m_persistentIndices.ReleaseStaleIndices(completedFenceValue);
+    m_perFrameIndices.ReleaseStaleIndices(completedFenceValue);
+}
+
+const BindlessIndexAllocator& BindlessDescriptorHeap::GetPersistentIndices() const
+{
+    return m_persistentIndices;
+}
+
+const BindlessIndexAllocator& BindlessDescriptorHeap::GetPerFrameIndices() const
+{
+    return m_perFrameIndices;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetCpuHandle(UINT offsetInHeap) const
+{
+    return GetCpuDescriptorHandle(m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), offsetInHeap, m_descriptorHandleIncrementSize);
+}
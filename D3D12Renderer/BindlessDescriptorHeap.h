@@ -0,0 +1,63 @@
+#pragma once
+
+#include <basetsd.h>
+#include <d3d12.h>
+#include <minwindef.h>
+#include <wrl/client.h>
+
+#include "BindlessIndexAllocator.h"
+#include "RendererConfig.h"
+
+// The only shader visible CBV/SRV/UAV heap. It stays bound for the whole frame.
+// | persistent | per frame x FrameCount | dynamic |
+// Persistent descriptors are written once, when their index is allocated.
+// Per frame ones are rewritten each frame by their owner into the region of that frame, which the GPU is done with.
+// Dynamic region is paged by DynamicDescriptorHeap for descriptors staged per frame.
+class BindlessDescriptorHeap
+{
+public:
+    BindlessDescriptorHeap(const BindlessDescriptorHeap&) = delete;
+    BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap&) = delete;
+    BindlessDescriptorHeap(BindlessDescriptorHeap&&) = delete;
+    BindlessDescriptorHeap& operator=(BindlessDescriptorHeap&&) = delete;
+
+    BindlessDescriptorHeap() = default;
+    ~BindlessDescriptorHeap() = default;
+
+    void Init(ID3D12Device* pDevice);
+
+    // Copies srcDescriptor into the slot of the new index.
+    BindlessIndex AllocatePersistent(D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+    BindlessIndex AllocatePerFrame();
+
+    void CopyPerFrameDescriptor(UINT index, UINT frameIndex, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor);
+
+    // Base of descriptor tables indexed by bindless indices
+    D3D12_GPU_DESCRIPTOR_HANDLE GetPersistentGpuHandle() const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetPerFrameGpuHandle(UINT frameIndex) const;
+
+    ID3D12DescriptorHeap* GetDescriptorHeap() const;
+    UINT GetDynamicOffset() const;
+    UINT GetNumDynamicDescriptors() const;
+
+    void QueueRetiredIndices(UINT64 signaledFenceValue);
+    void ReleaseStaleIndices(UINT64 completedFenceValue);
+
+    const BindlessIndexAllocator& GetPersistentIndices() const;
+    const BindlessIndexAllocator& GetPerFrameIndices() const;
+
+private:
+    static constexpr UINT NumPersistentDescriptors = 4096;
+    static constexpr UINT NumPerFrameDescriptors = 1024;
+    static constexpr UINT NumDynamicDescriptors = 8192;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(UINT offsetInHeap) const;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_descriptorHeap;
+    UINT m_descriptorHandleIncrementSize = 0;
+
+    BindlessIndexAllocator m_persistentIndices;
+    BindlessIndexAllocator m_perFrameIndices;
+
+    ID3D12Device* m_pDevice = nullptr;
+};
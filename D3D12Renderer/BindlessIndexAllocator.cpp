@@ -0,0 +1,119 @@
+#include "pch.h"
+
+#include "BindlessIndexAllocator.h"
+
+BindlessIndex::BindlessIndex(BindlessIndex&& other) noexcept
+    : m_index(other.m_index)
+    , m_pAllocator(other.m_pAllocator)
+{
+    other.m_index = 0;
+    other.m_pAllocator = nullptr;
+}
+
+BindlessIndex& BindlessIndex::operator=(BindlessIndex&& other) noexcept
+{
+    if (this != &other)
+    {
+        Free();
+
+        m_index = other.m_index;
+        m_pAllocator = other.m_pAllocator;
+
+        other.m_index = 0;
+        other.m_pAllocator = nullptr;
+    }
+
+    return *this;
+}
+
+BindlessIndex::BindlessIndex(UINT index, BindlessIndexAllocator* pAllocator)
+    : m_index(index)
+    , m_pAllocator(pAllocator)
+{
+}
+
+BindlessIndex::~BindlessIndex()
+{
+    Free();
+}
+
+bool BindlessIndex::IsNull() const
+{
+    return m_pAllocator == nullptr;
+}
+
+UINT BindlessIndex::Get() const
+{
+    assert(!IsNull());
+    return m_index;
+}
+
+void BindlessIndex::Free()
+{
+    if (m_pAllocator)
+    {
+        m_pAllocator->Free(m_index);
+        m_pAllocator = nullptr;
+    }
+}
+
+void BindlessIndexAllocator::Init(UINT capacity)
+{
+    m_capacity = capacity;
+    m_nextUnused = 0;
+    m_allocatedCount = 0;
+}
+
+BindlessIndex BindlessIndexAllocator::Allocate()
+{
+    UINT index;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else if (m_nextUnused < m_capacity)
+    {
+        index = m_nextUnused++;
+    }
+    else
+    {
+        throw std::out_of_range("Bindless index range is full.");
+    }
+
+    ++m_allocatedCount;
+    return BindlessIndex(index, this);
+}
+
+void BindlessIndexAllocator::Free(UINT index)
+{
+    assert(index < m_nextUnused);
+    m_retiredIndices.push_back(index);
+}
+
+void BindlessIndexAllocator::QueueRetiredIndices(UINT64 signaledFenceValue)
+{
+    for (UINT index : m_retiredIndices)
+        m_staleIndices.push({signaledFenceValue, index});
+    m_retiredIndices.clear();
+}
+
+void BindlessIndexAllocator::ReleaseStaleIndices(UINT64 completedFenceValue)
+{
+    while (!m_staleIndices.empty() && m_staleIndices.front().first <= completedFenceValue)
+    {
+        m_freeIndices.push_back(m_staleIndices.front().second);
+        m_staleIndices.pop();
+        --m_allocatedCount;
+    }
+}
+
+UINT BindlessIndexAllocator::GetCapacity() const
+{
+    return m_capacity;
+}
+
+UINT BindlessIndexAllocator::GetAllocatedCount() const
+{
+    return m_allocatedCount;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <basetsd.h>
+#include <minwindef.h>
+
+class BindlessIndexAllocator;
+
+// Move-only, self-freeing index into a bindless range.
+// Shaders see the same index for the whole lifetime of its owner.
+class BindlessIndex
+{
+public:
+    BindlessIndex() = default;
+
+    BindlessIndex(const BindlessIndex&) = delete;
+    BindlessIndex& operator=(const BindlessIndex&) = delete;
+
+    BindlessIndex(BindlessIndex&& other) noexcept;
+    BindlessIndex& operator=(BindlessIndex&& other) noexcept;
+
+    BindlessIndex(UINT index, BindlessIndexAllocator* pAllocator);
+
+    ~BindlessIndex();
+
+    bool IsNull() const;
+    UINT Get() const;
+
+private:
+    void Free();
+
+    UINT m_index = 0;
+    BindlessIndexAllocator* m_pAllocator = nullptr;
+};
+
+// Hands out indices in [0, capacity). Freed indices are reused only after the GPU is done with the frames that could reference them.
+// Does not touch the device, so it can be driven with plain fence values.
+class BindlessIndexAllocator
+{
+public:
+    BindlessIndexAllocator(const BindlessIndexAllocator&) = delete;
+    BindlessIndexAllocator& operator=(const BindlessIndexAllocator&) = delete;
+    BindlessIndexAllocator(BindlessIndexAllocator&&) = delete;
+    BindlessIndexAllocator& operator=(BindlessIndexAllocator&&) = delete;
+
+    BindlessIndexAllocator() = default;
+    ~BindlessIndexAllocator() = default;
+
+    void Init(UINT capacity);
+
+    // Throws when every index is in use or still waiting for the GPU.
+    BindlessIndex Allocate();
+
+    // Indices freed since the last call become reusable once signaledFenceValue completes.
+    void QueueRetiredIndices(UINT64 signaledFenceValue);
+    void ReleaseStaleIndices(UINT64 completedFenceValue);
+
+    UINT GetCapacity() const;
+    UINT GetAllocatedCount() const; // Stale ones included
+
+private:
+    friend class BindlessIndex;
+
+    void Free(UINT index);
+
+    UINT m_capacity = 0;
+    UINT m_nextUnused = 0; // Indices from here on were never allocated
+    UINT m_allocatedCount = 0;
+
+    std::vector<UINT> m_freeIndices;
+    std::vector<UINT> m_retiredIndices; // Freed during the frame being recorded
+    std::queue<std::pair<UINT64, UINT>> m_staleIndices;
+};
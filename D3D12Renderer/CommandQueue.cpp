@@ -32,6 +32,20 @@ void CommandQueue::Init(ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE type)
     m_fenceEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     if (m_fenceEvent == nullptr)
         ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+
+    m_threadPools.resize(1);
+}
+
+void CommandQueue::SetThreadPoolCount(UINT count)
+{
+    // Pools in use keep their lists, since they may still be executing.
+    if (count > m_threadPools.size())
+        m_threadPools.resize(count);
+}
+
+UINT CommandQueue::GetThreadPoolCount() const
+{
+    return static_cast<UINT>(m_threadPools.size());
 }
 
 void CommandQueue::SetDescriptorHeaps(const DynamicDescriptorHeap* pHeapForCbvSrvUav, ID3D12DescriptorHeap* pHeapForSampler)
@@ -45,57 +59,71 @@ ID3D12CommandQueue* CommandQueue::GetCommandQueue() const
     return m_commandQueue.Get();
 }
 
-ID3D12CommandAllocator* CommandQueue::CreateCommandAllocator()
+ID3D12CommandAllocator* CommandQueue::CreateCommandAllocator(UINT poolIdx)
 {
     ComPtr<ID3D12CommandAllocator> commandAllocator;
     ThrowIfFailed(m_pDevice->CreateCommandAllocator(m_type, IID_PPV_ARGS(&commandAllocator)));
-    m_commandAllocatorPool.push_back(std::move(commandAllocator));
 
-    return m_commandAllocatorPool.back().Get();
+    {
+        std::lock_guard<std::mutex> lock(m_allocatorPoolMutex);
+        m_allocatorPoolIndices[commandAllocator.Get()] = poolIdx;
+    }
+
+    auto& commandAllocators = m_threadPools[poolIdx].commandAllocators;
+    commandAllocators.push_back(std::move(commandAllocator));
+
+    return commandAllocators.back().Get();
 }
 
-ID3D12GraphicsCommandList7* CommandQueue::CreateCommandList(ID3D12CommandAllocator* pCommandAllocator)
+ID3D12GraphicsCommandList7* CommandQueue::CreateCommandList(UINT poolIdx, ID3D12CommandAllocator* pCommandAllocator)
 {
     ComPtr<ID3D12GraphicsCommandList7> commandList;
     ThrowIfFailed(m_pDevice->CreateCommandList(0, m_type, pCommandAllocator, nullptr, IID_PPV_ARGS(&commandList)));
-    m_commandListPool.push_back(std::move(commandList));
 
-    return m_commandListPool.back().Get();
+    auto& commandLists = m_threadPools[poolIdx].commandLists;
+    commandLists.push_back(std::move(commandList));
+
+    return commandLists.back().Get();
 }
 
-std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*> CommandQueue::GetAvailableCommandList()
+std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*> CommandQueue::GetAvailableCommandList(UINT poolIdx)
 {
     ID3D12CommandAllocator* pCommandAllocator;
     ID3D12GraphicsCommandList7* pCommandList;
 
+    auto& pool = m_threadPools[poolIdx];
+
     // Command allocator queue에 GPU 작업이 끝난 allocator가 존재한다면 그것을 사용하고 없다면 새로 생성
-    if (!m_commandAllocatorQueue.empty() && IsFenceComplete(m_commandAllocatorQueue.front().fenceValue))
+    if (!pool.commandAllocatorQueue.empty() && IsFenceComplete(pool.commandAllocatorQueue.front().fenceValue))
     {
-        pCommandAllocator = m_commandAllocatorQueue.front().pCommandAllocator;
-        m_commandAllocatorQueue.pop();
+        pCommandAllocator = pool.commandAllocatorQueue.front().pCommandAllocator;
+        pool.commandAllocatorQueue.pop();
         ThrowIfFailed(pCommandAllocator->Reset());
     }
     else
     {
-        pCommandAllocator = CreateCommandAllocator();
+        pCommandAllocator = CreateCommandAllocator(poolIdx);
     }
 
     // Command list는 execute만 되면 즉시 재사용이 가능하므로 큐에 있으면 바로 사용하고 없으면 새로 생성
     // 직전에 얻은 commandAllocator에 연결
-    if (!m_commandListQueue.empty())
+    if (!pool.commandListQueue.empty())
     {
-        pCommandList = m_commandListQueue.front();
-        m_commandListQueue.pop();
+        pCommandList = pool.commandListQueue.front();
+        pool.commandListQueue.pop();
         ThrowIfFailed(pCommandList->Reset(pCommandAllocator, nullptr));
     }
     else
     {
-        pCommandList = CreateCommandList(pCommandAllocator);
+        pCommandList = CreateCommandList(poolIdx, pCommandAllocator);
     }
 
-    // Bind with DescriptorHeaps
-    ID3D12DescriptorHeap* ppHeaps[] = {m_pDynamicDescriptorHeapForCbvSrvUav->GetCurrentDescriptorHeap(), m_pSamplerDescriptorHeap};
-    pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    // Bind with DescriptorHeaps, if set
+    if (m_pDynamicDescriptorHeapForCbvSrvUav)
+    {
+        ID3D12DescriptorHeap* ppHeaps[] = {m_pDynamicDescriptorHeapForCbvSrvUav->GetCurrentDescriptorHeap(), m_pSamplerDescriptorHeap};
+        pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    }
 
     return {pCommandAllocator, pCommandList};
 }
@@ -108,12 +136,42 @@ UINT64 CommandQueue::ExecuteCommandLists(ID3D12CommandAllocator* pCommandAllocat
     m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
     UINT64 fenceValue = Signal();
-    m_commandAllocatorQueue.push({fenceValue, pCommandAllocator});
-    m_commandListQueue.push(pCommandList);
+    Retire(pCommandAllocator, pCommandList, fenceValue);
 
     return fenceValue;
 }
 
+UINT64 CommandQueue::ExecuteCommandLists(const std::vector<std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*>>& commandLists)
+{
+    m_executingCommandLists.clear();
+    for (auto& [pCommandAllocator, pCommandList] : commandLists)
+    {
+        pCommandList->Close();
+        m_executingCommandLists.push_back(pCommandList);
+    }
+
+    m_commandQueue->ExecuteCommandLists(static_cast<UINT>(m_executingCommandLists.size()), m_executingCommandLists.data());
+
+    UINT64 fenceValue = Signal();
+    for (auto& [pCommandAllocator, pCommandList] : commandLists)
+        Retire(pCommandAllocator, pCommandList, fenceValue);
+
+    return fenceValue;
+}
+
+void CommandQueue::Retire(ID3D12CommandAllocator* pCommandAllocator, ID3D12GraphicsCommandList7* pCommandList, UINT64 fenceValue)
+{
+    UINT poolIdx;
+    {
+        std::lock_guard<std::mutex> lock(m_allocatorPoolMutex);
+        poolIdx = m_allocatorPoolIndices.at(pCommandAllocator);
+    }
+
+    auto& pool = m_threadPools[poolIdx];
+    pool.commandAllocatorQueue.push({fenceValue, pCommandAllocator});
+    pool.commandListQueue.push(pCommandList);
+}
+
 UINT64 CommandQueue::Signal()
 {
     m_fenceValue++;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <mutex>
 #include <queue>
+#include <unordered_map>
 #include <utility> // for std::pair
 #include <vector>
 
@@ -28,10 +30,20 @@ public:
 
     ID3D12CommandQueue* GetCommandQueue() const;
 
-    std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*> GetAvailableCommandList();
+    // Threads recording at the same time take lists from pools of their own. Pool 0 is the main thread's.
+    // Only change while no list is being recorded.
+    void SetThreadPoolCount(UINT count);
+    UINT GetThreadPoolCount() const;
+
+    // Safe to call from several threads with different pools. A pool must not be used by two threads at once.
+    // Submitted lists go back to the pool they came from.
+    std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*> GetAvailableCommandList(UINT poolIdx = 0);
 
     UINT64 ExecuteCommandLists(ID3D12CommandAllocator* pCommandAllocator, ID3D12GraphicsCommandList7* pCommandList);
 
+    // Close and submit lists in order with a single call. One fence value covers all of them.
+    UINT64 ExecuteCommandLists(const std::vector<std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*>>& commandLists);
+
     UINT64 Signal();
     UINT64 GetCompletedFenceValue() const;
     bool IsFenceComplete(UINT64 fenceValue) const;
@@ -39,24 +51,38 @@ public:
     void Flush();
 
 private:
-    ID3D12CommandAllocator* CreateCommandAllocator();
-    ID3D12GraphicsCommandList7* CreateCommandList(ID3D12CommandAllocator* pCommandAllocator);
-
-    D3D12_COMMAND_LIST_TYPE m_type;
-
     struct CommandAllocatorEntry
     {
         UINT64 fenceValue;
         ID3D12CommandAllocator* pCommandAllocator;
     };
 
-    // Pools
-    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_commandAllocatorPool;
-    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7>> m_commandListPool;
+    struct ThreadPool
+    {
+        std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocators;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7>> commandLists;
+
+        // Queue containing command allocators and lists currently being used by GPU
+        std::queue<CommandAllocatorEntry> commandAllocatorQueue;
+        std::queue<ID3D12GraphicsCommandList7*> commandListQueue;
+    };
+
+    ID3D12CommandAllocator* CreateCommandAllocator(UINT poolIdx);
+    ID3D12GraphicsCommandList7* CreateCommandList(UINT poolIdx, ID3D12CommandAllocator* pCommandAllocator);
+
+    // Returns allocator and list to their pool once the GPU passes fenceValue.
+    void Retire(ID3D12CommandAllocator* pCommandAllocator, ID3D12GraphicsCommandList7* pCommandList, UINT64 fenceValue);
+
+    D3D12_COMMAND_LIST_TYPE m_type;
+
+    // Pools are only touched by their thread while recording, and by the main thread on submission.
+    std::vector<ThreadPool> m_threadPools;
+
+    // Pool of each allocator, for submission. Written by recording threads when they create one.
+    std::unordered_map<ID3D12CommandAllocator*, UINT> m_allocatorPoolIndices;
+    std::mutex m_allocatorPoolMutex;
 
-    // Queue containing command allocators and lists currently being used by GPU
-    std::queue<CommandAllocatorEntry> m_commandAllocatorQueue;
-    std::queue<ID3D12GraphicsCommandList7*> m_commandListQueue;
+    std::vector<ID3D12CommandList*> m_executingCommandLists; // Reused by each submission
 
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_commandQueue;
 
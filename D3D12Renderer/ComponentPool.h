@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include <minwindef.h>
+
+#include "SceneHandles.h"
+
+// Sparse set of components owned by entities.
+// Components are packed in a dense array, so systems can iterate only the data they touch.
+// Sparse array is indexed by slot index of entity handle.
+template <typename T>
+class ComponentPool
+{
+public:
+    T& Add(EntityHandle owner, T&& component)
+    {
+        assert(!Has(owner));
+
+        if (owner.index >= m_sparse.size())
+            m_sparse.resize(owner.index + 1, NullIndex);
+
+        m_sparse[owner.index] = static_cast<UINT>(m_dense.size());
+        m_dense.push_back(std::move(component));
+        m_owners.push_back(owner);
+
+        return m_dense.back();
+    }
+
+    // Swap-and-pop. Dense indices of other components may change.
+    void Remove(EntityHandle owner)
+    {
+        if (!Has(owner))
+            return;
+
+        UINT idx = m_sparse[owner.index];
+        UINT lastIdx = static_cast<UINT>(m_dense.size()) - 1;
+
+        if (idx != lastIdx)
+        {
+            m_dense[idx] = std::move(m_dense[lastIdx]);
+            m_owners[idx] = m_owners[lastIdx];
+            m_sparse[m_owners[idx].index] = idx;
+        }
+
+        m_dense.pop_back();
+        m_owners.pop_back();
+
+        m_sparse[owner.index] = NullIndex;
+    }
+
+    bool Has(EntityHandle owner) const
+    {
+        // Owner check rejects stale handles whose slot was reused.
+        return owner.index < m_sparse.size() && m_sparse[owner.index] != NullIndex && m_owners[m_sparse[owner.index]] == owner;
+    }
+
+    T* Get(EntityHandle owner)
+    {
+        if (!Has(owner))
+            return nullptr;
+        return &m_dense[m_sparse[owner.index]];
+    }
+
+    const T* Get(EntityHandle owner) const
+    {
+        if (!Has(owner))
+            return nullptr;
+        return &m_dense[m_sparse[owner.index]];
+    }
+
+    UINT GetDenseIndex(EntityHandle owner) const
+    {
+        assert(Has(owner));
+        return m_sparse[owner.index];
+    }
+
+    std::vector<T>& GetDense()
+    {
+        return m_dense;
+    }
+    const std::vector<T>& GetDense() const
+    {
+        return m_dense;
+    }
+
+    // denseIdx → owner
+    const std::vector<EntityHandle>& GetOwners() const
+    {
+        return m_owners;
+    }
+
+    UINT GetCount() const
+    {
+        return static_cast<UINT>(m_dense.size());
+    }
+
+private:
+    static constexpr UINT NullIndex = UINT_MAX;
+
+    std::vector<T> m_dense;
+    std::vector<EntityHandle> m_owners;
+    std::vector<UINT> m_sparse; // slotIdx → denseIdx
+};
@@ -61,6 +61,9 @@ struct LightConstants
 };
 ConstantBuffer<LightConstants> LightConstantBuffers[] : register(b0, space2);
 
+// Bindless indices of LightConstantBuffers, one per light
+StructuredBuffer<uint> g_lightIndices : register(t0, space8);
+
 // Determine which index to use and alpha for interpolation.
 void CalcCSMIndex(float distView, out uint index, out float alpha)
 {
@@ -224,7 +227,7 @@ float4 main(PSInput input) : SV_TARGET
     [loop]
     for (uint i = 0; i < numLights; ++i)
     {
-        LightConstants light = LightConstantBuffers[i];
+        LightConstants light = LightConstantBuffers[g_lightIndices[i]];
         
         float shadowFactor;
         
@@ -2,13 +2,22 @@
 
 #include "DescriptorAllocator.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "CommandQueue.h"
 #include "DescriptorAllocation.h"
-#include "DescriptorAllocatorPage.h"
 
 using Microsoft::WRL::ComPtr;
 
-DescriptorAllocator::DescriptorAllocator() = default;
+std::atomic<UINT64> DescriptorAllocator::s_nextAllocatorId{0};
+thread_local std::vector<DescriptorAllocator::ThreadCacheSlot> DescriptorAllocator::t_threadCacheSlots;
+
+DescriptorAllocator::DescriptorAllocator()
+    : m_allocatorId(++s_nextAllocatorId)
+{
+}
+
 DescriptorAllocator::~DescriptorAllocator() = default;
 
 void DescriptorAllocator::Init(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type)
@@ -27,64 +36,216 @@ DescriptorAllocation DescriptorAllocator::Allocate(UINT32 numDescriptors)
 {
     assert(numDescriptors <= NumDescriptorsPerHeap);
 
+    // Single descriptors are the common case, served without touching the shared pool.
+    if (numDescriptors == 1)
+    {
+        ThreadCache& cache = GetThreadCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+
+        cache.isIdle = false;
+        if (cache.magazine.empty())
+            RefillMagazine(cache);
+
+        auto [pPage, offset] = cache.magazine.back();
+        cache.magazine.pop_back();
+        return pPage->WrapBlock(offset, 1);
+    }
+
     std::lock_guard<std::mutex> lock(m_allocationMutex);
 
-    // Release allocations that have finished execution before allocation.
-    ReleaseStaleDescriptors(m_pCommandQueue->GetCompletedFenceValue());
+    ReleaseStaleDescriptors();
 
-    std::optional<DescriptorAllocation> allocation;
+    UINT32 offset;
+    auto* pPage = AllocateBlock(numDescriptors, offset);
+    return pPage->WrapBlock(offset, numDescriptors);
+}
 
-    for (auto it = m_availableHeaps.begin(); it != m_availableHeaps.end(); ++it)
+void DescriptorAllocator::QueueStaleDescriptor(DescriptorAllocatorPage* pPage, const DescriptorAllocatorPage::StaleDescriptorInfo& info)
+{
+    ThreadCache& cache = GetThreadCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    cache.pendingFrees.push_back({pPage, info});
+    if (cache.pendingFrees.size() >= MagazineSize)
+        FlushPendingFrees(cache);
+}
+
+void DescriptorAllocator::FlushThreadCaches()
+{
+    std::lock_guard<std::mutex> cachesLock(m_threadCacheMutex);
+
+    for (auto& pCache : m_threadCaches)
     {
-        auto& allocatorPage = m_heapPool[*it];
-        allocation = allocatorPage->Allocate(numDescriptors);
+        std::lock_guard<std::mutex> lock(pCache->mutex);
 
-        // A valid allocation has been found
-        if (allocation.has_value())
-        {
-            // In DescriptorAllocatorPage::Allocate, m_numFreeHandles is already checked,
-            // but here it's checked again with GetNumFreeHandles. This could be redundant.
-
-            // Check if page has free handles only when allocation succeeded
-            if (allocatorPage->GetNumFreeHandles() == 0)
-            {
-                m_availableHeaps.erase(it);
-            }
-            break;
-        }
+        // Loader threads that went idle should not keep descriptors to themselves.
+        if (pCache->isIdle)
+            ReturnMagazine(*pCache);
+        FlushPendingFrees(*pCache);
+
+        pCache->isIdle = true;
+    }
+}
+
+DescriptorAllocator::ThreadCache& DescriptorAllocator::GetThreadCache()
+{
+    for (const auto& slot : t_threadCacheSlots)
+    {
+        if (slot.allocatorId == m_allocatorId)
+            return *slot.pCache;
+    }
+
+    // First use of this allocator on the thread
+    std::lock_guard<std::mutex> lock(m_threadCacheMutex);
+    m_threadCaches.push_back(std::make_unique<ThreadCache>());
+    t_threadCacheSlots.push_back({m_allocatorId, m_threadCaches.back().get()});
+    return *m_threadCaches.back();
+}
+
+// Takes the pool lock once for the whole magazine.
+void DescriptorAllocator::RefillMagazine(ThreadCache& cache)
+{
+    std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+    ReleaseStaleDescriptors();
+
+    for (UINT32 i = 0; i < MagazineSize; ++i)
+    {
+        UINT32 offset;
+        auto* pPage = AllocateBlock(1, offset);
+        cache.magazine.push_back({pPage, offset});
+    }
+}
+
+// Queues pending frees to their pages, locking each page once.
+void DescriptorAllocator::FlushPendingFrees(ThreadCache& cache)
+{
+    auto& pendingFrees = cache.pendingFrees;
+    std::stable_sort(pendingFrees.begin(), pendingFrees.end(), [](const PendingFree& a, const PendingFree& b) { return std::less<DescriptorAllocatorPage*>()(a.pPage, b.pPage); });
+
+    for (SIZE_T runBegin = 0; runBegin < pendingFrees.size();)
+    {
+        auto* pPage = pendingFrees[runBegin].pPage;
+
+        cache.scratch.clear();
+        SIZE_T runEnd = runBegin;
+        for (; runEnd < pendingFrees.size() && pendingFrees[runEnd].pPage == pPage; ++runEnd)
+            cache.scratch.push_back(pendingFrees[runEnd].info);
+
+        pPage->QueueStaleDescriptors(cache.scratch.data(), static_cast<UINT32>(cache.scratch.size()));
+        runBegin = runEnd;
+    }
+
+    pendingFrees.clear();
+}
+
+// Unused descriptors were never visible to the GPU, so they are freed with fence value 0.
+void DescriptorAllocator::ReturnMagazine(ThreadCache& cache)
+{
+    for (auto [pPage, offset] : cache.magazine)
+        cache.pendingFrees.push_back({pPage, {offset, 1, 0}});
+    cache.magazine.clear();
+}
+
+DescriptorAllocatorPage* DescriptorAllocator::AllocateBlock(UINT32 numDescriptors, UINT32& offset)
+{
+    DescriptorAllocatorPage* pPage = TryAllocateFromPool(numDescriptors, offset);
+
+    // Descriptors queued after the last release may already be complete. Try them before growing the pool.
+    if (!pPage)
+    {
+        ReleaseStaleDescriptors(m_releasedFenceValue);
+        pPage = TryAllocateFromPool(numDescriptors, offset);
     }
 
     // No available heap could satisfy the requested number of descriptors
-    if (!allocation.has_value())
+    if (!pPage)
+    {
+        pPage = CreateAllocatorPage();
+        bool allocated = pPage->AllocateBlock(numDescriptors, offset);
+        assert(allocated);
+    }
+
+    m_numFreeHandles -= numDescriptors;
+    return pPage;
+}
+
+DescriptorAllocatorPage* DescriptorAllocator::TryAllocateFromPool(UINT32 numDescriptors, UINT32& offset)
+{
+    // Skip the pool when it can not hold the request anyway
+    if (numDescriptors > m_numFreeHandles)
+        return nullptr;
+
+    for (auto it = m_availableHeaps.begin(); it != m_availableHeaps.end(); ++it)
     {
-        auto* pNewPage = CreateAllocatorPage();
-        allocation = pNewPage->Allocate(numDescriptors);
+        auto* pPage = m_heapPool[*it].get();
+
+        // HasSpace is O(1), so pages without a large enough block are skipped cheaply.
+        if (!pPage->HasSpace(numDescriptors))
+            continue;
+
+        bool allocated = pPage->AllocateBlock(numDescriptors, offset);
+        assert(allocated);
+
+        if (pPage->GetNumFreeHandles() == 0)
+        {
+            m_availableHeaps.erase(it);
+        }
+        return pPage;
     }
 
-    // std::optional<T>::value returns l-value reference, so std::move should be used for satisfy
-    // move constructor/assignment of DescriptorAllocation
-    return std::move(allocation.value());
+    return nullptr;
 }
 
 // Create a new heap with a specific number of descriptors
 DescriptorAllocatorPage* DescriptorAllocator::CreateAllocatorPage()
 {
-    m_heapPool.emplace_back(std::make_unique<DescriptorAllocatorPage>(m_pDevice, m_heapType, NumDescriptorsPerHeap));
+    m_heapPool.emplace_back(std::make_unique<DescriptorAllocatorPage>(m_pDevice, m_heapType, NumDescriptorsPerHeap, this));
     m_availableHeaps.insert(m_heapPool.size() - 1); // Index of the page added
+    m_numFreeHandles += NumDescriptorsPerHeap;
     return m_heapPool.back().get();
 }
 
+// Release allocations that have finished execution.
+// Nothing new can be released until the completed fence value advances.
+void DescriptorAllocator::ReleaseStaleDescriptors()
+{
+    UINT64 completedFenceValue = m_pCommandQueue->GetCompletedFenceValue();
+    if (completedFenceValue > m_releasedFenceValue)
+    {
+        ReleaseStaleDescriptors(completedFenceValue);
+        m_releasedFenceValue = completedFenceValue;
+    }
+}
+
 void DescriptorAllocator::ReleaseStaleDescriptors(UINT64 completedFenceValue)
 {
     for (SIZE_T i = 0; i < m_heapPool.size(); ++i)
     {
         auto& page = m_heapPool[i];
 
-        page->ReleaseStaleDescriptors(completedFenceValue);
+        UINT32 numReleased = page->ReleaseStaleDescriptors(completedFenceValue);
+        m_numFreeHandles += numReleased;
 
-        if (page->GetNumFreeHandles() > 0)
+        if (numReleased > 0)
         {
             m_availableHeaps.insert(i);
         }
     }
 }
+
+UINT32 DescriptorAllocator::GetNumPages() const
+{
+    return static_cast<UINT32>(m_heapPool.size());
+}
+
+UINT32 DescriptorAllocator::GetNumFreeHandles() const
+{
+    return m_numFreeHandles;
+}
+
+UINT32 DescriptorAllocator::GetNumThreadCaches() const
+{
+    std::lock_guard<std::mutex> lock(m_threadCacheMutex);
+    return static_cast<UINT32>(m_threadCaches.size());
+}
@@ -1,18 +1,23 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include <basetsd.h>
 #include <d3d12.h>
 
+#include "DescriptorAllocatorPage.h"
+
 class CommandQueue;
-class DescriptorAllocatorPage;
 class DescriptorAllocation;
 
 // DescriptorAllocator class is used to allocate descriptors to the application when loading new resources
+// Single descriptors come from a per-thread magazine, and frees are batched per thread,
+// so parallel loaders touch the shared pool once per MagazineSize operations.
 class DescriptorAllocator
 {
 public:
@@ -29,21 +34,76 @@ public:
 
     DescriptorAllocation Allocate(UINT32 numDescriptors = 1);
 
+    // Called by DescriptorAllocatorPage::Free. Queued to the page when the batch of the calling thread is full.
+    void QueueStaleDescriptor(DescriptorAllocatorPage* pPage, const DescriptorAllocatorPage::StaleDescriptorInfo& info);
+
+    // Call once per frame. Queues frees of every thread, and returns magazines of threads that did not allocate since the last call.
+    void FlushThreadCaches();
+
+    UINT32 GetNumPages() const;
+    UINT32 GetNumFreeHandles() const;
+    UINT32 GetNumThreadCaches() const;
+
 private:
     static constexpr UINT32 NumDescriptorsPerHeap = 256;
+    static constexpr UINT32 MagazineSize = 32;
+
+    struct PendingFree
+    {
+        DescriptorAllocatorPage* pPage;
+        DescriptorAllocatorPage::StaleDescriptorInfo info;
+    };
+
+    struct ThreadCache
+    {
+        std::mutex mutex; // Only contended by FlushThreadCaches
+
+        // Raw single descriptors, wrapped into DescriptorAllocation when handed out
+        std::vector<std::pair<DescriptorAllocatorPage*, UINT32>> magazine;
+        std::vector<PendingFree> pendingFrees;
+        std::vector<DescriptorAllocatorPage::StaleDescriptorInfo> scratch;
+
+        bool isIdle = true; // No allocation since the last flush
+    };
+
+    struct ThreadCacheSlot
+    {
+        UINT64 allocatorId = 0;
+        ThreadCache* pCache = nullptr;
+    };
+
+    ThreadCache& GetThreadCache();
+    void RefillMagazine(ThreadCache& cache);
+    void FlushPendingFrees(ThreadCache& cache);
+    void ReturnMagazine(ThreadCache& cache);
 
     // These functions not use mutex since they assume that mutex already locked on caller's side.
     // If this function called outside of DescriptorAllocator::Allocate, explicit mutex should be locked.
+    DescriptorAllocatorPage* AllocateBlock(UINT32 numDescriptors, UINT32& offset);
+    DescriptorAllocatorPage* TryAllocateFromPool(UINT32 numDescriptors, UINT32& offset);
     DescriptorAllocatorPage* CreateAllocatorPage();
+    void ReleaseStaleDescriptors();
     void ReleaseStaleDescriptors(UINT64 completedFenceValue);
 
+    static std::atomic<UINT64> s_nextAllocatorId;
+    // Slot per allocator the thread used, found by a linear search since there are only a few.
+    // Ids are never reused, so slots of destroyed allocators are never matched again.
+    static thread_local std::vector<ThreadCacheSlot> t_threadCacheSlots;
+
+    UINT64 m_allocatorId;
     D3D12_DESCRIPTOR_HEAP_TYPE m_heapType;
 
     std::vector<std::unique_ptr<DescriptorAllocatorPage>> m_heapPool;
     std::set<SIZE_T> m_availableHeaps; // Indices of available heaps in the heap pool.
+    UINT32 m_numFreeHandles = 0; // Sum over the pool, tracked as pages allocate and release
+    UINT64 m_releasedFenceValue = 0; // Stale descriptors up to this fence value are already released
 
     std::mutex m_allocationMutex;
 
+    // Destroyed before the pool. Caches hold raw blocks only, so nothing is freed through pages on destruction.
+    std::vector<std::unique_ptr<ThreadCache>> m_threadCaches;
+    mutable std::mutex m_threadCacheMutex;
+
     ID3D12Device* m_pDevice = nullptr;
     const CommandQueue* m_pCommandQueue = nullptr;
 };
@@ -4,12 +4,14 @@
 
 #include "D3DHelper.h"
 #include "DescriptorAllocation.h"
+#include "DescriptorAllocator.h"
 
 using namespace D3DHelper;
 
-DescriptorAllocatorPage::DescriptorAllocatorPage(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT32 numDescriptors)
+DescriptorAllocatorPage::DescriptorAllocatorPage(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT32 numDescriptors, DescriptorAllocator* pAllocator)
     : m_heapType(type)
     , m_numDescriptorsInHeap(numDescriptors)
+    , m_pAllocator(pAllocator)
 {
     D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
     heapDesc.Type = m_heapType;
@@ -21,44 +23,163 @@ DescriptorAllocatorPage::DescriptorAllocatorPage(ID3D12Device* pDevice, D3D12_DE
     m_descriptorHandleIncrementSize = pDevice->GetDescriptorHandleIncrementSize(m_heapType);
     m_numFreeHandles = m_numDescriptorsInHeap;
 
+    // Tags are allocated once, so allocation and free never touch the heap.
+    m_blockTags.resize(m_numDescriptorsInHeap);
+    for (auto& heads : m_freeListHeads)
+        heads.fill(InvalidOffset);
+
     // Initialize the free lists
     AddNewBlock(0, m_numFreeHandles);
 }
 
+void DescriptorAllocatorPage::MapInsert(SizeType size, UINT32& firstLevel, UINT32& secondLevel)
+{
+    if (size < SecondLevelCount)
+    {
+        firstLevel = 0;
+        secondLevel = size;
+        return;
+    }
+
+    DWORD log2Size;
+    _BitScanReverse(&log2Size, size);
+    firstLevel = log2Size - SecondLevelLog2 + 1;
+    secondLevel = (size >> (log2Size - SecondLevelLog2)) - SecondLevelCount;
+}
+
+void DescriptorAllocatorPage::MapSearch(SizeType size, UINT32& firstLevel, UINT32& secondLevel)
+{
+    // Round up to the next list boundary, so any block in the list found is large enough.
+    if (size >= SecondLevelCount)
+    {
+        DWORD log2Size;
+        _BitScanReverse(&log2Size, size);
+        size += (1u << (log2Size - SecondLevelLog2)) - 1;
+    }
+
+    MapInsert(size, firstLevel, secondLevel);
+}
+
+DescriptorAllocatorPage::OffsetType DescriptorAllocatorPage::FindFreeBlock(SizeType size) const
+{
+    UINT32 firstLevel, secondLevel;
+    MapSearch(size, firstLevel, secondLevel);
+    if (firstLevel >= FirstLevelCount)
+        return InvalidOffset;
+
+    DWORD index;
+
+    // Larger lists in the same first level
+    UINT32 secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0)
+    {
+        // Any list in larger first levels
+        UINT32 firstLevelMap = m_firstLevelBitmap & (~0u << (firstLevel + 1));
+        if (!_BitScanForward(&index, firstLevelMap))
+            return InvalidOffset;
+
+        firstLevel = index;
+        secondLevelMap = m_secondLevelBitmaps[firstLevel];
+    }
+
+    _BitScanForward(&index, secondLevelMap);
+    return m_freeListHeads[firstLevel][index];
+}
+
 void DescriptorAllocatorPage::AddNewBlock(UINT32 offset, UINT32 numDescriptors)
 {
-    auto offsetIt = m_freeListByOffset.insert({offset, numDescriptors});
-    auto sizeIt = m_freeListBySize.insert({numDescriptors, offsetIt.first});
-    offsetIt.first->second.freeListBySizeIt = sizeIt;
+    BlockTag& tail = m_blockTags[offset + numDescriptors - 1];
+    tail.size = numDescriptors;
+    tail.isFree = true;
+
+    BlockTag& tag = m_blockTags[offset];
+    tag.size = numDescriptors;
+    tag.isFree = true;
+
+    UINT32 firstLevel, secondLevel;
+    MapInsert(numDescriptors, firstLevel, secondLevel);
+
+    // Push front
+    OffsetType& head = m_freeListHeads[firstLevel][secondLevel];
+    tag.prevFree = InvalidOffset;
+    tag.nextFree = head;
+    if (head != InvalidOffset)
+        m_blockTags[head].prevFree = offset;
+    head = offset;
+
+    m_firstLevelBitmap |= 1u << firstLevel;
+    m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void DescriptorAllocatorPage::RemoveFreeBlock(OffsetType offset)
+{
+    BlockTag& tag = m_blockTags[offset];
+    assert(tag.isFree);
+
+    UINT32 firstLevel, secondLevel;
+    MapInsert(tag.size, firstLevel, secondLevel);
+
+    if (tag.prevFree != InvalidOffset)
+        m_blockTags[tag.prevFree].nextFree = tag.nextFree;
+    else
+        m_freeListHeads[firstLevel][secondLevel] = tag.nextFree;
+
+    if (tag.nextFree != InvalidOffset)
+        m_blockTags[tag.nextFree].prevFree = tag.prevFree;
+
+    // Clear bits of the list when it became empty
+    if (m_freeListHeads[firstLevel][secondLevel] == InvalidOffset)
+    {
+        m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (m_secondLevelBitmaps[firstLevel] == 0)
+            m_firstLevelBitmap &= ~(1u << firstLevel);
+    }
+
+    tag.prevFree = InvalidOffset;
+    tag.nextFree = InvalidOffset;
 }
 
 bool DescriptorAllocatorPage::HasSpace(UINT32 numDescriptors) const
 {
-    return m_freeListBySize.lower_bound(numDescriptors) != m_freeListBySize.end();
+    return numDescriptors <= m_numFreeHandles && FindFreeBlock(numDescriptors) != InvalidOffset;
 }
 
 std::optional<DescriptorAllocation> DescriptorAllocatorPage::Allocate(UINT32 numDescriptors)
 {
-    std::lock_guard<std::mutex> lock(m_allocationMutex);
+    UINT32 offset;
 
     // Return std::nullopt if allocation failed
-    if (numDescriptors > m_numFreeHandles)
+    if (!AllocateBlock(numDescriptors, offset))
     {
         return std::nullopt;
     }
 
-    auto smallestBlockIt = m_freeListBySize.lower_bound(numDescriptors);
-    if (smallestBlockIt == m_freeListBySize.end())
+    return WrapBlock(offset, numDescriptors);
+}
+
+bool DescriptorAllocatorPage::AllocateBlock(UINT32 numDescriptors, UINT32& offset)
+{
+    std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+    if (numDescriptors == 0 || numDescriptors > m_numFreeHandles)
+    {
+        return false;
+    }
+
+    offset = FindFreeBlock(numDescriptors);
+    if (offset == InvalidOffset)
     {
-        return std::nullopt;
+        return false;
     }
 
-    auto [blockSize, offsetIt] = *smallestBlockIt;
-    auto offset = offsetIt->first;
+    auto blockSize = m_blockTags[offset].size;
 
     // Remove the existing free block
-    m_freeListBySize.erase(smallestBlockIt);
-    m_freeListByOffset.erase(offsetIt);
+    RemoveFreeBlock(offset);
+
+    // Split allocations are freed piece by piece, so every descriptor of the block is marked.
+    for (UINT32 i = 0; i < numDescriptors; ++i)
+        m_blockTags[offset + i].isFree = false;
 
     // Add remaining part as a new block
     auto newOffset = offset + numDescriptors;
@@ -70,6 +191,11 @@ std::optional<DescriptorAllocation> DescriptorAllocatorPage::Allocate(UINT32 num
 
     m_numFreeHandles -= numDescriptors;
 
+    return true;
+}
+
+DescriptorAllocation DescriptorAllocatorPage::WrapBlock(UINT32 offset, UINT32 numDescriptors)
+{
     return DescriptorAllocation(
         m_baseDescriptor,
         offset,
@@ -81,18 +207,25 @@ std::optional<DescriptorAllocation> DescriptorAllocatorPage::Allocate(UINT32 num
 // Actual free is deferred till GPU execution using that descriptor finished
 // parameter is r-value reference type
 void DescriptorAllocatorPage::Free(DescriptorAllocation&& descriptor)
+{
+    m_pAllocator->QueueStaleDescriptor(this, {descriptor.GetOffset(), descriptor.GetNumHandles(), descriptor.GetFenceValue()});
+}
+
+void DescriptorAllocatorPage::QueueStaleDescriptors(const StaleDescriptorInfo* pStaleDescriptors, UINT32 count)
 {
     std::lock_guard<std::mutex> lock(m_allocationMutex);
 
-    m_staleDescriptors.emplace(descriptor.GetOffset(), descriptor.GetNumHandles(), descriptor.GetFenceValue());
+    for (UINT32 i = 0; i < count; ++i)
+        m_staleDescriptors.push(pStaleDescriptors[i]);
 }
 
 // Entry with fenceValue that less than given (completed) fenceValue
 // is popped and be the target of FreeBlock
-void DescriptorAllocatorPage::ReleaseStaleDescriptors(UINT64 completedFenceValue)
+UINT32 DescriptorAllocatorPage::ReleaseStaleDescriptors(UINT64 completedFenceValue)
 {
     std::lock_guard<std::mutex> lock(m_allocationMutex);
 
+    UINT32 numReleased = 0;
     while (!m_staleDescriptors.empty() && m_staleDescriptors.front().fenceValue <= completedFenceValue)
     {
         auto& staleDescriptor = m_staleDescriptors.front();
@@ -103,67 +236,47 @@ void DescriptorAllocatorPage::ReleaseStaleDescriptors(UINT64 completedFenceValue
         auto numDescriptors = staleDescriptor.size;
 
         FreeBlock(offset, numDescriptors);
+        numReleased += numDescriptors;
 
         m_staleDescriptors.pop();
     }
+
+    return numReleased;
 }
 
 void DescriptorAllocatorPage::FreeBlock(UINT32 offset, UINT32 numDescriptors)
 {
-    auto nextBlockIt = m_freeListByOffset.upper_bound(offset);
-
-    auto prevBlockIt = nextBlockIt;
-    if (prevBlockIt != m_freeListByOffset.begin())
-    {
-        --prevBlockIt;
-    }
-    else
-    {
-        // just set it to the end of the list to indicate that no
-        // block comes before the one being freed
-        prevBlockIt = m_freeListByOffset.end();
-    }
-
     m_numFreeHandles += numDescriptors;
 
     // Coalesce with prev block
-    if (prevBlockIt != m_freeListByOffset.end() &&
-        offset == prevBlockIt->first + prevBlockIt->second.size)
+    // The last tag of the previous block is right before the block that is to be freed
+    //
+    // PrevBlock.offset           offset
+    // |                          |
+    // |<-----PrevBlock.size----->|<------size-------->|
+    //
+    if (offset > 0 && m_blockTags[offset - 1].isFree)
     {
-        // The previous block is exactly behind the block that is to be freed
-        //
-        // PrevBlock.offset           offset
-        // |                          |
-        // |<-----PrevBlock.size----->|<------size-------->|
-        //
-
-        offset = prevBlockIt->first;
-        // Increase the block size by the size of merging with the previous block
-        numDescriptors += prevBlockIt->second.size;
+        auto prevOffset = offset - m_blockTags[offset - 1].size;
+        RemoveFreeBlock(prevOffset);
 
-        // Remove the previous block from the free list
-        // Erase iterator that pointed by prevBlockIt
-        m_freeListBySize.erase(prevBlockIt->second.freeListBySizeIt);
-        // Erase prevBlockIt itself
-        m_freeListByOffset.erase(prevBlockIt);
+        // Increase the block size by the size of merging with the previous block
+        numDescriptors += offset - prevOffset;
+        offset = prevOffset;
     }
 
     // Coalesce with next block
-    if (nextBlockIt != m_freeListByOffset.end() &&
-        offset + numDescriptors == nextBlockIt->first)
+    // The first tag of the next block is right after the block that is to be freed
+    //
+    // offset               NextBlock.offset
+    // |                    |
+    // |<------size-------->|<-----NextBlock.size----->|
+    auto nextOffset = offset + numDescriptors;
+    if (nextOffset < m_numDescriptorsInHeap && m_blockTags[nextOffset].isFree)
     {
-        // The next block is exactly in front of the block that is to be freed
-        //
-        // offset               NextBlock.offset
-        // |                    |
-        // |<------size-------->|<-----NextBlock.size----->|
-
         // Increase the block size by the size of merging with the next block
-        numDescriptors += nextBlockIt->second.size;
-
-        // Remove the next block from the free list
-        m_freeListBySize.erase(nextBlockIt->second.freeListBySizeIt);
-        m_freeListByOffset.erase(nextBlockIt);
+        numDescriptors += m_blockTags[nextOffset].size;
+        RemoveFreeBlock(nextOffset);
     }
 
     AddNewBlock(offset, numDescriptors);
@@ -1,21 +1,41 @@
 #pragma once
 
-#include <map>
+#include <array>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <vector>
 
 #include <basetsd.h>
 #include <d3d12.h>
 #include <wrl/client.h>
 
 class DescriptorAllocation;
+class DescriptorAllocator;
 
 // Wrapper for ID3D12DescriptorHeap and provides free list management
+// Free blocks are kept in two-level segregated fit (TLSF) lists, so Allocate and FreeBlock are O(1).
 class DescriptorAllocatorPage
 {
 public:
-    DescriptorAllocatorPage(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT32 numDescriptors);
+    struct StaleDescriptorInfo
+    {
+        StaleDescriptorInfo(UINT32 offset, UINT32 size, UINT64 fenceValue)
+            : offset(offset)
+            , size(size)
+            , fenceValue(fenceValue)
+        {
+        }
+
+        // The offset within the descriptor heap.
+        UINT32 offset;
+        // The number of descriptors
+        UINT32 size;
+        // The fence value that GPU execution using this descriptor ends
+        UINT64 fenceValue;
+    };
+
+    DescriptorAllocatorPage(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT32 numDescriptors, DescriptorAllocator* pAllocator);
 
     D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType() const
     {
@@ -30,9 +50,16 @@ public:
 
     std::optional<DescriptorAllocation> Allocate(UINT32 numDescriptors);
 
+    // Raw blocks, for thread caches of DescriptorAllocator which hand them out later.
+    bool AllocateBlock(UINT32 numDescriptors, UINT32& offset);
+    DescriptorAllocation WrapBlock(UINT32 offset, UINT32 numDescriptors);
+
+    // Frees are batched per thread by the owning DescriptorAllocator, then queued here in bulk.
     void Free(DescriptorAllocation&& descriptorHandle);
+    void QueueStaleDescriptors(const StaleDescriptorInfo* pStaleDescriptors, UINT32 count);
 
-    void ReleaseStaleDescriptors(UINT64 completedFenceValue);
+    // Returns the number of descriptors that became free.
+    UINT32 ReleaseStaleDescriptors(UINT64 completedFenceValue);
 
 protected:
     // Adds a new block to the free list.
@@ -49,47 +76,42 @@ private:
     // The number of descriptors that are available.
     using SizeType = UINT32;
 
-    struct FreeBlockInfo;
-    // A map that lists the free blocks by the offset within the descriptor heap.
-    using FreeListByOffset = std::map<OffsetType, FreeBlockInfo>;
+    static constexpr OffsetType InvalidOffset = UINT32_MAX;
 
-    // A map that lists the free blocks by size.
-    // Needs to be a multimap since multiple blocks can have the same size.
-    using FreeListBySize = std::multimap<SizeType, FreeListByOffset::iterator>;
+    // Each first level list covers sizes in [2^n, 2^(n+1)), split linearly into 2^SecondLevelLog2 second level lists.
+    // Sizes below 2^SecondLevelLog2 share the first list, one size per second level list.
+    static constexpr UINT32 SecondLevelLog2 = 2;
+    static constexpr UINT32 SecondLevelCount = 1 << SecondLevelLog2;
+    static constexpr UINT32 FirstLevelCount = 32 - SecondLevelLog2 + 1;
 
-    struct FreeBlockInfo
+    // Boundary tag. Descriptor memory can not hold it, so tags are stored by offset on the side.
+    // The first and the last tag of a free block hold its size, so neighbours are found in O(1).
+    // Tags of allocated descriptors are only marked as not free.
+    // Links of the segregated list are valid in the first tag of free blocks only.
+    struct BlockTag
     {
-        FreeBlockInfo(SizeType size)
-            : size(size)
-        {
-        }
-
-        SizeType size;
-        FreeListBySize::iterator freeListBySizeIt;
+        SizeType size = 0;
+        bool isFree = false;
+        OffsetType prevFree = InvalidOffset;
+        OffsetType nextFree = InvalidOffset;
     };
 
-    struct StaleDescriptorInfo
-    {
-        StaleDescriptorInfo(OffsetType offset, SizeType size, UINT64 fenceValue)
-            : offset(offset)
-            , size(size)
-            , fenceValue(fenceValue)
-        {
-        }
+    using StaleDescriptorQueue = std::queue<StaleDescriptorInfo>;
 
-        // The offset within the descriptor heap.
-        OffsetType offset;
-        // The number of descriptors
-        SizeType size;
-        // The fence value that GPU execution using this descriptor ends
-        UINT64 fenceValue;
-    };
+    // Index of the list that holds blocks of given size
+    static void MapInsert(SizeType size, UINT32& firstLevel, UINT32& secondLevel);
+    // Index of the first list whose blocks are all at least given size
+    static void MapSearch(SizeType size, UINT32& firstLevel, UINT32& secondLevel);
 
-    using StaleDescriptorQueue = std::queue<StaleDescriptorInfo>;
+    OffsetType FindFreeBlock(SizeType size) const;
+    void RemoveFreeBlock(OffsetType offset);
 
-    // bidirectional map
-    FreeListByOffset m_freeListByOffset;
-    FreeListBySize m_freeListBySize;
+    std::vector<BlockTag> m_blockTags; // One per descriptor in the heap
+
+    // Bit n of m_firstLevelBitmap is set if any list of m_secondLevelBitmaps[n] is not empty.
+    UINT32 m_firstLevelBitmap = 0;
+    std::array<UINT32, FirstLevelCount> m_secondLevelBitmaps = {};
+    std::array<std::array<OffsetType, SecondLevelCount>, FirstLevelCount> m_freeListHeads;
 
     StaleDescriptorQueue m_staleDescriptors;
 
@@ -101,4 +123,6 @@ private:
     UINT32 m_numFreeHandles;
 
     std::mutex m_allocationMutex;
+
+    DescriptorAllocator* m_pAllocator;
 };
@@ -0,0 +1,52 @@
+#include "pch.h"
+
+#include "DescriptorTableCache.h"
+
+#include "Utility.h"
+
+bool DescriptorTableCache::Find(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, std::size_t hash, D3D12_GPU_DESCRIPTOR_HANDLE& gpuHandle) const
+{
+    for (const auto& entry : m_entries)
+    {
+        if (!entry.isValid || entry.hash != hash || entry.handles.size() != numHandles)
+            continue;
+
+        bool isSame = true;
+        for (UINT32 i = 0; i < numHandles && isSame; ++i)
+            isSame = entry.handles[i].ptr == pHandles[i].ptr;
+
+        if (isSame)
+        {
+            gpuHandle = entry.gpuHandle;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DescriptorTableCache::Insert(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, std::size_t hash, D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle)
+{
+    Entry& entry = m_entries[m_nextEntry];
+    m_nextEntry = (m_nextEntry + 1) % NumEntries;
+
+    entry.isValid = true;
+    entry.hash = hash;
+    entry.handles.assign(pHandles, pHandles + numHandles);
+    entry.gpuHandle = gpuHandle;
+}
+
+void DescriptorTableCache::Clear()
+{
+    for (auto& entry : m_entries)
+        entry.isValid = false;
+    m_nextEntry = 0;
+}
+
+std::size_t DescriptorTableCache::Hash(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles)
+{
+    std::size_t seed = numHandles;
+    for (UINT32 i = 0; i < numHandles; ++i)
+        Utility::HashCombine(seed, pHandles[i].ptr);
+    return seed;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <basetsd.h>
+#include <d3d12.h>
+
+// Maps the CPU handles staged for a descriptor table to the GPU visible range they were last copied to.
+// Keyed by handles, not descriptor contents, so clear it when descriptors are rewritten in place.
+// Does not touch the device. The owner clears it when the range it points to may be reused.
+class DescriptorTableCache
+{
+public:
+    DescriptorTableCache(const DescriptorTableCache&) = delete;
+    DescriptorTableCache& operator=(const DescriptorTableCache&) = delete;
+    DescriptorTableCache(DescriptorTableCache&&) = delete;
+    DescriptorTableCache& operator=(DescriptorTableCache&&) = delete;
+
+    DescriptorTableCache() = default;
+    ~DescriptorTableCache() = default;
+
+    // Hashed once by the caller and passed to both Find and Insert on a miss.
+    static std::size_t Hash(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles);
+
+    bool Find(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, std::size_t hash, D3D12_GPU_DESCRIPTOR_HANDLE& gpuHandle) const;
+    void Insert(const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, std::size_t hash, D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle);
+    void Clear();
+
+private:
+    static constexpr UINT32 NumEntries = 16;
+
+    struct Entry
+    {
+        bool isValid = false;
+        std::size_t hash = 0;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> handles; // Compared on hit, so hash collisions never rebind a wrong range
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+    };
+
+    std::array<Entry, NumEntries> m_entries;
+    UINT32 m_nextEntry = 0; // Replaced in round robin
+};
@@ -0,0 +1,126 @@
+#include "pch.h"
+
+#include "DrawList.h"
+
+#include <cstring>
+
+namespace
+{
+constexpr UINT MeshBits = 16;
+constexpr UINT MaterialBits = 16;
+constexpr UINT DepthBits = 19;
+constexpr UINT PathBits = 1;
+constexpr UINT PsoBits = 8;
+constexpr UINT PassBits = 4;
+
+static_assert(MeshBits + MaterialBits + DepthBits + PathBits + PsoBits + PassBits == 64);
+
+UINT64 Field(UINT value, UINT bits, UINT shift)
+{
+    return (static_cast<UINT64>(value) & ((1ull << bits) - 1)) << shift;
+}
+} // namespace
+
+UINT64 DrawList::MakeKey(PassType passType, UINT psoIndex, RenderingPath path, UINT material, UINT mesh, UINT depth)
+{
+    UINT shift = 0;
+
+    UINT64 key = Field(mesh, MeshBits, shift);
+    shift += MeshBits;
+    key |= Field(material, MaterialBits, shift);
+    shift += MaterialBits;
+    key |= Field(depth, DepthBits, shift);
+    shift += DepthBits;
+    key |= Field(static_cast<UINT>(path), PathBits, shift);
+    shift += PathBits;
+    key |= Field(psoIndex, PsoBits, shift);
+    shift += PsoBits;
+    key |= Field(static_cast<UINT>(passType), PassBits, shift);
+
+    return key;
+}
+
+UINT DrawList::QuantizeDepth(float viewDepth)
+{
+    // Also maps -0.0 and NaN to 0.
+    if (!(viewDepth > 0.0f))
+        return 0;
+
+    UINT32 bits;
+    std::memcpy(&bits, &viewDepth, sizeof(bits));
+
+    // Sign bit is 0, so 31 bits are significant.
+    return bits >> (31 - DepthBits);
+}
+
+void DrawList::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    const UINT count = static_cast<UINT>(entries.size());
+    if (count < 2)
+        return;
+
+    scratch.resize(count);
+
+    // Histograms of all 8 digits in one pass over the keys
+    UINT histograms[8][256] = {};
+    for (const auto& entry : entries)
+    {
+        for (UINT digit = 0; digit < 8; ++digit)
+            ++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+    }
+
+    auto* pSrc = &entries;
+    auto* pDst = &scratch;
+
+    for (UINT digit = 0; digit < 8; ++digit)
+    {
+        auto& histogram = histograms[digit];
+
+        // All keys share this digit. Order would not change.
+        if (histogram[((*pSrc)[0].key >> (digit * 8)) & 0xFF] == count)
+            continue;
+
+        UINT offset = 0;
+        for (UINT bucket = 0; bucket < 256; ++bucket)
+        {
+            UINT bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (const auto& entry : *pSrc)
+            (*pDst)[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+
+        std::swap(pSrc, pDst);
+    }
+
+    if (pSrc != &entries)
+        entries.swap(scratch);
+}
+
+void DrawList::Clear()
+{
+    m_entries.clear();
+    m_packets.clear();
+}
+
+void DrawList::Add(UINT64 key, const DrawPacket& packet)
+{
+    m_entries.push_back({key, static_cast<UINT>(m_packets.size())});
+    m_packets.push_back(packet);
+}
+
+void DrawList::Sort()
+{
+    RadixSort(m_entries, m_scratch);
+}
+
+UINT DrawList::GetCount() const
+{
+    return static_cast<UINT>(m_entries.size());
+}
+
+const DrawPacket& DrawList::GetPacket(UINT idx) const
+{
+    return m_packets[m_entries[idx].index];
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include <basetsd.h>
+#include <minwindef.h>
+
+#include "CacheKeys.h"
+#include "Material.h"
+#include "SceneHandles.h"
+
+struct InstanceRange
+{
+    UINT offset; // offset in instance buffer
+    UINT forwardCount;
+    UINT deferredCount;
+    float depth; // view depth of the nearest instance. 0 if the view is not sorted by depth.
+};
+
+struct DrawPacket
+{
+    MeshHandle mesh;
+    InstanceRange range;
+};
+
+// Draw packets of one pass, ordered by 64-bit sort key.
+// Key layout from MSB : pass(4) | pso(8) | path(1) | depth(19) | material(16) | mesh(16)
+// Instanced draws have one packet per mesh, so depth is placed above material and mesh to take effect.
+class DrawList
+{
+public:
+    struct SortEntry
+    {
+        UINT64 key;
+        UINT index;
+    };
+
+    // Instanced draws resolve material per instance, so they pass 0 as material.
+    static UINT64 MakeKey(PassType passType, UINT psoIndex, RenderingPath path, UINT material, UINT mesh, UINT depth);
+
+    // Non-negative float bits are monotonic, so dropping low mantissa bits keeps the order.
+    // Precision is relative to depth, higher near the camera. Returns 19 bits.
+    static UINT QuantizeDepth(float viewDepth);
+
+    // Stable LSD radix sort by key, 8 bits per pass.
+    // Passes where every key has the same digit are skipped.
+    static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+    void Clear();
+    void Add(UINT64 key, const DrawPacket& packet);
+    void Sort();
+
+    UINT GetCount() const;
+
+    // In sorted order
+    const DrawPacket& GetPacket(UINT idx) const;
+
+private:
+    std::vector<SortEntry> m_entries;
+    std::vector<SortEntry> m_scratch;
+    std::vector<DrawPacket> m_packets;
+};
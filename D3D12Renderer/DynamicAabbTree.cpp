@@ -0,0 +1,704 @@
+#include "pch.h"
+
+#include "DynamicAabbTree.h"
+
+using namespace DirectX;
+
+DynamicAabbTree::DynamicAabbTree(float margin)
+    : m_margin(margin)
+{
+}
+
+UINT DynamicAabbTree::CreateProxy(const BoundingBox& box, EntityHandle entity)
+{
+    UINT proxyId = AllocateNode();
+
+    Node& node = m_nodes[proxyId];
+    node.aabb = Fatten(FromBox(box));
+    node.entity = entity;
+    node.height = 0;
+
+    InsertLeaf(proxyId);
+    ++m_proxyCount;
+
+    return proxyId;
+}
+
+void DynamicAabbTree::DestroyProxy(UINT proxyId)
+{
+    assert(proxyId < m_nodes.size());
+    assert(m_nodes[proxyId].IsLeaf());
+
+    RemoveLeaf(proxyId);
+    FreeNode(proxyId);
+    --m_proxyCount;
+}
+
+bool DynamicAabbTree::MoveProxy(UINT proxyId, const BoundingBox& box)
+{
+    assert(proxyId < m_nodes.size());
+    assert(m_nodes[proxyId].IsLeaf());
+
+    Aabb tight = FromBox(box);
+    Aabb& fat = m_nodes[proxyId].aabb;
+
+    if (Contains(fat, tight))
+        return false;
+
+    if (Overlaps(fat, tight))
+    {
+        // Moved a bit. Enlarge leaf and refit ancestors in place.
+        fat = Fatten(tight);
+        Refit(m_nodes[proxyId].parent);
+    }
+    else
+    {
+        // Teleported. Refitting would inflate every ancestor, so reinsert.
+        RemoveLeaf(proxyId);
+        fat = Fatten(tight);
+        InsertLeaf(proxyId);
+    }
+
+    return true;
+}
+
+EntityHandle DynamicAabbTree::GetEntity(UINT proxyId) const
+{
+    assert(proxyId < m_nodes.size());
+    return m_nodes[proxyId].entity;
+}
+
+BoundingBox DynamicAabbTree::GetFatBox(UINT proxyId) const
+{
+    assert(proxyId < m_nodes.size());
+    return ToBox(m_nodes[proxyId].aabb);
+}
+
+void DynamicAabbTree::QueryAabb(const BoundingBox& box, std::vector<EntityHandle>& out) const
+{
+    if (m_root == NullNode)
+        return;
+
+    Aabb query = FromBox(box);
+
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        UINT nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[nodeId];
+        if (!Overlaps(node.aabb, query))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.entity);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicAabbTree::QuerySphere(const BoundingSphere& sphere, std::vector<EntityHandle>& out) const
+{
+    if (m_root == NullNode)
+        return;
+
+    XMVECTOR center = XMLoadFloat3(&sphere.Center);
+    XMVECTOR radiusSq = XMVectorReplicate(sphere.Radius * sphere.Radius);
+
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        UINT nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[nodeId];
+
+        // Squared distance from center to AABB
+        XMVECTOR lower = XMLoadFloat3(&node.aabb.lower);
+        XMVECTOR upper = XMLoadFloat3(&node.aabb.upper);
+        XMVECTOR d = XMVectorAdd(
+            XMVectorMax(XMVectorSubtract(lower, center), XMVectorZero()),
+            XMVectorMax(XMVectorSubtract(center, upper), XMVectorZero()));
+
+        if (XMVector3Greater(XMVector3LengthSq(d), radiusSq))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.entity);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicAabbTree::QueryFrustum(const BoundingFrustum& frustum, std::vector<EntityHandle>& out) const
+{
+    if (m_root == NullNode)
+        return;
+
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        UINT nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[nodeId];
+
+        ContainmentType containment = frustum.Contains(ToBox(node.aabb));
+        if (containment == DISJOINT)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.entity);
+        }
+        else if (containment == CONTAINS)
+        {
+            // Whole subtree is inside. No need to test any further.
+            CollectLeaves(nodeId, out);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicAabbTree::RayCast(FXMVECTOR origin, FXMVECTOR direction, float maxDistance, std::vector<RayHit>& out) const
+{
+    if (m_root == NullNode)
+        return;
+
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        UINT nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[nodeId];
+
+        float distance;
+        if (!ToBox(node.aabb).Intersects(origin, direction, distance) || distance > maxDistance)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            // Distance is negative when the origin is inside.
+            out.push_back({node.entity, std::max(distance, 0.0f)});
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+UINT DynamicAabbTree::GetProxyCount() const
+{
+    return m_proxyCount;
+}
+
+UINT DynamicAabbTree::GetHeight() const
+{
+    return m_root == NullNode ? 0 : static_cast<UINT>(m_nodes[m_root].height);
+}
+
+float DynamicAabbTree::GetAreaRatio() const
+{
+    if (m_root == NullNode)
+        return 0.0f;
+
+    float rootArea = Area(m_nodes[m_root].aabb);
+    if (rootArea == 0.0f)
+        return 0.0f;
+
+    float totalArea = 0.0f;
+    for (const auto& node : m_nodes)
+    {
+        if (node.height <= 0)
+            continue;
+        totalArea += Area(node.aabb);
+    }
+
+    return totalArea / rootArea;
+}
+
+DynamicAabbTree::Aabb DynamicAabbTree::Union(const Aabb& a, const Aabb& b)
+{
+    Aabb ret;
+    XMStoreFloat3(&ret.lower, XMVectorMin(XMLoadFloat3(&a.lower), XMLoadFloat3(&b.lower)));
+    XMStoreFloat3(&ret.upper, XMVectorMax(XMLoadFloat3(&a.upper), XMLoadFloat3(&b.upper)));
+    return ret;
+}
+
+bool DynamicAabbTree::Contains(const Aabb& outer, const Aabb& inner)
+{
+    return XMVector3LessOrEqual(XMLoadFloat3(&outer.lower), XMLoadFloat3(&inner.lower)) &&
+           XMVector3LessOrEqual(XMLoadFloat3(&inner.upper), XMLoadFloat3(&outer.upper));
+}
+
+bool DynamicAabbTree::Overlaps(const Aabb& a, const Aabb& b)
+{
+    return XMVector3LessOrEqual(XMLoadFloat3(&a.lower), XMLoadFloat3(&b.upper)) &&
+           XMVector3LessOrEqual(XMLoadFloat3(&b.lower), XMLoadFloat3(&a.upper));
+}
+
+float DynamicAabbTree::Area(const Aabb& a)
+{
+    // Half of surface area. Constant factor does not matter for comparison.
+    float dx = a.upper.x - a.lower.x;
+    float dy = a.upper.y - a.lower.y;
+    float dz = a.upper.z - a.lower.z;
+    return dx * dy + dy * dz + dz * dx;
+}
+
+DynamicAabbTree::Aabb DynamicAabbTree::FromBox(const BoundingBox& box)
+{
+    XMVECTOR center = XMLoadFloat3(&box.Center);
+    XMVECTOR extents = XMLoadFloat3(&box.Extents);
+
+    Aabb ret;
+    XMStoreFloat3(&ret.lower, XMVectorSubtract(center, extents));
+    XMStoreFloat3(&ret.upper, XMVectorAdd(center, extents));
+    return ret;
+}
+
+BoundingBox DynamicAabbTree::ToBox(const Aabb& a)
+{
+    XMVECTOR lower = XMLoadFloat3(&a.lower);
+    XMVECTOR upper = XMLoadFloat3(&a.upper);
+
+    BoundingBox ret;
+    XMStoreFloat3(&ret.Center, XMVectorScale(XMVectorAdd(lower, upper), 0.5f));
+    XMStoreFloat3(&ret.Extents, XMVectorScale(XMVectorSubtract(upper, lower), 0.5f));
+    return ret;
+}
+
+DynamicAabbTree::Aabb DynamicAabbTree::Fatten(const Aabb& a) const
+{
+    XMVECTOR margin = XMVectorReplicate(m_margin);
+
+    Aabb ret;
+    XMStoreFloat3(&ret.lower, XMVectorSubtract(XMLoadFloat3(&a.lower), margin));
+    XMStoreFloat3(&ret.upper, XMVectorAdd(XMLoadFloat3(&a.upper), margin));
+    return ret;
+}
+
+UINT DynamicAabbTree::AllocateNode()
+{
+    if (m_freeList == NullNode)
+    {
+        m_nodes.emplace_back();
+        return static_cast<UINT>(m_nodes.size() - 1);
+    }
+
+    UINT nodeId = m_freeList;
+    m_freeList = m_nodes[nodeId].parent;
+    m_nodes[nodeId] = Node();
+    return nodeId;
+}
+
+void DynamicAabbTree::FreeNode(UINT nodeId)
+{
+    m_nodes[nodeId] = Node();
+    m_nodes[nodeId].parent = m_freeList;
+    m_freeList = nodeId;
+}
+
+void DynamicAabbTree::InsertLeaf(UINT leaf)
+{
+    if (m_root == NullNode)
+    {
+        m_root = leaf;
+        m_nodes[m_root].parent = NullNode;
+        return;
+    }
+
+    // Find the best sibling by SAH.
+    // Cost of making a node the sibling = area of new parent + area increase of all ancestors.
+    const Aabb leafAabb = m_nodes[leaf].aabb;
+    UINT index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+        const Node& node = m_nodes[index];
+
+        float area = Area(node.aabb);
+        float combinedArea = Area(Union(node.aabb, leafAabb));
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](UINT child)
+        {
+            const Node& childNode = m_nodes[child];
+            float newArea = Area(Union(leafAabb, childNode.aabb));
+            if (childNode.IsLeaf())
+                return newArea + inheritanceCost;
+            return newArea - Area(childNode.aabb) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    UINT sibling = index;
+
+    // Create a new parent.
+    UINT oldParent = m_nodes[sibling].parent;
+    UINT newParent = AllocateNode();
+
+    Node& parentNode = m_nodes[newParent];
+    parentNode.parent = oldParent;
+    parentNode.aabb = Union(leafAabb, m_nodes[sibling].aabb);
+    parentNode.height = m_nodes[sibling].height + 1;
+    parentNode.child1 = sibling;
+    parentNode.child2 = leaf;
+
+    if (oldParent != NullNode)
+    {
+        if (m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        m_root = newParent;
+    }
+
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    Refit(m_nodes[leaf].parent);
+}
+
+void DynamicAabbTree::RemoveLeaf(UINT leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NullNode;
+        return;
+    }
+
+    UINT parent = m_nodes[leaf].parent;
+    UINT grandParent = m_nodes[parent].parent;
+    UINT sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grandParent != NullNode)
+    {
+        // Destroy parent and connect sibling to grand parent.
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+
+        m_nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+
+        Refit(grandParent);
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = NullNode;
+        FreeNode(parent);
+    }
+
+    m_nodes[leaf].parent = NullNode;
+}
+
+void DynamicAabbTree::Refit(UINT nodeId)
+{
+    while (nodeId != NullNode)
+    {
+        Node& node = m_nodes[nodeId];
+        const Node& child1 = m_nodes[node.child1];
+        const Node& child2 = m_nodes[node.child2];
+
+        node.aabb = Union(child1.aabb, child2.aabb);
+        node.height = 1 + std::max(child1.height, child2.height);
+
+        RotateNodes(nodeId);
+
+        nodeId = m_nodes[nodeId].parent;
+    }
+}
+
+// Try swapping a child of A with a grand child, and keep the one that reduces the area of the changed child most.
+// Rotations do not change the AABB of A itself.
+//
+//       A
+//     /   \
+//    B     C
+//   / \   / \
+//  D   E F   G
+void DynamicAabbTree::RotateNodes(UINT iA)
+{
+    Node& A = m_nodes[iA];
+    if (A.height < 2)
+        return;
+
+    UINT iB = A.child1;
+    UINT iC = A.child2;
+    Node& B = m_nodes[iB];
+    Node& C = m_nodes[iC];
+
+    if (B.height == 0)
+    {
+        // B is a leaf and C is internal.
+        assert(C.height > 0);
+
+        UINT iF = C.child1;
+        UINT iG = C.child2;
+        Node& F = m_nodes[iF];
+        Node& G = m_nodes[iG];
+
+        float costBase = Area(C.aabb);
+
+        // Cost of swapping B and F
+        Aabb aabbBG = Union(B.aabb, G.aabb);
+        float costBF = Area(aabbBG);
+
+        // Cost of swapping B and G
+        Aabb aabbBF = Union(B.aabb, F.aabb);
+        float costBG = Area(aabbBF);
+
+        if (costBase < costBF && costBase < costBG)
+            return;
+
+        if (costBF < costBG)
+        {
+            A.child1 = iF;
+            C.child1 = iB;
+            B.parent = iC;
+            F.parent = iA;
+
+            C.aabb = aabbBG;
+            C.height = 1 + std::max(B.height, G.height);
+            A.height = 1 + std::max(C.height, F.height);
+        }
+        else
+        {
+            A.child1 = iG;
+            C.child2 = iB;
+            B.parent = iC;
+            G.parent = iA;
+
+            C.aabb = aabbBF;
+            C.height = 1 + std::max(B.height, F.height);
+            A.height = 1 + std::max(C.height, G.height);
+        }
+    }
+    else if (C.height == 0)
+    {
+        // C is a leaf and B is internal.
+        UINT iD = B.child1;
+        UINT iE = B.child2;
+        Node& D = m_nodes[iD];
+        Node& E = m_nodes[iE];
+
+        float costBase = Area(B.aabb);
+
+        // Cost of swapping C and D
+        Aabb aabbCE = Union(C.aabb, E.aabb);
+        float costCD = Area(aabbCE);
+
+        // Cost of swapping C and E
+        Aabb aabbCD = Union(C.aabb, D.aabb);
+        float costCE = Area(aabbCD);
+
+        if (costBase < costCD && costBase < costCE)
+            return;
+
+        if (costCD < costCE)
+        {
+            A.child2 = iD;
+            B.child1 = iC;
+            C.parent = iB;
+            D.parent = iA;
+
+            B.aabb = aabbCE;
+            B.height = 1 + std::max(C.height, E.height);
+            A.height = 1 + std::max(B.height, D.height);
+        }
+        else
+        {
+            A.child2 = iE;
+            B.child2 = iC;
+            C.parent = iB;
+            E.parent = iA;
+
+            B.aabb = aabbCD;
+            B.height = 1 + std::max(C.height, D.height);
+            A.height = 1 + std::max(B.height, E.height);
+        }
+    }
+    else
+    {
+        UINT iD = B.child1;
+        UINT iE = B.child2;
+        UINT iF = C.child1;
+        UINT iG = C.child2;
+        Node& D = m_nodes[iD];
+        Node& E = m_nodes[iE];
+        Node& F = m_nodes[iF];
+        Node& G = m_nodes[iG];
+
+        float areaB = Area(B.aabb);
+        float areaC = Area(C.aabb);
+        float costBase = areaB + areaC;
+
+        enum class Rotation
+        {
+            NONE,
+            BF,
+            BG,
+            CD,
+            CE
+        };
+
+        Rotation bestRotation = Rotation::NONE;
+        float bestCost = costBase;
+
+        // Cost of swapping B and F
+        Aabb aabbBG = Union(B.aabb, G.aabb);
+        float costBF = areaB + Area(aabbBG);
+        if (costBF < bestCost)
+        {
+            bestRotation = Rotation::BF;
+            bestCost = costBF;
+        }
+
+        // Cost of swapping B and G
+        Aabb aabbBF = Union(B.aabb, F.aabb);
+        float costBG = areaB + Area(aabbBF);
+        if (costBG < bestCost)
+        {
+            bestRotation = Rotation::BG;
+            bestCost = costBG;
+        }
+
+        // Cost of swapping C and D
+        Aabb aabbCE = Union(C.aabb, E.aabb);
+        float costCD = areaC + Area(aabbCE);
+        if (costCD < bestCost)
+        {
+            bestRotation = Rotation::CD;
+            bestCost = costCD;
+        }
+
+        // Cost of swapping C and E
+        Aabb aabbCD = Union(C.aabb, D.aabb);
+        float costCE = areaC + Area(aabbCD);
+        if (costCE < bestCost)
+        {
+            bestRotation = Rotation::CE;
+            bestCost = costCE;
+        }
+
+        switch (bestRotation)
+        {
+        case Rotation::NONE:
+            break;
+
+        case Rotation::BF:
+            A.child1 = iF;
+            C.child1 = iB;
+            B.parent = iC;
+            F.parent = iA;
+
+            C.aabb = aabbBG;
+            C.height = 1 + std::max(B.height, G.height);
+            A.height = 1 + std::max(C.height, F.height);
+            break;
+
+        case Rotation::BG:
+            A.child1 = iG;
+            C.child2 = iB;
+            B.parent = iC;
+            G.parent = iA;
+
+            C.aabb = aabbBF;
+            C.height = 1 + std::max(B.height, F.height);
+            A.height = 1 + std::max(C.height, G.height);
+            break;
+
+        case Rotation::CD:
+            A.child2 = iD;
+            B.child1 = iC;
+            C.parent = iB;
+            D.parent = iA;
+
+            B.aabb = aabbCE;
+            B.height = 1 + std::max(C.height, E.height);
+            A.height = 1 + std::max(B.height, D.height);
+            break;
+
+        case Rotation::CE:
+            A.child2 = iE;
+            B.child2 = iC;
+            C.parent = iB;
+            E.parent = iA;
+
+            B.aabb = aabbCD;
+            B.height = 1 + std::max(C.height, D.height);
+            A.height = 1 + std::max(B.height, E.height);
+            break;
+        }
+    }
+}
+
+void DynamicAabbTree::CollectLeaves(UINT nodeId, std::vector<EntityHandle>& out) const
+{
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(nodeId);
+
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.entity);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
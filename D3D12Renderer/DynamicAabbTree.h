@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <minwindef.h>
+
+#include "SceneHandles.h"
+
+// Incrementally maintained bounding volume hierarchy of world space AABBs.
+// Leaves store fattened AABBs, so small movements do not touch the tree at all.
+// Tree quality is kept by surface area heuristic (SAH) on insertion and by tree rotations on the way up.
+// Queries test fat AABBs, so results are conservative.
+class DynamicAabbTree
+{
+public:
+    static constexpr UINT NullNode = UINT_MAX;
+
+    struct RayHit
+    {
+        EntityHandle entity;
+        float distance;
+    };
+
+    explicit DynamicAabbTree(float margin = 0.1f);
+
+    UINT CreateProxy(const DirectX::BoundingBox& box, EntityHandle entity);
+    void DestroyProxy(UINT proxyId);
+
+    // Returns false if fat AABB still contains the box.
+    // Small movements are refit in place. Leaves moved out of their old fat AABB are reinserted.
+    bool MoveProxy(UINT proxyId, const DirectX::BoundingBox& box);
+
+    EntityHandle GetEntity(UINT proxyId) const;
+    DirectX::BoundingBox GetFatBox(UINT proxyId) const;
+
+    // Append entities whose fat AABB overlaps the volume.
+    void QueryAabb(const DirectX::BoundingBox& box, std::vector<EntityHandle>& out) const;
+    void QuerySphere(const DirectX::BoundingSphere& sphere, std::vector<EntityHandle>& out) const;
+    void QueryFrustum(const DirectX::BoundingFrustum& frustum, std::vector<EntityHandle>& out) const;
+
+    // direction should be normalized. Hits are not sorted.
+    void RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, std::vector<RayHit>& out) const;
+
+    UINT GetProxyCount() const;
+    UINT GetHeight() const;
+
+    // Sum of internal node areas divided by root area. Lower is better.
+    float GetAreaRatio() const;
+
+private:
+    struct Aabb
+    {
+        DirectX::XMFLOAT3 lower;
+        DirectX::XMFLOAT3 upper;
+    };
+
+    struct Node
+    {
+        Aabb aabb;
+
+        UINT parent = NullNode; // Next free node when the node is in free list
+        UINT child1 = NullNode;
+        UINT child2 = NullNode;
+
+        // Leaf = 0, free node = -1
+        int height = -1;
+
+        EntityHandle entity;
+
+        bool IsLeaf() const
+        {
+            return child1 == NullNode;
+        }
+    };
+
+    static Aabb Union(const Aabb& a, const Aabb& b);
+    static bool Contains(const Aabb& outer, const Aabb& inner);
+    static bool Overlaps(const Aabb& a, const Aabb& b);
+    static float Area(const Aabb& a);
+    static Aabb FromBox(const DirectX::BoundingBox& box);
+    static DirectX::BoundingBox ToBox(const Aabb& a);
+
+    Aabb Fatten(const Aabb& a) const;
+
+    UINT AllocateNode();
+    void FreeNode(UINT nodeId);
+
+    void InsertLeaf(UINT leaf);
+    void RemoveLeaf(UINT leaf);
+
+    // Recompute AABBs and heights from the node to the root, rotating each ancestor.
+    void Refit(UINT nodeId);
+    void RotateNodes(UINT nodeId);
+
+    void CollectLeaves(UINT nodeId, std::vector<EntityHandle>& out) const;
+
+    float m_margin;
+
+    UINT m_root = NullNode;
+
+    std::vector<Node> m_nodes;
+    UINT m_freeList = NullNode;
+    UINT m_proxyCount = 0;
+};
@@ -8,17 +8,24 @@
 using Microsoft::WRL::ComPtr;
 using namespace D3DHelper;
 
-void DynamicDescriptorHeap::Init(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE heapType)
+void DynamicDescriptorHeap::Init(ID3D12Device* pDevice, ID3D12DescriptorHeap* pDescriptorHeap, UINT firstDescriptor, UINT numDescriptors)
 {
     m_pDevice = pDevice;
-    m_heapType = heapType;
+    m_pDescriptorHeap = pDescriptorHeap;
+    m_heapType = pDescriptorHeap->GetDesc().Type;
     m_descriptorHandleIncrementSize = pDevice->GetDescriptorHandleIncrementSize(m_heapType);
 
-    // Allocate first descriptor heap
-    m_currentHeap = RequestDescriptorHeap();
-    m_currentCpuDescriptorHandle = m_currentHeap->GetCPUDescriptorHandleForHeapStart();
-    m_currentGpuDescriptorHandle = m_currentHeap->GetGPUDescriptorHandleForHeapStart();
-    m_numFreeHandles = NumDescriptorsPerHeap;
+    m_firstDescriptor = firstDescriptor;
+    m_numPages = numDescriptors / NumDescriptorsPerPage;
+    assert(m_numPages > 0);
+    for (UINT i = 0; i < m_numPages; ++i)
+        m_availablePages.push(i);
+
+    // Take first page
+    m_currentPage = RequestPage();
+    m_currentCpuDescriptorHandle = GetCpuDescriptorHandle(m_pDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), m_firstDescriptor + m_currentPage * NumDescriptorsPerPage, m_descriptorHandleIncrementSize);
+    m_currentGpuDescriptorHandle = GetGpuDescriptorHandle(m_pDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), m_firstDescriptor + m_currentPage * NumDescriptorsPerPage, m_descriptorHandleIncrementSize);
+    m_numFreeHandles = NumDescriptorsPerPage;
 }
 
 void DynamicDescriptorHeap::ParseRootSignature(const RootSignature& rootSignature)
@@ -31,6 +38,20 @@ void DynamicDescriptorHeap::ParseRootSignature(const RootSignature& rootSignatur
 
     m_currentOffset = 0;
     m_numParameters = rootSignature.GetNumParameters();
+
+    m_cacheableDescriptorTableBitMask = 0;
+    m_tableCache.Clear();
+}
+
+void DynamicDescriptorHeap::EnableTableCache(UINT32 rootParameterIndex)
+{
+    assert(m_descriptorTableBitMask & (1 << rootParameterIndex));
+    m_cacheableDescriptorTableBitMask |= (1 << rootParameterIndex);
+}
+
+void DynamicDescriptorHeap::InvalidateTableCache()
+{
+    m_tableCache.Clear();
 }
 
 // Staging new parameters MUST be done in ascending order of parameter index.
@@ -45,7 +66,7 @@ void DynamicDescriptorHeap::StageDescriptors(UINT32 rootParameterIndex, UINT32 o
     bool isLastStaged = true;
 
     UINT start = isNewParameter ? m_currentOffset + offsetInParameter : entry.Offset + offsetInParameter;
-    UINT upperLimit = NumDescriptorsPerHeap;
+    UINT upperLimit = NumDescriptorsPerPage;
 
     // If given index is not last, check that next table is staged
     if (rootParameterIndex < m_numParameters - 1)
@@ -104,90 +125,87 @@ UINT32 DynamicDescriptorHeap::ComputeStaleDescriptorCount() const
     return numStaleDescriptors;
 }
 
-ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap()
+UINT DynamicDescriptorHeap::RequestPage()
 {
-    while (!m_pendingHeaps.empty() && m_pendingHeaps.front().first <= m_completedFenceValue)
+    while (!m_pendingPages.empty() && m_pendingPages.front().first <= m_completedFenceValue)
     {
-        m_availableHeaps.push(m_pendingHeaps.front().second);
-        m_pendingHeaps.pop();
+        m_availablePages.push(m_pendingPages.front().second);
+        m_pendingPages.pop();
     }
 
-    ID3D12DescriptorHeap* pDescriptorHeap;
-    if (!m_availableHeaps.empty())
-    {
-        pDescriptorHeap = m_availableHeaps.front();
-        m_availableHeaps.pop();
-    }
-    else
-    {
-        D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-        heapDesc.Type = m_heapType;
-        heapDesc.NumDescriptors = NumDescriptorsPerHeap;
-        heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-        ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-        ThrowIfFailed(m_pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&descriptorHeap)));
-        pDescriptorHeap = descriptorHeap.Get();
-        m_heapPool.push_back(std::move(descriptorHeap));
-    }
+    // Pages can not be added without switching heaps, which would unbind the persistent descriptors.
+    if (m_availablePages.empty())
+        throw std::runtime_error("Every dynamic descriptor page is still in use by the GPU.");
 
-    return pDescriptorHeap;
+    UINT page = m_availablePages.front();
+    m_availablePages.pop();
+    return page;
 }
 
-bool DynamicDescriptorHeap::CheckHeapChanged()
+void DynamicDescriptorHeap::ReservePage(UINT32 numDescriptors)
 {
-    // Compute the number of descriptors that need to be copied
-    UINT32 numDescriptorsToCommit = ComputeStaleDescriptorCount();
-
-    if (numDescriptorsToCommit > 0)
-    {
-        if (m_numFreeHandles < numDescriptorsToCommit)
-        {
-            m_retiredHeaps.push_back(m_currentHeap);
-
-            m_currentHeap = RequestDescriptorHeap();
-            m_currentCpuDescriptorHandle = m_currentHeap->GetCPUDescriptorHandleForHeapStart();
-            m_currentGpuDescriptorHandle = m_currentHeap->GetGPUDescriptorHandleForHeapStart();
-            m_numFreeHandles = NumDescriptorsPerHeap;
-
-            // When updating the descriptor heap on the command list, all descriptor
-            // tables must be (re)recopied to the new descriptor heap (not just the stale descriptor tables)
-            m_staleDescriptorTableBitMask = m_descriptorTableBitMask;
-
-            return true;
-        }
-    }
-
-    return false;
+    if (m_numFreeHandles >= numDescriptors)
+        return;
+
+    // Tables committed to the retired page stay valid until its fence completes.
+    // They can not be bound by later commits, since those may execute after the page is reused.
+    m_retiredPages.push_back(m_currentPage);
+    m_tableCache.Clear();
+
+    m_currentPage = RequestPage();
+    m_currentCpuDescriptorHandle = GetCpuDescriptorHandle(m_pDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), m_firstDescriptor + m_currentPage * NumDescriptorsPerPage, m_descriptorHandleIncrementSize);
+    m_currentGpuDescriptorHandle = GetGpuDescriptorHandle(m_pDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), m_firstDescriptor + m_currentPage * NumDescriptorsPerPage, m_descriptorHandleIncrementSize);
+    m_numFreeHandles = NumDescriptorsPerPage;
 }
 
 // Copy all of the staged descriptors to the GPU visible descriptor heap and
 // bind the descriptor heap and the descriptor tables to the command list
 void DynamicDescriptorHeap::CommitStagedDescriptors(ID3D12GraphicsCommandList* pCommandList, std::function<void(ID3D12GraphicsCommandList*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc)
 {
+    ReservePage(ComputeStaleDescriptorCount());
+
     DWORD rootIndex;
     while (_BitScanForward(&rootIndex, m_staleDescriptorTableBitMask))
     {
         UINT numSrcDescriptors = m_descriptorTableEntries[rootIndex].NumDescriptors;
         D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorHandles = &m_descriptorHandleCache[m_descriptorTableEntries[rootIndex].Offset];
 
-        D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStarts[] = {m_currentCpuDescriptorHandle};
-        UINT pDestDescriptorRangeSizes[] = {numSrcDescriptors};
+        bool isCacheable = (m_cacheableDescriptorTableBitMask & (1 << rootIndex)) != 0;
 
-        // Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
-        // Assume that descriptors in m_descriptorHandleCache are discontinuous or reside in different heap.
-        m_pDevice->CopyDescriptors(
-            1, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
-            numSrcDescriptors, pSrcDescriptorHandles, nullptr,
-            m_heapType);
+        std::size_t tableHash = isCacheable ? DescriptorTableCache::Hash(pSrcDescriptorHandles, numSrcDescriptors) : 0;
 
-        // Set the descriptors on the command list using the passed-in setter function.
-        setFunc(pCommandList, rootIndex, m_currentGpuDescriptorHandle);
+        D3D12_GPU_DESCRIPTOR_HANDLE hGpu;
+        if (isCacheable && m_tableCache.Find(pSrcDescriptorHandles, numSrcDescriptors, tableHash, hGpu))
+        {
+            m_numReusedDescriptors += numSrcDescriptors;
+        }
+        else
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStarts[] = {m_currentCpuDescriptorHandle};
+            UINT pDestDescriptorRangeSizes[] = {numSrcDescriptors};
+
+            // Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
+            // Assume that descriptors in m_descriptorHandleCache are discontinuous or reside in different heap.
+            m_pDevice->CopyDescriptors(
+                1, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
+                numSrcDescriptors, pSrcDescriptorHandles, nullptr,
+                m_heapType);
+
+            hGpu = m_currentGpuDescriptorHandle;
+            if (isCacheable)
+                m_tableCache.Insert(pSrcDescriptorHandles, numSrcDescriptors, tableHash, hGpu);
+
+            // Offset current CPU and GPU descriptor handles.
+            m_currentCpuDescriptorHandle = GetCpuDescriptorHandle(m_currentCpuDescriptorHandle, numSrcDescriptors, m_descriptorHandleIncrementSize);
+            m_currentGpuDescriptorHandle = GetGpuDescriptorHandle(m_currentGpuDescriptorHandle, numSrcDescriptors, m_descriptorHandleIncrementSize);
+            m_numFreeHandles -= numSrcDescriptors;
+            m_numCopiedDescriptors += numSrcDescriptors;
+        }
 
-        // Offset current CPU and GPU descriptor handles.
-        m_currentCpuDescriptorHandle = GetCpuDescriptorHandle(m_currentCpuDescriptorHandle, numSrcDescriptors, m_descriptorHandleIncrementSize);
-        m_currentGpuDescriptorHandle = GetGpuDescriptorHandle(m_currentGpuDescriptorHandle, numSrcDescriptors, m_descriptorHandleIncrementSize);
-        m_numFreeHandles -= numSrcDescriptors;
+        // Set the descriptors on the command list using the passed-in setter function.
+        setFunc(pCommandList, rootIndex, hGpu);
+        m_committedGpuDescriptorHandles[rootIndex] = hGpu;
+        m_committedDescriptorTableBitMask |= (1 << rootIndex);
 
         // Flip the stale bit so the descriptor table is not recopied again unless it is updated with a new descriptor
         m_staleDescriptorTableBitMask ^= (1 << rootIndex);
@@ -204,23 +222,21 @@ void DynamicDescriptorHeap::CommitStagedDescriptorsForDispatch(ID3D12GraphicsCom
     CommitStagedDescriptors(pCommandList, &ID3D12GraphicsCommandList::SetComputeRootDescriptorTable);
 }
 
-// Copy a single CPU visible descriptor to a GPU visible descriptor heap
-D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor)
+void DynamicDescriptorHeap::BindCommittedDescriptorsForDraw(ID3D12GraphicsCommandList* pCommandList) const
 {
-    if (m_numFreeHandles < 1)
+    DWORD rootIndex;
+    DWORD committedDescriptorTableBitMask = m_committedDescriptorTableBitMask;
+    while (_BitScanForward(&rootIndex, committedDescriptorTableBitMask))
     {
-        m_retiredHeaps.push_back(m_currentHeap);
-
-        m_currentHeap = RequestDescriptorHeap();
-        m_currentCpuDescriptorHandle = m_currentHeap->GetCPUDescriptorHandleForHeapStart();
-        m_currentGpuDescriptorHandle = m_currentHeap->GetGPUDescriptorHandleForHeapStart();
-        m_numFreeHandles = NumDescriptorsPerHeap;
-
-        ID3D12DescriptorHeap* ppHeaps[] = {m_currentHeap};
-        pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-
-        m_staleDescriptorTableBitMask = m_descriptorTableBitMask;
+        pCommandList->SetGraphicsRootDescriptorTable(rootIndex, m_committedGpuDescriptorHandles[rootIndex]);
+        committedDescriptorTableBitMask ^= (1 << rootIndex);
     }
+}
+
+// Copy a single CPU visible descriptor to a GPU visible descriptor heap
+D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor)
+{
+    ReservePage(1);
 
     D3D12_GPU_DESCRIPTOR_HANDLE hGpu = m_currentGpuDescriptorHandle;
     m_pDevice->CopyDescriptorsSimple(1, m_currentCpuDescriptorHandle, cpuDescriptor, m_heapType);
@@ -228,21 +244,22 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(ID3D12Graphics
     m_currentCpuDescriptorHandle = GetCpuDescriptorHandle(m_currentCpuDescriptorHandle, 1, m_descriptorHandleIncrementSize);
     m_currentGpuDescriptorHandle = GetGpuDescriptorHandle(m_currentGpuDescriptorHandle, 1, m_descriptorHandleIncrementSize);
     m_numFreeHandles -= 1;
+    m_numCopiedDescriptors += 1;
 
     return hGpu;
 }
 
 ID3D12DescriptorHeap* DynamicDescriptorHeap::GetCurrentDescriptorHeap() const
 {
-    assert(m_currentHeap != nullptr);
-    return m_currentHeap;
+    assert(m_pDescriptorHeap != nullptr);
+    return m_pDescriptorHeap;
 }
 
-void DynamicDescriptorHeap::QueueRetiredHeaps(UINT64 signaledFenceValue)
+void DynamicDescriptorHeap::QueueRetiredPages(UINT64 signaledFenceValue)
 {
-    for (auto* pPage : m_retiredHeaps)
-        m_pendingHeaps.push({signaledFenceValue, pPage});
-    m_retiredHeaps.clear();
+    for (UINT page : m_retiredPages)
+        m_pendingPages.push({signaledFenceValue, page});
+    m_retiredPages.clear();
 }
 
 void DynamicDescriptorHeap::UpdateCompletedFenceValue(UINT64 completedFenceValue)
@@ -252,6 +269,11 @@ void DynamicDescriptorHeap::UpdateCompletedFenceValue(UINT64 completedFenceValue
 
 void DynamicDescriptorHeap::Reset()
 {
+    m_lastFrameCopiedDescriptors = m_numCopiedDescriptors;
+    m_lastFrameReusedDescriptors = m_numReusedDescriptors;
+    m_numCopiedDescriptors = 0;
+    m_numReusedDescriptors = 0;
+
     m_currentOffset = 0;
     for (auto& entry : m_descriptorTableEntries)
     {
@@ -259,3 +281,13 @@ void DynamicDescriptorHeap::Reset()
         entry.NumDescriptors = 0;
     }
 }
+
+UINT32 DynamicDescriptorHeap::GetCopiedDescriptorCount() const
+{
+    return m_lastFrameCopiedDescriptors;
+}
+
+UINT32 DynamicDescriptorHeap::GetReusedDescriptorCount() const
+{
+    return m_lastFrameReusedDescriptors;
+}
@@ -11,9 +11,12 @@
 #include <minwindef.h>
 #include <wrl/client.h>
 
+#include "DescriptorTableCache.h"
+
 class RootSignature;
 
 // Staging CPU visible descriptors and committing those descriptors to a GPU visible descriptor heap
+// Pages are carved from a range of a heap that stays bound, so switching pages does not invalidate committed tables.
 // Root constants and root descriptors do not use descriptor heap
 // For multithreading, this class should be modified to use mutex
 class DynamicDescriptorHeap
@@ -28,34 +31,47 @@ public:
     DynamicDescriptorHeap() = default;
     ~DynamicDescriptorHeap() = default;
 
-    void Init(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE heapType);
+    void Init(ID3D12Device* pDevice, ID3D12DescriptorHeap* pDescriptorHeap, UINT firstDescriptor, UINT numDescriptors);
 
     void StageDescriptors(UINT32 rootParameterIndex, UINT32 offsetInParameter, UINT32 numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE baseCpuHandle);
 
-    bool CheckHeapChanged();
-
     void CommitStagedDescriptorsForDraw(ID3D12GraphicsCommandList* pCommandList);
     void CommitStagedDescriptorsForDispatch(ID3D12GraphicsCommandList* pCommandList);
 
+    // Bind tables committed so far to another command list. Copies nothing, so worker threads can call it concurrently.
+    void BindCommittedDescriptorsForDraw(ID3D12GraphicsCommandList* pCommandList) const;
+
     D3D12_GPU_DESCRIPTOR_HANDLE CopyDescriptor(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor);
 
     void ParseRootSignature(const RootSignature& rootSignature);
 
+    // Unchanged handles of the table are rebound to the range they were copied to, while it is in the current page.
+    // Only for tables whose CPU descriptors are not rewritten in place every frame.
+    void EnableTableCache(UINT32 rootParameterIndex);
+    // Call when CPU descriptors of cached tables are rewritten in place, e.g. on resize.
+    void InvalidateTableCache();
+
     ID3D12DescriptorHeap* GetCurrentDescriptorHeap() const;
 
-    void QueueRetiredHeaps(UINT64 signaledFenceValue);
+    void QueueRetiredPages(UINT64 signaledFenceValue);
     void UpdateCompletedFenceValue(UINT64 completedFenceValue);
 
     void Reset();
 
+    // Counts of the last frame, reset by Reset
+    UINT32 GetCopiedDescriptorCount() const;
+    UINT32 GetReusedDescriptorCount() const;
+
 private:
     // A 16-bit mask is used to keep track of the root parameter indices that are descriptor tables
     static constexpr UINT32 MaxDescriptorTables = 16;
-    static constexpr UINT32 NumDescriptorsPerHeap = 1024;
+    static constexpr UINT32 NumDescriptorsPerPage = 1024;
 
     void CommitStagedDescriptors(ID3D12GraphicsCommandList* pCommandList, std::function<void(ID3D12GraphicsCommandList*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc);
 
-    ID3D12DescriptorHeap* RequestDescriptorHeap();
+    // Retires the current page when it has less than numDescriptors left.
+    void ReservePage(UINT32 numDescriptors);
+    UINT RequestPage();
 
     UINT32 ComputeStaleDescriptorCount() const;
 
@@ -74,7 +90,7 @@ private:
     D3D12_DESCRIPTOR_HEAP_TYPE m_heapType;
     UINT32 m_descriptorHandleIncrementSize = 0;
 
-    std::array<D3D12_CPU_DESCRIPTOR_HANDLE, NumDescriptorsPerHeap> m_descriptorHandleCache; // Flat storage for all staged CPU descriptor handles
+    std::array<D3D12_CPU_DESCRIPTOR_HANDLE, NumDescriptorsPerPage> m_descriptorHandleCache; // Flat storage for all staged CPU descriptor handles
     DescriptorTableEntry m_descriptorTableEntries[MaxDescriptorTables];                     // Per-rootParameter metadata: start position and count within m_descriptorHandleCache
     UINT32 m_currentOffset = 0;
     UINT m_numParameters = 0;
@@ -84,16 +100,31 @@ private:
     // Represents a descriptor table in the root signature that has changed since the last time the descriptors were copied
     UINT16 m_staleDescriptorTableBitMask = 0;
 
-    std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_heapPool;
-    std::queue<ID3D12DescriptorHeap*> m_availableHeaps;
+    // Tables whose commits look up m_tableCache first
+    UINT16 m_cacheableDescriptorTableBitMask = 0;
+    DescriptorTableCache m_tableCache;
+
+    UINT32 m_numCopiedDescriptors = 0;
+    UINT32 m_numReusedDescriptors = 0;
+    UINT32 m_lastFrameCopiedDescriptors = 0;
+    UINT32 m_lastFrameReusedDescriptors = 0;
+
+    // Tables committed so far and where they were copied to
+    UINT16 m_committedDescriptorTableBitMask = 0;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_committedGpuDescriptorHandles[MaxDescriptorTables];
+
+    ID3D12DescriptorHeap* m_pDescriptorHeap = nullptr;
+    UINT m_firstDescriptor = 0; // Offset of the first page in the heap
+    UINT m_numPages = 0;
 
-    std::vector<ID3D12DescriptorHeap*> m_retiredHeaps;
-    std::queue<std::pair<UINT64, ID3D12DescriptorHeap*>> m_pendingHeaps;
+    std::queue<UINT> m_availablePages;
+    std::vector<UINT> m_retiredPages;
+    std::queue<std::pair<UINT64, UINT>> m_pendingPages;
 
-    ID3D12DescriptorHeap* m_currentHeap = nullptr;
+    UINT m_currentPage = 0;
     D3D12_GPU_DESCRIPTOR_HANDLE m_currentGpuDescriptorHandle;
     D3D12_CPU_DESCRIPTOR_HANDLE m_currentCpuDescriptorHandle;
-    UINT32 m_numFreeHandles; // Number of free handles in current descriptor heap
+    UINT32 m_numFreeHandles; // Number of free handles in current page
 
     UINT64 m_completedFenceValue = 0;
 
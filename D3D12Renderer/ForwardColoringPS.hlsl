@@ -78,6 +78,9 @@ struct LightConstants
 };
 ConstantBuffer<LightConstants> LightConstantBuffers[] : register(b0, space2);
 
+// Bindless indices of LightConstantBuffers, one per light
+StructuredBuffer<uint> g_lightIndices : register(t0, space8);
+
 // Parallax Occlusion Mapping
 float2 ParallaxMapping(float2 texCoord, float3 toCamera, uint heightMapIdx, uint heightMapSamplerIdx)
 {
@@ -344,7 +347,7 @@ float4 main(PSInput input) : SV_TARGET
     [loop]
     for (uint i = 0; i < numLights; ++i)
     {
-        LightConstants light = LightConstantBuffers[i];
+        LightConstants light = LightConstantBuffers[g_lightIndices[i]];
         
         float shadowFactor;
         
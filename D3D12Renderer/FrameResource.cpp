@@ -5,7 +5,6 @@
 #include "D3DHelper.h"
 #include "DescriptorAllocation.h"
 #include "InstanceData.h"
-#include "UploadAllocation.h"
 #include "Utility.h"
 
 using Microsoft::WRL::ComPtr;
@@ -40,10 +39,6 @@ void FrameResource::Init(
         InitBackBufferRtv();
     }
 
-    auto rtDesc = m_backBuffer.Get()->GetDesc();
-    const UINT64 width = rtDesc.Width;
-    const UINT height = rtDesc.Height;
-
     // Scene color buffers
     {
         auto rtvAllocs = sceneBufferRtvAllocation.Split();
@@ -53,7 +48,6 @@ void FrameResource::Init(
             m_sceneColorBufferRtvs[i] = RenderTargetView(std::move(rtvAllocs[i]));
             m_sceneColorBufferSrvs[i] = ShaderResourceView(std::move(srvAllocs[i]));
         }
-        CreateSceneColorBuffers(width, height);
     }
 
     // GBuffers
@@ -65,22 +59,18 @@ void FrameResource::Init(
             m_gBufferRtvs[i] = RenderTargetView(std::move(rtvAllocs[i]));
             m_gBufferSrvs[i] = ShaderResourceView(std::move(srvAllocs[i]));
         }
-        CreateGBuffers(width, height);
     }
 
-    // Create masks
+    // Masks
     m_selectionMaskRtv = RenderTargetView(std::move(selectionMaskRtvAllocation));
     m_selectionMaskSrv = ShaderResourceView(std::move(selectionMaskSrvAllocation));
     m_horizontalDilatedMaskRtv = RenderTargetView(std::move(horizontalDilatedMaskRtvAllocation));
     m_horizontalDilatedMaskSrv = ShaderResourceView(std::move(horizontalDilatedMaskSrvAllocation));
-    CreateMasks(width, height);
 
     // Create Upload buffer
     m_instanceUploadBuffer = Buffer(m_pDevice, sizeof(InstanceData) * m_instanceCapacity, D3D12_HEAP_TYPE_UPLOAD);
     D3D12_RANGE readRange = {0, 0};
     ThrowIfFailed(m_instanceUploadBuffer.Get()->Map(0, &readRange, reinterpret_cast<void**>(&m_instanceBufferBegin)));
-
-    m_uploadAllocator.Init(pDevice);
 }
 
 // Back buffer
@@ -112,30 +102,18 @@ void FrameResource::ResetBackBuffer()
 }
 
 // Scene color buffer
-void FrameResource::CreateSceneColorBuffers(UINT64 width, UINT height)
+void FrameResource::SetSceneColorBuffer(UINT index, ID3D12Resource* pResource)
 {
-    for (UINT i = 0; i < SceneColorBufferCount; ++i)
-    {
-        const auto format = DXGI_FORMAT_R8G8B8A8_UNORM;
-
-        DirectX::XMVECTORF32 color;
-        color.v = DirectX::XMColorSRGBToRGB(DirectX::XMVectorSet(0.5f, 0.5f, 0.5f, 1.0f));
-        const auto clearValue = CreateClearValue(format, color.f[0], color.f[1], color.f[2], color.f[3]);
-
-        m_sceneColorBuffers[i] = Texture(
-            m_pDevice,
-            GetTexture2DDesc(width, height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
-            D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-            &clearValue);
+    const auto format = GetSceneColorBufferFormat();
 
-        m_sceneColorBufferRtvs[i].Init(m_pDevice, m_sceneColorBuffers[i].Get(), GetRtvDesc(format, 0));
-        m_sceneColorBufferSrvs[i].Init(m_pDevice, m_sceneColorBuffers[i].Get(), GetSrvDesc(format, 1));
-    }
+    m_sceneColorBuffers[index] = pResource;
+    m_sceneColorBufferRtvs[index].Init(m_pDevice, pResource, GetRtvDesc(format, 0));
+    m_sceneColorBufferSrvs[index].Init(m_pDevice, pResource, GetSrvDesc(format, 1));
 }
 
 ID3D12Resource* FrameResource::GetSceneColorBuffer(UINT index) const
 {
-    return m_sceneColorBuffers[index].Get();
+    return m_sceneColorBuffers[index];
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE FrameResource::GetSceneColorBufferRtvHandle(UINT index) const
@@ -148,34 +126,25 @@ D3D12_CPU_DESCRIPTOR_HANDLE FrameResource::GetSceneColorBufferSrvHandle(UINT ind
     return m_sceneColorBufferSrvs[index].GetHandle();
 }
 
-void FrameResource::ResetSceneColorBuffers()
+DXGI_FORMAT FrameResource::GetSceneColorBufferFormat()
 {
-    for (UINT i = 0; i < SceneColorBufferCount; ++i)
-        m_sceneColorBuffers[i].Reset();
+    return DXGI_FORMAT_R8G8B8A8_UNORM;
 }
 
 // GBuffer
-void FrameResource::CreateGBuffers(UINT64 width, UINT height)
+void FrameResource::SetGBuffer(GBufferSlot slot, ID3D12Resource* pResource)
 {
-    for (UINT i = 0; i < static_cast<UINT>(GBufferSlot::NUM_GBUFFER_SLOTS); ++i)
-    {
-        const auto format = GetGBufferFormat(static_cast<GBufferSlot>(i));
-        const auto clearValue = CreateClearValue(format, 0.0f, 0.0f, 0.0f, 0.0f);
-
-        m_gBuffers[i] = Texture(
-            m_pDevice,
-            GetTexture2DDesc(width, height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
-            D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-            &clearValue);
+    const UINT i = static_cast<UINT>(slot);
+    const auto format = GetGBufferFormat(slot);
 
-        m_gBufferRtvs[i].Init(m_pDevice, m_gBuffers[i].Get(), GetRtvDesc(format, 0));
-        m_gBufferSrvs[i].Init(m_pDevice, m_gBuffers[i].Get(), GetSrvDesc(format, 1));
-    }
+    m_gBuffers[i] = pResource;
+    m_gBufferRtvs[i].Init(m_pDevice, pResource, GetRtvDesc(format, 0));
+    m_gBufferSrvs[i].Init(m_pDevice, pResource, GetSrvDesc(format, 1));
 }
 
 ID3D12Resource* FrameResource::GetGBuffer(GBufferSlot slot) const
 {
-    return m_gBuffers[static_cast<UINT>(slot)].Get();
+    return m_gBuffers[static_cast<UINT>(slot)];
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE FrameResource::GetGBufferBaseRtvHandle() const
@@ -206,45 +175,28 @@ DXGI_FORMAT FrameResource::GetGBufferFormat(GBufferSlot slot)
     }
 }
 
-void FrameResource::ResetGBuffers()
-{
-    for (auto& gBuffer : m_gBuffers)
-        gBuffer.Reset();
-}
-
 // Masks
-void FrameResource::CreateMasks(UINT64 width, UINT height)
+void FrameResource::SetMasks(ID3D12Resource* pSelectionMask, ID3D12Resource* pHorizontalDilatedMask)
 {
-    const auto format = DXGI_FORMAT_R8_UNORM;
-    const auto clearValue = CreateClearValue(format, 0.0f, 0.0f, 0.0f, 0.0f);
-
-    m_selectionMask = Texture(
-        m_pDevice,
-        GetTexture2DDesc(width, height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
-        D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-        &clearValue);
-
-    m_selectionMaskRtv.Init(m_pDevice, m_selectionMask.Get(), GetRtvDesc(format, 0));
-    m_selectionMaskSrv.Init(m_pDevice, m_selectionMask.Get(), GetSrvDesc(format, 1));
-
-    m_horizontalDilatedMask = Texture(
-        m_pDevice,
-        GetTexture2DDesc(width, height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
-        D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-        &clearValue);
-
-    m_horizontalDilatedMaskRtv.Init(m_pDevice, m_horizontalDilatedMask.Get(), GetRtvDesc(format, 0));
-    m_horizontalDilatedMaskSrv.Init(m_pDevice, m_horizontalDilatedMask.Get(), GetSrvDesc(format, 1));
+    const auto format = GetMaskFormat();
+
+    m_selectionMask = pSelectionMask;
+    m_selectionMaskRtv.Init(m_pDevice, m_selectionMask, GetRtvDesc(format, 0));
+    m_selectionMaskSrv.Init(m_pDevice, m_selectionMask, GetSrvDesc(format, 1));
+
+    m_horizontalDilatedMask = pHorizontalDilatedMask;
+    m_horizontalDilatedMaskRtv.Init(m_pDevice, m_horizontalDilatedMask, GetRtvDesc(format, 0));
+    m_horizontalDilatedMaskSrv.Init(m_pDevice, m_horizontalDilatedMask, GetSrvDesc(format, 1));
 }
 
 ID3D12Resource* FrameResource::GetSelectionMask() const
 {
-    return m_selectionMask.Get();
+    return m_selectionMask;
 }
 
 ID3D12Resource* FrameResource::GetHorizontalDilatedMask() const
 {
-    return m_horizontalDilatedMask.Get();
+    return m_horizontalDilatedMask;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE FrameResource::GetSelectionMaskRtvHandle() const
@@ -267,10 +219,9 @@ D3D12_CPU_DESCRIPTOR_HANDLE FrameResource::GetHorizontalDilatedMaskSrvHandle() c
     return m_horizontalDilatedMaskSrv.GetHandle();
 }
 
-void FrameResource::ResetMasks()
+DXGI_FORMAT FrameResource::GetMaskFormat()
 {
-    m_selectionMask.Reset();
-    m_horizontalDilatedMask.Reset();
+    return DXGI_FORMAT_R8_UNORM;
 }
 
 // Instance data
@@ -293,10 +244,12 @@ void FrameResource::EnsureInstanceCapacity(UINT requiredSize)
     }
 }
 
-void FrameResource::PushInstanceData(std::vector<InstanceData>& data)
+// Returned memory is write-combined. Write only, never read back.
+InstanceData* FrameResource::AllocateInstanceData(UINT count)
 {
-    memcpy(m_instanceBufferBegin + m_instanceOffsetByte, data.data(), sizeof(InstanceData) * data.size());
-    m_instanceOffsetByte += sizeof(InstanceData) * static_cast<UINT>(data.size());
+    auto* pData = reinterpret_cast<InstanceData*>(m_instanceBufferBegin + m_instanceOffsetByte);
+    m_instanceOffsetByte += sizeof(InstanceData) * count;
+    return pData;
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS FrameResource::GetInstanceBufferVirtualAddress() const
@@ -304,17 +257,6 @@ D3D12_GPU_VIRTUAL_ADDRESS FrameResource::GetInstanceBufferVirtualAddress() const
     return m_instanceUploadBuffer.Get()->GetGPUVirtualAddress();
 }
 
-// Transient upload
-UploadAllocation FrameResource::PushConstantData(void* src, std::size_t size)
-{
-    return m_uploadAllocator.Push(src, size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
-}
-
-void FrameResource::ResetUploadAllocator()
-{
-    m_uploadAllocator.Reset();
-}
-
 // Synchronization
 UINT64 FrameResource::GetSignaledFenceValue() const
 {
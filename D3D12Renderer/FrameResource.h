@@ -12,12 +12,10 @@
 #include "Buffer.h"
 #include "SharedConfig.h"
 #include "Texture.h"
-#include "TransientUploadAllocator.h"
 #include "View.h"
 
 class DescriptorAllocation;
 struct InstanceData;
-struct UploadAllocation;
 
 // Dynamic Data for each frame
 class FrameResource
@@ -52,41 +50,39 @@ public:
     D3D12_CPU_DESCRIPTOR_HANDLE GetBackBufferRtvHandle() const;
     void ResetBackBuffer();
 
+    // Scene color buffers, GBuffers and masks are transient textures owned by the render graph.
+    // Views are recreated whenever the graph reallocates them.
+
     // Scene color buffer
-    void CreateSceneColorBuffers(UINT64 width, UINT height);
+    void SetSceneColorBuffer(UINT index, ID3D12Resource* pResource);
     ID3D12Resource* GetSceneColorBuffer(UINT index) const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetSceneColorBufferRtvHandle(UINT index) const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetSceneColorBufferSrvHandle(UINT index) const;
-    void ResetSceneColorBuffers();
+    static DXGI_FORMAT GetSceneColorBufferFormat();
 
     // GBuffer
-    void CreateGBuffers(UINT64 width, UINT height);
+    void SetGBuffer(GBufferSlot slot, ID3D12Resource* pResource);
     ID3D12Resource* GetGBuffer(GBufferSlot slot) const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetGBufferBaseRtvHandle() const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetGBufferBaseSrvHandle() const;
     static DXGI_FORMAT GetGBufferFormat(GBufferSlot slot);
-    void ResetGBuffers();
 
     // Masks
-    void CreateMasks(UINT64 width, UINT height);
+    void SetMasks(ID3D12Resource* pSelectionMask, ID3D12Resource* pHorizontalDilatedMask);
     ID3D12Resource* GetSelectionMask() const;
     ID3D12Resource* GetHorizontalDilatedMask() const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetSelectionMaskRtvHandle() const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetSelectionMaskSrvHandle() const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetHorizontalDilatedMaskRtvHandle() const;
     D3D12_CPU_DESCRIPTOR_HANDLE GetHorizontalDilatedMaskSrvHandle() const;
-    void ResetMasks();
+    static DXGI_FORMAT GetMaskFormat();
 
     // Instance data
     void ResetInstanceOffsetByte();
     void EnsureInstanceCapacity(UINT requiredSize);
-    void PushInstanceData(std::vector<InstanceData>& data);
+    InstanceData* AllocateInstanceData(UINT count);
     D3D12_GPU_VIRTUAL_ADDRESS GetInstanceBufferVirtualAddress() const;
 
-    // Transient upload
-    UploadAllocation PushConstantData(void* src, std::size_t size);
-    void ResetUploadAllocator();
-
     // Synchronization
     UINT64 GetSignaledFenceValue() const;
     void UpdateSignaledFenceValue(UINT64 signaledFenceValue);
@@ -97,19 +93,19 @@ private:
     Texture m_backBuffer;
     RenderTargetView m_backBufferRtv;
 
-    std::array<Texture, SceneColorBufferCount> m_sceneColorBuffers;
+    std::array<ID3D12Resource*, SceneColorBufferCount> m_sceneColorBuffers = {};
     std::array<RenderTargetView, SceneColorBufferCount> m_sceneColorBufferRtvs;
     std::array<ShaderResourceView, SceneColorBufferCount> m_sceneColorBufferSrvs;
 
-    std::array<Texture, static_cast<std::size_t>(GBufferSlot::NUM_GBUFFER_SLOTS)> m_gBuffers;
+    std::array<ID3D12Resource*, static_cast<std::size_t>(GBufferSlot::NUM_GBUFFER_SLOTS)> m_gBuffers = {};
     std::array<RenderTargetView, static_cast<std::size_t>(GBufferSlot::NUM_GBUFFER_SLOTS)> m_gBufferRtvs;
     std::array<ShaderResourceView, static_cast<std::size_t>(GBufferSlot::NUM_GBUFFER_SLOTS)> m_gBufferSrvs;
 
-    Texture m_selectionMask;
+    ID3D12Resource* m_selectionMask = nullptr;
     RenderTargetView m_selectionMaskRtv;
     ShaderResourceView m_selectionMaskSrv;
 
-    Texture m_horizontalDilatedMask;
+    ID3D12Resource* m_horizontalDilatedMask = nullptr;
     RenderTargetView m_horizontalDilatedMaskRtv;
     ShaderResourceView m_horizontalDilatedMaskSrv;
 
@@ -118,8 +114,6 @@ private:
     UINT m_instanceOffsetByte = 0;
     UINT m_instanceCapacity = 1024;
 
-    TransientUploadAllocator m_uploadAllocator;
-
     UINT64 m_signaledFenceValue = 0;
 
     ID3D12Device10* m_pDevice = nullptr;
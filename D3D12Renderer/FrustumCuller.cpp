@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "FrustumCuller.h"
+
+#include <cfloat>
+
+using namespace DirectX;
+
+BoundingFrustum FrustumCuller::CreateWorldFrustum(FXMMATRIX view, CXMMATRIX projection)
+{
+    BoundingFrustum frustum;
+    BoundingFrustum::CreateFromMatrix(frustum, projection);
+
+    // CreateFromMatrix assumes 0.0 is near plane and 1.0 is far plane.
+    // With reverse-z, Near holds the far distance and Far holds the near distance.
+    if (frustum.Near > frustum.Far)
+        std::swap(frustum.Near, frustum.Far);
+
+    frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+
+    return frustum;
+}
+
+void FrustumCuller::SetFrustum(const BoundingFrustum& frustum)
+{
+    XMVECTOR planes[NumPlanes];
+    frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+    for (UINT i = 0; i < NumPlanes; ++i)
+        XMStoreFloat4(&m_planes[i], planes[i]);
+}
+
+void FrustumCuller::SetViewProjection(FXMMATRIX viewProjection)
+{
+    // Gribb-Hartmann plane extraction.
+    // Clip space volume is -w <= x <= w, -w <= y <= w, 0 <= z <= w. It also holds with reverse-z.
+    XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+    XMVECTOR planes[NumPlanes] = {
+        columns.r[3] + columns.r[0], // left
+        columns.r[3] - columns.r[0], // right
+        columns.r[3] + columns.r[1], // bottom
+        columns.r[3] - columns.r[1], // top
+        columns.r[2],                // z = 0
+        columns.r[3] - columns.r[2]  // z = w
+    };
+
+    // Extracted normals point inward. Flip them to match GetPlanes.
+    for (UINT i = 0; i < NumPlanes; ++i)
+        XMStoreFloat4(&m_planes[i], XMPlaneNormalize(XMVectorNegate(planes[i])));
+}
+
+UINT FrustumCuller::Cull(const XMFLOAT4* pSpheres, UINT count, std::vector<UINT>& visible) const
+{
+    // Splat planes once, so inner loop only does multiply-add on 4 spheres.
+    XMVECTOR planeX[NumPlanes];
+    XMVECTOR planeY[NumPlanes];
+    XMVECTOR planeZ[NumPlanes];
+    XMVECTOR planeW[NumPlanes];
+    for (UINT p = 0; p < NumPlanes; ++p)
+    {
+        XMVECTOR plane = XMLoadFloat4(&m_planes[p]);
+        planeX[p] = XMVectorSplatX(plane);
+        planeY[p] = XMVectorSplatY(plane);
+        planeZ[p] = XMVectorSplatZ(plane);
+        planeW[p] = XMVectorSplatW(plane);
+    }
+
+    auto testBatch = [&](const XMFLOAT4* pBatch, UINT batchBase, UINT batchCount)
+    {
+        // AoS -> SoA. Each row holds x, y, z, radius of 4 spheres.
+        XMMATRIX soa = XMMatrixTranspose(XMMATRIX(
+            XMLoadFloat4(&pBatch[0]),
+            XMLoadFloat4(&pBatch[1]),
+            XMLoadFloat4(&pBatch[2]),
+            XMLoadFloat4(&pBatch[3])));
+
+        XMVECTOR outside = XMVectorFalseInt();
+        for (UINT p = 0; p < NumPlanes; ++p)
+        {
+            XMVECTOR dist = XMVectorMultiplyAdd(soa.r[0], planeX[p], planeW[p]);
+            dist = XMVectorMultiplyAdd(soa.r[1], planeY[p], dist);
+            dist = XMVectorMultiplyAdd(soa.r[2], planeZ[p], dist);
+            outside = XMVectorOrInt(outside, XMVectorGreater(dist, soa.r[3]));
+        }
+
+        UINT32 lanes[4];
+        XMStoreInt4(lanes, outside);
+
+        for (UINT lane = 0; lane < batchCount; ++lane)
+        {
+            if (lanes[lane] == 0)
+                visible.push_back(batchBase + lane);
+        }
+    };
+
+    const UINT prevSize = static_cast<UINT>(visible.size());
+
+    UINT i = 0;
+    for (; i + 4 <= count; i += 4)
+        testBatch(&pSpheres[i], i, 4);
+
+    // Pad the tail with spheres that are always outside.
+    if (i < count)
+    {
+        XMFLOAT4 tail[4];
+        for (UINT lane = 0; lane < 4; ++lane)
+            tail[lane] = (i + lane < count) ? pSpheres[i + lane] : XMFLOAT4(0.0f, 0.0f, 0.0f, -FLT_MAX);
+        testBatch(tail, i, count - i);
+    }
+
+    return static_cast<UINT>(visible.size()) - prevSize;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <minwindef.h>
+
+// Tests world-space bounding spheres against a frustum, 4 spheres per iteration.
+// Only depends on DirectXMath, so it can run without a device.
+class FrustumCuller
+{
+public:
+    // Create world space frustum from camera matrices.
+    // Handles reverse-z projection (near/far swapped).
+    static DirectX::BoundingFrustum CreateWorldFrustum(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+    void SetFrustum(const DirectX::BoundingFrustum& frustum);
+
+    // Extract planes from view * projection. Works for both perspective and orthographic projection.
+    void SetViewProjection(DirectX::FXMMATRIX viewProjection);
+
+    // Each sphere is (center.xyz, radius) in world space.
+    // Appends indices of visible spheres to visible and returns the number of appended indices.
+    UINT Cull(const DirectX::XMFLOAT4* pSpheres, UINT count, std::vector<UINT>& visible) const;
+
+private:
+    static constexpr UINT NumPlanes = 6;
+
+    // Plane normals point outward. A sphere is outside when dot(plane, center) > radius for any plane.
+    DirectX::XMFLOAT4 m_planes[NumPlanes] = {};
+};
@@ -0,0 +1,145 @@
+#include "pch.h"
+
+#include "InstanceTable.h"
+
+#include <cassert>
+
+UINT InstanceTable::Allocate(EntityHandle owner, MeshHandle mesh)
+{
+    UINT slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<UINT>(m_slots.size());
+        m_slots.push_back({});
+        m_data.push_back({});
+    }
+
+    auto& s = m_slots[slot];
+    s.owner = owner;
+    s.group = GetOrCreateGroup(mesh);
+    s.allocated = true;
+
+    ++m_groups[s.group].instanceCount;
+
+    MarkDirty(slot);
+
+    return slot;
+}
+
+void InstanceTable::Free(UINT slot)
+{
+    assert(IsAllocated(slot));
+
+    auto& s = m_slots[slot];
+    --m_groups[s.group].instanceCount;
+
+    // Dirty flag is kept while the slot is still in dirty list.
+    s.owner = {};
+    s.group = NullSlot;
+    s.allocated = false;
+
+    m_freeSlots.push_back(slot);
+}
+
+void InstanceTable::SetMesh(UINT slot, MeshHandle mesh)
+{
+    assert(IsAllocated(slot));
+
+    auto& s = m_slots[slot];
+    UINT group = GetOrCreateGroup(mesh);
+    if (group == s.group)
+        return;
+
+    --m_groups[s.group].instanceCount;
+    ++m_groups[group].instanceCount;
+    s.group = group;
+}
+
+void InstanceTable::MarkDirty(UINT slot)
+{
+    if (m_slots[slot].dirty)
+        return;
+
+    m_slots[slot].dirty = true;
+    m_dirtySlots.push_back(slot);
+}
+
+const std::vector<UINT>& InstanceTable::GetDirtySlots() const
+{
+    return m_dirtySlots;
+}
+
+void InstanceTable::ClearDirtySlots()
+{
+    for (UINT slot : m_dirtySlots)
+        m_slots[slot].dirty = false;
+    m_dirtySlots.clear();
+}
+
+bool InstanceTable::IsAllocated(UINT slot) const
+{
+    return slot < m_slots.size() && m_slots[slot].allocated;
+}
+
+EntityHandle InstanceTable::GetOwner(UINT slot) const
+{
+    return m_slots[slot].owner;
+}
+
+void InstanceTable::SetData(UINT slot, const InstanceData& data)
+{
+    m_data[slot] = data;
+}
+
+const InstanceData& InstanceTable::GetData(UINT slot) const
+{
+    return m_data[slot];
+}
+
+UINT InstanceTable::GetGroup(UINT slot) const
+{
+    return m_slots[slot].group;
+}
+
+UINT InstanceTable::GetGroupCount() const
+{
+    return static_cast<UINT>(m_groups.size());
+}
+
+MeshHandle InstanceTable::GetGroupMesh(UINT group) const
+{
+    return m_groups[group].mesh;
+}
+
+UINT InstanceTable::GetGroupInstanceCount(UINT group) const
+{
+    return m_groups[group].instanceCount;
+}
+
+UINT InstanceTable::GetSlotCapacity() const
+{
+    return static_cast<UINT>(m_slots.size());
+}
+
+UINT InstanceTable::GetAllocatedCount() const
+{
+    return static_cast<UINT>(m_slots.size() - m_freeSlots.size());
+}
+
+UINT InstanceTable::GetOrCreateGroup(MeshHandle mesh)
+{
+    auto it = m_groupIndices.find(mesh);
+    if (it != m_groupIndices.end())
+        return it->second;
+
+    UINT group = static_cast<UINT>(m_groups.size());
+    m_groups.push_back({mesh, 0});
+    m_groupIndices.emplace(mesh, group);
+
+    return group;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <minwindef.h>
+
+#include "InstanceData.h"
+#include "SceneHandles.h"
+
+// Persistent instance data of renderables.
+// A renderable keeps its slot until it is freed, so only changed slots have to be rebuilt.
+// Slots are grouped by mesh. Instance count of each group is maintained on allocate, free and mesh change.
+class InstanceTable
+{
+public:
+    static constexpr UINT NullSlot = UINT_MAX;
+
+    // New slot is marked dirty.
+    UINT Allocate(EntityHandle owner, MeshHandle mesh);
+    void Free(UINT slot);
+
+    void SetMesh(UINT slot, MeshHandle mesh);
+
+    // Marking same slot several times before ClearDirtySlots() is fine.
+    void MarkDirty(UINT slot);
+
+    // May contain freed slots. Check IsAllocated() before rebuilding.
+    const std::vector<UINT>& GetDirtySlots() const;
+    void ClearDirtySlots();
+
+    bool IsAllocated(UINT slot) const;
+    EntityHandle GetOwner(UINT slot) const;
+
+    void SetData(UINT slot, const InstanceData& data);
+    const InstanceData& GetData(UINT slot) const;
+
+    UINT GetGroup(UINT slot) const;
+    UINT GetGroupCount() const;
+    MeshHandle GetGroupMesh(UINT group) const;
+    UINT GetGroupInstanceCount(UINT group) const;
+
+    UINT GetSlotCapacity() const;
+    UINT GetAllocatedCount() const;
+
+private:
+    UINT GetOrCreateGroup(MeshHandle mesh);
+
+    struct Slot
+    {
+        EntityHandle owner;
+        UINT group = NullSlot;
+        bool allocated = false;
+        bool dirty = false;
+    };
+
+    struct Group
+    {
+        MeshHandle mesh;
+        UINT instanceCount = 0;
+    };
+
+    std::vector<InstanceData> m_data; // per slot
+    std::vector<Slot> m_slots;
+    std::vector<UINT> m_freeSlots;
+    std::vector<UINT> m_dirtySlots;
+
+    std::vector<Group> m_groups;
+    std::unordered_map<MeshHandle, UINT> m_groupIndices;
+};
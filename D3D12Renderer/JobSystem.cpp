@@ -0,0 +1,211 @@
+#include "pch.h"
+
+#include "JobSystem.h"
+
+#include <iterator>
+
+thread_local UINT JobSystem::t_queueIdx = 0;
+
+JobSystem::JobSystem(UINT workerCount)
+{
+    if (workerCount == 0)
+    {
+        UINT hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_queues.reserve(workerCount + 1);
+    for (UINT i = 0; i < workerCount + 1; ++i)
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+
+    m_activeWorkerCount = workerCount;
+
+    m_workers.reserve(workerCount);
+    for (UINT i = 0; i < workerCount; ++i)
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void JobSystem::Run(Job job, JobCounter* pCounter)
+{
+    if (pCounter)
+        pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+    Push({std::move(job), pCounter, nullptr});
+}
+
+void JobSystem::Run(Job job, JobCounter* pCounter, const JobCounter& dependency)
+{
+    if (pCounter)
+        pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_waitingMutex);
+
+        // Checked under the lock, so a release in between cannot be missed.
+        if (!dependency.IsDone())
+        {
+            m_waitingTasks.push_back({std::move(job), pCounter, &dependency});
+            return;
+        }
+    }
+
+    Push({std::move(job), pCounter, nullptr});
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!RunOne(t_queueIdx))
+            std::this_thread::yield();
+    }
+}
+
+UINT JobSystem::GetWorkerCount() const
+{
+    return static_cast<UINT>(m_workers.size());
+}
+
+UINT JobSystem::GetCurrentThreadIndex()
+{
+    return t_queueIdx;
+}
+
+void JobSystem::SetActiveWorkerCount(UINT count)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_activeWorkerCount = (std::min)(count, GetWorkerCount());
+    }
+    m_wakeCondition.notify_all();
+}
+
+UINT JobSystem::GetActiveWorkerCount() const
+{
+    return m_activeWorkerCount.load(std::memory_order_relaxed);
+}
+
+void JobSystem::WorkerLoop(UINT queueIdx)
+{
+    t_queueIdx = queueIdx;
+
+    while (m_running)
+    {
+        if (IsActive(queueIdx) && RunOne(queueIdx))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(
+            lock,
+            [&]()
+            {
+                return !m_running || (IsActive(queueIdx) && m_queuedTaskCount > 0);
+            });
+    }
+}
+
+void JobSystem::Push(Task&& task)
+{
+    auto& queue = *m_queues[t_queueIdx];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    m_queuedTaskCount.fetch_add(1);
+
+    // Lock so that a worker between its predicate check and wait cannot miss the notification.
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCondition.notify_one();
+}
+
+bool JobSystem::TryPop(UINT queueIdx, Task& task)
+{
+    auto& queue = *m_queues[queueIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::TrySteal(UINT thiefIdx, Task& task)
+{
+    // Inactive workers' queues are also visited, so no task is left behind.
+    const UINT queueCount = static_cast<UINT>(m_queues.size());
+    for (UINT i = 1; i < queueCount; ++i)
+    {
+        auto& queue = *m_queues[(thiefIdx + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::RunOne(UINT queueIdx)
+{
+    Task task;
+    if (!TryPop(queueIdx, task) && !TrySteal(queueIdx, task))
+        return false;
+
+    m_queuedTaskCount.fetch_sub(1);
+
+    task.job();
+
+    if (task.pCounter && task.pCounter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        ReleaseWaitingTasks();
+
+    return true;
+}
+
+void JobSystem::ReleaseWaitingTasks()
+{
+    std::vector<Task> released;
+    {
+        std::lock_guard<std::mutex> lock(m_waitingMutex);
+        if (m_waitingTasks.empty())
+            return;
+
+        auto it = std::partition(
+            m_waitingTasks.begin(),
+            m_waitingTasks.end(),
+            [](const Task& t)
+            {
+                return !t.pDependency->IsDone();
+            });
+        std::move(it, m_waitingTasks.end(), std::back_inserter(released));
+        m_waitingTasks.erase(it, m_waitingTasks.end());
+    }
+
+    for (auto& task : released)
+    {
+        task.pDependency = nullptr;
+        Push(std::move(task));
+    }
+}
+
+bool JobSystem::IsActive(UINT queueIdx) const
+{
+    // Queue 0 is not a worker.
+    return queueIdx <= GetActiveWorkerCount();
+}
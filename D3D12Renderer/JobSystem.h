@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <minwindef.h>
+
+// Number of unfinished jobs. Wait on it with JobSystem::Wait().
+class JobCounter
+{
+public:
+    bool IsDone() const
+    {
+        return m_value.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<UINT> m_value{0};
+};
+
+// Work-stealing job scheduler.
+// Each thread owns a deque. Owner pushes and pops at the back, idle threads steal from the front.
+// Threads which are not workers (main thread) share queue 0 and run jobs while waiting.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    JobSystem& operator=(JobSystem&&) = delete;
+
+    // 0 uses one worker per hardware thread except the main thread.
+    explicit JobSystem(UINT workerCount = 0);
+    ~JobSystem();
+
+    // pCounter is incremented now and decremented when the job finishes.
+    void Run(Job job, JobCounter* pCounter);
+
+    // Job is queued after dependency reaches zero.
+    // Run all jobs of the dependency first, since its counter may reach zero between two Run calls.
+    void Run(Job job, JobCounter* pCounter, const JobCounter& dependency);
+
+    // Run queued jobs on the calling thread until counter reaches zero.
+    void Wait(const JobCounter& counter);
+
+    // Call func(i) for each i in [begin, end), grainSize indices per job. Returns when all are done.
+    template <typename F>
+    void ParallelFor(UINT begin, UINT end, UINT grainSize, F&& func)
+    {
+        if (begin >= end)
+            return;
+
+        grainSize = (std::max)(grainSize, 1u);
+
+        // Not worth splitting
+        if (end - begin <= grainSize || GetActiveWorkerCount() == 0)
+        {
+            for (UINT i = begin; i < end; ++i)
+                func(i);
+            return;
+        }
+
+        JobCounter counter;
+        for (UINT chunkBegin = begin; chunkBegin < end; chunkBegin += (std::min)(grainSize, end - chunkBegin))
+        {
+            UINT chunkEnd = chunkBegin + (std::min)(grainSize, end - chunkBegin);
+            Run(
+                [&func, chunkBegin, chunkEnd]()
+                {
+                    for (UINT i = chunkBegin; i < chunkEnd; ++i)
+                        func(i);
+                },
+                &counter);
+        }
+        Wait(counter);
+    }
+
+    UINT GetWorkerCount() const;
+
+    // 0 for threads which are not workers, 1 to GetWorkerCount() for workers. Indexes per-thread data.
+    static UINT GetCurrentThreadIndex();
+
+    // Workers beyond the count sleep. Used to compare scaling at runtime.
+    void SetActiveWorkerCount(UINT count);
+    UINT GetActiveWorkerCount() const;
+
+private:
+    struct Task
+    {
+        Job job;
+        JobCounter* pCounter = nullptr;
+        const JobCounter* pDependency = nullptr;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(UINT queueIdx);
+
+    void Push(Task&& task);
+    bool TryPop(UINT queueIdx, Task& task);
+    bool TrySteal(UINT thiefIdx, Task& task);
+
+    // Returns false if there was nothing to run.
+    bool RunOne(UINT queueIdx);
+
+    void ReleaseWaitingTasks();
+
+    bool IsActive(UINT queueIdx) const;
+
+    static thread_local UINT t_queueIdx; // 0 for non-worker threads
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues; // [0] is shared by non-worker threads
+    std::vector<std::thread> m_workers;
+
+    std::atomic<bool> m_running{true};
+    std::atomic<UINT> m_activeWorkerCount{0};
+    std::atomic<UINT> m_queuedTaskCount{0};
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+
+    std::mutex m_waitingMutex;
+    std::vector<Task> m_waitingTasks; // Tasks whose dependency is not done yet
+};
@@ -122,9 +122,25 @@ void Light::SetViewProjection(XMMATRIX view, XMMATRIX projection, UINT idx)
     m_lightConstantData.SetViewProjection(view * projection, idx);
 }
 
-void Light::SetIdxInArray(UINT idxInArray)
+XMMATRIX Light::GetViewProjection(UINT idx) const
 {
-    m_lightConstantData.idxInArray = idxInArray;
+    return XMMatrixTranspose(XMLoadFloat4x4(&m_lightConstantData.viewProjection[idx]));
+}
+
+void Light::SetShadowMapIndex(BindlessIndex&& index)
+{
+    m_shadowMapIndex = std::move(index);
+    m_lightConstantData.idxInArray = m_shadowMapIndex.Get();
+}
+
+void Light::SetLightCbvIndex(BindlessIndex&& index)
+{
+    m_lightCbvIndex = std::move(index);
+}
+
+UINT Light::GetLightCbvIndex() const
+{
+    return m_lightCbvIndex.Get();
 }
 
 CameraConstantData* Light::GetCameraConstantDataPtr(UINT arrayIndex)
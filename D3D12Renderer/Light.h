@@ -8,6 +8,7 @@
 #include <d3d12.h>
 #include <minwindef.h>
 
+#include "BindlessIndexAllocator.h"
 #include "ConstantData.h"
 #include "SharedConfig.h"
 #include "Texture.h"
@@ -48,8 +49,14 @@ public:
     virtual void SetRange(float range);
 
     void SetViewProjection(DirectX::XMMATRIX view, DirectX::XMMATRIX projection, UINT idx);
+    DirectX::XMMATRIX GetViewProjection(UINT idx) const;
 
-    void SetIdxInArray(UINT idxInArray);
+    // Index of the shadow map SRV in the bindless heap, read by shaders as idxInArray
+    void SetShadowMapIndex(BindlessIndex&& index);
+
+    // Index of the light CBV in the per-frame region of the bindless heap. Lighting finds the light by it.
+    void SetLightCbvIndex(BindlessIndex&& index);
+    UINT GetLightCbvIndex() const;
 
     CameraConstantData* GetCameraConstantDataPtr(UINT arrayIndex);
     void SetCameraUploadAllocation(UINT arrayIndex, UploadAllocation alloc);
@@ -75,6 +82,8 @@ protected:
     Texture m_depthBuffer;
     std::vector<DepthStencilView> m_dsvs;
     ShaderResourceView m_srv;
+    BindlessIndex m_shadowMapIndex;
+    BindlessIndex m_lightCbvIndex;
 };
 
 class DirectionalLight : public Light
@@ -77,6 +77,16 @@ D3D12_CPU_DESCRIPTOR_HANDLE Material::GetCbvHandle() const
     return m_cbv.GetHandle();
 }
 
+void Material::SetBindlessIndex(BindlessIndex&& index)
+{
+    m_bindlessIndex = std::move(index);
+}
+
+UINT Material::GetBindlessIndex() const
+{
+    return m_bindlessIndex.Get();
+}
+
 void Material::InitCbv(ID3D12Device* pDevice, D3D12_GPU_VIRTUAL_ADDRESS gpuPtr)
 {
     m_cbv.Init(pDevice, gpuPtr, sizeof(MaterialConstantData));
@@ -7,6 +7,7 @@
 #include <d3d12.h>
 #include <minwindef.h>
 
+#include "BindlessIndexAllocator.h"
 #include "ConstantData.h"
 #include "RendererConfig.h"
 #include "View.h"
@@ -52,6 +53,10 @@ public:
 
     D3D12_CPU_DESCRIPTOR_HANDLE GetCbvHandle() const;
 
+    // Index of the CBV in the per-frame region of the bindless heap. Instances refer to the material by it.
+    void SetBindlessIndex(BindlessIndex&& index);
+    UINT GetBindlessIndex() const;
+
     void InitCbv(ID3D12Device* pDevice, D3D12_GPU_VIRTUAL_ADDRESS gpuPtr);
 
     void CopyDataFrom(const Material& src);
@@ -65,6 +70,7 @@ private:
 
     MaterialConstantData m_constantData;
     ConstantBufferView m_cbv;
+    BindlessIndex m_bindlessIndex;
 
     std::array<TextureAddressingMode, static_cast<std::size_t>(TextureSlot::NUM_TEXTURE_SLOTS)> m_textureAddressingModes;
 
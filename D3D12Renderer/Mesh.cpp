@@ -4,15 +4,16 @@
 
 #include "D3DHelper.h"
 #include "GeometryData.h"
-#include "TransientUploadAllocator.h"
 #include "UploadAllocation.h"
+#include "UploadRingBuffer.h"
 
 using namespace D3DHelper;
+using namespace DirectX;
 
 Mesh::Mesh(
     ID3D12Device10* pDevice,
     ID3D12GraphicsCommandList7* pCommandList,
-    TransientUploadAllocator& allocator,
+    UploadRingBuffer& allocator,
     const GeometryData& geometryData)
 {
     // Vertex Buffer
@@ -69,6 +70,21 @@ Mesh::Mesh(
     m_ibv.BufferLocation = m_indexBuffer.Get()->GetGPUVirtualAddress();
     m_ibv.SizeInBytes = static_cast<UINT>(indexBufferSize);
     m_ibv.Format = DXGI_FORMAT_R32_UINT;
+
+    // Bounds
+    if (!geometryData.vertices.empty())
+    {
+        BoundingBox::CreateFromPoints(
+            m_boundingBox,
+            geometryData.vertices.size(),
+            &geometryData.vertices[0].position,
+            sizeof(Vertex));
+        BoundingSphere::CreateFromPoints(
+            m_boundingSphere,
+            geometryData.vertices.size(),
+            &geometryData.vertices[0].position,
+            sizeof(Vertex));
+    }
 }
 
 const D3D12_VERTEX_BUFFER_VIEW& Mesh::GetVbv() const
@@ -86,6 +102,16 @@ UINT Mesh::GetNumIndices() const
     return m_numIndices;
 }
 
+const BoundingBox& Mesh::GetBoundingBox() const
+{
+    return m_boundingBox;
+}
+
+const BoundingSphere& Mesh::GetBoundingSphere() const
+{
+    return m_boundingSphere;
+}
+
 MaterialHandle Mesh::GetMaterial() const
 {
     return m_material;
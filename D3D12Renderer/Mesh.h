@@ -1,5 +1,6 @@
 #pragma once
 
+#include <DirectXCollision.h>
 #include <d3d12.h>
 #include <minwindef.h>
 
@@ -7,7 +8,7 @@
 #include "SceneHandles.h"
 
 struct GeometryData;
-class TransientUploadAllocator;
+class UploadRingBuffer;
 
 class Mesh
 {
@@ -15,12 +16,14 @@ public:
     Mesh(
         ID3D12Device10* pDevice,
         ID3D12GraphicsCommandList7* pCommandList,
-        TransientUploadAllocator& allocator,
+        UploadRingBuffer& allocator,
         const GeometryData& geometryData);
 
     const D3D12_VERTEX_BUFFER_VIEW& GetVbv() const;
     const D3D12_INDEX_BUFFER_VIEW& GetIbv() const;
     UINT GetNumIndices() const;
+    const DirectX::BoundingBox& GetBoundingBox() const;
+    const DirectX::BoundingSphere& GetBoundingSphere() const;
 
     MaterialHandle GetMaterial() const;
     void SetMaterial(MaterialHandle handle);
@@ -33,5 +36,9 @@ private:
     D3D12_INDEX_BUFFER_VIEW m_ibv;
     UINT m_numIndices = 0;
 
+    // Local space bounds
+    DirectX::BoundingBox m_boundingBox;
+    DirectX::BoundingSphere m_boundingSphere;
+
     MaterialHandle m_material;
 };
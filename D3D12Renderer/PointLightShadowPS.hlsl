@@ -21,6 +21,7 @@ struct LightConstants
 };
 ConstantBuffer<LightConstants> LightConstantBuffers[] : register(b0, space2);
 
+// Bindless index of the light being rendered
 cbuffer IdxConstant : register(b3, space0)
 {
     uint currentLightIdx;
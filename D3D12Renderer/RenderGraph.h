@@ -3,7 +3,11 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstddef>
 #include <functional>
+#include <list>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -12,16 +16,66 @@
 #include <basetsd.h>
 #include <d3d12.h>
 #include <minwindef.h>
+#include <wrl/client.h>
 
 #include "CacheKeys.h"
 #include "D3DHelper.h"
 #include "RenderGraphNode.h"
 #include "RendererConfig.h"
+#include "Texture.h"
+#include "Utility.h"
+
+// Memory requirement and lifetime of a transient texture.
+// Passes are positions in the compiled order.
+struct TransientAllocationRequest
+{
+    UINT64 size;
+    UINT64 alignment;
+    UINT firstPass; // UINT_MAX if no pass uses it
+    UINT lastPass;
+};
+
+struct TransientMemoryPlan
+{
+    std::vector<UINT64> offsets;        // per request
+    std::vector<UINT> previousRequests; // request placed in the same memory right before, UINT_MAX if none in the frame
+    std::vector<bool> isAliased;        // shares memory with another request
+    UINT64 heapSize = 0;                // peak footprint
+    UINT64 summedSize = 0;              // footprint without aliasing
+};
+
+// Cross-queue synchronization of one compiled order. Positions are in the order.
+// Queues other than direct wait for the direct queue at frame begin, after the frame begin barriers.
+struct QueueSyncPlan
+{
+    std::vector<bool> signals;            // queue of the pass signals its fence after it
+    std::vector<std::vector<UINT>> waits; // signaling positions the queue of the pass waits for before it
+    std::vector<UINT> frameEndWaits;      // signaling positions the direct queue waits for before frame end
+    UINT syncPointCount = 0;              // waits including frame end ones
+    UINT coveredDependencyCount = 0;      // cross-queue dependencies needing no wait of their own
+};
+
+// Layout of a texture group for indexing subresources of partial ranges.
+// Mips, array slices and planes are left 0 when the group is only accessed as a whole.
+struct TextureDimension
+{
+    UINT subresourceCount;
+    UINT mipLevels;
+    UINT arraySize;
+    UINT planeCount;
+};
+
+// Barriers of one pass with resources resolved for one frame. Ready to be passed to ID3D12GraphicsCommandList7::Barrier.
+struct PassBarriers
+{
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+};
 
 class RenderGraph
 {
 public:
-    void Init(ID3D12Device* pDevice)
+    void Init(ID3D12Device10* pDevice)
     {
         m_pDevice = pDevice;
     }
@@ -37,14 +91,17 @@ public:
         return {idx};
     }
 
+    // Provider is called again only when value of versionProvider changes.
     RGBuffer RegisterBuffer(
         const std::string& name,
         bool isPerFrame,
-        std::function<std::vector<ID3D12Resource*>()> provider)
+        std::function<std::vector<ID3D12Resource*>()> provider,
+        std::function<UINT64()> versionProvider)
     {
         auto idx = RegisterHelper(name, isPerFrame, m_bufferGroups, m_bufferMap, {});
         m_bufferGroups[idx].isDynamic = true;
         m_bufferGroups[idx].provider = provider;
+        m_bufferGroups[idx].versionProvider = versionProvider;
         return {idx};
     }
 
@@ -65,15 +122,495 @@ public:
         bool isPerFrame,
         TextureResourceUsage initialUsage,
         UINT subresourceCount,
-        std::function<std::vector<ID3D12Resource*>()> provider)
+        std::function<std::vector<ID3D12Resource*>()> provider,
+        std::function<UINT64()> versionProvider)
     {
         auto idx = RegisterHelper(name, isPerFrame, m_textureGroups, m_textureMap, initialUsage);
         m_textureGroups[idx].isDynamic = true;
         m_textureGroups[idx].subresourceCount = subresourceCount;
         m_textureGroups[idx].provider = provider;
+        m_textureGroups[idx].versionProvider = versionProvider;
         return {idx};
     }
 
+    // Transient textures are created by the graph, one per element and frame.
+    // Ones whose lifetimes do not overlap share memory.
+    RGTexture RegisterTransientTexture(
+        const std::string& name,
+        TextureResourceUsage initialUsage)
+    {
+        auto idx = RegisterHelper(name, true, m_textureGroups, m_textureMap, initialUsage);
+        m_textureGroups[idx].isDynamic = false;
+        m_textureGroups[idx].isTransient = true;
+        m_textureGroups[idx].subresourceCount = 0;
+        return {idx};
+    }
+
+    void AddTransientElement(RGTexture texture, const D3D12_RESOURCE_DESC1& desc, const D3D12_CLEAR_VALUE& clearValue)
+    {
+        auto& group = m_textureGroups[texture.index];
+        assert(group.isTransient);
+
+        group.subresourceCount = D3DHelper::GetSubresourceCount(m_pDevice, desc);
+        group.descs.push_back(desc);
+        group.clearValues.push_back(clearValue);
+        group.pResources.resize(group.pResources.size() + FrameCount, nullptr);
+        ++group.elementCount;
+    }
+
+    // Takes effect on the next Compile() and AllocateTransientTextures().
+    void ResizeTransientTextures(UINT64 width, UINT height)
+    {
+        for (auto& group : m_textureGroups)
+        {
+            for (auto& desc : group.descs)
+            {
+                desc.Width = width;
+                desc.Height = height;
+            }
+        }
+    }
+
+    // Create per-frame heaps and place transient textures by the plan of last Compile().
+    // GPU must be done with the previous ones.
+    void AllocateTransientTextures()
+    {
+        m_transientTextures.clear();
+        for (auto& heap : m_transientHeaps)
+            heap.Reset();
+
+        if (m_transientRequests.empty())
+            return;
+
+        for (UINT frame = 0; frame < FrameCount; ++frame)
+        {
+            D3D12_HEAP_DESC heapDesc = {};
+            heapDesc.SizeInBytes = m_transientPlan.heapSize;
+            heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+            heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+            D3DHelper::ThrowIfFailed(m_pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_transientHeaps[frame])));
+
+            for (UINT i = 0; i < m_transientElements.size(); ++i)
+            {
+                const auto& [groupIdx, element] = m_transientElements[i];
+                auto& group = m_textureGroups[groupIdx];
+
+                m_transientTextures.emplace_back(
+                    m_pDevice,
+                    m_transientHeaps[frame].Get(),
+                    m_transientPlan.offsets[i],
+                    group.descs[element],
+                    group.initialUsage.layout,
+                    &group.clearValues[element]);
+                group.pResources[element * FrameCount + frame] = m_transientTextures.back().Get();
+            }
+        }
+
+        // New textures are created in initialUsage.
+        for (UINT i = 0; i < static_cast<UINT>(m_textureGroups.size()); ++i)
+        {
+            if (!m_textureGroups[i].isTransient)
+                continue;
+
+            for (auto& state : m_textureStates[i])
+                state.assign(m_textureGroups[i].subresourceCount, m_textureGroups[i].initialUsage);
+        }
+
+        ++m_resourceVersion;
+    }
+
+    // Per frame
+    UINT64 GetTransientHeapSize() const
+    {
+        return m_transientPlan.heapSize;
+    }
+
+    UINT64 GetTransientSummedSize() const
+    {
+        return m_transientPlan.summedSize;
+    }
+
+    // Interval partitioning of requests by lifetime. Requests in one bucket never live at the same time,
+    // so they share the bucket's memory. Needs no device, only sizes and lifetimes.
+    static TransientMemoryPlan PlanTransientMemory(const std::vector<TransientAllocationRequest>& requests)
+    {
+        const UINT count = static_cast<UINT>(requests.size());
+
+        TransientMemoryPlan plan;
+        plan.offsets.assign(count, 0);
+        plan.previousRequests.assign(count, UINT_MAX);
+        plan.isAliased.assign(count, false);
+
+        std::vector<UINT> order;
+        for (UINT i = 0; i < count; ++i)
+        {
+            plan.summedSize += Utility::Align(requests[i].size, requests[i].alignment);
+            if (requests[i].firstPass != UINT_MAX)
+                order.push_back(i);
+        }
+
+        // By first use. Larger ones first on ties, so smaller ones can reuse their buckets later.
+        std::sort(
+            order.begin(),
+            order.end(),
+            [&](UINT a, UINT b)
+            {
+                if (requests[a].firstPass != requests[b].firstPass)
+                    return requests[a].firstPass < requests[b].firstPass;
+                return requests[a].size > requests[b].size;
+            });
+
+        struct Bucket
+        {
+            UINT64 size;
+            UINT64 alignment;
+            UINT lastPass;
+            UINT lastRequest;
+        };
+        std::vector<Bucket> buckets;
+        std::vector<UINT> requestBuckets(count, UINT_MAX);
+
+        for (UINT i : order)
+        {
+            const auto& request = requests[i];
+
+            // Smallest one that fits wastes least. If none fits, largest one grows least.
+            auto isBetter = [&](const Bucket& candidate, const Bucket& current)
+            {
+                bool candidateFits = candidate.size >= request.size;
+                bool currentFits = current.size >= request.size;
+                if (candidateFits != currentFits)
+                    return candidateFits;
+                return candidateFits ? candidate.size < current.size : candidate.size > current.size;
+            };
+
+            UINT best = UINT_MAX;
+            for (UINT b = 0; b < static_cast<UINT>(buckets.size()); ++b)
+            {
+                // Occupant is still alive
+                if (buckets[b].lastPass >= request.firstPass)
+                    continue;
+
+                if (best == UINT_MAX || isBetter(buckets[b], buckets[best]))
+                    best = b;
+            }
+
+            if (best == UINT_MAX)
+            {
+                best = static_cast<UINT>(buckets.size());
+                buckets.push_back({0, 1, 0, UINT_MAX});
+            }
+            else
+            {
+                plan.previousRequests[i] = buckets[best].lastRequest;
+                plan.isAliased[i] = true;
+                plan.isAliased[buckets[best].lastRequest] = true;
+            }
+
+            auto& bucket = buckets[best];
+            bucket.size = (std::max)(bucket.size, request.size);
+            bucket.alignment = (std::max)(bucket.alignment, request.alignment);
+            bucket.lastPass = request.lastPass;
+            bucket.lastRequest = i;
+            requestBuckets[i] = best;
+        }
+
+        std::vector<UINT64> bucketOffsets(buckets.size());
+        UINT64 offset = 0;
+        for (UINT b = 0; b < static_cast<UINT>(buckets.size()); ++b)
+        {
+            offset = Utility::Align(offset, buckets[b].alignment);
+            bucketOffsets[b] = offset;
+            offset += buckets[b].size;
+        }
+        plan.heapSize = offset;
+
+        for (UINT i = 0; i < count; ++i)
+        {
+            if (requestBuckets[i] != UINT_MAX)
+                plan.offsets[i] = bucketOffsets[requestBuckets[i]];
+            else // Never accessed. Only needs memory to be placed in.
+                plan.heapSize = (std::max)(plan.heapSize, static_cast<UINT64>(Utility::Align(requests[i].size, requests[i].alignment)));
+        }
+
+        return plan;
+    }
+
+    // Vector clocks. A queue runs in order, so waiting for a position covers every earlier position of that queue,
+    // and every one that queue had waited for. Per pass, only the latest uncovered dependency of each other queue is waited for.
+    // Dependencies are earlier positions per position. Needs no device.
+    static QueueSyncPlan PlanQueueSync(const std::vector<QueueType>& queues, const std::vector<std::vector<UINT>>& dependencies)
+    {
+        constexpr UINT QueueCount = static_cast<UINT>(QueueType::NUM_QUEUE_TYPES);
+        constexpr UINT DirectQueue = static_cast<UINT>(QueueType::DIRECT);
+
+        // Per queue, number of positions known to be complete. Positions of a queue below it are covered.
+        using Clock = std::array<UINT, QueueCount>;
+
+        const UINT count = static_cast<UINT>(queues.size());
+
+        QueueSyncPlan plan;
+        plan.signals.assign(count, false);
+        plan.waits.resize(count);
+
+        std::array<Clock, QueueCount> queueClocks = {};
+        std::vector<Clock> passClocks(count); // clock of the queue right after each pass
+        UINT crossDependencyCount = 0;
+
+        auto wait = [&](Clock& clock, UINT signal)
+        {
+            plan.signals[signal] = true;
+            ++plan.syncPointCount;
+            for (UINT queue = 0; queue < QueueCount; ++queue)
+                clock[queue] = (std::max)(clock[queue], passClocks[signal][queue]);
+        };
+
+        std::vector<UINT> candidates;
+        for (UINT position = 0; position < count; ++position)
+        {
+            const UINT queue = static_cast<UINT>(queues[position]);
+            auto& clock = queueClocks[queue];
+
+            candidates.clear();
+            for (UINT dependency : dependencies[position])
+            {
+                assert(dependency < position);
+                const UINT other = static_cast<UINT>(queues[dependency]);
+                if (other == queue)
+                    continue;
+
+                ++crossDependencyCount;
+                if (clock[other] > dependency)
+                    continue;
+
+                auto it = std::find_if(
+                    candidates.begin(),
+                    candidates.end(),
+                    [&](UINT candidate)
+                    {
+                        return queues[candidate] == queues[dependency];
+                    });
+                if (it == candidates.end())
+                    candidates.push_back(dependency);
+                else
+                    *it = (std::max)(*it, dependency);
+            }
+
+            // Latest first. What it covers may include the candidates of other queues.
+            std::sort(candidates.begin(), candidates.end(), std::greater<UINT>());
+            for (UINT signal : candidates)
+            {
+                if (clock[static_cast<UINT>(queues[signal])] > signal)
+                    continue;
+
+                plan.waits[position].push_back(signal);
+                wait(clock, signal);
+            }
+
+            clock[queue] = position + 1;
+            passClocks[position] = clock;
+        }
+
+        // Frame fence is signaled on the direct queue, so it joins the other queues at frame end.
+        auto& directClock = queueClocks[DirectQueue];
+        for (UINT position = count; position-- > 0;)
+        {
+            if (directClock[static_cast<UINT>(queues[position])] > position)
+                continue;
+
+            plan.frameEndWaits.push_back(position);
+            wait(directClock, position);
+        }
+
+        plan.coveredDependencyCount = crossDependencyCount - (plan.syncPointCount - static_cast<UINT>(plan.frameEndWaits.size()));
+        return plan;
+    }
+
+    // Cover subresources set in mask with mip x array x plane boxes. Mask is indexed by subresource index.
+    // Greedy: extend each box along mips, then array slices, then planes. Full coverage becomes a single all-subresources range.
+    static std::vector<D3D12_BARRIER_SUBRESOURCE_RANGE> MergeSubresourceRanges(
+        const std::vector<bool>& mask,
+        UINT mipLevels,
+        UINT arraySize,
+        UINT planeCount)
+    {
+        std::vector<D3D12_BARRIER_SUBRESOURCE_RANGE> ranges;
+        if (std::all_of(mask.begin(), mask.end(), [](bool b) { return b; }))
+        {
+            ranges.push_back({0xffff'ffff, 0, 0, 0, 0, 0});
+            return ranges;
+        }
+
+        std::vector<bool> isTaken(mask.size());
+        auto isFree = [&](UINT mip, UINT array, UINT plane)
+        {
+            UINT idx = D3DHelper::CalcSubresourceIndex(mip, array, plane, mipLevels, arraySize);
+            return mask[idx] && !isTaken[idx];
+        };
+
+        for (UINT plane = 0; plane < planeCount; ++plane)
+        {
+            for (UINT array = 0; array < arraySize; ++array)
+            {
+                for (UINT mip = 0; mip < mipLevels; ++mip)
+                {
+                    if (!isFree(mip, array, plane))
+                        continue;
+
+                    UINT numMips = 1;
+                    while (mip + numMips < mipLevels && isFree(mip + numMips, array, plane))
+                        ++numMips;
+
+                    auto isRowFree = [&](UINT a, UINT p)
+                    {
+                        for (UINT m = mip; m < mip + numMips; ++m)
+                        {
+                            if (!isFree(m, a, p))
+                                return false;
+                        }
+                        return true;
+                    };
+
+                    UINT numArrays = 1;
+                    while (array + numArrays < arraySize && isRowFree(array + numArrays, plane))
+                        ++numArrays;
+
+                    auto isSlabFree = [&](UINT p)
+                    {
+                        for (UINT a = array; a < array + numArrays; ++a)
+                        {
+                            if (!isRowFree(a, p))
+                                return false;
+                        }
+                        return true;
+                    };
+
+                    UINT numPlanes = 1;
+                    while (plane + numPlanes < planeCount && isSlabFree(plane + numPlanes))
+                        ++numPlanes;
+
+                    for (UINT p = plane; p < plane + numPlanes; ++p)
+                    {
+                        for (UINT a = array; a < array + numArrays; ++a)
+                        {
+                            for (UINT m = mip; m < mip + numMips; ++m)
+                                isTaken[D3DHelper::CalcSubresourceIndex(m, a, p, mipLevels, arraySize)] = true;
+                        }
+                    }
+
+                    ranges.push_back({mip, numMips, array, numArrays, plane, numPlanes});
+                }
+            }
+        }
+
+        return ranges;
+    }
+
+    // Every BEGIN is followed by its END in the same command list, and no pass in between accesses the same subresources.
+    // Texture barriers and nodes are per pass, dimensions per texture group. Needs no device.
+    static bool IsSplitScheduleValid(
+        const std::vector<PassType>& order,
+        const std::array<std::vector<CompiledTextureBarrier>, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)>& textureBarriers,
+        const std::array<RenderGraphNode, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)>& nodes,
+        const std::vector<TextureDimension>& dimensions)
+    {
+        const UINT count = static_cast<UINT>(order.size());
+        UINT beginCount = 0;
+        UINT endCount = 0;
+
+        for (UINT begin = 0; begin < count; ++begin)
+        {
+            for (const auto& barrier : textureBarriers[static_cast<UINT>(order[begin])])
+            {
+                if (barrier.split == BarrierSplit::END)
+                    ++endCount;
+                if (barrier.split != BarrierSplit::BEGIN)
+                    continue;
+
+                ++beginCount;
+                auto mask = GetSubresourceMask(barrier.subresourceRange, dimensions[barrier.texture.index]);
+
+                auto overlaps = [&](RGTexture texture, const D3D12_BARRIER_SUBRESOURCE_RANGE& range)
+                {
+                    if (texture.index != barrier.texture.index)
+                        return false;
+
+                    auto other = GetSubresourceMask(range, dimensions[texture.index]);
+                    for (UINT i = 0; i < static_cast<UINT>(mask.size()); ++i)
+                    {
+                        if (mask[i] && other[i])
+                            return true;
+                    }
+                    return false;
+                };
+
+                bool isEnded = false;
+                for (UINT position = begin; position < count && !isEnded; ++position)
+                {
+                    const auto& node = nodes[static_cast<UINT>(order[position])];
+
+                    // END is issued before the pass runs, so it is in another list if the pass starts one.
+                    if (position > begin)
+                    {
+                        if (node.startsCommandList)
+                            return false;
+
+                        for (const auto& other : textureBarriers[static_cast<UINT>(order[position])])
+                        {
+                            if (other.split == BarrierSplit::END && IsSameTransition(other, barrier))
+                                isEnded = true;
+                        }
+                        if (isEnded)
+                            break;
+                    }
+
+                    for (const auto& [texture, usage, range] : node.textureInputs)
+                    {
+                        if (overlaps(texture, range))
+                            return false;
+                    }
+                    for (const auto& [texture, usage, range] : node.textureOutputs)
+                    {
+                        if (overlaps(texture, range))
+                            return false;
+                    }
+                }
+
+                if (!isEnded)
+                    return false;
+            }
+        }
+
+        return beginCount == endCount;
+    }
+
+    // Subresources in range, indexed by subresource index
+    static std::vector<bool> GetSubresourceMask(const D3D12_BARRIER_SUBRESOURCE_RANGE& range, const TextureDimension& dimension)
+    {
+        const auto& [IndexOrFirstMipLevel, NumMipLevels, FirstArraySlice, NumArraySlices, FirstPlane, NumPlanes] = range;
+
+        if (IndexOrFirstMipLevel == 0xffff'ffff && NumMipLevels == 0)
+            return std::vector<bool>(dimension.subresourceCount, true);
+
+        std::vector<bool> mask(dimension.subresourceCount);
+        if (NumMipLevels == 0)
+        {
+            mask[IndexOrFirstMipLevel] = true;
+            return mask;
+        }
+
+        for (UINT plane = FirstPlane; plane < FirstPlane + NumPlanes; ++plane)
+        {
+            for (UINT array = FirstArraySlice; array < FirstArraySlice + NumArraySlices; ++array)
+            {
+                for (UINT mip = IndexOrFirstMipLevel; mip < IndexOrFirstMipLevel + NumMipLevels; ++mip)
+                    mask[D3DHelper::CalcSubresourceIndex(mip, array, plane, dimension.mipLevels, dimension.arraySize)] = true;
+            }
+        }
+        return mask;
+    }
+
     std::vector<ID3D12Resource*> GetResources(RGBuffer buffer, UINT frameIndex = 0) const
     {
         auto& group = m_bufferGroups[buffer.index];
@@ -116,9 +653,12 @@ public:
         AddElementHelper(buffer.index, pResources, m_bufferGroups);
     }
 
+    // Added or updated textures must be in initialUsage. They are brought to the state of the group at the start of their next frame.
     void AddElement(RGTexture texture, std::vector<ID3D12Resource*> pResources)
     {
         AddElementHelper(texture.index, pResources, m_textureGroups);
+        for (auto* pResource : pResources)
+            m_joiningTextures.emplace_back(texture.index, pResource);
     }
 
     void UpdateElement(RGBuffer buffer, UINT elementIndex, std::vector<ID3D12Resource*> pResources)
@@ -129,6 +669,8 @@ public:
     void UpdateElement(RGTexture texture, UINT elementIndex, std::vector<ID3D12Resource*> pResources)
     {
         UpdateElementHelper(texture.index, elementIndex, pResources, m_textureGroups);
+        for (auto* pResource : pResources)
+            m_joiningTextures.emplace_back(texture.index, pResource);
     }
 
     ID3D12Resource* Resolve(RGBuffer buffer, UINT elementIndex, UINT frameIndex) const
@@ -143,7 +685,17 @@ public:
 
     std::tuple<UINT, UINT, UINT> GetResourceDimension(ID3D12Device* pDevice, RGTexture texture) const
     {
-        auto desc = m_textureGroups[texture.index].pResources.front()->GetDesc();
+        auto& group = m_textureGroups[texture.index];
+
+        // Transient ones may not be created yet.
+        if (group.isTransient)
+        {
+            const auto& desc = group.descs.front();
+            UINT8 planeCount = D3DHelper::GetFormatPlaneCount(pDevice, desc.Format);
+            return {desc.MipLevels, desc.DepthOrArraySize, planeCount};
+        }
+
+        auto desc = group.pResources.front()->GetDesc();
         UINT8 planeCount = D3DHelper::GetFormatPlaneCount(pDevice, desc.Format);
         return {desc.MipLevels, desc.DepthOrArraySize, planeCount};
     }
@@ -168,50 +720,542 @@ public:
         return {m_textureMap.at(name)};
     }
 
-    void Compile()
+    // For textures leaving the graph in a fixed usage after the last pass, such as presented back buffers.
+    void SetFrameEndUsage(RGTexture texture, TextureResourceUsage usage)
+    {
+        m_textureGroups[texture.index].hasFrameEndUsage = true;
+        m_textureGroups[texture.index].frameEndUsage = usage;
+    }
+
+    // Per-frame condition for passes. Passes whose condition is false are culled.
+    RGPredicate RegisterPredicate(const std::string& name)
+    {
+        UINT idx = static_cast<UINT>(m_predicateMap.size());
+        assert(idx < 32);
+        m_predicateMap[name] = idx;
+        return {idx};
+    }
+
+    RGPredicate GetRGPredicate(const std::string& name)
+    {
+        return {m_predicateMap.at(name)};
+    }
+
+    // Switches to the plan of the new predicate combination. Each combination is compiled only once.
+    void SetPredicate(RGPredicate predicate, bool value)
+    {
+        UINT bit = 1u << predicate.index;
+        UINT predicates = value ? (m_predicates | bit) : (m_predicates & ~bit);
+        if (predicates == m_predicates)
+            return;
+
+        m_predicates = predicates;
+        m_pCurrentPlan = &GetOrCompilePlan(m_predicates);
+    }
+
+    // Passes that do not contribute to any output are culled.
+    void MarkAsOutput(RGTexture texture)
+    {
+        m_outputTextures.push_back(texture.index);
+    }
+
+    // Schedule passes, plan transient memory, and compile the plan of current predicates.
+    // Call again when declarations or transient sizes change. Plans of configurations seen before are taken from the cache.
+    void Compile()
+    {
+        m_topologyHash = HashTopology();
+
+        BuildSchedule();
+        PlanTransientTextures();
+        InitTextureStates();
+
+        m_pCurrentPlan = &GetOrCompilePlan(m_predicates);
+    }
+
+    // Order to record passes in. Culled passes are not included.
+    const std::vector<PassType>& GetCompiledOrder() const
+    {
+        return m_pCurrentPlan->order;
+    }
+
+    const std::vector<CompiledBufferBarrier>& GetCompiledBufferBarriers(PassType passType) const
+    {
+        return m_pCurrentPlan->bufferBarriers[static_cast<UINT>(passType)];
+    }
+
+    const std::vector<CompiledTextureBarrier>& GetCompiledTextureBarrier(PassType passType) const
+    {
+        return m_pCurrentPlan->textureBarriers[static_cast<UINT>(passType)];
+    }
+
+    // Issued after the pass, for textures moving to another queue
+    const std::vector<CompiledTextureBarrier>& GetCompiledReleaseTextureBarriers(PassType passType) const
+    {
+        return m_pCurrentPlan->releaseTextureBarriers[static_cast<UINT>(passType)];
+    }
+
+    // Per position in GetCompiledOrder(), earlier positions the pass must run after
+    const std::vector<std::vector<UINT>>& GetCompiledDependencies() const
+    {
+        return m_pCurrentPlan->dependencies;
+    }
+
+    // Call once per frame before GetPassBarriers.
+    // Barriers of the current plan are re-resolved only when a resource has changed since the last time for the frame.
+    void PrepareBarriers(UINT frameIndex)
+    {
+        RefreshDynamicResources(m_bufferGroups, nullptr);
+        RefreshDynamicResources(m_textureGroups, &m_joiningTextures);
+        BridgeTextureStates(frameIndex);
+
+        if (m_pCurrentPlan->patchedVersions[frameIndex] != m_resourceVersion)
+            PatchBarriers(*m_pCurrentPlan, frameIndex);
+    }
+
+    // No allocation. Valid until the next PrepareBarriers.
+    PassBarriers& GetPassBarriers(PassType passType, UINT frameIndex)
+    {
+        return m_pCurrentPlan->passBarriers[frameIndex][static_cast<UINT>(passType)];
+    }
+
+    // Releases resources moving to another queue. Issue right after the pass, before its queue signals.
+    PassBarriers& GetPassReleaseBarriers(PassType passType, UINT frameIndex)
+    {
+        return m_pCurrentPlan->releaseBarriers[frameIndex][static_cast<UINT>(passType)];
+    }
+
+    // Signals and waits of the current plan, by position in GetCompiledOrder().
+    const QueueSyncPlan& GetQueueSyncPlan() const
+    {
+        return m_pCurrentPlan->sync;
+    }
+
+    // Brings textures from their actual state to the one the current plan begins with. Issue before the first pass.
+    PassBarriers& GetFrameBeginBarriers()
+    {
+        return m_frameBeginBarriers;
+    }
+
+    UINT GetBarrierPatchCount() const
+    {
+        return m_barrierPatchCount;
+    }
+
+    // Compiled texture barriers of the current plan, before and after merging subresources
+    UINT GetUnmergedTextureBarrierCount() const
+    {
+        return m_pCurrentPlan->unmergedTextureBarrierCount;
+    }
+
+    UINT GetTextureBarrierCount() const
+    {
+        return m_pCurrentPlan->textureBarrierCount;
+    }
+
+    UINT GetSplitBarrierCount() const
+    {
+        return m_pCurrentPlan->splitBarrierCount;
+    }
+
+    UINT GetCachedPlanCount() const
+    {
+        return static_cast<UINT>(m_plans.size());
+    }
+
+    // Plan lookups by Compile() and SetPredicate(). Misses compile a new plan.
+    UINT GetPlanCacheHitCount() const
+    {
+        return m_planCacheHitCount;
+    }
+
+    UINT GetPlanCacheMissCount() const
+    {
+        return m_planCacheMissCount;
+    }
+
+    // CPU time of the last plan compiled on a miss
+    double GetLastCompileMs() const
+    {
+        return m_lastCompileMs;
+    }
+
+    std::array<RenderGraphNode, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)> m_nodes;
+
+private:
+    static constexpr UINT PassCount = static_cast<UINT>(PassType::NUM_PASS_TYPES);
+    static constexpr UINT PlanCacheCapacity = 16;
+
+    struct CompiledPlan
+    {
+        std::vector<PassType> order;
+        std::array<std::vector<CompiledBufferBarrier>, PassCount> bufferBarriers;
+        std::array<std::vector<CompiledTextureBarrier>, PassCount> textureBarriers;
+
+        // Resolved per frame. Rebuilt when patchedVersions falls behind m_resourceVersion.
+        std::array<std::array<PassBarriers, PassCount>, FrameCount> passBarriers;
+        std::array<UINT64, FrameCount> patchedVersions;
+
+        UINT unmergedTextureBarrierCount = 0;
+        UINT textureBarrierCount = 0;
+        UINT splitBarrierCount = 0; // BEGIN/END pairs
+
+        // Texture usages at frame start, per group and subresource. Same as the ones at frame end.
+        std::vector<std::vector<TextureResourceUsage>> entryUsages;
+
+        // Issued after the pass, when a resource moves to another queue.
+        std::array<std::vector<CompiledTextureBarrier>, PassCount> releaseTextureBarriers;
+        std::array<std::array<PassBarriers, PassCount>, FrameCount> releaseBarriers;
+
+        // Per position, earlier positions it must run after. Only the ones on other queues need sync.
+        std::vector<std::vector<UINT>> dependencies;
+        QueueSyncPlan sync;
+    };
+
+    // Both fields are compared on lookup, so plans of different predicates never share a slot on a hash collision.
+    struct PlanKey
+    {
+        UINT64 topologyHash;
+        UINT predicates;
+
+        bool operator==(const PlanKey& other) const
+        {
+            return topologyHash == other.topologyHash && predicates == other.predicates;
+        }
+    };
+
+    struct PlanKeyHash
+    {
+        std::size_t operator()(const PlanKey& key) const
+        {
+            std::size_t seed = 0;
+            Utility::HashCombine(seed, key.topologyHash);
+            Utility::HashCombine(seed, key.predicates);
+            return seed;
+        }
+    };
+
+    struct CachedPlan
+    {
+        PlanKey key;
+        CompiledPlan plan;
+    };
+
+    // Keyed by topology hash and predicates. Least recently used plan is evicted beyond PlanCacheCapacity.
+    CompiledPlan& GetOrCompilePlan(UINT predicates)
+    {
+        PlanKey key = {m_topologyHash, predicates};
+
+        auto it = m_planLookup.find(key);
+        if (it != m_planLookup.end())
+        {
+            ++m_planCacheHitCount;
+            m_plans.splice(m_plans.begin(), m_plans, it->second);
+            return it->second->plan;
+        }
+
+        ++m_planCacheMissCount;
+        auto compileBegin = std::chrono::steady_clock::now();
+
+        m_plans.emplace_front();
+        m_plans.front().key = key;
+        m_planLookup[key] = m_plans.begin();
+
+        // Subsequence of the full order, so lifetimes in the transient memory plan still hold.
+        auto isActive = FindActivePasses(predicates);
+        CompiledPlan& plan = m_plans.front().plan;
+        plan.patchedVersions.fill(UINT64_MAX);
+        std::array<UINT, PassCount> positions;
+        for (PassType passType : m_fullOrder)
+        {
+            if (!isActive[static_cast<UINT>(passType)])
+                continue;
+
+            positions[static_cast<UINT>(passType)] = static_cast<UINT>(plan.order.size());
+            plan.order.push_back(passType);
+        }
+
+        // Data flow between active passes. Barrier compilation adds the queue transfers.
+        auto predecessors = BuildPredecessors(isActive);
+        plan.dependencies.resize(plan.order.size());
+        for (UINT position = 0; position < static_cast<UINT>(plan.order.size()); ++position)
+        {
+            for (UINT producer : predecessors[static_cast<UINT>(plan.order[position])])
+                plan.dependencies[position].push_back(positions[producer]);
+        }
+
+        // Steady state. A frame begins where the previous one with this plan ended,
+        // so first uses transition from the last usage directly, without resetting at frame end.
+        CompiledPlan scratch;
+        scratch.order = plan.order;
+        plan.entryUsages = CompileBarriers(scratch, GetInitialTextureUsages());
+        CompileBarriers(plan, plan.entryUsages);
+        assert(IsSplitScheduleValid(plan.order, plan.textureBarriers, m_nodes, GetTextureDimensions()));
+
+        std::vector<QueueType> queues;
+        for (PassType passType : plan.order)
+            queues.push_back(m_nodes[static_cast<UINT>(passType)].queue);
+        plan.sync = PlanQueueSync(queues, plan.dependencies);
+
+        m_lastCompileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileBegin).count();
+
+        // New plan is at the front, so it is never the one evicted.
+        while (m_plans.size() > PlanCacheCapacity)
+        {
+            m_planLookup.erase(m_plans.back().key);
+            m_plans.pop_back();
+        }
+        return plan;
+    }
+
+    // Everything compiled plans depend on: node declarations, resource descriptors and outputs.
+    // Resources themselves are resolved per frame, so they are left out.
+    UINT64 HashTopology() const
+    {
+        std::size_t seed = 0;
+
+        auto hashBufferUsage = [&](const BufferResourceUsage& usage)
+        {
+            Utility::HashCombine(seed, usage.sync);
+            Utility::HashCombine(seed, usage.access);
+        };
+        auto hashTextureUsage = [&](const TextureResourceUsage& usage)
+        {
+            Utility::HashCombine(seed, usage.sync);
+            Utility::HashCombine(seed, usage.access);
+            Utility::HashCombine(seed, usage.layout);
+        };
+        auto hashTextureUsages = [&](const std::vector<std::tuple<RGTexture, TextureResourceUsage, D3D12_BARRIER_SUBRESOURCE_RANGE>>& usages)
+        {
+            Utility::HashCombine(seed, usages.size());
+            for (const auto& [texture, usage, range] : usages)
+            {
+                Utility::HashCombine(seed, texture.index);
+                hashTextureUsage(usage);
+                Utility::HashCombine(seed, range.IndexOrFirstMipLevel);
+                Utility::HashCombine(seed, range.NumMipLevels);
+                Utility::HashCombine(seed, range.FirstArraySlice);
+                Utility::HashCombine(seed, range.NumArraySlices);
+                Utility::HashCombine(seed, range.FirstPlane);
+                Utility::HashCombine(seed, range.NumPlanes);
+            }
+        };
+        auto hashVersions = [&](const auto& resources)
+        {
+            Utility::HashCombine(seed, resources.size());
+            for (const auto& resource : resources)
+            {
+                Utility::HashCombine(seed, resource.index);
+                Utility::HashCombine(seed, resource.version);
+            }
+        };
+
+        for (const auto& node : m_nodes)
+        {
+            Utility::HashCombine(seed, node.conditionMask);
+            Utility::HashCombine(seed, node.queue);
+            Utility::HashCombine(seed, node.startsCommandList);
+
+            Utility::HashCombine(seed, node.bufferInputs.size());
+            for (const auto& [buffer, usage] : node.bufferInputs)
+            {
+                Utility::HashCombine(seed, buffer.index);
+                hashBufferUsage(usage);
+            }
+            Utility::HashCombine(seed, node.bufferOutputs.size());
+            for (const auto& [buffer, usage] : node.bufferOutputs)
+            {
+                Utility::HashCombine(seed, buffer.index);
+                hashBufferUsage(usage);
+            }
+            hashTextureUsages(node.textureInputs);
+            hashTextureUsages(node.textureOutputs);
+
+            hashVersions(node.bufferReads);
+            hashVersions(node.bufferWrites);
+            hashVersions(node.textureReads);
+            hashVersions(node.textureWrites);
+        }
+
+        Utility::HashCombine(seed, m_bufferGroups.size());
+        for (const auto& group : m_bufferGroups)
+            Utility::HashCombine(seed, group.isPerFrame);
+
+        Utility::HashCombine(seed, m_textureGroups.size());
+        for (const auto& group : m_textureGroups)
+        {
+            Utility::HashCombine(seed, group.isPerFrame);
+            Utility::HashCombine(seed, group.subresourceCount);
+            hashTextureUsage(group.initialUsage);
+            Utility::HashCombine(seed, group.hasFrameEndUsage);
+            if (group.hasFrameEndUsage)
+                hashTextureUsage(group.frameEndUsage);
+
+            // Sizes of transient elements decide how they alias.
+            Utility::HashCombine(seed, group.isTransient);
+            Utility::HashCombine(seed, group.descs.size());
+            for (const auto& desc : group.descs)
+            {
+                Utility::HashCombine(seed, desc.Dimension);
+                Utility::HashCombine(seed, desc.Width);
+                Utility::HashCombine(seed, desc.Height);
+                Utility::HashCombine(seed, desc.DepthOrArraySize);
+                Utility::HashCombine(seed, desc.MipLevels);
+                Utility::HashCombine(seed, desc.Format);
+                Utility::HashCombine(seed, desc.SampleDesc.Count);
+                Utility::HashCombine(seed, desc.Flags);
+            }
+        }
+
+        Utility::HashCombine(seed, m_outputTextures.size());
+        for (UINT texture : m_outputTextures)
+            Utility::HashCombine(seed, texture);
+
+        return seed;
+    }
+
+    std::vector<std::vector<TextureResourceUsage>> GetInitialTextureUsages() const
+    {
+        std::vector<std::vector<TextureResourceUsage>> usages(m_textureGroups.size());
+        for (UINT i = 0; i < m_textureGroups.size(); ++i)
+            usages[i].assign(m_textureGroups[i].subresourceCount, m_textureGroups[i].initialUsage);
+        return usages;
+    }
+
+    // Returns texture usages at frame end.
+    std::vector<std::vector<TextureResourceUsage>> CompileBarriers(CompiledPlan& plan, std::vector<std::vector<TextureResourceUsage>> currentTextureUsages)
     {
         std::vector<BufferResourceUsage> currentBufferUsages(m_bufferGroups.size());
+        plan.dependencies.resize(plan.order.size());
+
+        // Queue and position of the latest use of each resource. Frame begins on the direct queue.
+        std::vector<QueueType> bufferQueues(m_bufferGroups.size(), QueueType::DIRECT);
+        std::vector<UINT> bufferPositions(m_bufferGroups.size(), UINT_MAX);
+        std::vector<QueueType> textureQueues(m_textureGroups.size(), QueueType::DIRECT);
+        std::vector<QueueType> firstTextureQueues(m_textureGroups.size(), QueueType::DIRECT);
+        std::vector<UINT> texturePositions(m_textureGroups.size(), UINT_MAX);
 
-        // Use initialLayout when using newly created resources.
-        // For existing resources, use values queried from m_frameEndUsage.
-        std::vector<std::vector<TextureResourceUsage>> currentTextureUsages(m_textureGroups.size());
+        // Position of the last pass accessing each subresource. Split barriers begin after it.
+        std::vector<std::vector<UINT>> lastPositions(m_textureGroups.size());
         for (UINT i = 0; i < m_textureGroups.size(); ++i)
+            lastPositions[i].assign(m_textureGroups[i].subresourceCount, UINT_MAX);
+
+        // First use of each texture in this plan. Culled passes can make it later than in the memory plan.
+        std::vector<UINT> firstPositions(m_textureGroups.size(), UINT_MAX);
+        for (UINT position = 0; position < static_cast<UINT>(plan.order.size()); ++position)
         {
-            auto& group = m_textureGroups[i];
-            UINT subresourceCount = group.subresourceCount;
-            currentTextureUsages[i] = std::vector<TextureResourceUsage>(subresourceCount, group.initialUsage);
+            const auto& node = m_nodes[static_cast<UINT>(plan.order[position])];
+            for (RGTexture texture : node.textureReads)
+                firstPositions[texture.index] = (std::min)(firstPositions[texture.index], position);
+            for (RGTexture texture : node.textureWrites)
+                firstPositions[texture.index] = (std::min)(firstPositions[texture.index], position);
         }
 
-        std::vector<PassType> defaultOrder = {
-            PassType::SHADOW_MAP,
-            PassType::GBUFFER,
-            PassType::DEFERRED_LIGHTING,
-            PassType::FORWARD_COLORING,
-            PassType::SELECTION_MASK,
-            PassType::HORIZONTAL_DILATE,
-            PassType::OUTLINE_DRAWING,
-            PassType::TONEMAP};
+        // Sync of the latest use of each texture. Next texture placed in the same memory waits for it.
+        std::vector<D3D12_BARRIER_SYNC> latestSyncs(m_textureGroups.size(), D3D12_BARRIER_SYNC_NONE);
+        std::vector<bool> isActivated(m_textureGroups.size());
+
+        // Subresource index and its usage before, for one input
+        std::vector<SubresourceTransition> transitions;
+
+        // Fence orders the queues, so the new queue begins with no sync to wait for.
+        auto transferBuffer = [&](UINT bufferIdx, QueueType queue, UINT position)
+        {
+            if (bufferQueues[bufferIdx] != queue)
+            {
+                if (bufferPositions[bufferIdx] != UINT_MAX)
+                    plan.dependencies[position].push_back(bufferPositions[bufferIdx]);
+                currentBufferUsages[bufferIdx] = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS};
+                bufferQueues[bufferIdx] = queue;
+            }
+            bufferPositions[bufferIdx] = position;
+        };
+
+        // Textures are released to the common layout after the last use on the old queue, which every queue can transition from.
+        auto transferTexture = [&](UINT groupIdx, QueueType queue, UINT position)
+        {
+            if (texturePositions[groupIdx] == UINT_MAX)
+                firstTextureQueues[groupIdx] = queue;
+
+            if (textureQueues[groupIdx] != queue)
+            {
+                if (texturePositions[groupIdx] != UINT_MAX)
+                {
+                    AppendReleaseBarriers(plan, texturePositions[groupIdx], groupIdx, currentTextureUsages[groupIdx]);
+                    plan.dependencies[position].push_back(texturePositions[groupIdx]);
+                }
+
+                for (auto& usage : currentTextureUsages[groupIdx])
+                {
+                    usage.sync = D3D12_BARRIER_SYNC_NONE;
+                    usage.access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+                }
+                std::fill(lastPositions[groupIdx].begin(), lastPositions[groupIdx].end(), UINT_MAX);
+                textureQueues[groupIdx] = queue;
+            }
+            texturePositions[groupIdx] = position;
+        };
 
         // Compile graph
-        for (const PassType& passType : defaultOrder)
+        for (UINT position = 0; position < static_cast<UINT>(plan.order.size()); ++position)
         {
-            auto& node = m_nodes[static_cast<UINT>(passType)];
+            const UINT pass = static_cast<UINT>(plan.order[position]);
+            auto& node = m_nodes[pass];
+
+            // Aliased transient textures begin their lifetime with undefined contents.
+            // First barrier discards them, after the last use of the previous texture in that memory.
+            std::fill(isActivated.begin(), isActivated.end(), false);
+            for (UINT i = 0; i < static_cast<UINT>(m_transientRequests.size()); ++i)
+            {
+                UINT groupIdx = m_transientElements[i].group;
+                if (firstPositions[groupIdx] != position || !m_transientPlan.isAliased[i])
+                    continue;
+
+                auto& latestUsages = currentTextureUsages[groupIdx];
+                if (!isActivated[groupIdx])
+                {
+                    std::fill(latestUsages.begin(), latestUsages.end(), TextureResourceUsage{D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_UNDEFINED});
+                    std::fill(lastPositions[groupIdx].begin(), lastPositions[groupIdx].end(), UINT_MAX);
+                    textureQueues[groupIdx] = node.queue;
+                    isActivated[groupIdx] = true;
+                }
+
+                // Previous one of the frame before is already fenced. One on another queue is waited for by fence.
+                UINT previous = m_transientPlan.previousRequests[i];
+                if (previous != UINT_MAX)
+                {
+                    UINT previousGroupIdx = m_transientElements[previous].group;
+                    if (textureQueues[previousGroupIdx] == node.queue)
+                    {
+                        for (auto& usage : latestUsages)
+                            usage.sync |= latestSyncs[previousGroupIdx];
+                    }
+                    else if (texturePositions[previousGroupIdx] != UINT_MAX)
+                    {
+                        plan.dependencies[position].push_back(texturePositions[previousGroupIdx]);
+                    }
+                }
+            }
 
             // Process buffer inputs
             for (auto& [buffer, usage] : node.bufferInputs)
             {
+                transferBuffer(buffer.index, node.queue, position);
                 CompiledBufferBarrier barrier = {buffer, currentBufferUsages[buffer.index], usage};
                 currentBufferUsages[buffer.index] = usage;
-                node.bufferBarriers.push_back(barrier);
+                plan.bufferBarriers[pass].push_back(barrier);
             }
 
             // Process texture inputs
             for (auto& [texture, usage, range] : node.textureInputs)
             {
+                transferTexture(texture.index, node.queue, position);
                 auto& latestUsages = currentTextureUsages[texture.index];
+                auto& latestPositions = lastPositions[texture.index];
+                latestSyncs[texture.index] = usage.sync;
 
                 const auto& [IndexOrFirstMipLevel, NumMipLevels, FirstArraySlice, NumArraySlices, FirstPlane, NumPlanes] = range;
 
+                transitions.clear();
                 if (IndexOrFirstMipLevel == 0xffff'ffff && NumMipLevels == 0)
                 {
                     UINT subresourceCount = m_textureGroups[texture.index].subresourceCount;
@@ -220,10 +1264,10 @@ public:
                     {
                         if (latestUsages[i] != usage)
                         {
-                            CompiledTextureBarrier barrier = {texture, latestUsages[i], usage, {i, 0, 0, 0, 0, 0}};
+                            transitions.push_back({i, latestUsages[i], GetSplitBeginPosition(plan, latestPositions[i], position, latestUsages[i])});
                             latestUsages[i] = usage;
-                            node.textureBarriers.push_back(barrier);
                         }
+                        latestPositions[i] = position;
                     }
                 }
                 else
@@ -240,26 +1284,31 @@ public:
 
                                 if (latestUsages[subresourceIndex] != usage)
                                 {
-                                    CompiledTextureBarrier barrier = {texture, latestUsages[subresourceIndex], usage, {subresourceIndex, 0, 0, 0, 0, 0}};
+                                    transitions.push_back({subresourceIndex, latestUsages[subresourceIndex], GetSplitBeginPosition(plan, latestPositions[subresourceIndex], position, latestUsages[subresourceIndex])});
                                     latestUsages[subresourceIndex] = usage;
-                                    node.textureBarriers.push_back(barrier);
                                 }
+                                latestPositions[subresourceIndex] = position;
                             }
                         }
                     }
                 }
+
+                AppendMergedTextureBarriers(plan, plan.textureBarriers, position, texture, usage, transitions);
             }
 
             // Process buffer outputs
             for (auto& [buffer, usage] : node.bufferOutputs)
             {
+                transferBuffer(buffer.index, node.queue, position);
                 currentBufferUsages[buffer.index] = usage;
             }
 
             // Process texture outputs
             for (auto& [texture, usage, range] : node.textureOutputs)
             {
+                transferTexture(texture.index, node.queue, position);
                 auto& latestUsages = currentTextureUsages[texture.index];
+                auto& latestPositions = lastPositions[texture.index];
 
                 const auto& [IndexOrFirstMipLevel, NumMipLevels, FirstArraySlice, NumArraySlices, FirstPlane, NumPlanes] = range;
 
@@ -270,6 +1319,7 @@ public:
                     for (UINT i = 0; i < subresourceCount; ++i)
                     {
                         latestUsages[i] = usage;
+                        latestPositions[i] = position;
                     }
                 }
                 else
@@ -288,27 +1338,475 @@ public:
                                 {
                                     latestUsages[subresourceIndex] = usage;
                                 }
+                                latestPositions[subresourceIndex] = position;
                             }
                         }
                     }
                 }
             }
         }
+
+        // Next frame begins on the direct queue. Textures used on another queue at either end of the frame are left released.
+        for (UINT i = 0; i < static_cast<UINT>(m_textureGroups.size()); ++i)
+        {
+            if (texturePositions[i] != UINT_MAX && (firstTextureQueues[i] != QueueType::DIRECT || textureQueues[i] != QueueType::DIRECT))
+                AppendReleaseBarriers(plan, texturePositions[i], i, currentTextureUsages[i]);
+        }
+
+        for (UINT i = 0; i < m_textureGroups.size(); ++i)
+        {
+            if (m_textureGroups[i].hasFrameEndUsage)
+                std::fill(currentTextureUsages[i].begin(), currentTextureUsages[i].end(), m_textureGroups[i].frameEndUsage);
+        }
+
+        return currentTextureUsages;
     }
 
-    const std::vector<CompiledBufferBarrier>& GetCompiledBufferBarriers(PassType passType) const
+    static UINT64 VersionKey(UINT index, UINT version)
     {
-        return m_nodes[static_cast<UINT>(passType)].bufferBarriers;
+        return (static_cast<UINT64>(index) << 32) | version;
     }
 
-    const std::vector<CompiledTextureBarrier>& GetCompiledTextureBarrier(PassType passType) const
+    // Add an edge for each producer -> consumer, and for each reader -> next writer of the same contents.
+    // Disabled passes leave the contents as they are, so their versions pass through to earlier ones.
+    template <typename Handle>
+    void AddDataFlowEdges(
+        std::vector<Handle> RenderGraphNode::*reads,
+        std::vector<Handle> RenderGraphNode::*writes,
+        const std::array<bool, PassCount>& isEnabled,
+        std::array<std::vector<UINT>, PassCount>& predecessors) const
+    {
+        std::unordered_map<UINT64, UINT> producers;
+        std::unordered_map<UINT64, std::vector<UINT>> readers;
+        for (UINT pass = 0; pass < PassCount; ++pass)
+        {
+            for (const Handle& handle : m_nodes[pass].*writes)
+            {
+                [[maybe_unused]] bool isFirstWrite = producers.emplace(VersionKey(handle.index, handle.version + 1), pass).second;
+                assert(isFirstWrite && "Each version can be written by only one pass");
+            }
+
+            if (!isEnabled[pass])
+                continue;
+
+            for (const Handle& handle : m_nodes[pass].*reads)
+                readers[VersionKey(handle.index, handle.version)].push_back(pass);
+        }
+
+        auto addEdge = [&](UINT from, UINT to)
+        {
+            auto& list = predecessors[to];
+            if (from != to && std::find(list.begin(), list.end(), from) == list.end())
+                list.push_back(from);
+        };
+
+        // Version 0 exists before the graph runs.
+        auto isProducedByEnabledPass = [&](UINT index, UINT version)
+        {
+            auto it = producers.find(VersionKey(index, version));
+            assert(it != producers.end() && "Version is read before it is written");
+            return isEnabled[it->second];
+        };
+
+        auto addProducerEdge = [&](const Handle& handle, UINT pass)
+        {
+            for (UINT version = handle.version; version > 0; --version)
+            {
+                if (isProducedByEnabledPass(handle.index, version))
+                {
+                    addEdge(producers.at(VersionKey(handle.index, version)), pass);
+                    return;
+                }
+            }
+        };
+
+        for (UINT pass = 0; pass < PassCount; ++pass)
+        {
+            if (!isEnabled[pass])
+                continue;
+
+            for (const Handle& handle : m_nodes[pass].*reads)
+                addProducerEdge(handle, pass);
+
+            for (const Handle& handle : m_nodes[pass].*writes)
+            {
+                addProducerEdge(handle, pass);
+
+                for (UINT version = handle.version;; --version)
+                {
+                    auto it = readers.find(VersionKey(handle.index, version));
+                    if (it != readers.end())
+                    {
+                        for (UINT reader : it->second)
+                            addEdge(reader, pass);
+                    }
+
+                    if (version == 0 || isProducedByEnabledPass(handle.index, version))
+                        break;
+                }
+            }
+        }
+    }
+
+    // Capacity of the arrays is kept, so they stop growing once they have reached their peak.
+    void PatchBarriers(CompiledPlan& plan, UINT frameIndex)
+    {
+        for (PassType passType : plan.order)
+        {
+            const UINT pass = static_cast<UINT>(passType);
+            auto& [bufferBarriers, textureBarriers] = plan.passBarriers[frameIndex][pass];
+            bufferBarriers.clear();
+            textureBarriers.clear();
+
+            for (const auto& barrier : plan.bufferBarriers[pass])
+            {
+                for (UINT i = 0; i < GetElementCount(barrier.buffer); ++i)
+                {
+                    bufferBarriers.push_back({
+                        barrier.before.sync,
+                        barrier.after.sync,
+                        barrier.before.access,
+                        barrier.after.access,
+                        Resolve(barrier.buffer, i, frameIndex),
+                        0,
+                        UINT64_MAX});
+                }
+            }
+
+            ResolveTextureBarriers(plan.textureBarriers[pass], frameIndex, textureBarriers);
+
+            auto& releaseBarriers = plan.releaseBarriers[frameIndex][pass].textureBarriers;
+            releaseBarriers.clear();
+            ResolveTextureBarriers(plan.releaseTextureBarriers[pass], frameIndex, releaseBarriers);
+        }
+
+        plan.patchedVersions[frameIndex] = m_resourceVersion;
+        ++m_barrierPatchCount;
+    }
+
+    void ResolveTextureBarriers(const std::vector<CompiledTextureBarrier>& compiledBarriers, UINT frameIndex, std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers) const
     {
-        return m_nodes[static_cast<UINT>(passType)].textureBarriers;
+        for (const auto& barrier : compiledBarriers)
+        {
+            for (UINT i = 0; i < GetElementCount(barrier.texture); ++i)
+            {
+                textureBarriers.push_back({
+                    barrier.split == BarrierSplit::END ? D3D12_BARRIER_SYNC_SPLIT : barrier.before.sync,
+                    barrier.split == BarrierSplit::BEGIN ? D3D12_BARRIER_SYNC_SPLIT : barrier.after.sync,
+                    barrier.before.access,
+                    barrier.after.access,
+                    barrier.before.layout,
+                    barrier.after.layout,
+                    Resolve(barrier.texture, i, frameIndex),
+                    barrier.subresourceRange,
+                    barrier.flags});
+            }
+        }
     }
 
-    std::array<RenderGraphNode, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)> m_nodes;
+    std::array<std::vector<UINT>, PassCount> BuildPredecessors(const std::array<bool, PassCount>& isEnabled) const
+    {
+        std::array<std::vector<UINT>, PassCount> predecessors;
+        AddDataFlowEdges(&RenderGraphNode::bufferReads, &RenderGraphNode::bufferWrites, isEnabled, predecessors);
+        AddDataFlowEdges(&RenderGraphNode::textureReads, &RenderGraphNode::textureWrites, isEnabled, predecessors);
+        return predecessors;
+    }
+
+    // Passes whose conditions hold and whose results reach an output.
+    std::array<bool, PassCount> FindActivePasses(UINT predicates) const
+    {
+        std::array<bool, PassCount> isEnabled;
+        for (UINT pass = 0; pass < PassCount; ++pass)
+            isEnabled[pass] = (m_nodes[pass].conditionMask & ~predicates) == 0;
+
+        auto predecessors = BuildPredecessors(isEnabled);
+
+        std::array<bool, PassCount> isActive = {};
+        std::vector<UINT> stack;
+        for (UINT pass = 0; pass < PassCount; ++pass)
+        {
+            if (!isEnabled[pass])
+                continue;
+
+            for (RGTexture texture : m_nodes[pass].textureWrites)
+            {
+                if (std::find(m_outputTextures.begin(), m_outputTextures.end(), texture.index) != m_outputTextures.end())
+                {
+                    isActive[pass] = true;
+                    stack.push_back(pass);
+                    break;
+                }
+            }
+        }
+
+        while (!stack.empty())
+        {
+            UINT pass = stack.back();
+            stack.pop_back();
+
+            for (UINT producer : predecessors[pass])
+            {
+                if (!isActive[producer])
+                {
+                    isActive[producer] = true;
+                    stack.push_back(producer);
+                }
+            }
+        }
+
+        return isActive;
+    }
+
+    struct SubresourceTransition
+    {
+        UINT subresource;
+        TextureResourceUsage before;
+        UINT beginPosition; // UINT_MAX if immediate
+    };
+
+    // Position to begin a split barrier at, or UINT_MAX for an immediate one.
+    // Only worth it if at least one pass runs in between. Discarding transitions are not split.
+    // Both halves must be on the queue of the pass at position, and in its command list.
+    UINT GetSplitBeginPosition(const CompiledPlan& plan, UINT lastPosition, UINT position, const TextureResourceUsage& before) const
+    {
+        if (lastPosition == UINT_MAX || before.layout == D3D12_BARRIER_LAYOUT_UNDEFINED)
+            return UINT_MAX;
+
+        // First pass of the list the pass at position is recorded in
+        UINT listBegin = position;
+        while (listBegin > 0 && !m_nodes[static_cast<UINT>(plan.order[listBegin])].startsCommandList)
+            --listBegin;
+
+        QueueType queue = m_nodes[static_cast<UINT>(plan.order[position])].queue;
+        for (UINT begin = (std::max)(lastPosition + 1, listBegin); begin < position; ++begin)
+        {
+            if (m_nodes[static_cast<UINT>(plan.order[begin])].queue == queue)
+                return begin;
+        }
+        return UINT_MAX;
+    }
+
+    // One barrier per box of subresources sharing the same usage before and begin position, instead of one per subresource.
+    void AppendMergedTextureBarriers(
+        CompiledPlan& plan,
+        std::array<std::vector<CompiledTextureBarrier>, PassCount>& passBarriers,
+        UINT position,
+        RGTexture texture,
+        const TextureResourceUsage& after,
+        const std::vector<SubresourceTransition>& transitions)
+    {
+        if (transitions.empty())
+            return;
+
+        plan.unmergedTextureBarrierCount += static_cast<UINT>(transitions.size());
+
+        auto append = [&](const TextureResourceUsage& before, UINT beginPosition, const D3D12_BARRIER_SUBRESOURCE_RANGE& range)
+        {
+            auto& barriers = passBarriers[static_cast<UINT>(plan.order[position])];
+            if (beginPosition == UINT_MAX)
+            {
+                barriers.push_back({texture, before, after, range, GetBarrierFlags(before)});
+                ++plan.textureBarrierCount;
+                return;
+            }
+
+            auto& beginBarriers = passBarriers[static_cast<UINT>(plan.order[beginPosition])];
+            beginBarriers.push_back({texture, before, after, range, GetBarrierFlags(before), BarrierSplit::BEGIN});
+            barriers.push_back({texture, before, after, range, GetBarrierFlags(before), BarrierSplit::END});
+            plan.textureBarrierCount += 2;
+            ++plan.splitBarrierCount;
+        };
+
+        // Common case. Whole resource moves from one usage, which needs no dimension.
+        const UINT subresourceCount = m_textureGroups[texture.index].subresourceCount;
+        const auto& first = transitions.front();
+        bool isUniform = std::all_of(
+            transitions.begin(),
+            transitions.end(),
+            [&](const SubresourceTransition& transition)
+            {
+                return transition.before == first.before && transition.beginPosition == first.beginPosition;
+            });
+        if (isUniform && transitions.size() == subresourceCount)
+        {
+            append(first.before, first.beginPosition, {0xffff'ffff, 0, 0, 0, 0, 0});
+            return;
+        }
+
+        const auto [mipLevels, depthOrArraySize, planeCount] = GetResourceDimension(m_pDevice, texture);
+
+        std::vector<bool> isHandled(transitions.size());
+        std::vector<bool> mask(subresourceCount);
+        for (UINT i = 0; i < static_cast<UINT>(transitions.size()); ++i)
+        {
+            if (isHandled[i])
+                continue;
+
+            const auto& [subresource, before, beginPosition] = transitions[i];
+            std::fill(mask.begin(), mask.end(), false);
+            for (UINT j = i; j < static_cast<UINT>(transitions.size()); ++j)
+            {
+                if (!isHandled[j] && transitions[j].before == before && transitions[j].beginPosition == beginPosition)
+                {
+                    mask[transitions[j].subresource] = true;
+                    isHandled[j] = true;
+                }
+            }
+
+            for (const auto& range : MergeSubresourceRanges(mask, mipLevels, depthOrArraySize, planeCount))
+                append(before, beginPosition, range);
+        }
+    }
+
+    // Common layout is accessible from every queue type.
+    void AppendReleaseBarriers(CompiledPlan& plan, UINT position, UINT groupIdx, std::vector<TextureResourceUsage>& latestUsages)
+    {
+        const TextureResourceUsage released = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_COMMON};
+
+        std::vector<SubresourceTransition> transitions;
+        for (UINT i = 0; i < static_cast<UINT>(latestUsages.size()); ++i)
+        {
+            if (latestUsages[i] != released)
+            {
+                transitions.push_back({i, latestUsages[i], UINT_MAX});
+                latestUsages[i] = released;
+            }
+        }
+
+        AppendMergedTextureBarriers(plan, plan.releaseTextureBarriers, position, RGTexture{groupIdx}, released, transitions);
+    }
+
+    static bool IsSameTransition(const CompiledTextureBarrier& a, const CompiledTextureBarrier& b)
+    {
+        const auto& ra = a.subresourceRange;
+        const auto& rb = b.subresourceRange;
+        return a.texture.index == b.texture.index && a.before == b.before && a.after == b.after &&
+               ra.IndexOrFirstMipLevel == rb.IndexOrFirstMipLevel && ra.NumMipLevels == rb.NumMipLevels &&
+               ra.FirstArraySlice == rb.FirstArraySlice && ra.NumArraySlices == rb.NumArraySlices &&
+               ra.FirstPlane == rb.FirstPlane && ra.NumPlanes == rb.NumPlanes;
+    }
+
+    // Mips, array slices and planes are looked up only for groups not always accessed as a whole, since it needs the device.
+    std::vector<TextureDimension> GetTextureDimensions() const
+    {
+        std::vector<TextureDimension> dimensions;
+        for (const auto& group : m_textureGroups)
+            dimensions.push_back({group.subresourceCount, 0, 0, 0});
+
+        for (const auto& node : m_nodes)
+        {
+            for (const auto& accesses : {&node.textureInputs, &node.textureOutputs})
+            {
+                for (const auto& [texture, usage, range] : *accesses)
+                {
+                    auto& dimension = dimensions[texture.index];
+                    bool isFullRange = range.IndexOrFirstMipLevel == 0xffff'ffff && range.NumMipLevels == 0;
+                    if (!isFullRange && dimension.mipLevels == 0)
+                        std::tie(dimension.mipLevels, dimension.arraySize, dimension.planeCount) = GetResourceDimension(m_pDevice, texture);
+                }
+            }
+        }
+        return dimensions;
+    }
+
+    // Contents of undefined layout are not preserved anyway.
+    static D3D12_TEXTURE_BARRIER_FLAGS GetBarrierFlags(const TextureResourceUsage& before)
+    {
+        return before.layout == D3D12_BARRIER_LAYOUT_UNDEFINED ? D3D12_TEXTURE_BARRIER_FLAG_DISCARD : D3D12_TEXTURE_BARRIER_FLAG_NONE;
+    }
+
+    // First and last use of each transient element in the full order, then their places in the heap.
+    // Every pass is included, so the placement holds whichever passes are culled.
+    void PlanTransientTextures()
+    {
+        std::vector<UINT> firstPasses(m_textureGroups.size(), UINT_MAX);
+        std::vector<UINT> lastPasses(m_textureGroups.size(), 0);
+        for (UINT position = 0; position < static_cast<UINT>(m_fullOrder.size()); ++position)
+        {
+            const auto& node = m_nodes[static_cast<UINT>(m_fullOrder[position])];
+
+            auto markUse = [&](RGTexture texture)
+            {
+                firstPasses[texture.index] = (std::min)(firstPasses[texture.index], position);
+                lastPasses[texture.index] = (std::max)(lastPasses[texture.index], position);
+            };
+
+            for (RGTexture texture : node.textureReads)
+                markUse(texture);
+            for (RGTexture texture : node.textureWrites)
+                markUse(texture);
+        }
+
+        m_transientElements.clear();
+        m_transientRequests.clear();
+        for (UINT i = 0; i < static_cast<UINT>(m_textureGroups.size()); ++i)
+        {
+            const auto& group = m_textureGroups[i];
+            if (!group.isTransient)
+                continue;
+
+            for (UINT element = 0; element < group.elementCount; ++element)
+            {
+                auto info = m_pDevice->GetResourceAllocationInfo2(0, 1, &group.descs[element], nullptr);
+                m_transientElements.push_back({i, element});
+                m_transientRequests.push_back({info.SizeInBytes, info.Alignment, firstPasses[i], lastPasses[i]});
+            }
+        }
+
+        m_transientPlan = PlanTransientMemory(m_transientRequests);
+    }
+
+    // Topological sort of the DAG built from Read/Write declarations.
+    // Among ready passes, pick the one whose nearest producer was scheduled earliest.
+    // Independent passes then fall between producers and consumers, which gives barriers room to overlap.
+    // Ties go to the lower PassType, so the order does not depend on declaration order.
+    // Every pass is scheduled. Plans of predicate combinations take subsequences of this order.
+    void BuildSchedule()
+    {
+        std::array<bool, PassCount> isEnabled;
+        isEnabled.fill(true);
+        auto predecessors = BuildPredecessors(isEnabled);
+
+        constexpr UINT Unscheduled = UINT_MAX;
+        std::array<UINT, PassCount> positions;
+        positions.fill(Unscheduled);
+
+        m_fullOrder.clear();
+        for (UINT step = 0; step < PassCount; ++step)
+        {
+            UINT best = Unscheduled;
+            UINT bestDistance = 0;
+            for (UINT pass = 0; pass < PassCount; ++pass)
+            {
+                if (positions[pass] != Unscheduled)
+                    continue;
+
+                // Passes without producers are infinitely far from them.
+                bool isReady = true;
+                UINT distance = UINT_MAX;
+                for (UINT producer : predecessors[pass])
+                {
+                    if (positions[producer] == Unscheduled)
+                    {
+                        isReady = false;
+                        break;
+                    }
+                    distance = (std::min)(distance, step - positions[producer]);
+                }
+
+                if (isReady && (best == Unscheduled || distance > bestDistance))
+                {
+                    best = pass;
+                    bestDistance = distance;
+                }
+            }
+
+            assert(best != Unscheduled && "Render graph has a cycle");
+            positions[best] = step;
+            m_fullOrder.push_back(static_cast<PassType>(best));
+        }
+    }
 
-private:
     struct ResourceGroup
     {
         std::vector<ID3D12Resource*> pResources; // size = elementCount * (isPerFrame ? frameCount : 1)
@@ -321,8 +1819,125 @@ private:
         TextureResourceUsage initialUsage;
 
         std::function<std::vector<ID3D12Resource*>()> provider;
+        std::function<UINT64()> versionProvider;
+        UINT64 providedVersion = UINT64_MAX;
+
+        bool hasFrameEndUsage = false;
+        TextureResourceUsage frameEndUsage;
+
+        // Transient only. Per element.
+        bool isTransient = false;
+        std::vector<D3D12_RESOURCE_DESC1> descs;
+        std::vector<D3D12_CLEAR_VALUE> clearValues;
+    };
+
+    struct TransientElement
+    {
+        UINT group;
+        UINT element;
     };
 
+    // Call provider only when its version has changed. Resources new to the group join with initialUsage.
+    void RefreshDynamicResources(std::vector<ResourceGroup>& groups, std::vector<std::pair<UINT, ID3D12Resource*>>* pJoining)
+    {
+        for (UINT i = 0; i < static_cast<UINT>(groups.size()); ++i)
+        {
+            auto& group = groups[i];
+            if (!group.isDynamic)
+                continue;
+
+            UINT64 version = group.versionProvider();
+            if (version == group.providedVersion)
+                continue;
+
+            auto pPrevious = std::move(group.pResources);
+            group.pResources = group.provider();
+            group.elementCount = static_cast<UINT>(group.pResources.size());
+            group.providedVersion = version;
+            ++m_resourceVersion;
+
+            if (!pJoining)
+                continue;
+
+            for (auto* pResource : group.pResources)
+            {
+                if (std::find(pPrevious.begin(), pPrevious.end(), pResource) == pPrevious.end())
+                    pJoining->emplace_back(i, pResource);
+            }
+        }
+    }
+
+    // Groups created so far start in initialUsage. States of existing ones are kept.
+    void InitTextureStates()
+    {
+        for (UINT i = static_cast<UINT>(m_textureStates.size()); i < static_cast<UINT>(m_textureGroups.size()); ++i)
+        {
+            const auto& group = m_textureGroups[i];
+            m_textureStates.emplace_back(group.isPerFrame ? FrameCount : 1, std::vector<TextureResourceUsage>(group.subresourceCount, group.initialUsage));
+        }
+    }
+
+    bool IsAliasedTransient(UINT groupIdx) const
+    {
+        for (UINT i = 0; i < static_cast<UINT>(m_transientElements.size()); ++i)
+        {
+            if (m_transientElements[i].group == groupIdx && m_transientPlan.isAliased[i])
+                return true;
+        }
+        return false;
+    }
+
+    // Usually nothing to do, since a plan ends each frame in the usages it begins with.
+    // Needed after switching plans and for resources joining a group.
+    void BridgeTextureStates(UINT frameIndex)
+    {
+        auto& barriers = m_frameBeginBarriers.textureBarriers;
+        barriers.clear();
+
+        for (UINT i = 0; i < static_cast<UINT>(m_textureGroups.size()); ++i)
+        {
+            const auto& group = m_textureGroups[i];
+
+            // Contents are discarded at first use anyway.
+            if (IsAliasedTransient(i))
+                continue;
+
+            auto& state = m_textureStates[i][group.isPerFrame ? frameIndex : 0];
+            const auto& entry = m_pCurrentPlan->entryUsages[i];
+
+            for (UINT element = 0; element < group.elementCount; ++element)
+            {
+                ID3D12Resource* pResource = Resolve(RGTexture{i}, element, frameIndex);
+
+                auto joining = std::find(m_joiningTextures.begin(), m_joiningTextures.end(), std::make_pair(i, pResource));
+                bool isJoining = joining != m_joiningTextures.end();
+                if (isJoining)
+                    m_joiningTextures.erase(joining);
+
+                for (UINT subresource = 0; subresource < group.subresourceCount; ++subresource)
+                {
+                    const auto& before = isJoining ? group.initialUsage : state[subresource];
+                    const auto& after = entry[subresource];
+                    if (before == after)
+                        continue;
+
+                    barriers.push_back({
+                        before.sync,
+                        after.sync,
+                        before.access,
+                        after.access,
+                        before.layout,
+                        after.layout,
+                        pResource,
+                        {subresource, 0, 0, 0, 0, 0},
+                        D3D12_TEXTURE_BARRIER_FLAG_NONE});
+                }
+            }
+
+            state = entry;
+        }
+    }
+
     UINT RegisterHelper(
         const std::string& name,
         bool isPerFrame,
@@ -351,6 +1966,7 @@ private:
         auto& group = groups[index];
         group.pResources.insert(group.pResources.end(), pResources.begin(), pResources.end());
         ++group.elementCount;
+        ++m_resourceVersion;
     }
 
     void UpdateElementHelper(
@@ -362,6 +1978,7 @@ private:
         auto& group = groups[index];
         UINT offset = group.isPerFrame ? elementIndex * FrameCount : elementIndex;
         std::copy(pResources.begin(), pResources.end(), group.pResources.begin() + offset);
+        ++m_resourceVersion;
     }
 
     ID3D12Resource* ResolveHelper(
@@ -383,5 +2000,33 @@ private:
     std::unordered_map<std::string, UINT> m_bufferMap;
     std::unordered_map<std::string, UINT> m_textureMap;
 
-    ID3D12Device* m_pDevice;
+    std::vector<PassType> m_fullOrder;
+
+    std::unordered_map<std::string, UINT> m_predicateMap;
+    UINT m_predicates = 0; // bit per predicate
+    std::vector<UINT> m_outputTextures;
+
+    UINT64 m_topologyHash = 0;     // of the last Compile()
+    std::list<CachedPlan> m_plans; // most recently used first
+    std::unordered_map<PlanKey, std::list<CachedPlan>::iterator, PlanKeyHash> m_planLookup;
+    CompiledPlan* m_pCurrentPlan = nullptr;
+    UINT m_planCacheHitCount = 0;
+    UINT m_planCacheMissCount = 0;
+    double m_lastCompileMs = 0.0;
+
+    UINT64 m_resourceVersion = 0; // incremented whenever any resource pointer changes
+
+    // Actual usages of textures at the start of the next frame. [group][frame index, or 0 if not per frame][subresource]
+    std::vector<std::vector<std::vector<TextureResourceUsage>>> m_textureStates;
+    std::vector<std::pair<UINT, ID3D12Resource*>> m_joiningTextures; // still in initialUsage
+    PassBarriers m_frameBeginBarriers;
+    UINT m_barrierPatchCount = 0;
+
+    std::vector<TransientElement> m_transientElements;
+    std::vector<TransientAllocationRequest> m_transientRequests; // parallel to m_transientElements
+    TransientMemoryPlan m_transientPlan;
+    std::array<Microsoft::WRL::ComPtr<ID3D12Heap>, FrameCount> m_transientHeaps;
+    std::vector<Texture> m_transientTextures;
+
+    ID3D12Device10* m_pDevice;
 };
@@ -7,14 +7,30 @@
 #include <d3d12.h>
 #include <minwindef.h>
 
+// version counts writes declared on the resource. Version 0 is the content at the start of the frame.
 struct RGBuffer
 {
     UINT index;
+    UINT version = 0;
 };
 
 struct RGTexture
 {
     UINT index;
+    UINT version = 0;
+};
+
+struct RGPredicate
+{
+    UINT index;
+};
+
+// Queue a pass is submitted to. Compute passes may overlap with direct ones.
+enum class QueueType
+{
+    DIRECT,
+    COMPUTE,
+    NUM_QUEUE_TYPES
 };
 
 struct BufferResourceUsage
@@ -60,12 +76,22 @@ struct CompiledBufferBarrier
     BufferResourceUsage after;
 };
 
+// Split barriers begin after the last access of the subresources and end before the next one.
+enum class BarrierSplit
+{
+    IMMEDIATE,
+    BEGIN,
+    END
+};
+
 struct CompiledTextureBarrier
 {
     RGTexture texture;
     TextureResourceUsage before;
     TextureResourceUsage after;
     D3D12_BARRIER_SUBRESOURCE_RANGE subresourceRange;
+    D3D12_TEXTURE_BARRIER_FLAGS flags = D3D12_TEXTURE_BARRIER_FLAG_NONE;
+    BarrierSplit split = BarrierSplit::IMMEDIATE;
 };
 
 struct RenderGraphNode
@@ -91,12 +117,62 @@ public:
         textureOutputs.emplace_back(texture, usage, range);
     }
 
+    // Read/Write declare data flow between passes. RenderGraph::Compile orders passes from them.
+    // Write consumes given version and returns the version this pass produces.
+    void Read(RGBuffer buffer)
+    {
+        bufferReads.push_back(buffer);
+    }
+
+    void Read(RGTexture texture)
+    {
+        textureReads.push_back(texture);
+    }
+
+    RGBuffer Write(RGBuffer buffer)
+    {
+        bufferWrites.push_back(buffer);
+        return {buffer.index, buffer.version + 1};
+    }
+
+    RGTexture Write(RGTexture texture)
+    {
+        textureWrites.push_back(texture);
+        return {texture.index, texture.version + 1};
+    }
+
+    // Pass runs only while every condition is true. Passes only feeding it are culled with it.
+    void SetCondition(RGPredicate predicate)
+    {
+        conditionMask |= 1u << predicate.index;
+    }
+
+    // Declared usages must be supported by the queue. Compiler inserts fence waits and queue transfers.
+    void SetQueue(QueueType queueType)
+    {
+        queue = queueType;
+    }
+
+    // Pass is recorded from the start of a new command list. D3D12 pairs split barriers only within one list,
+    // so the compiler never splits a barrier across such a pass.
+    void SetStartsCommandList(bool value)
+    {
+        startsCommandList = value;
+    }
+
+    const char* name = "";
+    UINT conditionMask = 0;
+    QueueType queue = QueueType::DIRECT;
+    bool startsCommandList = false;
+
     std::vector<std::pair<RGBuffer, BufferResourceUsage>> bufferInputs;
     std::vector<std::pair<RGBuffer, BufferResourceUsage>> bufferOutputs;
 
     std::vector<std::tuple<RGTexture, TextureResourceUsage, D3D12_BARRIER_SUBRESOURCE_RANGE>> textureInputs;
     std::vector<std::tuple<RGTexture, TextureResourceUsage, D3D12_BARRIER_SUBRESOURCE_RANGE>> textureOutputs;
 
-    std::vector<CompiledBufferBarrier> bufferBarriers;
-    std::vector<CompiledTextureBarrier> textureBarriers;
+    std::vector<RGBuffer> bufferReads;
+    std::vector<RGBuffer> bufferWrites;
+    std::vector<RGTexture> textureReads;
+    std::vector<RGTexture> textureWrites;
 };
@@ -15,6 +15,7 @@
 
 #include "D3DHelper.h"
 #include "DescriptorAllocation.h"
+#include "FrustumCuller.h"
 #include "GeometryData.h"
 #include "GeometryGenerator.h"
 #include "InstanceData.h"
@@ -22,7 +23,6 @@
 #include "Material.h"
 #include "Mesh.h"
 #include "SharedConfig.h"
-#include "TransientUploadAllocator.h"
 #include "Win32Application.h"
 
 using Microsoft::WRL::ComPtr;
@@ -319,10 +319,12 @@ void Renderer::OnUpdate()
     float alpha = std::clamp(static_cast<float>(accumulatedMs / fixedDtMs), 0.0f, 1.0f);
 
     // 이번에 드로우할 프레임에 대해 constant buffers 업데이트
-    FrameResource& frameResource = m_frameResources[m_frameIndex];
+    auto prepBegin = m_clock.now();
 
     PrepareConstantData(alpha);
-    UpdateConstantBuffers(frameResource);
+    UpdateConstantBuffers();
+
+    m_framePrepMs = std::chrono::duration<double, std::milli>(m_clock.now() - prepBegin).count();
 
     m_inputManager.ResetPressedFlags();
 }
@@ -332,16 +334,20 @@ void Renderer::OnRender()
 {
     auto [pCommandAllocator, pCommandList] = m_commandQueue.GetAvailableCommandList();
 
+    // Passes are recorded into lists of their own, submitted after this one.
+    m_submittedCommandLists.clear();
+    m_submittedCommandLists.emplace_back(pCommandAllocator, pCommandList);
     PopulateCommandList(pCommandList);
 
     m_dynamicDescriptorHeapForCbvSrvUav.Reset();
 
-    // Populate commands for ImGui
+    // Populate commands for ImGui, after the last pass
     // Is it OK to call SetDescriptorHeaps? (Does it affect performance?)
+    auto* pLastCommandList = m_submittedCommandLists.back().second;
     ImGui::Render();
     ID3D12DescriptorHeap* ppHeaps[] = {m_imguiDescriptorAllocator.GetDescriptorHeap()};
-    pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-    ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), pCommandList);
+    pLastCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), pLastCommandList);
 
     // Barrier for RTV should be called after ImGui Render.
     // Swap Chain textures initially created in D3D12_BARRIER_LAYOUT_COMMON.
@@ -359,14 +365,20 @@ void Renderer::OnRender()
         D3D12_TEXTURE_BARRIER_FLAG_NONE};
 
     D3D12_BARRIER_GROUP barrierGroups[] = {TextureBarrierGroup(1, &barrier)};
-    pCommandList->Barrier(1, barrierGroups);
+    pLastCommandList->Barrier(1, barrierGroups);
 
-    // Execute the command lists and update objects with fence values
-    UINT64 signaledFenceValue = m_commandQueue.ExecuteCommandLists(pCommandAllocator, pCommandList);
+    // Execute the command lists in graph order with one call and update objects with fence values
+    UINT64 signaledFenceValue = m_commandQueue.ExecuteCommandLists(m_submittedCommandLists);
     UINT64 completedFenceValue = m_commandQueue.GetCompletedFenceValue();
     m_frameResources[m_frameIndex].UpdateSignaledFenceValue(signaledFenceValue);
-    m_dynamicDescriptorHeapForCbvSrvUav.QueueRetiredHeaps(signaledFenceValue);
+    m_dynamicDescriptorHeapForCbvSrvUav.QueueRetiredPages(signaledFenceValue);
     m_dynamicDescriptorHeapForCbvSrvUav.UpdateCompletedFenceValue(completedFenceValue);
+    m_bindlessDescriptorHeap.QueueRetiredIndices(signaledFenceValue);
+    m_bindlessDescriptorHeap.ReleaseStaleIndices(completedFenceValue);
+    m_uploadRingBuffer.QueueRetiredAllocations(signaledFenceValue);
+    m_uploadRingBuffer.ReleaseStaleAllocations(completedFenceValue);
+    for (auto& descriptorAllocator : m_descriptorAllocators)
+        descriptorAllocator.FlushThreadCaches();
     m_sceneManager.QueueDeferredDeletions(signaledFenceValue);
     m_sceneManager.ProcessCompletedDeletions(completedFenceValue);
 
@@ -439,21 +451,10 @@ void Renderer::OnResize(UINT width, UINT height)
     UpdateWidthHeight();
 
     // Reset back buffer
-    // Reset & create scene color buffers and gbuffers
     // Set current frame's fence value to all frameResources
     for (UINT i = 0; i < FrameCount; i++)
     {
         m_frameResources[i].ResetBackBuffer();
-
-        m_frameResources[i].ResetSceneColorBuffers();
-        m_frameResources[i].CreateSceneColorBuffers(m_width, m_height);
-
-        m_frameResources[i].ResetGBuffers();
-        m_frameResources[i].CreateGBuffers(m_width, m_height);
-
-        m_frameResources[i].ResetMasks();
-        m_frameResources[i].CreateMasks(m_width, m_height);
-
         m_frameResources[i].UpdateSignaledFenceValue(m_frameResources[m_frameIndex].GetSignaledFenceValue());
     }
 
@@ -480,6 +481,9 @@ void Renderer::OnResize(UINT width, UINT height)
     m_readOnlyDsv.Init(m_device.Get(), m_depthStencilBuffer.Get(), GetDsvDesc(DXGI_FORMAT_D24_UNORM_S8_UINT, D3D12_DSV_FLAG_READ_ONLY_DEPTH));
     m_depthSrv.Init(m_device.Get(), m_depthStencilBuffer.Get(), GetSrvDesc(DXGI_FORMAT_R24_UNORM_X8_TYPELESS, 1));
 
+    // SRVs of root parameter 11 are rewritten in place
+    m_dynamicDescriptorHeapForCbvSrvUav.InvalidateTableCache();
+
     // Update registered info of backbuffers
     std::vector<ID3D12Resource*> pBackBuffers;
     for (UINT i = 0; i < FrameCount; ++i)
@@ -489,56 +493,15 @@ void Renderer::OnResize(UINT width, UINT height)
     auto backBuffer = m_renderGraph.GetRGTexture("BackBuffer");
     m_renderGraph.UpdateElement(backBuffer, 0, pBackBuffers);
 
-    // Update registered info of scene color buffers
-    std::vector<ID3D12Resource*> pSceneColorBuffers0;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pSceneColorBuffers0.push_back(m_frameResources[i].GetSceneColorBuffer(0));
-    }
-    auto sceneColorBuffer0 = m_renderGraph.GetRGTexture("SceneColorBuffer0");
-    m_renderGraph.UpdateElement(sceneColorBuffer0, 0, pSceneColorBuffers0);
-
-    std::vector<ID3D12Resource*> pSceneColorBuffers1;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pSceneColorBuffers1.push_back(m_frameResources[i].GetSceneColorBuffer(1));
-    }
-    auto sceneColorBuffer1 = m_renderGraph.GetRGTexture("SceneColorBuffer1");
-    m_renderGraph.UpdateElement(sceneColorBuffer1, 0, pSceneColorBuffers1);
-
     // Update registered info of depth-stencil buffer
     auto depthStencilBuffer = m_renderGraph.GetRGTexture("DepthStencilBuffer");
     m_renderGraph.UpdateElement(depthStencilBuffer, 0, {m_depthStencilBuffer.Get()});
 
-    // Update registered info of GBuffers
-    auto gBuffer = m_renderGraph.GetRGTexture("GBuffer");
-    for (UINT slot = 0; slot < static_cast<UINT>(GBufferSlot::NUM_GBUFFER_SLOTS); ++slot)
-    {
-        std::vector<ID3D12Resource*> pGBuffers;
-        for (UINT i = 0; i < FrameCount; ++i)
-        {
-            pGBuffers.push_back(m_frameResources[i].GetGBuffer(static_cast<GBufferSlot>(slot)));
-        }
-        m_renderGraph.UpdateElement(gBuffer, slot, pGBuffers);
-    }
-
-    // Update registered info of selection mask
-    auto selectionMask = m_renderGraph.GetRGTexture("SelectionMask");
-    std::vector<ID3D12Resource*> pSelectionMasks;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pSelectionMasks.push_back(m_frameResources[i].GetSelectionMask());
-    }
-    m_renderGraph.UpdateElement(selectionMask, 0, pSelectionMasks);
-
-    // Update registered info of horizontal dilated mask
-    RGTexture horizontalDilatedMask = m_renderGraph.GetRGTexture("HorizontalDilatedMask");
-    std::vector<ID3D12Resource*> pHorizontalDilatedMasks;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pHorizontalDilatedMasks.push_back(m_frameResources[i].GetHorizontalDilatedMask());
-    }
-    m_renderGraph.UpdateElement(horizontalDilatedMask, 0, pHorizontalDilatedMasks);
+    // Recreate transient textures. Sizes changed, so their placement is planned again.
+    m_renderGraph.ResizeTransientTextures(m_width, m_height);
+    m_renderGraph.Compile();
+    m_renderGraph.AllocateTransientTextures();
+    BindTransientTextures();
 }
 
 void Renderer::OnDpiChanged(UINT dpi)
@@ -574,6 +537,72 @@ void Renderer::BuildImGuiFrame()
     ImGui::Text("FPS: %.1f", fps);
     ImGui::Text("Latency: %.3f", frameTime);
 
+    ImGui::Text("Visible: %u / %u", m_sceneManager.GetVisibleCount(MAIN_VIEW), m_sceneManager.GetRenderableCount());
+    ImGui::Text("Transforms Updated: %u", m_recomputedTransformCount);
+    ImGui::Text("Instances Rebuilt: %u", m_sceneManager.GetRebuiltInstanceCount());
+
+    // Compare frame preparation time from 0 to N workers
+    int activeWorkers = static_cast<int>(m_jobSystem.GetActiveWorkerCount());
+    if (ImGui::SliderInt("Job Workers", &activeWorkers, 0, static_cast<int>(m_jobSystem.GetWorkerCount())))
+        m_jobSystem.SetActiveWorkerCount(static_cast<UINT>(activeWorkers));
+    ImGui::Text("Frame Prep: %.3f ms", m_framePrepMs);
+    ImGui::Text("Pass Recording: %.3f ms, Command Lists: %u", m_recordMs, m_recordTaskCount);
+
+    const auto& persistentIndices = m_bindlessDescriptorHeap.GetPersistentIndices();
+    const auto& perFrameIndices = m_bindlessDescriptorHeap.GetPerFrameIndices();
+    ImGui::Text("Bindless Descriptors: %u / %u (Per Frame: %u / %u)", persistentIndices.GetAllocatedCount(), persistentIndices.GetCapacity(), perFrameIndices.GetAllocatedCount(), perFrameIndices.GetCapacity());
+    const auto& cbvSrvUavAllocator = m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV];
+    ImGui::Text("Dynamic Descriptors / Frame: %u Copied, %u Reused", m_dynamicDescriptorHeapForCbvSrvUav.GetCopiedDescriptorCount(), m_dynamicDescriptorHeapForCbvSrvUav.GetReusedDescriptorCount());
+    ImGui::Text("CPU Descriptor Pages: %u, Free: %u, Thread Caches: %u", cbvSrvUavAllocator.GetNumPages(), cbvSrvUavAllocator.GetNumFreeHandles(), cbvSrvUavAllocator.GetNumThreadCaches());
+
+    // Peak includes frames still in flight
+    const double toKB = 1.0 / 1024.0;
+    UINT64 ringCapacity = m_uploadRingBuffer.GetCapacity();
+    UINT64 ringPeak = m_uploadRingBuffer.GetFrameHighWaterMark();
+    ImGui::Text("Upload Ring: %.0f KB / %.0f KB (Peak: %.1f%%)", static_cast<double>(m_uploadRingBuffer.GetUsedSize()) * toKB, static_cast<double>(ringCapacity) * toKB, 100.0 * ringPeak / ringCapacity);
+    ImGui::Text("Upload Wraps: %llu, Stalls: %llu, Dedicated: %llu", m_uploadRingBuffer.GetWrapCount(), m_uploadRingBuffer.GetStallCount(), m_uploadRingBuffer.GetDedicatedCount());
+
+    const auto& spatialIndex = m_sceneManager.GetSpatialIndex();
+    ImGui::Text("BVH Proxies: %u, Height: %u, Area Ratio: %.2f", spatialIndex.GetProxyCount(), spatialIndex.GetHeight(), spatialIndex.GetAreaRatio());
+
+    if (ImGui::TreeNode("Shadow Views"))
+    {
+        // Without culling, every view draws all renderables.
+        UINT totalDrawCalls = 0;
+        UINT totalInstances = 0;
+        for (UINT i = 0; i < static_cast<UINT>(m_shadowViewStats.size()); ++i)
+        {
+            const auto& stats = m_shadowViewStats[i];
+            ImGui::Text("[%u] Draws: %u, Instances: %u / %u", i, stats.drawCalls, stats.instanceCount, m_sceneManager.GetRenderableCount());
+
+            totalDrawCalls += stats.drawCalls;
+            totalInstances += stats.instanceCount;
+        }
+        ImGui::Text("Total Draws: %u, Instances: %u", totalDrawCalls, totalInstances);
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Render Graph"))
+    {
+        UINT passIdx = 0;
+        for (PassType passType : m_renderGraph.GetCompiledOrder())
+            ImGui::Text("[%u] %s", passIdx++, m_renderGraph.m_nodes[static_cast<UINT>(passType)].name);
+        ImGui::Text("Active Passes: %u / %u, Cached Plans: %u", passIdx, static_cast<UINT>(PassType::NUM_PASS_TYPES), m_renderGraph.GetCachedPlanCount());
+        UINT planHits = m_renderGraph.GetPlanCacheHitCount();
+        UINT planLookups = planHits + m_renderGraph.GetPlanCacheMissCount();
+        ImGui::Text("Plan Cache Hit Rate: %.1f%% (%u / %u), Last Compile: %.3f ms", planLookups ? 100.0 * planHits / planLookups : 0.0, planHits, planLookups, m_renderGraph.GetLastCompileMs());
+        ImGui::Text("Barrier Patches: %u", m_renderGraph.GetBarrierPatchCount());
+        ImGui::Text("Barriers / Frame: %u", m_barrierCount.load());
+        const auto& queueSync = m_renderGraph.GetQueueSyncPlan();
+        ImGui::Text("Queue Sync Points: %u (Covered Dependencies: %u)", queueSync.syncPointCount, queueSync.coveredDependencyCount);
+        ImGui::Text("Texture Barriers: %u (Unmerged: %u, Split Pairs: %u)", m_renderGraph.GetTextureBarrierCount(), m_renderGraph.GetUnmergedTextureBarrierCount(), m_renderGraph.GetSplitBarrierCount());
+
+        // Per frame resource
+        const double toMB = 1.0 / (1024.0 * 1024.0);
+        ImGui::Text("Transient Memory: %.2f MB (Summed: %.2f MB)", static_cast<double>(m_renderGraph.GetTransientHeapSize()) * toMB, static_cast<double>(m_renderGraph.GetTransientSummedSize()) * toMB);
+        ImGui::TreePop();
+    }
+
     ImGui::Checkbox("vSync", &m_vSync);
 
     const char* items0[] = {"Unlimited", "30", "60", "120", "144", "160", "240"};
@@ -644,8 +673,9 @@ void Renderer::BuildImGuiFrame()
 
     for (const auto& entity : m_sceneManager.GetEntities())
     {
-        if (entity.parent.index == UINT_MAX && entity.parent.generation == 0)
-            RenderEntityNode(entity, m_selected, toDelete, selectionChanged);
+        auto parent = m_sceneManager.GetHierarchy(entity.selfHandle)->parent;
+        if (parent.index == UINT_MAX && parent.generation == 0)
+            RenderEntityNode(entity.selfHandle, m_selected, toDelete, selectionChanged);
     }
 
     m_sceneManager.Remove(toDelete);
@@ -657,12 +687,11 @@ void Renderer::BuildImGuiFrame()
     // Inspector
     ImGui::Begin("Inspector");
 
-    auto* pEntity = m_sceneManager.Get(m_selected);
-    if (pEntity)
+    if (m_sceneManager.Get(m_selected))
     {
-        if (pEntity->transform.has_value())
+        if (auto* pTransform = m_sceneManager.GetTransform(m_selected))
         {
-            auto& transform = pEntity->transform.value();
+            auto& transform = *pTransform;
 
             XMFLOAT3 s = transform.GetScale();
             if (ImGui::DragFloat3("Scale", &s.x))
@@ -683,35 +712,37 @@ void Renderer::BuildImGuiFrame()
     ImGui::End();
 }
 
-void Renderer::RenderEntityNode(const Entity& entity, EntityHandle& selected, EntityHandle& toDelete, bool& selectionChanged)
+void Renderer::RenderEntityNode(EntityHandle entity, EntityHandle& selected, EntityHandle& toDelete, bool& selectionChanged)
 {
-    bool isSelected = (entity.selfHandle == selected);
+    bool isSelected = (entity == selected);
+
+    const auto& children = m_sceneManager.GetHierarchy(entity)->children;
 
     ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanAvailWidth;
-    if (entity.children.empty())
+    if (children.empty())
         flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
     if (isSelected)
         flags |= ImGuiTreeNodeFlags_Selected;
 
-    UINT64 id = (static_cast<UINT64>(entity.selfHandle.index) << 32) | entity.selfHandle.generation;
-    bool isExpanded = ImGui::TreeNodeEx(reinterpret_cast<void*>(id), flags, "%s", entity.name.c_str());
+    UINT64 id = (static_cast<UINT64>(entity.index) << 32) | entity.generation;
+    bool isExpanded = ImGui::TreeNodeEx(reinterpret_cast<void*>(id), flags, "%s", m_sceneManager.GetName(entity)->c_str());
 
-    if (ImGui::IsItemClicked() && selected != entity.selfHandle)
+    if (ImGui::IsItemClicked() && selected != entity)
     {
-        selected = entity.selfHandle;
+        selected = entity;
         selectionChanged = true;
     }
 
     if (ImGui::BeginPopupContextItem())
     {
         if (ImGui::MenuItem("Delete"))
-            toDelete = entity.selfHandle;
+            toDelete = entity;
         ImGui::EndPopup();
     }
     if (!(flags & ImGuiTreeNodeFlags_NoTreePushOnOpen) && isExpanded)
     {
-        for (auto c : entity.children)
-            RenderEntityNode(*m_sceneManager.Get(c), selected, toDelete, selectionChanged);
+        for (auto c : children)
+            RenderEntityNode(c, selected, toDelete, selectionChanged);
         ImGui::TreePop();
     }
 }
@@ -791,13 +822,22 @@ void Renderer::LoadPipeline()
     }
 
     m_commandQueue.Init(m_device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
-    m_dynamicDescriptorHeapForCbvSrvUav.Init(m_device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_commandQueue.SetThreadPoolCount(m_jobSystem.GetWorkerCount() + 1); // One per thread recording passes
+    // Dynamic descriptors are paged out of the tail of the bindless heap, so the heap never changes.
+    m_bindlessDescriptorHeap.Init(m_device.Get());
+    m_dynamicDescriptorHeapForCbvSrvUav.Init(
+        m_device.Get(),
+        m_bindlessDescriptorHeap.GetDescriptorHeap(),
+        m_bindlessDescriptorHeap.GetDynamicOffset(),
+        m_bindlessDescriptorHeap.GetNumDynamicDescriptors());
     for (UINT i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
     {
         D3D12_DESCRIPTOR_HEAP_TYPE type = static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i);
         m_descriptorAllocators[i].Init(m_device.Get(), type);
         m_descriptorAllocators[i].SetCommandQueue(&m_commandQueue); // Dependency injection
     }
+    m_uploadRingBuffer.Init(m_device.Get());
+    m_uploadRingBuffer.SetCommandQueue(&m_commandQueue);
 
     // Create descriptor heap for samplers
     UINT numSamplers = static_cast<UINT>(TextureFiltering::NUM_TEXTURE_FILTERINGS) * static_cast<UINT>(TextureAddressingMode::NUM_TEXTURE_ADDRESSING_MODES);
@@ -870,14 +910,14 @@ void Renderer::LoadPipeline()
 
     CreateRootSignature();
     m_dynamicDescriptorHeapForCbvSrvUav.ParseRootSignature(m_rootSignature);
+
+    // Screen space SRVs only change on resize. Light CBVs are recreated every frame at the same handles, so they are not cached.
+    m_dynamicDescriptorHeapForCbvSrvUav.EnableTableCache(11);
 }
 
 // Load the sample assets.
 void Renderer::LoadAssets()
 {
-    TransientUploadAllocator uploadAllocator;
-    uploadAllocator.Init(m_device.Get());
-
     // Read shaders
     {
         std::vector<std::wstring> shaderNames;
@@ -976,51 +1016,54 @@ void Renderer::LoadAssets()
     {
         auto allocations = m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(3).Split();
 
-        // index 0: white albedo
-        CreateAssetTexture(pCommandList, std::move(allocations[0]), uploadAllocator, {255, 255, 255, 255}, 1, 1);
+        // white albedo
+        auto hAlbedo = CreateAssetTexture(pCommandList, std::move(allocations[0]), m_uploadRingBuffer, {255, 255, 255, 255}, 1, 1);
 
-        // index 1: flat normal  (128, 128, 255) in linear space
-        CreateAssetTexture(pCommandList, std::move(allocations[1]), uploadAllocator, {128, 128, 255, 255}, 1, 1);
+        // flat normal  (128, 128, 255) in linear space
+        auto hNormal = CreateAssetTexture(pCommandList, std::move(allocations[1]), m_uploadRingBuffer, {128, 128, 255, 255}, 1, 1);
 
-        // index 2: black height
-        CreateAssetTexture(pCommandList, std::move(allocations[2]), uploadAllocator, {0, 0, 0, 255}, 1, 1);
+        // black height
+        auto hHeight = CreateAssetTexture(pCommandList, std::move(allocations[2]), m_uploadRingBuffer, {0, 0, 0, 255}, 1, 1);
 
         auto hDefaultMat = CreateMaterial("builtin://material/default");
         auto* pDefaultMat = m_sceneManager.GetMaterial(hDefaultMat);
         pDefaultMat->SetAmbient(XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f));
         pDefaultMat->SetSpecular(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
         pDefaultMat->SetShininess(1.0f);
-        pDefaultMat->SetTextureIndices(0, 1, 2); // default textures
+        pDefaultMat->SetTextureIndices(
+            m_sceneManager.GetAssetTexture(hAlbedo)->bindlessIndex.Get(),
+            m_sceneManager.GetAssetTexture(hNormal)->bindlessIndex.Get(),
+            m_sceneManager.GetAssetTexture(hHeight)->bindlessIndex.Get()); // default textures
         pDefaultMat->BuildSamplerIndices(m_currentTextureFiltering);
         pDefaultMat->SetRenderingPath(RenderingPath::DEFERRED);
     }
 
     auto allocations = m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(3).Split();
 
-    CreateAssetTexture(
+    auto hColor = CreateAssetTexture(
         pCommandList,
         std::move(allocations[0]),
-        uploadAllocator,
+        m_uploadRingBuffer,
         L"assets/textures/PavingStones150_4K-PNG_Color.png",
         true,
         true,
         false,
         false);
 
-    CreateAssetTexture(
+    auto hNormalDX = CreateAssetTexture(
         pCommandList,
         std::move(allocations[1]),
-        uploadAllocator,
+        m_uploadRingBuffer,
         L"assets/textures/PavingStones150_4K-PNG_NormalDX.png",
         false,
         true,
         false,
         false);
 
-    CreateAssetTexture(
+    auto hDisplacement = CreateAssetTexture(
         pCommandList,
         std::move(allocations[2]),
-        uploadAllocator,
+        m_uploadRingBuffer,
         L"assets/textures/PavingStones150_4K-PNG_Displacement.png",
         false,
         true,
@@ -1033,7 +1076,10 @@ void Renderer::LoadAssets()
     pBaseMat->SetAmbient(XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f));
     pBaseMat->SetSpecular(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
     pBaseMat->SetShininess(10.0f);
-    pBaseMat->SetTextureIndices(3, 4, 5);
+    pBaseMat->SetTextureIndices(
+        m_sceneManager.GetAssetTexture(hColor)->bindlessIndex.Get(),
+        m_sceneManager.GetAssetTexture(hNormalDX)->bindlessIndex.Get(),
+        m_sceneManager.GetAssetTexture(hDisplacement)->bindlessIndex.Get());
     pBaseMat->SetTextureAddressingModes(TextureAddressingMode::WRAP, TextureAddressingMode::WRAP, TextureAddressingMode::WRAP);
     pBaseMat->BuildSamplerIndices(m_currentTextureFiltering);
     pBaseMat->SetRenderingPath(RenderingPath::DEFERRED);
@@ -1043,8 +1089,8 @@ void Renderer::LoadAssets()
     pPlaneMat->SetTextureTileScales(50.0f, 50.0f, 50.0f);
 
     // Add meshes
-    auto hCubeMesh = m_sceneManager.AddMesh(m_device.Get(), pCommandList, uploadAllocator, GeometryGenerator::GenerateCube());
-    auto hSphereMesh = m_sceneManager.AddMesh(m_device.Get(), pCommandList, uploadAllocator, GeometryGenerator::GenerateSphere());
+    auto hCubeMesh = m_sceneManager.AddMesh(m_device.Get(), pCommandList, m_uploadRingBuffer, GeometryGenerator::GenerateCube());
+    auto hSphereMesh = m_sceneManager.AddMesh(m_device.Get(), pCommandList, m_uploadRingBuffer, GeometryGenerator::GenerateSphere());
 
     // Add Entities
     auto hPlane = m_sceneManager.AddEntity("Plane");
@@ -1097,10 +1143,13 @@ void Renderer::LoadAssets()
     pSpotLight->SetAngles(50.0f, 10.0f);
 
     // Execute commands for loading assets and update signaled fence value
-    m_frameResources[m_frameIndex].UpdateSignaledFenceValue(m_commandQueue.ExecuteCommandLists(pCommandAllocator, pCommandList));
+    UINT64 signaledFenceValue = m_commandQueue.ExecuteCommandLists(pCommandAllocator, pCommandList);
+    m_frameResources[m_frameIndex].UpdateSignaledFenceValue(signaledFenceValue);
+    m_uploadRingBuffer.QueueRetiredAllocations(signaledFenceValue);
 
     // Wait until assets have been uploaded to the GPU
     WaitForGpu();
+    m_uploadRingBuffer.ReleaseStaleAllocations(m_commandQueue.GetCompletedFenceValue());
 
     // Render Graph
     m_renderGraph.Init(m_device.Get());
@@ -1118,31 +1167,23 @@ void Renderer::LoadAssets()
     }
     m_renderGraph.AddElement(backBuffer, pBackBuffers);
 
-    // Scene color buffer0
-    RGTexture sceneColorBuffer0 = m_renderGraph.RegisterTexture(
-        "SceneColorBuffer0",
-        true,
-        {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET},
-        GetSubresourceCount(m_device.Get(), m_frameResources.front().GetSceneColorBuffer(0)));
-    std::vector<ID3D12Resource*> pSceneColorBuffers0;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pSceneColorBuffers0.push_back(m_frameResources[i].GetSceneColorBuffer(0));
-    }
-    m_renderGraph.AddElement(sceneColorBuffer0, pSceneColorBuffers0);
+    // Transient textures. Render graph creates them and aliases the ones with disjoint lifetimes.
+    const TextureResourceUsage transientUsage = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET};
 
-    // Scene color buffer1
-    RGTexture sceneColorBuffer1 = m_renderGraph.RegisterTexture(
-        "SceneColorBuffer1",
-        true,
-        {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET},
-        GetSubresourceCount(m_device.Get(), m_frameResources.front().GetSceneColorBuffer(1)));
-    std::vector<ID3D12Resource*> pSceneColorBuffers1;
-    for (UINT i = 0; i < FrameCount; ++i)
+    // Scene color buffers
     {
-        pSceneColorBuffers1.push_back(m_frameResources[i].GetSceneColorBuffer(1));
+        const auto format = FrameResource::GetSceneColorBufferFormat();
+        XMVECTORF32 color;
+        color.v = XMColorSRGBToRGB(XMVectorSet(0.5f, 0.5f, 0.5f, 1.0f));
+        const auto clearValue = CreateClearValue(format, color.f[0], color.f[1], color.f[2], color.f[3]);
+        const auto desc = GetTexture2DDesc(m_width, m_height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+        RGTexture sceneColorBuffer0 = m_renderGraph.RegisterTransientTexture("SceneColorBuffer0", transientUsage);
+        m_renderGraph.AddTransientElement(sceneColorBuffer0, desc, clearValue);
+
+        RGTexture sceneColorBuffer1 = m_renderGraph.RegisterTransientTexture("SceneColorBuffer1", transientUsage);
+        m_renderGraph.AddTransientElement(sceneColorBuffer1, desc, clearValue);
     }
-    m_renderGraph.AddElement(sceneColorBuffer1, pSceneColorBuffers1);
 
     // Depth-stencil buffer
     RGTexture depthStencilBuffer = m_renderGraph.RegisterTexture(
@@ -1153,46 +1194,26 @@ void Renderer::LoadAssets()
     m_renderGraph.AddElement(depthStencilBuffer, {m_depthStencilBuffer.Get()});
 
     // GBuffer
-    RGTexture gBuffer = m_renderGraph.RegisterTexture(
-        "GBuffer",
-        true,
-        {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET},
-        GetSubresourceCount(m_device.Get(), m_frameResources.front().GetGBuffer(GBufferSlot::ALBEDO)));
+    RGTexture gBuffer = m_renderGraph.RegisterTransientTexture("GBuffer", transientUsage);
     for (UINT slot = 0; slot < static_cast<UINT>(GBufferSlot::NUM_GBUFFER_SLOTS); ++slot)
     {
-        std::vector<ID3D12Resource*> pGBuffers;
-        for (UINT i = 0; i < FrameCount; ++i)
-        {
-            pGBuffers.push_back(m_frameResources[i].GetGBuffer(static_cast<GBufferSlot>(slot)));
-        }
-        m_renderGraph.AddElement(gBuffer, pGBuffers);
+        const auto format = FrameResource::GetGBufferFormat(static_cast<GBufferSlot>(slot));
+        const auto clearValue = CreateClearValue(format, 0.0f, 0.0f, 0.0f, 0.0f);
+        m_renderGraph.AddTransientElement(gBuffer, GetTexture2DDesc(m_width, m_height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), clearValue);
     }
 
-    // Selection mask
-    RGTexture selectionMask = m_renderGraph.RegisterTexture(
-        "SelectionMask",
-        true,
-        {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET},
-        GetSubresourceCount(m_device.Get(), m_frameResources.front().GetSelectionMask()));
-    std::vector<ID3D12Resource*> pSelectionMasks;
-    for (UINT i = 0; i < FrameCount; ++i)
+    // Masks
     {
-        pSelectionMasks.push_back(m_frameResources[i].GetSelectionMask());
-    }
-    m_renderGraph.AddElement(selectionMask, pSelectionMasks);
+        const auto format = FrameResource::GetMaskFormat();
+        const auto clearValue = CreateClearValue(format, 0.0f, 0.0f, 0.0f, 0.0f);
+        const auto desc = GetTexture2DDesc(m_width, m_height, 1, 1, format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
 
-    // Horizontal dilated mask
-    RGTexture horizontalDilatedMask = m_renderGraph.RegisterTexture(
-        "HorizontalDilatedMask",
-        true,
-        {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET},
-        GetSubresourceCount(m_device.Get(), m_frameResources.front().GetHorizontalDilatedMask()));
-    std::vector<ID3D12Resource*> pHorizontalDilatedMasks;
-    for (UINT i = 0; i < FrameCount; ++i)
-    {
-        pHorizontalDilatedMasks.push_back(m_frameResources[i].GetHorizontalDilatedMask());
+        RGTexture selectionMask = m_renderGraph.RegisterTransientTexture("SelectionMask", transientUsage);
+        m_renderGraph.AddTransientElement(selectionMask, desc, clearValue);
+
+        RGTexture horizontalDilatedMask = m_renderGraph.RegisterTransientTexture("HorizontalDilatedMask", transientUsage);
+        m_renderGraph.AddTransientElement(horizontalDilatedMask, desc, clearValue);
     }
-    m_renderGraph.AddElement(horizontalDilatedMask, pHorizontalDilatedMasks);
 
     // Light
     m_renderGraph.RegisterTexture(
@@ -1206,6 +1227,10 @@ void Renderer::LoadAssets()
             for (auto& light : m_sceneManager.GetDirectionalLights())
                 pResources.push_back(light.GetDepthBuffer());
             return pResources;
+        },
+        [this]()
+        {
+            return m_sceneManager.GetLightVersion();
         });
 
     m_renderGraph.RegisterTexture(
@@ -1219,6 +1244,10 @@ void Renderer::LoadAssets()
             for (auto& light : m_sceneManager.GetPointLights())
                 pResources.push_back(light.GetRenderTarget());
             return pResources;
+        },
+        [this]()
+        {
+            return m_sceneManager.GetLightVersion();
         });
 
     m_renderGraph.RegisterTexture(
@@ -1232,10 +1261,16 @@ void Renderer::LoadAssets()
             for (auto& light : m_sceneManager.GetSpotLights())
                 pResources.push_back(light.GetDepthBuffer());
             return pResources;
+        },
+        [this]()
+        {
+            return m_sceneManager.GetLightVersion();
         });
 
     PrepareRenderGraph();
     m_renderGraph.Compile();
+    m_renderGraph.AllocateTransientTextures();
+    BindTransientTextures();
 }
 
 void Renderer::PopulateCommandList(ID3D12GraphicsCommandList7* pCommandList)
@@ -1256,59 +1291,7 @@ void Renderer::PopulateCommandList(ID3D12GraphicsCommandList7* pCommandList)
     // Set outline thickness
     pCommandList->SetGraphicsRoot32BitConstant(4, 4, 0);
 
-    // Stage material CBVs
-    UINT matIdx = 0;
-    for (auto& mat : m_sceneManager.GetMaterials())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(5, matIdx, 1, mat.GetCbvHandle());
-        ++matIdx;
-    }
-
-    // Stage light CBVs
-    UINT lightIdx = 0;
-    for (auto& light : m_sceneManager.GetDirectionalLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(6, lightIdx, 1, light.GetLightCbvHandle());
-        ++lightIdx;
-    }
-    for (auto& light : m_sceneManager.GetPointLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(6, lightIdx, 1, light.GetLightCbvHandle());
-        ++lightIdx;
-    }
-    for (auto& light : m_sceneManager.GetSpotLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(6, lightIdx, 1, light.GetLightCbvHandle());
-        ++lightIdx;
-    }
-
-    // Stage textures
-    UINT textureIdx = 0;
-    for (auto& [texture, srv] : m_sceneManager.GetAssetTextures())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(7, textureIdx, 1, srv.GetHandle());
-        ++textureIdx;
-    }
-
-    // Stage shadow SRVs
-    lightIdx = 0;
-    for (auto& light : m_sceneManager.GetDirectionalLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(8, lightIdx, 1, light.GetSrvHandle());
-        ++lightIdx;
-    }
-    lightIdx = 0;
-    for (auto& light : m_sceneManager.GetPointLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(9, lightIdx, 1, light.GetSrvHandle());
-        ++lightIdx;
-    }
-    lightIdx = 0;
-    for (auto& light : m_sceneManager.GetSpotLights())
-    {
-        m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(10, lightIdx, 1, light.GetSrvHandle());
-        ++lightIdx;
-    }
+    // Materials, lights, textures and shadow maps are not staged. They are indexed in the bindless heap.
 
     m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(11, 0, NUM_GBUFFER_SLOTS, frameResource.GetGBufferBaseSrvHandle());
     m_dynamicDescriptorHeapForCbvSrvUav.StageDescriptors(11, NUM_GBUFFER_SLOTS, 1, m_depthSrv.GetHandle());
@@ -1318,404 +1301,421 @@ void Renderer::PopulateCommandList(ID3D12GraphicsCommandList7* pCommandList)
 
     BindDescriptorTables(pCommandList);
 
-    auto data = m_sceneManager.GatherInstances();
-    frameResource.EnsureInstanceCapacity(static_cast<UINT>(data.size()));
-    frameResource.PushInstanceData(data);
+    // Culling
+    UINT numShadowViews =
+        static_cast<UINT>(m_sceneManager.GetDirectionalLights().size()) * MAX_CASCADES +
+        static_cast<UINT>(m_sceneManager.GetPointLights().size()) * POINT_LIGHT_ARRAY_SIZE +
+        static_cast<UINT>(m_sceneManager.GetSpotLights().size()) * SPOT_LIGHT_ARRAY_SIZE;
+
+    m_sceneManager.UpdateWorldBounds();
+    m_sceneManager.SetViewCount(FIRST_SHADOW_VIEW + numShadowViews);
+    m_shadowViewStats.assign(numShadowViews, {});
+    m_sceneManager.CullView(MAIN_VIEW, m_cameraFrustum);
+    m_sceneManager.SetViewDepthPlane(MAIN_VIEW, m_camera.GetRenderPosition(), m_camera.GetForward());
+
+    // Casters are culled against the volume of each shadow map entry, not the camera frustum.
+    // Casters outside of camera frustum can still cast shadows into it.
+    UINT cullViewIdx = FIRST_SHADOW_VIEW;
+    auto cullShadowViews = [&](const Light& light)
+    {
+        for (UINT j = 0; j < light.GetArraySize(); ++j)
+            m_sceneManager.CullView(cullViewIdx++, light.GetViewProjection(j));
+    };
 
-    // Shadow map pass
-    {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Shadow map pass");
+    for (const auto& light : m_sceneManager.GetDirectionalLights())
+        cullShadowViews(light);
+    for (const auto& light : m_sceneManager.GetPointLights())
+        cullShadowViews(light);
+    for (const auto& light : m_sceneManager.GetSpotLights())
+        cullShadowViews(light);
 
-        ApplyPassBarriers(m_renderGraph, PassType::SHADOW_MAP, pCommandList);
+    UINT instanceCount = m_sceneManager.GetInstanceCount();
+    frameResource.EnsureInstanceCapacity(instanceCount);
+    m_sceneManager.GatherInstances(frameResource.AllocateInstanceData(instanceCount), m_jobSystem);
 
-        pCommandList->RSSetViewports(1, &m_shadowMapViewport);
-        pCommandList->RSSetScissorRects(1, &m_shadowMapScissorRect);
+    // Compiled plan is cached per predicate combination.
+    m_renderGraph.SetPredicate(m_hasSelectionPredicate, HasSelection());
+    m_renderGraph.PrepareBarriers(m_frameIndex);
 
-        // Pre-query PSOs
-        m_currentPSOKey.passType = PassType::SHADOW_MAP;
-        m_currentPSOKey.vsName = L"MeshVS.hlsl";
-        m_currentPSOKey.psName = L"";
-        auto* shadowPSO = GetPipelineState(m_currentPSOKey);
+    // Carries resources from the state the previous frame left them in
+    m_barrierCount = 0;
+    IssueBarriers(m_renderGraph.GetFrameBeginBarriers(), pCommandList);
 
-        m_currentPSOKey.psName = L"PointLightShadowPS.hlsl";
-        auto* pointShadowPSO = GetPipelineState(m_currentPSOKey);
+    // Sorted once here, drawn by the GBuffer tasks
+    BuildDrawList(m_drawList, MAIN_VIEW, PassType::GBUFFER, 0);
 
-        auto processLight = [&](Light* pLight, bool isPointLight, UINT& lightIdx)
+    // Tasks are split here in graph order. Each one takes its command list from the pool of the thread recording it.
+    // Every list goes to the direct queue, compute passes included. Queue order already satisfies the sync plan.
+    m_recordTaskCount = 0;
+    for (PassType passType : m_renderGraph.GetCompiledOrder())
+    {
+        switch (passType)
         {
-            if (isPointLight)
-                pCommandList->SetGraphicsRoot32BitConstant(3, lightIdx, 0);
+        case PassType::SHADOW_MAP:
+            AddRecordTasks(passType, numShadowViews, SHADOW_VIEWS_PER_RECORD_TASK);
+            break;
+        case PassType::GBUFFER:
+            AddRecordTasks(passType, m_drawList.GetCount(), DRAWS_PER_RECORD_TASK);
+            break;
+        default:
+            AddRecordTasks(passType, 1, 1);
+            break;
+        }
+    }
 
-            // Render each entry of shadow map.
-            UINT16 arraySize = pLight->GetArraySize();
-            for (UINT j = 0; j < arraySize; ++j)
-            {
-                auto shadowMapDsvHandle = pLight->GetDsvHandle(j);
+    auto recordBegin = m_clock.now();
 
-                if (isPointLight)
-                {
-                    auto rtvHandle = static_cast<PointLight*>(pLight)->GetRtvHandle(j);
-                    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &shadowMapDsvHandle);
+    m_jobSystem.ParallelFor(
+        0,
+        m_recordTaskCount,
+        1,
+        [&](UINT i)
+        {
+            RecordPassTask(m_recordTasks[i], frameResource);
+        });
 
-                    XMVECTORF32 clearColor;
-                    clearColor.v = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
-                    pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-                }
-                else
-                {
-                    pCommandList->OMSetRenderTargets(0, nullptr, FALSE, &shadowMapDsvHandle);
-                }
+    m_recordMs = std::chrono::duration<double, std::milli>(m_clock.now() - recordBegin).count();
 
-                pCommandList->ClearDepthStencilView(shadowMapDsvHandle, D3D12_CLEAR_FLAG_DEPTH, 0.0f, 0, 0, nullptr);
+    for (UINT i = 0; i < m_recordTaskCount; ++i)
+        m_submittedCommandLists.emplace_back(m_recordTasks[i].pCommandAllocator, m_recordTasks[i].pCommandList);
+}
 
-                pCommandList->SetPipelineState(isPointLight ? pointShadowPSO : shadowPSO);
+// Split [0, count) into tasks of grainSize items. Empty passes still get one task, which issues their barriers.
+void Renderer::AddRecordTasks(PassType passType, UINT count, UINT grainSize)
+{
+    UINT first = 0;
+    do
+    {
+        UINT last = (std::min)(first + grainSize, count);
 
-                pCommandList->SetGraphicsRootConstantBufferView(0, pLight->GetCameraUploadAllocation(j).gpuPtr);
+        if (m_recordTaskCount == static_cast<UINT>(m_recordTasks.size()))
+            m_recordTasks.emplace_back();
 
-                for (const auto& [meshHandle, bucket] : m_sceneManager.GetBuckets())
-                {
-                    DrawMesh(pCommandList, meshHandle, PassType::SHADOW_MAP, frameResource.GetInstanceBufferVirtualAddress());
-                }
-            }
+        auto& task = m_recordTasks[m_recordTaskCount++];
+        task.passType = passType;
+        task.first = first;
+        task.last = last;
+        task.isFirst = first == 0;
+        task.isLast = last == count;
 
-            ++lightIdx;
-        };
+        first = last;
+    } while (first < count);
+}
 
-        UINT lightIdx = 0;
-        for (auto& light : m_sceneManager.GetDirectionalLights())
-        {
-            processLight(&light, false, lightIdx);
-        }
-        for (auto& light : m_sceneManager.GetPointLights())
-        {
-            processLight(&light, true, lightIdx);
-        }
-        for (auto& light : m_sceneManager.GetSpotLights())
-        {
-            processLight(&light, false, lightIdx);
-        }
-    }
+// Runs on a worker thread. Reads shared state only, except its own command list, draw list and shadow view stats.
+void Renderer::RecordPassTask(RecordTask& task, FrameResource& frameResource)
+{
+    // From the pool of this thread, so recording threads do not share allocators.
+    std::tie(task.pCommandAllocator, task.pCommandList) = m_commandQueue.GetAvailableCommandList(JobSystem::GetCurrentThreadIndex());
+    auto* pCommandList = task.pCommandList;
 
-    // GBuffer pass
-    {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"GBuffer pass");
+    // Root arguments are not inherited from other command lists.
+    pCommandList->SetGraphicsRootSignature(m_rootSignature.GetRootSignature());
+    pCommandList->SetGraphicsRoot32BitConstant(2, m_sceneManager.GetLightCount(), 0);
+    pCommandList->SetGraphicsRoot32BitConstant(4, 4, 0);
+    m_dynamicDescriptorHeapForCbvSrvUav.BindCommittedDescriptorsForDraw(pCommandList);
+    pCommandList->SetGraphicsRootDescriptorTable(12, m_samplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart()); // Root parameter 12
+    BindBindlessTables(pCommandList);
 
-        ApplyPassBarriers(m_renderGraph, PassType::GBUFFER, pCommandList);
+    if (task.isFirst)
+        ApplyPassBarriers(m_renderGraph, task.passType, pCommandList);
 
-        pCommandList->RSSetViewports(1, &m_viewport);
-        pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    switch (task.passType)
+    {
+    case PassType::SHADOW_MAP:
+        RecordShadowMapPass(pCommandList, frameResource, task.drawList, task.first, task.last);
+        break;
+    case PassType::GBUFFER:
+        RecordGBufferPass(pCommandList, frameResource, task.first, task.last);
+        break;
+    case PassType::DEFERRED_LIGHTING:
+        RecordDeferredLightingPass(pCommandList, frameResource);
+        break;
+    case PassType::FORWARD_COLORING:
+        RecordForwardColoringPass(pCommandList, frameResource, task.drawList);
+        break;
+    case PassType::SELECTION_MASK:
+        RecordSelectionMaskPass(pCommandList, frameResource);
+        break;
+    case PassType::HORIZONTAL_DILATE:
+        RecordHorizontalDilatePass(pCommandList, frameResource);
+        break;
+    case PassType::OUTLINE_DRAWING:
+        RecordOutlineDrawingPass(pCommandList, frameResource);
+        break;
+    case PassType::TONEMAP:
+        RecordToneMapPass(pCommandList, frameResource);
+        break;
+    }
 
-        // Pre-query PSOs
-        m_currentPSOKey.passType = PassType::GBUFFER;
-        m_currentPSOKey.vsName = L"MeshVS.hlsl";
-        m_currentPSOKey.psName = L"GBufferPS.hlsl";
-        auto* pso = GetPipelineState(m_currentPSOKey);
+    if (task.isLast)
+        IssueBarriers(m_renderGraph.GetPassReleaseBarriers(task.passType, m_frameIndex), pCommandList);
+}
 
-        D3D12_CPU_DESCRIPTOR_HANDLE baseRTVHandle = frameResource.GetGBufferBaseRtvHandle();
-        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsv.GetHandle();
-        pCommandList->OMSetRenderTargets(NUM_GBUFFER_SLOTS, &baseRTVHandle, TRUE, &dsvHandle);
+void Renderer::RecordShadowMapPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, DrawList& drawList, UINT firstView, UINT lastView)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Shadow map pass");
 
-        XMVECTORF32 clearColor;
-        clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-        static UINT rtvHandleIncrementSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-        for (UINT i = 0; i < NUM_GBUFFER_SLOTS; ++i)
-        {
-            auto rtvHandle = GetCpuDescriptorHandle(baseRTVHandle, i, rtvHandleIncrementSize);
-            pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-        }
-        pCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 0.0f, 0, 0, nullptr);
-        pCommandList->OMSetStencilRef(1);
+    pCommandList->RSSetViewports(1, &m_shadowMapViewport);
+    pCommandList->RSSetScissorRects(1, &m_shadowMapScissorRect);
 
-        pCommandList->SetPipelineState(pso);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::SHADOW_MAP, L"MeshVS.hlsl", L""};
+    auto* shadowPSO = GetPipelineState(psoKey);
 
-        pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
+    psoKey.psName = L"PointLightShadowPS.hlsl";
+    auto* pointShadowPSO = GetPipelineState(psoKey);
 
-        for (const auto& [meshHandle, bucket] : m_sceneManager.GetBuckets())
-        {
-            DrawMesh(pCommandList, meshHandle, PassType::GBUFFER, frameResource.GetInstanceBufferVirtualAddress());
-        }
-    }
+    UINT shadowViewIdx = FIRST_SHADOW_VIEW;
 
-    // Deferred Lighting pass
+    auto processLight = [&](Light* pLight, bool isPointLight)
     {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Deferred Lighting pass");
+        if (isPointLight)
+            pCommandList->SetGraphicsRoot32BitConstant(3, pLight->GetLightCbvIndex(), 0);
 
-        ApplyPassBarriers(m_renderGraph, PassType::DEFERRED_LIGHTING, pCommandList);
+        // Render each entry of shadow map. Entries out of [firstView, lastView) are recorded by other tasks.
+        UINT16 arraySize = pLight->GetArraySize();
+        for (UINT j = 0; j < arraySize; ++j, ++shadowViewIdx)
+        {
+            UINT viewIdx = shadowViewIdx - FIRST_SHADOW_VIEW;
+            if (viewIdx < firstView || viewIdx >= lastView)
+                continue;
 
-        pCommandList->RSSetViewports(1, &m_viewport);
-        pCommandList->RSSetScissorRects(1, &m_scissorRect);
+            auto shadowMapDsvHandle = pLight->GetDsvHandle(j);
 
-        // Pre-query PSOs
-        m_currentPSOKey.passType = PassType::DEFERRED_LIGHTING;
-        m_currentPSOKey.vsName = L"FullScreenTriangleVS.hlsl";
-        m_currentPSOKey.psName = L"DeferredLightingPS.hlsl";
-        auto* pso = GetPipelineState(m_currentPSOKey);
+            if (isPointLight)
+            {
+                auto rtvHandle = static_cast<PointLight*>(pLight)->GetRtvHandle(j);
+                pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &shadowMapDsvHandle);
 
-        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
-        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_readOnlyDsv.GetHandle();
-        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
-        pCommandList->OMSetStencilRef(1);
+                XMVECTORF32 clearColor;
+                clearColor.v = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+                pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+            }
+            else
+            {
+                pCommandList->OMSetRenderTargets(0, nullptr, FALSE, &shadowMapDsvHandle);
+            }
 
-        // Use linear color for gamma-correct rendering
-        XMVECTORF32 clearColor;
-        clearColor.v = XMColorSRGBToRGB(XMVectorSet(0.5f, 0.5f, 0.5f, 1.0f));
-        pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+            pCommandList->ClearDepthStencilView(shadowMapDsvHandle, D3D12_CLEAR_FLAG_DEPTH, 0.0f, 0, 0, nullptr);
 
-        pCommandList->SetPipelineState(pso);
+            pCommandList->SetPipelineState(isPointLight ? pointShadowPSO : shadowPSO);
 
-        pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
-        pCommandList->SetGraphicsRootConstantBufferView(1, m_shadowUploadAllocation.gpuPtr);
+            pCommandList->SetGraphicsRootConstantBufferView(0, pLight->GetCameraUploadAllocation(j).gpuPtr);
 
-        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        pCommandList->DrawInstanced(3, 1, 0, 0);
+            auto& stats = m_shadowViewStats[viewIdx];
+            BuildDrawList(drawList, shadowViewIdx, PassType::SHADOW_MAP, isPointLight ? 1 : 0);
+            for (UINT k = 0; k < drawList.GetCount(); ++k)
+            {
+                const auto& packet = drawList.GetPacket(k);
+                DrawMesh(pCommandList, packet.mesh, packet.range, PassType::SHADOW_MAP, frameResource.GetInstanceBufferVirtualAddress());
 
-        std::vector<D3D12_TEXTURE_BARRIER> barriers;
-        for (UINT slot = 0; slot < NUM_GBUFFER_SLOTS; ++slot)
-        {
-            D3D12_TEXTURE_BARRIER b = {
-                D3D12_BARRIER_SYNC_PIXEL_SHADING,
-                D3D12_BARRIER_SYNC_NONE,
-                D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-                D3D12_BARRIER_ACCESS_NO_ACCESS,
-                D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-                D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-                frameResource.GetGBuffer(static_cast<GBufferSlot>(slot)),
-                {0xffff'ffff, 0, 0, 0, 0, 0},
-                D3D12_TEXTURE_BARRIER_FLAG_NONE};
-            barriers.push_back(b);
+                ++stats.drawCalls;
+                stats.instanceCount += packet.range.forwardCount + packet.range.deferredCount;
+            }
         }
-        D3D12_BARRIER_GROUP barrierGroups[] = {TextureBarrierGroup(static_cast<UINT32>(barriers.size()), barriers.data())};
-        pCommandList->Barrier(1, barrierGroups);
-    }
+    };
 
-    // Forward Coloring pass
+    for (auto& light : m_sceneManager.GetDirectionalLights())
     {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Forward coloring pass");
-
-        ApplyPassBarriers(m_renderGraph, PassType::FORWARD_COLORING, pCommandList);
+        processLight(&light, false);
+    }
+    for (auto& light : m_sceneManager.GetPointLights())
+    {
+        processLight(&light, true);
+    }
+    for (auto& light : m_sceneManager.GetSpotLights())
+    {
+        processLight(&light, false);
+    }
+}
 
-        pCommandList->RSSetViewports(1, &m_viewport);
-        pCommandList->RSSetScissorRects(1, &m_scissorRect);
+void Renderer::RecordGBufferPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, UINT firstDraw, UINT lastDraw)
+{
+    static constexpr UINT NUM_GBUFFER_SLOTS = static_cast<UINT>(GBufferSlot::NUM_GBUFFER_SLOTS);
 
-        // Pre-query PSOs
-        m_currentPSOKey.passType = PassType::FORWARD_COLORING;
-        m_currentPSOKey.vsName = L"MeshVS.hlsl";
-        m_currentPSOKey.psName = L"ForwardColoringPS.hlsl";
-        auto* pso = GetPipelineState(m_currentPSOKey);
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"GBuffer pass");
 
-        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
-        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsv.GetHandle();
-        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-        pCommandList->SetPipelineState(pso);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::GBUFFER, L"MeshVS.hlsl", L"GBufferPS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
 
-        pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
-        pCommandList->SetGraphicsRootConstantBufferView(1, m_shadowUploadAllocation.gpuPtr);
+    D3D12_CPU_DESCRIPTOR_HANDLE baseRTVHandle = frameResource.GetGBufferBaseRtvHandle();
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsv.GetHandle();
+    pCommandList->OMSetRenderTargets(NUM_GBUFFER_SLOTS, &baseRTVHandle, TRUE, &dsvHandle);
 
-        for (const auto& [meshHandle, bucket] : m_sceneManager.GetBuckets())
+    // Only the first task clears. Later ones draw on top of it.
+    if (firstDraw == 0)
+    {
+        XMVECTORF32 clearColor;
+        clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
+        static const UINT rtvHandleIncrementSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        for (UINT i = 0; i < NUM_GBUFFER_SLOTS; ++i)
         {
-            DrawMesh(pCommandList, meshHandle, PassType::FORWARD_COLORING, frameResource.GetInstanceBufferVirtualAddress());
+            auto rtvHandle = GetCpuDescriptorHandle(baseRTVHandle, i, rtvHandleIncrementSize);
+            pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
         }
+        pCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 0.0f, 0, 0, nullptr);
+    }
+    pCommandList->OMSetStencilRef(1);
 
-        std::vector<D3D12_TEXTURE_BARRIER> barriers;
-
-        auto processLight = [&](Light* pLight, bool isPointLight)
-        {
-            if (isPointLight)
-            {
-                D3D12_TEXTURE_BARRIER b = {
-                    D3D12_BARRIER_SYNC_PIXEL_SHADING,
-                    D3D12_BARRIER_SYNC_NONE,
-                    D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-                    D3D12_BARRIER_ACCESS_NO_ACCESS,
-                    D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-                    D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-                    static_cast<PointLight*>(pLight)->GetRenderTarget(),
-                    {0xffff'ffff, 0, 0, 0, 0, 0},
-                    D3D12_TEXTURE_BARRIER_FLAG_NONE};
-                barriers.push_back(b);
-            }
-            else
-            {
-                D3D12_TEXTURE_BARRIER b = {
-                    D3D12_BARRIER_SYNC_PIXEL_SHADING,
-                    D3D12_BARRIER_SYNC_NONE,
-                    D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-                    D3D12_BARRIER_ACCESS_NO_ACCESS,
-                    D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-                    D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE,
-                    pLight->GetDepthBuffer(),
-                    {0xffff'ffff, 0, 0, 0, 0, 0},
-                    D3D12_TEXTURE_BARRIER_FLAG_NONE};
-                barriers.push_back(b);
-            }
-        };
+    pCommandList->SetPipelineState(pso);
 
-        for (auto& light : m_sceneManager.GetDirectionalLights())
-        {
-            processLight(&light, false);
-        }
-        for (auto& light : m_sceneManager.GetPointLights())
-        {
-            processLight(&light, true);
-        }
-        for (auto& light : m_sceneManager.GetSpotLights())
-        {
-            processLight(&light, false);
-        }
+    pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
 
-        D3D12_BARRIER_GROUP barrierGroups[] = {TextureBarrierGroup(static_cast<UINT32>(barriers.size()), barriers.data())};
-        pCommandList->Barrier(1, barrierGroups);
+    // Front-to-back for early depth rejection. Sorted before the tasks are started.
+    for (UINT i = firstDraw; i < lastDraw; ++i)
+    {
+        const auto& packet = m_drawList.GetPacket(i);
+        DrawMesh(pCommandList, packet.mesh, packet.range, PassType::GBUFFER, frameResource.GetInstanceBufferVirtualAddress());
     }
+}
 
-    bool selectionExists = !(m_selected.index == UINT_MAX && m_selected.generation == 0);
+void Renderer::RecordDeferredLightingPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Deferred Lighting pass");
 
-    // Selection mask pass
-    {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Selection mask pass");
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-        ApplyPassBarriers(m_renderGraph, PassType::SELECTION_MASK, pCommandList);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::DEFERRED_LIGHTING, L"FullScreenTriangleVS.hlsl", L"DeferredLightingPS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
 
-        if (selectionExists)
-        {
-            pCommandList->RSSetViewports(1, &m_viewport);
-            pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_readOnlyDsv.GetHandle();
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    pCommandList->OMSetStencilRef(1);
 
-            // Pre-query PSOs
-            m_currentPSOKey.passType = PassType::SELECTION_MASK;
-            m_currentPSOKey.vsName = L"MeshVS.hlsl";
-            m_currentPSOKey.psName = L"SelectionMaskPS.hlsl";
-            auto* pso = GetPipelineState(m_currentPSOKey);
-            pCommandList->SetPipelineState(pso);
+    // Use linear color for gamma-correct rendering
+    XMVECTORF32 clearColor;
+    clearColor.v = XMColorSRGBToRGB(XMVectorSet(0.5f, 0.5f, 0.5f, 1.0f));
+    pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 
-            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSelectionMaskRtvHandle();
-            pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    pCommandList->SetPipelineState(pso);
 
-            XMVECTORF32 clearColor;
-            clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-            pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
+    pCommandList->SetGraphicsRootConstantBufferView(1, m_shadowUploadAllocation.gpuPtr);
 
-            pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->DrawInstanced(3, 1, 0, 0);
+}
 
-            // 선택된 Entity들에 대해서만 draw call을 호출해야 함 (나중에는 여러 Entity를 다중 선택할 수도 있어야 함)
-            DrawEntity(pCommandList, m_selected, frameResource.GetInstanceBufferVirtualAddress());
-        }
-    }
+void Renderer::RecordForwardColoringPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, DrawList& drawList)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Forward coloring pass");
 
-    // Horizontal dilate pass
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
+
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::FORWARD_COLORING, L"MeshVS.hlsl", L"ForwardColoringPS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsv.GetHandle();
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+
+    pCommandList->SetPipelineState(pso);
+
+    pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
+    pCommandList->SetGraphicsRootConstantBufferView(1, m_shadowUploadAllocation.gpuPtr);
+
+    BuildDrawList(drawList, MAIN_VIEW, PassType::FORWARD_COLORING, 0);
+    for (UINT i = 0; i < drawList.GetCount(); ++i)
     {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Horizontal dilate pass");
+        const auto& packet = drawList.GetPacket(i);
+        DrawMesh(pCommandList, packet.mesh, packet.range, PassType::FORWARD_COLORING, frameResource.GetInstanceBufferVirtualAddress());
+    }
+}
 
-        ApplyPassBarriers(m_renderGraph, PassType::HORIZONTAL_DILATE, pCommandList);
+void Renderer::RecordSelectionMaskPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Selection mask pass");
 
-        if (selectionExists)
-        {
-            pCommandList->RSSetViewports(1, &m_viewport);
-            pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-            // Pre-query PSOs
-            m_currentPSOKey.passType = PassType::HORIZONTAL_DILATE;
-            m_currentPSOKey.vsName = L"FullScreenTriangleVS.hlsl";
-            m_currentPSOKey.psName = L"HorizontalDilatePS.hlsl";
-            auto* pso = GetPipelineState(m_currentPSOKey);
-            pCommandList->SetPipelineState(pso);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::SELECTION_MASK, L"MeshVS.hlsl", L"SelectionMaskPS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
+    pCommandList->SetPipelineState(pso);
 
-            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetHorizontalDilatedMaskRtvHandle();
-            pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSelectionMaskRtvHandle();
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-            XMVECTORF32 clearColor;
-            clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-            pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    XMVECTORF32 clearColor;
+    clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
+    pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 
-            pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            pCommandList->DrawInstanced(3, 1, 0, 0);
-        }
-    }
+    pCommandList->SetGraphicsRootConstantBufferView(0, m_cameraUploadAllocation.gpuPtr);
 
-    // Outline drawing pass
-    {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Outline drawing pass");
+    // 선택된 Entity들에 대해서만 draw call을 호출해야 함 (나중에는 여러 Entity를 다중 선택할 수도 있어야 함)
+    DrawEntity(pCommandList, m_selected, frameResource.GetInstanceBufferVirtualAddress());
+}
 
-        ApplyPassBarriers(m_renderGraph, PassType::OUTLINE_DRAWING, pCommandList);
+void Renderer::RecordHorizontalDilatePass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Horizontal dilate pass");
 
-        if (selectionExists)
-        {
-            pCommandList->RSSetViewports(1, &m_viewport);
-            pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-            // Pre-query PSOs
-            m_currentPSOKey.passType = PassType::OUTLINE_DRAWING;
-            m_currentPSOKey.vsName = L"FullScreenTriangleVS.hlsl";
-            m_currentPSOKey.psName = L"OutlinePS.hlsl";
-            auto* pso = GetPipelineState(m_currentPSOKey);
-            pCommandList->SetPipelineState(pso);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::HORIZONTAL_DILATE, L"FullScreenTriangleVS.hlsl", L"HorizontalDilatePS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
+    pCommandList->SetPipelineState(pso);
 
-            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
-            pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetHorizontalDilatedMaskRtvHandle();
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-            pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            pCommandList->DrawInstanced(3, 1, 0, 0);
-        }
+    XMVECTORF32 clearColor;
+    clearColor.v = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
+    pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 
-        std::vector<D3D12_TEXTURE_BARRIER> barriers = {
-            {D3D12_BARRIER_SYNC_PIXEL_SHADING,
-             D3D12_BARRIER_SYNC_NONE,
-             D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-             D3D12_BARRIER_ACCESS_NO_ACCESS,
-             D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-             D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-             frameResource.GetSelectionMask(),
-             {0xffff'ffff, 0, 0, 0, 0, 0},
-             D3D12_TEXTURE_BARRIER_FLAG_NONE},
-            {D3D12_BARRIER_SYNC_PIXEL_SHADING,
-             D3D12_BARRIER_SYNC_NONE,
-             D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-             D3D12_BARRIER_ACCESS_NO_ACCESS,
-             D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-             D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-             frameResource.GetHorizontalDilatedMask(),
-             {0xffff'ffff, 0, 0, 0, 0, 0},
-             D3D12_TEXTURE_BARRIER_FLAG_NONE}};
-
-        D3D12_BARRIER_GROUP barrierGroups[] = {TextureBarrierGroup(static_cast<UINT32>(barriers.size()), barriers.data())};
-        pCommandList->Barrier(1, barrierGroups);
-    }
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->DrawInstanced(3, 1, 0, 0);
+}
 
-    // Tone mapping pass
-    {
-        PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Tone mapping pass");
+void Renderer::RecordOutlineDrawingPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Outline drawing pass");
+
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-        ApplyPassBarriers(m_renderGraph, PassType::TONEMAP, pCommandList);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::OUTLINE_DRAWING, L"FullScreenTriangleVS.hlsl", L"OutlinePS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
+    pCommandList->SetPipelineState(pso);
 
-        pCommandList->RSSetViewports(1, &m_viewport);
-        pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetSceneColorBufferRtvHandle(0);
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-        // Pre-query PSOs
-        m_currentPSOKey.passType = PassType::TONEMAP;
-        m_currentPSOKey.vsName = L"FullScreenTriangleVS.hlsl";
-        m_currentPSOKey.psName = L"ToneMapPS.hlsl";
-        auto* pso = GetPipelineState(m_currentPSOKey);
-        pCommandList->SetPipelineState(pso);
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->DrawInstanced(3, 1, 0, 0);
+}
+
+void Renderer::RecordToneMapPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource)
+{
+    PIX_SCOPED_EVENT(pCommandList, PIX_COLOR_DEFAULT, L"Tone mapping pass");
 
-        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetBackBufferRtvHandle();
-        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    pCommandList->RSSetViewports(1, &m_viewport);
+    pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        pCommandList->DrawInstanced(3, 1, 0, 0);
+    // Pre-query PSOs
+    PSOKey psoKey = {PassType::TONEMAP, L"FullScreenTriangleVS.hlsl", L"ToneMapPS.hlsl"};
+    auto* pso = GetPipelineState(psoKey);
+    pCommandList->SetPipelineState(pso);
 
-        std::vector<D3D12_TEXTURE_BARRIER> barriers = {
-            {D3D12_BARRIER_SYNC_PIXEL_SHADING,
-             D3D12_BARRIER_SYNC_NONE,
-             D3D12_BARRIER_ACCESS_SHADER_RESOURCE,
-             D3D12_BARRIER_ACCESS_NO_ACCESS,
-             D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
-             D3D12_BARRIER_LAYOUT_RENDER_TARGET,
-             frameResource.GetSceneColorBuffer(0),
-             {0xffff'ffff, 0, 0, 0, 0, 0},
-             D3D12_TEXTURE_BARRIER_FLAG_NONE}};
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = frameResource.GetBackBufferRtvHandle();
+    pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-        D3D12_BARRIER_GROUP barrierGroups[] = {TextureBarrierGroup(static_cast<UINT32>(barriers.size()), barriers.data())};
-        pCommandList->Barrier(1, barrierGroups);
-    }
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->DrawInstanced(3, 1, 0, 0);
 }
 
 // Wait for pending GPU work to complete
@@ -1786,6 +1786,62 @@ void Renderer::PrepareRenderGraph()
     auto pointLightRenderTarget = m_renderGraph.GetRGTexture("PointLight");
     auto spotLightDepthBuffer = m_renderGraph.GetRGTexture("SpotLight");
 
+    shadowMapPass.name = "Shadow map";
+    gBufferPass.name = "GBuffer";
+    deferredLightingPass.name = "Deferred lighting";
+    forwardColoringPass.name = "Forward coloring";
+    selectionMaskPass.name = "Selection mask";
+    horizontalDilatePass.name = "Horizontal dilate";
+    outlineDrawingPass.name = "Outline drawing";
+    toneMapPass.name = "Tone mapping";
+
+    // Each pass is split into record tasks of its own, and each task records into its own list. See AddRecordTasks.
+    for (auto& node : m_renderGraph.m_nodes)
+        node.SetStartsCommandList(true);
+
+    // Data flow. Pass order is derived from these in RenderGraph::Compile.
+    auto directionalLightShadow = shadowMapPass.Write(directionalLightDepthBuffer);
+    auto pointLightShadow = shadowMapPass.Write(pointLightRenderTarget);
+    auto spotLightShadow = shadowMapPass.Write(spotLightDepthBuffer);
+
+    auto gBufferDepth = gBufferPass.Write(depthStencilBuffer);
+    auto gBufferTargets = gBufferPass.Write(gBuffer);
+
+    deferredLightingPass.Read(gBufferDepth);
+    deferredLightingPass.Read(gBufferTargets);
+    deferredLightingPass.Read(directionalLightShadow);
+    deferredLightingPass.Read(pointLightShadow);
+    deferredLightingPass.Read(spotLightShadow);
+    auto litColor = deferredLightingPass.Write(sceneColorBuffer0);
+
+    // Forward objects are depth-tested against deferred ones and drawn over the lit result.
+    forwardColoringPass.Read(directionalLightShadow);
+    forwardColoringPass.Read(pointLightShadow);
+    forwardColoringPass.Read(spotLightShadow);
+    forwardColoringPass.Write(gBufferDepth);
+    auto forwardColor = forwardColoringPass.Write(litColor);
+
+    auto mask = selectionMaskPass.Write(selectionMask);
+
+    horizontalDilatePass.Read(mask);
+    auto dilatedMask = horizontalDilatePass.Write(horizontalDilatedMask);
+
+    outlineDrawingPass.Read(mask);
+    outlineDrawingPass.Read(dilatedMask);
+    auto outlinedColor = outlineDrawingPass.Write(forwardColor);
+
+    toneMapPass.Read(outlinedColor);
+    toneMapPass.Write(backBuffer);
+
+    // Passes not reaching the back buffer are culled.
+    // Mask passes only feed outline drawing, so they are culled with it while nothing is selected.
+    m_renderGraph.MarkAsOutput(backBuffer);
+
+    // Present barrier is issued after ImGui. Other resources are left in their last used state.
+    m_renderGraph.SetFrameEndUsage(backBuffer, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_PRESENT});
+    m_hasSelectionPredicate = m_renderGraph.RegisterPredicate("HasSelection");
+    outlineDrawingPass.SetCondition(m_hasSelectionPredicate);
+
     // Shadow map pass
     shadowMapPass.AddTextureInput(directionalLightDepthBuffer, {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE});
     shadowMapPass.AddTextureInput(pointLightRenderTarget, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
@@ -1802,7 +1858,6 @@ void Renderer::PrepareRenderGraph()
     // DSV: for stencil test
     deferredLightingPass.AddTextureInput(depthStencilBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE | D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ, D3D12_BARRIER_LAYOUT_DIRECT_QUEUE_GENERIC_READ});
     deferredLightingPass.AddTextureInput(gBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    deferredLightingPass.AddTextureOutput(gBuffer, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     deferredLightingPass.AddTextureInput(directionalLightDepthBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
     deferredLightingPass.AddTextureInput(pointLightRenderTarget, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
     deferredLightingPass.AddTextureInput(spotLightDepthBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
@@ -1811,11 +1866,8 @@ void Renderer::PrepareRenderGraph()
     forwardColoringPass.AddTextureInput(sceneColorBuffer0, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     forwardColoringPass.AddTextureInput(depthStencilBuffer, {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE});
     forwardColoringPass.AddTextureInput(directionalLightDepthBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    forwardColoringPass.AddTextureOutput(directionalLightDepthBuffer, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE});
     forwardColoringPass.AddTextureInput(pointLightRenderTarget, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    forwardColoringPass.AddTextureOutput(pointLightRenderTarget, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     forwardColoringPass.AddTextureInput(spotLightDepthBuffer, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    forwardColoringPass.AddTextureOutput(spotLightDepthBuffer, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE});
 
     // Selection mask pass
     selectionMaskPass.AddTextureInput(selectionMask, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
@@ -1827,65 +1879,56 @@ void Renderer::PrepareRenderGraph()
     // Outline drawing pass
     outlineDrawingPass.AddTextureInput(sceneColorBuffer0, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     outlineDrawingPass.AddTextureInput(selectionMask, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    outlineDrawingPass.AddTextureOutput(selectionMask, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     outlineDrawingPass.AddTextureInput(horizontalDilatedMask, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    outlineDrawingPass.AddTextureOutput(horizontalDilatedMask, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
 
     // Tone mapping pass
     toneMapPass.AddTextureInput(backBuffer, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
     toneMapPass.AddTextureInput(sceneColorBuffer0, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE});
-    toneMapPass.AddTextureOutput(sceneColorBuffer0, {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET});
 }
 
-void Renderer::ApplyPassBarriers(RenderGraph& renderGraph, PassType passType, ID3D12GraphicsCommandList7* pCommandList)
+// Point views of each frame resource to the textures render graph allocated.
+void Renderer::BindTransientTextures()
 {
-    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
-    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    auto sceneColorBuffer0 = m_renderGraph.GetRGTexture("SceneColorBuffer0");
+    auto sceneColorBuffer1 = m_renderGraph.GetRGTexture("SceneColorBuffer1");
+    auto gBuffer = m_renderGraph.GetRGTexture("GBuffer");
+    auto selectionMask = m_renderGraph.GetRGTexture("SelectionMask");
+    auto horizontalDilatedMask = m_renderGraph.GetRGTexture("HorizontalDilatedMask");
 
-    for (const auto& barrier : renderGraph.GetCompiledBufferBarriers(passType))
+    for (UINT i = 0; i < FrameCount; ++i)
     {
-        auto pResources = renderGraph.GetResources(barrier.buffer, m_frameIndex);
-        for (const auto& pResource : pResources)
-        {
-            D3D12_BUFFER_BARRIER b = {
-                barrier.before.sync,
-                barrier.after.sync,
-                barrier.before.access,
-                barrier.after.access,
-                pResource,
-                0,
-                UINT64_MAX};
-            bufferBarriers.push_back(b);
-        }
-    }
+        auto& frameResource = m_frameResources[i];
 
-    for (const auto& barrier : renderGraph.GetCompiledTextureBarrier(passType))
-    {
-        auto pResources = renderGraph.GetResources(barrier.texture, m_frameIndex);
-        for (const auto& pResource : pResources)
-        {
-            D3D12_TEXTURE_BARRIER b = {
-                barrier.before.sync,
-                barrier.after.sync,
-                barrier.before.access,
-                barrier.after.access,
-                barrier.before.layout,
-                barrier.after.layout,
-                pResource,
-                barrier.subresourceRange,
-                D3D12_TEXTURE_BARRIER_FLAG_NONE};
-            textureBarriers.push_back(b);
-        }
+        frameResource.SetSceneColorBuffer(0, m_renderGraph.Resolve(sceneColorBuffer0, 0, i));
+        frameResource.SetSceneColorBuffer(1, m_renderGraph.Resolve(sceneColorBuffer1, 0, i));
+
+        for (UINT slot = 0; slot < static_cast<UINT>(GBufferSlot::NUM_GBUFFER_SLOTS); ++slot)
+            frameResource.SetGBuffer(static_cast<GBufferSlot>(slot), m_renderGraph.Resolve(gBuffer, slot, i));
+
+        frameResource.SetMasks(m_renderGraph.Resolve(selectionMask, 0, i), m_renderGraph.Resolve(horizontalDilatedMask, 0, i));
     }
+}
+
+void Renderer::ApplyPassBarriers(RenderGraph& renderGraph, PassType passType, ID3D12GraphicsCommandList7* pCommandList)
+{
+    IssueBarriers(renderGraph.GetPassBarriers(passType, m_frameIndex), pCommandList);
+}
 
-    std::vector<D3D12_BARRIER_GROUP> barrierGroups;
+void Renderer::IssueBarriers(const PassBarriers& barriers, ID3D12GraphicsCommandList7* pCommandList)
+{
+    auto& [bufferBarriers, textureBarriers] = barriers;
+
+    D3D12_BARRIER_GROUP barrierGroups[2];
+    UINT32 numBarrierGroups = 0;
     if (!bufferBarriers.empty())
-        barrierGroups.push_back(BufferBarrierGroup(static_cast<UINT32>(bufferBarriers.size()), bufferBarriers.data()));
+        barrierGroups[numBarrierGroups++] = BufferBarrierGroup(static_cast<UINT32>(bufferBarriers.size()), bufferBarriers.data());
     if (!textureBarriers.empty())
-        barrierGroups.push_back(TextureBarrierGroup(static_cast<UINT32>(textureBarriers.size()), textureBarriers.data()));
+        barrierGroups[numBarrierGroups++] = TextureBarrierGroup(static_cast<UINT32>(textureBarriers.size()), textureBarriers.data());
+
+    if (numBarrierGroups > 0)
+        pCommandList->Barrier(numBarrierGroups, barrierGroups);
 
-    if (!barrierGroups.empty())
-        pCommandList->Barrier(static_cast<UINT32>(barrierGroups.size()), barrierGroups.data());
+    m_barrierCount += static_cast<UINT>(bufferBarriers.size() + textureBarriers.size());
 }
 
 void Renderer::SetTextureFiltering(TextureFiltering filtering)
@@ -1900,13 +1943,17 @@ void Renderer::SetTextureFiltering(TextureFiltering filtering)
 // Allocate Material
 MaterialHandle Renderer::CreateMaterial()
 {
-    return m_sceneManager.AddMaterial(m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate());
+    auto hMaterial = m_sceneManager.AddMaterial(m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate());
+    m_sceneManager.GetMaterial(hMaterial)->SetBindlessIndex(m_bindlessDescriptorHeap.AllocatePerFrame());
+    return hMaterial;
 }
 
 // Allocate & register Material
 MaterialHandle Renderer::CreateMaterial(const AssetID& id)
 {
-    return m_sceneManager.AddMaterial(m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(), id);
+    auto hMaterial = m_sceneManager.AddMaterial(m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(), id);
+    m_sceneManager.GetMaterial(hMaterial)->SetBindlessIndex(m_bindlessDescriptorHeap.AllocatePerFrame());
+    return hMaterial;
 }
 
 MaterialHandle Renderer::CloneMaterial(MaterialHandle src)
@@ -1918,51 +1965,63 @@ MaterialHandle Renderer::CloneMaterial(MaterialHandle src)
     return hDst;
 }
 
-MeshHandle Renderer::CreateMesh(ID3D12GraphicsCommandList7* pCommandList, TransientUploadAllocator& allocator, const GeometryData& data)
+MeshHandle Renderer::CreateMesh(ID3D12GraphicsCommandList7* pCommandList, UploadRingBuffer& allocator, const GeometryData& data)
 {
     return m_sceneManager.AddMesh(m_device.Get(), pCommandList, allocator, data);
 }
 
 DirectionalLightHandle Renderer::CreateDirectionalLight()
 {
-    return m_sceneManager.AddDirectionalLight(
+    auto hLight = m_sceneManager.AddDirectionalLight(
         m_device.Get(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_DSV].Allocate(MAX_CASCADES),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_shadowMapResolution);
+    auto* pLight = m_sceneManager.Get(hLight);
+    pLight->SetShadowMapIndex(m_bindlessDescriptorHeap.AllocatePersistent(pLight->GetSrvHandle()));
+    pLight->SetLightCbvIndex(m_bindlessDescriptorHeap.AllocatePerFrame());
+    return hLight;
 }
 
 PointLightHandle Renderer::CreatePointLight()
 {
-    return m_sceneManager.AddPointLight(
+    auto hLight = m_sceneManager.AddPointLight(
         m_device.Get(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_DSV].Allocate(POINT_LIGHT_ARRAY_SIZE),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_RTV].Allocate(POINT_LIGHT_ARRAY_SIZE),
         m_shadowMapResolution);
+    auto* pLight = m_sceneManager.Get(hLight);
+    pLight->SetShadowMapIndex(m_bindlessDescriptorHeap.AllocatePersistent(pLight->GetSrvHandle()));
+    pLight->SetLightCbvIndex(m_bindlessDescriptorHeap.AllocatePerFrame());
+    return hLight;
 }
 
 SpotLightHandle Renderer::CreateSpotLight()
 {
-    return m_sceneManager.AddSpotLight(
+    auto hLight = m_sceneManager.AddSpotLight(
         m_device.Get(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_DSV].Allocate(SPOT_LIGHT_ARRAY_SIZE),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_descriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Allocate(),
         m_shadowMapResolution);
+    auto* pLight = m_sceneManager.Get(hLight);
+    pLight->SetShadowMapIndex(m_bindlessDescriptorHeap.AllocatePersistent(pLight->GetSrvHandle()));
+    pLight->SetLightCbvIndex(m_bindlessDescriptorHeap.AllocatePerFrame());
+    return hLight;
 }
 
 AssetTextureHandle Renderer::CreateAssetTexture(
     ID3D12GraphicsCommandList7* pCommandList,
     DescriptorAllocation&& srvAllocation,
-    TransientUploadAllocator& uploadAllocator,
+    UploadRingBuffer& uploadAllocator,
     const std::vector<UINT8>& textureSrc,
     UINT width,
     UINT height)
 {
-    return m_sceneManager.AddAssetTexture(
+    auto hTexture = m_sceneManager.AddAssetTexture(
         m_device.Get(),
         pCommandList,
         std::move(srvAllocation),
@@ -1970,19 +2029,22 @@ AssetTextureHandle Renderer::CreateAssetTexture(
         textureSrc,
         width,
         height);
+    auto* pTexture = m_sceneManager.GetAssetTexture(hTexture);
+    pTexture->bindlessIndex = m_bindlessDescriptorHeap.AllocatePersistent(pTexture->srv.GetHandle());
+    return hTexture;
 }
 
 AssetTextureHandle Renderer::CreateAssetTexture(
     ID3D12GraphicsCommandList7* pCommandList,
     DescriptorAllocation&& srvAllocation,
-    TransientUploadAllocator& uploadAllocator,
+    UploadRingBuffer& uploadAllocator,
     const std::wstring& filePath,
     bool isSRGB,
     bool useBlockCompress,
     bool flipImage,
     bool isCubeMap)
 {
-    return m_sceneManager.AddAssetTexture(
+    auto hTexture = m_sceneManager.AddAssetTexture(
         m_device.Get(),
         pCommandList,
         std::move(srvAllocation),
@@ -1992,6 +2054,9 @@ AssetTextureHandle Renderer::CreateAssetTexture(
         useBlockCompress,
         flipImage,
         isCubeMap);
+    auto* pTexture = m_sceneManager.GetAssetTexture(hTexture);
+    pTexture->bindlessIndex = m_bindlessDescriptorHeap.AllocatePersistent(pTexture->srv.GetHandle());
+    return hTexture;
 }
 
 void Renderer::SetFpsCap(std::string fps)
@@ -2009,21 +2074,27 @@ void Renderer::SetFpsCap(std::string fps)
 
 void Renderer::BindDescriptorTables(ID3D12GraphicsCommandList* pCommandList)
 {
-    bool cbvSrvUavHeapChanged = m_dynamicDescriptorHeapForCbvSrvUav.CheckHeapChanged();
-
-    if (cbvSrvUavHeapChanged)
-    {
-        ID3D12DescriptorHeap* ppHeaps[] = {m_dynamicDescriptorHeapForCbvSrvUav.GetCurrentDescriptorHeap(), m_samplerDescriptorHeap.Get()};
-        pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-    }
-
     m_dynamicDescriptorHeapForCbvSrvUav.CommitStagedDescriptorsForDraw(pCommandList);
     pCommandList->SetGraphicsRootDescriptorTable(12, m_samplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart()); // Root parameter 12
+    BindBindlessTables(pCommandList);
+}
+
+// Tables indexed by bindless indices start at the base of their region.
+void Renderer::BindBindlessTables(ID3D12GraphicsCommandList* pCommandList)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE perFrameBase = m_bindlessDescriptorHeap.GetPerFrameGpuHandle(m_frameIndex);
+    pCommandList->SetGraphicsRootDescriptorTable(5, perFrameBase);
+    pCommandList->SetGraphicsRootDescriptorTable(6, perFrameBase);
+    pCommandList->SetGraphicsRootShaderResourceView(13, m_lightIndexUploadAllocation.gpuPtr);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE persistentBase = m_bindlessDescriptorHeap.GetPersistentGpuHandle();
+    for (UINT rootIndex = 7; rootIndex <= 10; ++rootIndex)
+        pCommandList->SetGraphicsRootDescriptorTable(rootIndex, persistentBase);
 }
 
 void Renderer::CreateRootSignature()
 {
-    m_rootSignature.Init(13, 2);
+    m_rootSignature.Init(14, 2);
 
     // Root descriptor for CameraCB and ShadowCB
     m_rootSignature[0].InitAsDescriptor(0, 0, D3D12_SHADER_VISIBILITY_ALL, D3D12_ROOT_PARAMETER_TYPE_CBV, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);   // Camera
@@ -2038,28 +2109,29 @@ void Renderer::CreateRootSignature()
     // Root constant for outline
     m_rootSignature[4].InitAsConstant(4, 0, 1, D3D12_SHADER_VISIBILITY_PIXEL);
 
-    // Descriptor table for MaterialConstantBuffers[]
+    // Descriptor table for MaterialConstantBuffers[], indexed by bindless index in the per frame region
+    // Unused slots in the region are never accessed, so descriptors are volatile.
     m_rootSignature[5].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[5].InitAsRange(0, 0, 1, D3D12_DESCRIPTOR_RANGE_TYPE_CBV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+    m_rootSignature[5].InitAsRange(0, 0, 1, D3D12_DESCRIPTOR_RANGE_TYPE_CBV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
 
-    // Descriptor table for LightConstantBuffers[]
+    // Descriptor table for LightConstantBuffers[], indexed by bindless index in the per frame region
     m_rootSignature[6].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[6].InitAsRange(0, 0, 2, D3D12_DESCRIPTOR_RANGE_TYPE_CBV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+    m_rootSignature[6].InitAsRange(0, 0, 2, D3D12_DESCRIPTOR_RANGE_TYPE_CBV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
 
-    // Descriptor table for textures (albedo, normal map, height map)
+    // Descriptor table for textures (albedo, normal map, height map), indexed by bindless index in the persistent region
     m_rootSignature[7].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[7].InitAsRange(0, 0, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+    m_rootSignature[7].InitAsRange(0, 0, 0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
 
-    // Descriptor table for shadowMaps[]
+    // Descriptor table for shadowMaps[], indexed by idxInArray in the persistent region
     // Directional
     m_rootSignature[8].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[8].InitAsRange(0, 0, 1, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
+    m_rootSignature[8].InitAsRange(0, 0, 1, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
     // Point
     m_rootSignature[9].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[9].InitAsRange(0, 0, 2, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
+    m_rootSignature[9].InitAsRange(0, 0, 2, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
     // Spot
     m_rootSignature[10].InitAsTable(1, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_rootSignature[10].InitAsRange(0, 0, 3, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
+    m_rootSignature[10].InitAsRange(0, 0, 3, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
 
     // Descriptor table for
     // SRV for GBuffers
@@ -2078,6 +2150,9 @@ void Renderer::CreateRootSignature()
                                     static_cast<UINT>(TextureFiltering::NUM_TEXTURE_FILTERINGS) * static_cast<UINT>(TextureAddressingMode::NUM_TEXTURE_ADDRESSING_MODES),
                                     D3D12_DESCRIPTOR_RANGE_FLAG_NONE);
 
+    // Root SRV for bindless indices of lights, in the order lighting loops over them
+    m_rootSignature[13].InitAsDescriptor(0, 8, D3D12_SHADER_VISIBILITY_PIXEL, D3D12_ROOT_PARAMETER_TYPE_SRV, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+
     // Static samplers
     m_rootSignature.InitStaticSampler(0, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL, TextureFiltering::BILINEAR, TextureAddressingMode::BORDER, D3D12_COMPARISON_FUNC_GREATER_EQUAL);
     m_rootSignature.InitStaticSampler(1, 1, 1, D3D12_SHADER_VISIBILITY_PIXEL, TextureFiltering::BILINEAR, TextureAddressingMode::BORDER, D3D12_COMPARISON_FUNC_LESS_EQUAL);
@@ -2087,6 +2162,9 @@ void Renderer::CreateRootSignature()
 
 ID3D12PipelineState* Renderer::GetPipelineState(const PSOKey& psoKey)
 {
+    // Pipeline states are created at first use, which can be on any recording thread.
+    std::lock_guard<std::mutex> lock(m_pipelineStateMutex);
+
     auto [it, inserted] = m_pipelineStates.try_emplace(psoKey, nullptr);
 
     if (inserted)
@@ -2311,33 +2389,22 @@ void Renderer::FixedUpdate(double fixedDtMs)
     // Transforms
     static float rotationSpeed = 1.0f; // unit : rad/s
 
-    for (auto& entity : m_sceneManager.GetEntities())
-    {
-        if (!entity.transform.has_value())
-            continue;
-        entity.transform->SnapshotState();
-    }
+    for (auto& transform : m_sceneManager.GetTransforms())
+        transform.SnapshotState();
 
     for (auto& handle : m_previewRotations)
     {
-        auto* pEntity = m_sceneManager.Get(handle);
-        if (pEntity == nullptr)
+        auto* pTransform = m_sceneManager.GetTransform(handle);
+        if (pTransform == nullptr)
             continue;
-        pEntity->transform->Apply(XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, rotationSpeed * fixedDtSec, 0.0f), XMFLOAT3());
+        pTransform->Apply(XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, rotationSpeed * fixedDtSec, 0.0f), XMFLOAT3());
     }
 }
 
 void Renderer::PrepareConstantData(float alpha)
 {
     // Transforms
-    for (auto& entity : m_sceneManager.GetEntities())
-    {
-        if (entity.parent.index == UINT_MAX && entity.parent.generation == 0)
-        {
-            XMMATRIX accumulated = XMMatrixIdentity();
-            PrepareTransform(entity, accumulated, alpha);
-        }
-    }
+    m_recomputedTransformCount = m_sceneManager.UpdateWorldTransforms(alpha, m_jobSystem);
 
     // Main Camera
     m_camera.UpdateRenderState(alpha);
@@ -2345,6 +2412,8 @@ void Renderer::PrepareConstantData(float alpha)
     m_cameraConstantData.SetView(m_camera.GetViewMatrix());
     m_cameraConstantData.SetProjection(m_camera.GetProjectionMatrix());
 
+    m_cameraFrustum = FrustumCuller::CreateWorldFrustum(m_camera.GetViewMatrix(), m_camera.GetProjectionMatrix());
+
     // Light
     // XMVECTOR lightDir = m_lights[0]->GetDirection();
     // XMMATRIX rot = XMMatrixRotationAxis(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), 0.001f);
@@ -2354,42 +2423,36 @@ void Renderer::PrepareConstantData(float alpha)
     // Pre-calculate common data for CSM.
     std::vector<BoundingSphere> cascadeSpheres = CalcCascadeSpheres();
 
-    UINT idx = 0;
-    for (auto& light : m_sceneManager.GetDirectionalLights())
-    {
-        PrepareDirectionalLight(light, cascadeSpheres);
-        light.SetIdxInArray(idx);
-        ++idx;
-    }
-    idx = 0;
-    for (auto& light : m_sceneManager.GetPointLights())
-    {
-        PreparePointLight(light);
-        light.SetIdxInArray(idx);
-        ++idx;
-    }
-    idx = 0;
-    for (auto& light : m_sceneManager.GetSpotLights())
-    {
-        PrepareSpotLight(light);
-        light.SetIdxInArray(idx);
-        ++idx;
-    }
-}
-
-void Renderer::PrepareTransform(Entity& entity, XMMATRIX& accumulated, float alpha)
-{
-    if (!entity.transform.has_value())
-        return;
-
-    entity.transform->UpdateLocalRenderState(alpha);
-    XMMATRIX localRenderTransform = XMLoadFloat4x4(&entity.transform->GetLocalRenderTransform());
+    // Each light only writes its own matrices.
+    auto& directionalLights = m_sceneManager.GetDirectionalLights();
+    m_jobSystem.ParallelFor(
+        0,
+        static_cast<UINT>(directionalLights.size()),
+        1,
+        [&](UINT i)
+        {
+            PrepareDirectionalLight(directionalLights[i], cascadeSpheres);
+        });
 
-    XMMATRIX world = localRenderTransform * accumulated;
-    entity.transform->SetWorldRenderTransform(world);
+    auto& pointLights = m_sceneManager.GetPointLights();
+    m_jobSystem.ParallelFor(
+        0,
+        static_cast<UINT>(pointLights.size()),
+        1,
+        [&](UINT i)
+        {
+            PreparePointLight(pointLights[i]);
+        });
 
-    for (auto& child : entity.children)
-        PrepareTransform(*m_sceneManager.Get(child), world, alpha);
+    auto& spotLights = m_sceneManager.GetSpotLights();
+    m_jobSystem.ParallelFor(
+        0,
+        static_cast<UINT>(spotLights.size()),
+        1,
+        [&](UINT i)
+        {
+            PrepareSpotLight(spotLights[i]);
+        });
 }
 
 std::vector<BoundingSphere> Renderer::CalcCascadeSpheres()
@@ -2540,36 +2603,61 @@ void Renderer::PrepareSpotLight(SpotLight& light)
     light.SetViewProjection(view, projection, 0);
 }
 
-void Renderer::UpdateConstantBuffers(FrameResource& frameResource)
+void Renderer::UpdateConstantBuffers()
 {
-    frameResource.ResetUploadAllocator();
+    m_cameraUploadAllocation = m_uploadRingBuffer.Push(&m_cameraConstantData, sizeof(CameraConstantData), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    m_shadowUploadAllocation = m_uploadRingBuffer.Push(&m_shadowConstantData, sizeof(ShadowConstantData), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
-    m_cameraUploadAllocation = frameResource.PushConstantData(&m_cameraConstantData, sizeof(CameraConstantData));
-    m_shadowUploadAllocation = frameResource.PushConstantData(&m_shadowConstantData, sizeof(ShadowConstantData));
+    m_constantUploads.clear();
+    auto stage = [&](const void* src, std::size_t size)
+    {
+        auto alloc = m_uploadRingBuffer.Allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+        m_constantUploads.push_back({src, alloc.cpuPtr, size});
+        return alloc;
+    };
 
     for (auto& mat : m_sceneManager.GetMaterials())
     {
-        auto alloc = frameResource.PushConstantData(mat.GetConstantDataPtr(), sizeof(MaterialConstantData));
+        auto alloc = stage(mat.GetConstantDataPtr(), sizeof(MaterialConstantData));
         mat.InitCbv(m_device.Get(), alloc.gpuPtr);
+        m_bindlessDescriptorHeap.CopyPerFrameDescriptor(mat.GetBindlessIndex(), m_frameIndex, mat.GetCbvHandle());
     }
 
     auto processLight = [&](Light& light, UINT arraySize)
     {
         for (UINT i = 0; i < arraySize; ++i)
         {
-            auto alloc = frameResource.PushConstantData(light.GetCameraConstantDataPtr(i), sizeof(CameraConstantData));
+            auto alloc = stage(light.GetCameraConstantDataPtr(i), sizeof(CameraConstantData));
             light.SetCameraUploadAllocation(i, alloc);
         }
-        auto alloc = frameResource.PushConstantData(light.GetLightConstantDataPtr(), sizeof(LightConstantData));
+        auto alloc = stage(light.GetLightConstantDataPtr(), sizeof(LightConstantData));
         light.InitLightCbv(m_device.Get(), alloc.gpuPtr);
+        m_bindlessDescriptorHeap.CopyPerFrameDescriptor(light.GetLightCbvIndex(), m_frameIndex, light.GetLightCbvHandle());
+        m_lightCbvIndices.push_back(light.GetLightCbvIndex());
     };
 
+    m_lightCbvIndices.clear();
     for (auto& light : m_sceneManager.GetDirectionalLights())
         processLight(light, MAX_CASCADES);
     for (auto& light : m_sceneManager.GetPointLights())
         processLight(light, POINT_LIGHT_ARRAY_SIZE);
     for (auto& light : m_sceneManager.GetSpotLights())
         processLight(light, SPOT_LIGHT_ARRAY_SIZE);
+
+    // Lighting loops over lights through this list. Root SRV needs a buffer even with no lights, so it is never empty.
+    if (m_lightCbvIndices.empty())
+        m_lightCbvIndices.push_back(0);
+    m_lightIndexUploadAllocation = stage(m_lightCbvIndices.data(), m_lightCbvIndices.size() * sizeof(UINT));
+
+    m_jobSystem.ParallelFor(
+        0,
+        static_cast<UINT>(m_constantUploads.size()),
+        32,
+        [&](UINT i)
+        {
+            const auto& upload = m_constantUploads[i];
+            memcpy(upload.dst, upload.src, upload.size);
+        });
 }
 
 void Renderer::ProcessInput()
@@ -2600,10 +2688,9 @@ void Renderer::ProcessInput()
     }
 
     // Focus
-    if (m_inputManager.IsKeyPressed('F') && !(m_selected.index == UINT_MAX && m_selected.generation == 0))
+    if (m_inputManager.IsKeyPressed('F') && HasSelection())
     {
-        auto* pEntity = m_sceneManager.Get(m_selected);
-        auto pos = pEntity->transform->GetTranslation();
+        auto pos = m_sceneManager.GetTransform(m_selected)->GetTranslation();
 
         m_camera.SetCurrentPosition(XMLoadFloat3(&pos) - m_camera.GetForward() * DEFAULT_FOCUS_DIST);
 
@@ -2686,11 +2773,23 @@ void Renderer::ProcessInput()
     m_camera.SnapshotState();
 }
 
-void Renderer::DrawMesh(ID3D12GraphicsCommandList* pCommandList, MeshHandle meshhandle, PassType passType, D3D12_GPU_VIRTUAL_ADDRESS instanceBufferBase)
+// Draw order is pass, PSO, rendering path, nearest depth, then mesh.
+void Renderer::BuildDrawList(DrawList& drawList, UINT viewIdx, PassType passType, UINT psoIndex)
 {
-    static const UINT instanceDataSize = static_cast<UINT>(sizeof(InstanceData));
+    RenderingPath path = passType == PassType::GBUFFER ? RenderingPath::DEFERRED : RenderingPath::FORWARD;
 
-    const auto& instanceRange = m_sceneManager.GetInstanceRange(meshhandle);
+    drawList.Clear();
+    for (const auto& [meshHandle, instanceRange] : m_sceneManager.GetInstanceRanges(viewIdx))
+    {
+        UINT64 key = DrawList::MakeKey(passType, psoIndex, path, 0, meshHandle.index, DrawList::QuantizeDepth(instanceRange.depth));
+        drawList.Add(key, {meshHandle, instanceRange});
+    }
+    drawList.Sort();
+}
+
+void Renderer::DrawMesh(ID3D12GraphicsCommandList* pCommandList, MeshHandle meshhandle, const InstanceRange& instanceRange, PassType passType, D3D12_GPU_VIRTUAL_ADDRESS instanceBufferBase)
+{
+    static const UINT instanceDataSize = static_cast<UINT>(sizeof(InstanceData));
 
     if ((passType == PassType::FORWARD_COLORING && instanceRange.forwardCount == 0) ||
         (passType == PassType::SHADOW_MAP && (instanceRange.forwardCount + instanceRange.deferredCount) == 0) ||
@@ -2733,19 +2832,22 @@ void Renderer::DrawEntity(ID3D12GraphicsCommandList* pCommandList, EntityHandle
 {
     static const UINT instanceDataSize = static_cast<UINT>(sizeof(InstanceData));
 
-    auto* pEntity = m_sceneManager.Get(entityHandle);
+    auto* pMeshRenderer = m_sceneManager.GetMeshRenderer(entityHandle);
 
-    if (!pEntity->meshRenderer.has_value())
+    if (pMeshRenderer == nullptr)
         return;
-    auto meshHandle = pEntity->meshRenderer->mesh;
+    auto meshHandle = pMeshRenderer->mesh;
     auto* pMesh = m_sceneManager.GetMesh(meshHandle);
 
-    auto instanceRange = m_sceneManager.GetInstanceRange(meshHandle);
+    // Culled entities are not in the instance buffer.
+    auto indexInBucket = m_sceneManager.GetEntityIndexInBucket(entityHandle);
+    if (!indexInBucket.has_value())
+        return;
 
-    UINT indexInBucket = m_sceneManager.GetEntityIndexInBucket(entityHandle);
+    auto instanceRange = m_sceneManager.GetInstanceRange(MAIN_VIEW, meshHandle);
 
     D3D12_VERTEX_BUFFER_VIEW instanceBufferView;
-    instanceBufferView.BufferLocation = instanceBufferBase + instanceRange.offset + indexInBucket * instanceDataSize;
+    instanceBufferView.BufferLocation = instanceBufferBase + instanceRange.offset + indexInBucket.value() * instanceDataSize;
     instanceBufferView.StrideInBytes = instanceDataSize;
     instanceBufferView.SizeInBytes = instanceDataSize;
 
@@ -2763,3 +2865,8 @@ void Renderer::BeginOrbit()
     XMStoreFloat3(&m_orbitPivot, camPos + m_camera.GetForward() * m_orbitDistance);
     m_orbiting = true;
 }
+
+bool Renderer::HasSelection() const
+{
+    return !(m_selected.index == UINT_MAX && m_selected.generation == 0);
+}
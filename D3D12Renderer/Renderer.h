@@ -1,9 +1,11 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <ratio>
 #include <string>
 #include <unordered_map>
@@ -18,15 +20,18 @@
 #include <wrl/client.h>
 
 #include "Aliases.h"
+#include "BindlessDescriptorHeap.h"
 #include "CacheKeys.h"
 #include "Camera.h"
 #include "CommandQueue.h"
 #include "ConstantData.h"
 #include "DescriptorAllocator.h"
+#include "DrawList.h"
 #include "DynamicDescriptorHeap.h"
 #include "FrameResource.h"
 #include "ImGuiDescriptorAllocator.h"
 #include "InputManager.h"
+#include "JobSystem.h"
 #include "RenderGraph.h"
 #include "RendererConfig.h"
 #include "RootSignature.h"
@@ -34,6 +39,7 @@
 #include "SceneManager.h"
 #include "Texture.h"
 #include "UploadAllocation.h"
+#include "UploadRingBuffer.h"
 #include "View.h"
 
 struct GeometryData;
@@ -41,7 +47,6 @@ class DescriptorAllocation;
 class DirectionalLight;
 class PointLight;
 class SpotLight;
-class TransientUploadAllocator;
 
 class Renderer
 {
@@ -130,16 +135,17 @@ private:
     Microsoft::WRL::ComPtr<ID3D12Device10> m_device;
     Microsoft::WRL::ComPtr<IDXGISwapChain3> m_swapChain;
 
+    BindlessDescriptorHeap m_bindlessDescriptorHeap;
     DynamicDescriptorHeap m_dynamicDescriptorHeapForCbvSrvUav;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_samplerDescriptorHeap;
     CommandQueue m_commandQueue;
     std::array<DescriptorAllocator, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_descriptorAllocators;
     std::array<FrameResource, FrameCount> m_frameResources;
+    UploadRingBuffer m_uploadRingBuffer;
 
     RootSignature m_rootSignature;
     std::unordered_map<PSOKey, Microsoft::WRL::ComPtr<ID3D12PipelineState>> m_pipelineStates;
-
-    PSOKey m_currentPSOKey = {PassType::FORWARD_COLORING};
+    std::mutex m_pipelineStateMutex; // Passes are recorded by multiple threads
 
     std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputLayout;
     std::unordered_map<ShaderKey, std::vector<char>> m_shaderBlobs;
@@ -159,10 +165,21 @@ private:
     InputManager m_inputManager;
 
     RenderGraph m_renderGraph;
+    RGPredicate m_hasSelectionPredicate;
+    std::atomic<UINT> m_barrierCount{0}; // Issued by the graph in the last recorded frame
+
+    JobSystem m_jobSystem;
 
     SceneManager m_sceneManager;
     EntityHandle m_selected;
 
+    // Instance views
+    // View 0 is the main camera. Each entry of shadow maps follows in the order of directional, point, spot lights.
+    inline static constexpr UINT MAIN_VIEW = 0;
+    inline static constexpr UINT FIRST_SHADOW_VIEW = 1;
+
+    DirectX::BoundingFrustum m_cameraFrustum;
+
     inline static constexpr float DEFAULT_FOCUS_DIST = 30.0f;
 
     bool m_cameraControl = false;
@@ -173,6 +190,23 @@ private:
 
     std::vector<EntityHandle> m_previewRotations;
 
+    UINT m_recomputedTransformCount = 0; // World transforms recomputed in last frame
+    double m_framePrepMs = 0.0;          // CPU time of PrepareConstantData and UpdateConstantBuffers
+    double m_recordMs = 0.0;             // CPU time of recording passes
+
+    // Upload allocator is not thread-safe. Allocations are made first, then copied in parallel.
+    struct ConstantUpload
+    {
+        const void* src;
+        void* dst;
+        std::size_t size;
+    };
+    std::vector<ConstantUpload> m_constantUploads;
+
+    // Per-frame bindless indices of light CBVs, in the order of directional, point, spot lights
+    std::vector<UINT> m_lightCbvIndices;
+    UploadAllocation m_lightIndexUploadAllocation;
+
     // Shadows
     D3D12_VIEWPORT m_shadowMapViewport;
     D3D12_RECT m_shadowMapScissorRect;
@@ -180,6 +214,35 @@ private:
     ShadowConstantData m_shadowConstantData;
     UploadAllocation m_shadowUploadAllocation;
 
+    struct ShadowViewStats
+    {
+        UINT drawCalls = 0;
+        UINT instanceCount = 0;
+    };
+    std::vector<ShadowViewStats> m_shadowViewStats; // Per shadow view, last recorded frame
+
+    DrawList m_drawList; // Main view GBuffer draws, shared by the tasks recording them
+
+    // Part of a pass, recorded by a job into its own command list.
+    // Shadow map pass is split by views, GBuffer pass by draws. Others are recorded whole.
+    struct RecordTask
+    {
+        PassType passType;
+        UINT first;
+        UINT last;
+        bool isFirst; // Issues the barriers of the pass
+        bool isLast;  // Issues the release barriers of the pass
+        ID3D12CommandAllocator* pCommandAllocator;
+        ID3D12GraphicsCommandList7* pCommandList;
+        DrawList drawList;
+    };
+    std::vector<RecordTask> m_recordTasks; // Capacity kept across frames
+    UINT m_recordTaskCount = 0;
+    std::vector<std::pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList7*>> m_submittedCommandLists; // In graph order
+
+    inline static constexpr UINT SHADOW_VIEWS_PER_RECORD_TASK = 2;
+    inline static constexpr UINT DRAWS_PER_RECORD_TASK = 256;
+
     TextureFiltering m_currentTextureFiltering = TextureFiltering::ANISOTROPIC_X16;
 
     // For ImGui
@@ -199,14 +262,26 @@ private:
     void LoadPipeline();
     void LoadAssets();
     void PopulateCommandList(ID3D12GraphicsCommandList7* pCommandList);
+    void AddRecordTasks(PassType passType, UINT count, UINT grainSize);
+    void RecordPassTask(RecordTask& task, FrameResource& frameResource);
+    void RecordShadowMapPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, DrawList& drawList, UINT firstView, UINT lastView);
+    void RecordGBufferPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, UINT firstDraw, UINT lastDraw);
+    void RecordDeferredLightingPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource);
+    void RecordForwardColoringPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource, DrawList& drawList);
+    void RecordSelectionMaskPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource);
+    void RecordHorizontalDilatePass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource);
+    void RecordOutlineDrawingPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource);
+    void RecordToneMapPass(ID3D12GraphicsCommandList7* pCommandList, FrameResource& frameResource);
     void WaitForGpu();
     void MoveToNextFrame();
 
     void InitImGui();
-    void RenderEntityNode(const Entity& entity, EntityHandle& selected, EntityHandle& toDelete, bool& selectionChanged);
+    void RenderEntityNode(EntityHandle entity, EntityHandle& selected, EntityHandle& toDelete, bool& selectionChanged);
 
     void PrepareRenderGraph();
+    void BindTransientTextures();
     void ApplyPassBarriers(RenderGraph& renderGraph, PassType passType, ID3D12GraphicsCommandList7* pCommandList);
+    void IssueBarriers(const PassBarriers& barriers, ID3D12GraphicsCommandList7* pCommandList);
 
     void SetTextureFiltering(TextureFiltering filtering);
 
@@ -214,7 +289,7 @@ private:
     MaterialHandle CreateMaterial(const AssetID& id);
     MaterialHandle CloneMaterial(MaterialHandle src);
 
-    MeshHandle CreateMesh(ID3D12GraphicsCommandList7* pCommandList, TransientUploadAllocator& allocator, const GeometryData& data);
+    MeshHandle CreateMesh(ID3D12GraphicsCommandList7* pCommandList, UploadRingBuffer& allocator, const GeometryData& data);
 
     DirectionalLightHandle CreateDirectionalLight();
     PointLightHandle CreatePointLight();
@@ -223,7 +298,7 @@ private:
     AssetTextureHandle CreateAssetTexture(
         ID3D12GraphicsCommandList7* pCommandList,
         DescriptorAllocation&& allocation,
-        TransientUploadAllocator& uploadAllocator,
+        UploadRingBuffer& uploadAllocator,
         const std::vector<UINT8>& textureSrc,
         UINT width,
         UINT height);
@@ -231,7 +306,7 @@ private:
     AssetTextureHandle CreateAssetTexture(
         ID3D12GraphicsCommandList7* pCommandList,
         DescriptorAllocation&& allocation,
-        TransientUploadAllocator& uploadAllocator,
+        UploadRingBuffer& uploadAllocator,
         const std::wstring& filePath,
         bool isSRGB,
         bool useBlockCompress,
@@ -241,6 +316,7 @@ private:
     void SetFpsCap(std::string fps);
 
     void BindDescriptorTables(ID3D12GraphicsCommandList* pCommandList);
+    void BindBindlessTables(ID3D12GraphicsCommandList* pCommandList);
 
     void CreateRootSignature();
     ID3D12PipelineState* GetPipelineState(const PSOKey& psoKey);
@@ -249,17 +325,18 @@ private:
     void FixedUpdate(double fixedDt);
 
     void PrepareConstantData(float alpha);
-    void PrepareTransform(Entity& entity, DirectX::XMMATRIX& accumulated, float alpha);
     std::vector<DirectX::BoundingSphere> CalcCascadeSpheres();
     void PrepareDirectionalLight(DirectionalLight& light, const std::vector<DirectX::BoundingSphere>& cascadeSpheres);
     void PreparePointLight(PointLight& light);
     void PrepareSpotLight(SpotLight& light);
 
-    void UpdateConstantBuffers(FrameResource& frameResource);
+    void UpdateConstantBuffers();
 
-    void DrawMesh(ID3D12GraphicsCommandList* pCommandList, MeshHandle meshhandle, PassType passType, D3D12_GPU_VIRTUAL_ADDRESS instanceBufferBase);
+    void BuildDrawList(DrawList& drawList, UINT viewIdx, PassType passType, UINT psoIndex);
+    void DrawMesh(ID3D12GraphicsCommandList* pCommandList, MeshHandle meshhandle, const InstanceRange& instanceRange, PassType passType, D3D12_GPU_VIRTUAL_ADDRESS instanceBufferBase);
     void DrawEntity(ID3D12GraphicsCommandList* pCommandList, EntityHandle entityHandle, D3D12_GPU_VIRTUAL_ADDRESS instanceBufferBase);
 
     void ProcessInput();
     void BeginOrbit();
+    bool HasSelection() const;
 };
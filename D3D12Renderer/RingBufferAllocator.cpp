@@ -0,0 +1,122 @@
+#include "pch.h"
+
+#include "RingBufferAllocator.h"
+
+#include <algorithm>
+
+#include "Utility.h"
+
+void RingBufferAllocator::Init(UINT64 capacity)
+{
+    m_capacity = capacity;
+    m_head = 0;
+    m_tail = 0;
+    m_usedSize = 0;
+    m_frameSize = 0;
+    m_highWaterMark = 0;
+    m_retiredFrames = {};
+}
+
+UINT64 RingBufferAllocator::Allocate(UINT64 size, UINT64 alignment)
+{
+    assert(size > 0 && alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    // Head and tail meet when the ring is full
+    if (m_usedSize == m_capacity)
+        return InvalidOffset;
+
+    UINT64 offset = Utility::Align(m_tail, alignment);
+
+    if (m_tail >= m_head)
+    {
+        // Free space is [tail, capacity) and [0, head)
+        if (offset + size > m_capacity)
+        {
+            // Does not fit before the end. The rest of the ring is skipped, and freed with this frame.
+            if (size > m_head)
+                return InvalidOffset;
+
+            m_usedSize += m_capacity - m_tail;
+            m_frameSize += m_capacity - m_tail;
+            m_tail = 0;
+            offset = 0;
+            ++m_wrapCount;
+        }
+    }
+    else if (offset + size > m_head)
+    {
+        // Free space is [tail, head)
+        return InvalidOffset;
+    }
+
+    m_usedSize += offset + size - m_tail;
+    m_frameSize += offset + size - m_tail;
+    m_tail = offset + size;
+
+    m_highWaterMark = std::max(m_highWaterMark, m_usedSize);
+
+    return offset;
+}
+
+void RingBufferAllocator::QueueRetiredAllocations(UINT64 signaledFenceValue)
+{
+    if (m_frameSize == 0)
+        return;
+
+    m_retiredFrames.push({signaledFenceValue, m_tail, m_frameSize});
+    m_frameSize = 0;
+}
+
+void RingBufferAllocator::ReleaseStaleAllocations(UINT64 completedFenceValue)
+{
+    while (!m_retiredFrames.empty() && m_retiredFrames.front().fenceValue <= completedFenceValue)
+    {
+        auto& frame = m_retiredFrames.front();
+        m_head = frame.endOffset;
+        m_usedSize -= frame.size;
+        m_retiredFrames.pop();
+    }
+
+    // Restart from the front when nothing is in use, so the next frame is less likely to wrap.
+    if (m_usedSize == 0)
+    {
+        m_head = 0;
+        m_tail = 0;
+    }
+}
+
+bool RingBufferAllocator::HasStaleAllocations() const
+{
+    return !m_retiredFrames.empty();
+}
+
+UINT64 RingBufferAllocator::GetOldestFenceValue() const
+{
+    assert(!m_retiredFrames.empty());
+    return m_retiredFrames.front().fenceValue;
+}
+
+UINT64 RingBufferAllocator::GetCapacity() const
+{
+    return m_capacity;
+}
+
+UINT64 RingBufferAllocator::GetUsedSize() const
+{
+    return m_usedSize;
+}
+
+UINT64 RingBufferAllocator::GetHighWaterMark() const
+{
+    return m_highWaterMark;
+}
+
+void RingBufferAllocator::ResetHighWaterMark()
+{
+    m_highWaterMark = m_usedSize;
+}
+
+UINT64 RingBufferAllocator::GetWrapCount() const
+{
+    return m_wrapCount;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <queue>
+
+#include <basetsd.h>
+
+// Offsets into a ring of capacity bytes. Allocations of a frame are freed together once the fence of that frame completes,
+// so the head only moves forward in the order frames were submitted.
+// Does not touch the device, so it can be driven with plain fence values.
+// Not thread-safe.
+class RingBufferAllocator
+{
+public:
+    RingBufferAllocator(const RingBufferAllocator&) = delete;
+    RingBufferAllocator& operator=(const RingBufferAllocator&) = delete;
+    RingBufferAllocator(RingBufferAllocator&&) = delete;
+    RingBufferAllocator& operator=(RingBufferAllocator&&) = delete;
+
+    RingBufferAllocator() = default;
+    ~RingBufferAllocator() = default;
+
+    static constexpr UINT64 InvalidOffset = UINT64_MAX;
+
+    // Drops every allocation. The caller keeps the old memory alive until its frames complete.
+    void Init(UINT64 capacity);
+
+    // Returns InvalidOffset when the free part of the ring can not hold the request.
+    // Alignment must be a power of two.
+    UINT64 Allocate(UINT64 size, UINT64 alignment);
+
+    // Allocations since the last call are freed once signaledFenceValue completes.
+    void QueueRetiredAllocations(UINT64 signaledFenceValue);
+    void ReleaseStaleAllocations(UINT64 completedFenceValue);
+
+    // Fence value to wait on for the next release. Only valid if HasStaleAllocations().
+    bool HasStaleAllocations() const;
+    UINT64 GetOldestFenceValue() const;
+
+    UINT64 GetCapacity() const;
+    UINT64 GetUsedSize() const; // Bytes skipped at wraps included
+    UINT64 GetHighWaterMark() const; // Largest used size since the last ResetHighWaterMark
+    void ResetHighWaterMark();
+    UINT64 GetWrapCount() const;
+
+private:
+    struct RetiredFrame
+    {
+        UINT64 fenceValue;
+        UINT64 endOffset; // Head moves here when the frame is released
+        UINT64 size;
+    };
+
+    UINT64 m_capacity = 0;
+    UINT64 m_head = 0; // Oldest byte in use
+    UINT64 m_tail = 0; // Next byte to allocate
+    UINT64 m_usedSize = 0; // Tells a full ring from an empty one when head and tail meet
+    UINT64 m_frameSize = 0; // Allocated since the last QueueRetiredAllocations
+
+    UINT64 m_highWaterMark = 0;
+    UINT64 m_wrapCount = 0;
+
+    std::queue<RetiredFrame> m_retiredFrames;
+};
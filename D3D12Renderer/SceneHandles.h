@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+
+#include <basetsd.h>
+
 #include "SlotMap.h"
 
 class Mesh;
@@ -17,3 +22,21 @@ using PointLightHandle = SlotMap<PointLight>::Handle;
 using SpotLightHandle = SlotMap<SpotLight>::Handle;
 using AssetTextureHandle = SlotMap<AssetTexture>::Handle;
 using EntityHandle = SlotMap<Entity>::Handle;
+
+template <>
+struct std::hash<MeshHandle>
+{
+    std::size_t operator()(const MeshHandle& h) const
+    {
+        return (static_cast<UINT64>(h.index) << 32) | static_cast<UINT64>(h.generation);
+    }
+};
+
+template <>
+struct std::hash<EntityHandle>
+{
+    std::size_t operator()(const EntityHandle& h) const
+    {
+        return (static_cast<UINT64>(h.index) << 32) | static_cast<UINT64>(h.generation);
+    }
+};
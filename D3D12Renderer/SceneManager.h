@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <cfloat>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -12,6 +15,7 @@
 #include <variant>
 #include <vector>
 
+#include <DirectXCollision.h>
 #include <DirectXMath.h>
 #include <basetsd.h>
 #include <d3d12.h>
@@ -21,8 +25,15 @@
 #include <DDSTextureLoader12.h>
 
 #include "Aliases.h"
+#include "BindlessIndexAllocator.h"
+#include "ComponentPool.h"
+#include "DrawList.h"
+#include "DynamicAabbTree.h"
+#include "FrustumCuller.h"
 #include "GeometryData.h"
 #include "InstanceData.h"
+#include "InstanceTable.h"
+#include "JobSystem.h"
 #include "Light.h"
 #include "Material.h"
 #include "Mesh.h"
@@ -30,40 +41,10 @@
 #include "SlotMap.h"
 #include "Texture.h"
 #include "Transform.h"
-#include "TransientUploadAllocator.h"
+#include "UploadRingBuffer.h"
 #include "Utility.h"
 #include "View.h"
-
-template <>
-struct std::hash<MeshHandle>
-{
-    std::size_t operator()(const MeshHandle& h) const
-    {
-        return (static_cast<UINT64>(h.index) << 32) | static_cast<UINT64>(h.generation);
-    }
-};
-
-template <>
-struct std::hash<EntityHandle>
-{
-    std::size_t operator()(const EntityHandle& h) const
-    {
-        return (static_cast<UINT64>(h.index) << 32) | static_cast<UINT64>(h.generation);
-    }
-};
-
-struct InstanceRange
-{
-    UINT offset; // offset in instance buffer
-    UINT forwardCount;
-    UINT deferredCount;
-};
-
-struct MeshBucket
-{
-    std::vector<InstanceData> forward;
-    std::vector<InstanceData> deferred;
-};
+#include "WorldBounds.h"
 
 using LightHandle = std::variant<
     DirectionalLightHandle,
@@ -74,25 +55,26 @@ struct MeshRenderer
 {
     MeshHandle mesh;
     MaterialHandle material;
+    UINT instanceSlot = InstanceTable::NullSlot;
 };
 
-struct Entity
+struct Hierarchy
 {
-    std::string name;
-
-    EntityHandle selfHandle;
     EntityHandle parent;
     std::vector<EntityHandle> children;
+};
 
-    std::optional<Transform> transform;
-    std::optional<MeshRenderer> meshRenderer;
-    std::optional<LightHandle> light;
+// Components are not stored in entity. They live in per-component pools of SceneManager.
+struct Entity
+{
+    EntityHandle selfHandle;
 };
 
 struct AssetTexture
 {
     Texture texture;
     ShaderResourceView srv;
+    BindlessIndex bindlessIndex; // Materials refer to the texture by it
 };
 
 class SceneManager
@@ -101,10 +83,12 @@ public:
     EntityHandle AddEntity(const std::string& name)
     {
         auto handle = m_entities.Add(Entity());
+        m_entities.Get(handle)->selfHandle = handle;
+
+        m_names.Add(handle, std::string(name));
+        m_hierarchies.Add(handle, Hierarchy());
 
-        auto* pEntity = m_entities.Get(handle);
-        pEntity->name = name;
-        pEntity->selfHandle = handle;
+        m_hierarchyChanged = true;
 
         return handle;
     }
@@ -114,13 +98,11 @@ public:
         if (!m_entities.IsValid(handle))
             return;
 
-        auto* pEntity = m_entities.Get(handle);
-
         // Should delete material with 0 usage?
 
-        if (pEntity->light.has_value())
+        if (auto* pLight = m_lights.Get(handle))
         {
-            auto lightHandle = pEntity->light.value();
+            auto lightHandle = *pLight;
             std::visit(
                 [&](auto&& handle)
                 {
@@ -135,77 +117,108 @@ public:
         }
 
         // Recursively Remove children entities
-        auto childrenCopy = pEntity->children;
+        auto childrenCopy = m_hierarchies.Get(handle)->children;
         for (auto child : childrenCopy)
             Remove(child);
 
+        // Remove from spatial index
+        auto proxyIt = m_proxies.find(handle);
+        if (proxyIt != m_proxies.end())
+        {
+            m_spatialIndex.DestroyProxy(proxyIt->second);
+            m_proxies.erase(proxyIt);
+        }
+
         // If it have parent, remove handle from parent's children
-        auto* pParent = m_entities.Get(pEntity->parent);
+        auto* pParent = m_hierarchies.Get(m_hierarchies.Get(handle)->parent);
         if (pParent)
         {
             auto& children = pParent->children;
             children.erase(std::remove(children.begin(), children.end(), handle));
         }
 
+        if (auto* pMeshRenderer = m_meshRenderers.Get(handle))
+            m_instanceTable.Free(pMeshRenderer->instanceSlot);
+
+        m_names.Remove(handle);
+        m_hierarchies.Remove(handle);
+        m_transforms.Remove(handle);
+        m_meshRenderers.Remove(handle);
+        m_lights.Remove(handle);
+
         m_entities.Remove(handle);
+
+        // Dense indices are changed by swap-and-pop.
+        m_hierarchyChanged = true;
     }
 
     void AddChild(EntityHandle parent, EntityHandle child)
     {
-        auto* pParent = m_entities.Get(parent);
-        auto* pChild = m_entities.Get(child);
+        m_hierarchies.Get(parent)->children.push_back(child);
+        m_hierarchies.Get(child)->parent = parent;
 
-        pParent->children.push_back(child);
-        pChild->parent = parent;
+        // World transform depends on the new parent.
+        if (auto* pTransform = m_transforms.Get(child))
+            pTransform->MarkDirty();
+
+        m_hierarchyChanged = true;
     }
 
     void AddTransform(EntityHandle eh)
     {
-        auto* pEntity = m_entities.Get(eh);
-        if (pEntity->transform.has_value())
+        if (m_transforms.Has(eh))
             assert(false);
 
-        pEntity->transform.emplace();
+        m_transforms.Add(eh, Transform());
+        m_hierarchyChanged = true;
+
+        if (auto* pMeshRenderer = m_meshRenderers.Get(eh))
+            m_instanceTable.MarkDirty(pMeshRenderer->instanceSlot);
     }
 
     void AddTransform(EntityHandle eh, const DirectX::XMFLOAT3& s, const DirectX::XMFLOAT3& eulerRad, const DirectX::XMFLOAT3& t)
     {
-        auto* pEntity = m_entities.Get(eh);
-        if (pEntity->transform.has_value())
+        if (m_transforms.Has(eh))
             assert(false);
 
-        pEntity->transform.emplace(s, eulerRad, t);
+        m_transforms.Add(eh, Transform(s, eulerRad, t));
+        m_hierarchyChanged = true;
+
+        if (auto* pMeshRenderer = m_meshRenderers.Get(eh))
+            m_instanceTable.MarkDirty(pMeshRenderer->instanceSlot);
     }
 
     void ApplyTransform(EntityHandle eh, const DirectX::XMFLOAT3& s, const DirectX::XMFLOAT3& eulerRad, const DirectX::XMFLOAT3& t)
     {
-        auto* pEntity = m_entities.Get(eh);
-        if (!pEntity->transform.has_value())
+        auto* pTransform = m_transforms.Get(eh);
+        if (!pTransform)
             assert(false);
-        pEntity->transform->Apply(s, eulerRad, t);
+        pTransform->Apply(s, eulerRad, t);
     }
 
     void SetMesh(EntityHandle eh, MeshHandle mh)
     {
-        auto* pEntity = m_entities.Get(eh);
-
-        if (pEntity->meshRenderer.has_value())
+        if (auto* pMeshRenderer = m_meshRenderers.Get(eh))
         {
-            pEntity->meshRenderer->mesh = mh;
+            pMeshRenderer->mesh = mh;
+            m_instanceTable.SetMesh(pMeshRenderer->instanceSlot, mh);
         }
         else
         {
-            pEntity->meshRenderer = {mh, GetMaterialHandle("builtin://material/default")};
+            auto& meshRenderer = m_meshRenderers.Add(eh, {mh, GetMaterialHandle("builtin://material/default")});
+            meshRenderer.instanceSlot = m_instanceTable.Allocate(eh, mh);
         }
+
+        // Local bounds come from the mesh.
+        m_renderablesChanged = true;
     }
 
     void SetMaterial(EntityHandle eh, MaterialHandle mh)
     {
-        auto* pEntity = m_entities.Get(eh);
-
-        if (pEntity->meshRenderer.has_value())
+        if (auto* pMeshRenderer = m_meshRenderers.Get(eh))
         {
-            pEntity->meshRenderer->material = mh;
+            pMeshRenderer->material = mh;
+            m_instanceTable.MarkDirty(pMeshRenderer->instanceSlot);
         }
         else
         {
@@ -215,8 +228,70 @@ public:
 
     void AddComponent(EntityHandle eh, LightHandle lh)
     {
-        auto* pEntity = m_entities.Get(eh);
-        pEntity->light = lh;
+        if (auto* pLight = m_lights.Get(eh))
+            *pLight = lh;
+        else
+            m_lights.Add(eh, LightHandle(lh));
+    }
+
+    // Update world render transforms with one linear pass over the flattened hierarchy.
+    // Only entities whose local transform or one of ancestors changed are recalculated.
+    // Returns the number of recalculated world transforms.
+    UINT UpdateWorldTransforms(float alpha, JobSystem& jobSystem)
+    {
+        if (m_hierarchyChanged)
+            RebuildHierarchy();
+
+        auto& transforms = m_transforms.GetDense();
+        const auto& owners = m_transforms.GetOwners();
+
+        // Entities of the same depth only depend on the previous depth, so each depth runs in parallel.
+        for (UINT level = 0; level + 1 < static_cast<UINT>(m_hierarchyLevels.size()); ++level)
+        {
+            jobSystem.ParallelFor(
+                m_hierarchyLevels[level],
+                m_hierarchyLevels[level + 1],
+                256,
+                [&](UINT i)
+                {
+                    auto& transform = transforms[m_hierarchyTransforms[i]];
+                    UINT parent = m_hierarchyParents[i];
+
+                    bool dirty = transform.UpdateLocalRenderState(alpha);
+                    if (dirty)
+                        m_localMatrices[i] = transform.GetLocalRenderTransform();
+
+                    // Parents are in the previous depth, so parent's flag is already final.
+                    if (parent != UINT_MAX && m_hierarchyDirty[parent])
+                        dirty = true;
+
+                    m_hierarchyDirty[i] = dirty;
+                    if (!dirty)
+                        return;
+
+                    DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&m_localMatrices[i]);
+                    if (parent != UINT_MAX)
+                        world = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&m_worldMatrices[parent]));
+
+                    DirectX::XMStoreFloat4x4(&m_worldMatrices[i], world);
+                    transform.SetWorldRenderTransform(world);
+                });
+        }
+
+        // Instance table is not thread-safe.
+        UINT recomputed = 0;
+        for (UINT i = 0; i < static_cast<UINT>(m_hierarchyTransforms.size()); ++i)
+        {
+            if (!m_hierarchyDirty[i])
+                continue;
+
+            if (auto* pMeshRenderer = m_meshRenderers.Get(owners[m_hierarchyTransforms[i]]))
+                m_instanceTable.MarkDirty(pMeshRenderer->instanceSlot);
+
+            ++recomputed;
+        }
+
+        return recomputed;
     }
 
     const std::vector<Entity>& GetEntities() const
@@ -229,10 +304,36 @@ public:
         return m_entities.GetDense();
     }
 
+    Transform* GetTransform(EntityHandle h)
+    {
+        return m_transforms.Get(h);
+    }
+
+    const MeshRenderer* GetMeshRenderer(EntityHandle h) const
+    {
+        return m_meshRenderers.Get(h);
+    }
+
+    const std::string* GetName(EntityHandle h) const
+    {
+        return m_names.Get(h);
+    }
+
+    const Hierarchy* GetHierarchy(EntityHandle h) const
+    {
+        return m_hierarchies.Get(h);
+    }
+
+    // Dense transform array. Order is not stable across Remove.
+    std::vector<Transform>& GetTransforms()
+    {
+        return m_transforms.GetDense();
+    }
+
     MeshHandle AddMesh(
         ID3D12Device10* pDevice,
         ID3D12GraphicsCommandList7* pCommandList,
-        TransientUploadAllocator& allocator,
+        UploadRingBuffer& allocator,
         const GeometryData& data)
     {
         auto handle = m_meshes.Add(Mesh(pDevice, pCommandList, allocator, data));
@@ -310,92 +411,171 @@ public:
         return ret;
     }
 
-    std::vector<InstanceData> GatherInstances()
+    void SetViewCount(UINT count)
     {
-        for (auto& [mesh, bucket] : m_buckets)
-        {
-            bucket.forward.clear();
-            bucket.deferred.clear();
-        }
-        m_instanceRanges.clear();
-        m_entityIndexInBucket.clear(); // 실제로 entity dense array에 변화가 있을 때만 clear하거나, 구조를 개선하기.
+        m_views.resize(count);
+    }
 
-        for (const auto& entity : m_entities.GetDense())
-        {
-            if (!entity.meshRenderer.has_value())
-                continue;
+    // Instances of the view are sorted front-to-back in each mesh range.
+    void SetViewDepthPlane(UINT viewIdx, DirectX::FXMVECTOR eye, DirectX::FXMVECTOR forward)
+    {
+        auto& view = m_views[viewIdx];
 
-            auto meshHandle = entity.meshRenderer->mesh;
-            auto matHandle = entity.meshRenderer->material;
+        DirectX::XMVECTOR normal = DirectX::XMVector3Normalize(forward);
+        DirectX::XMStoreFloat4(&view.depthPlane, DirectX::XMVectorSetW(normal, -DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, eye))));
+        view.sortByDepth = true;
+    }
 
-            auto matIdx = m_materials.GetDenseIndex(matHandle);
-            auto data = BuildInstanceData(entity.transform->GetWorldRenderTransform(), matIdx);
+    // Refresh world space bounds of renderable entities.
+    // Should be called after world render transforms are updated.
+    void UpdateWorldBounds()
+    {
+        // World matrices are read by hierarchy index, so the hierarchy should match the pools.
+        if (m_hierarchyChanged)
+            RebuildHierarchy();
 
-            auto renderingPath = GetMaterial(matHandle)->GetRenderingPath();
+        if (m_renderablesChanged)
+            RebuildRenderables();
 
-            if (renderingPath == RenderingPath::FORWARD)
-            {
-                m_entityIndexInBucket[entity.selfHandle] = static_cast<UINT>(m_buckets[meshHandle].forward.size());
-                m_buckets[meshHandle].forward.push_back(data);
-            }
+        m_worldBounds.Update(m_worldMatrices.data());
+
+        const auto& owners = m_meshRenderers.GetOwners();
+
+        // Entities get a proxy once they have bounds, i.e. the first frame after they become renderable.
+        // Moving a proxy is a no-op while it stays inside its fat AABB.
+        for (UINT i = 0; i < static_cast<UINT>(m_renderables.size()); ++i)
+        {
+            auto handle = owners[m_renderables[i]];
+            auto box = m_worldBounds.GetBox(i);
+
+            auto it = m_proxies.find(handle);
+            if (it == m_proxies.end())
+                m_proxies.emplace(handle, m_spatialIndex.CreateProxy(box, handle));
             else
-            {
-                m_entityIndexInBucket[entity.selfHandle] = static_cast<UINT>(m_buckets[meshHandle].deferred.size());
-                m_buckets[meshHandle].deferred.push_back(data);
-            }
+                m_spatialIndex.MoveProxy(it->second, box);
         }
+    }
 
-        for (const auto& entity : m_entities.GetDense())
-        {
-            if (!entity.meshRenderer.has_value())
-                continue;
+    // Spatial queries. Results are conservative since the index stores fattened bounds.
+    void QueryAabb(const DirectX::BoundingBox& box, std::vector<EntityHandle>& out) const
+    {
+        m_spatialIndex.QueryAabb(box, out);
+    }
 
-            auto meshHandle = entity.meshRenderer->mesh;
-            auto matHandle = entity.meshRenderer->material;
+    void QuerySphere(const DirectX::BoundingSphere& sphere, std::vector<EntityHandle>& out) const
+    {
+        m_spatialIndex.QuerySphere(sphere, out);
+    }
 
-            auto renderingPath = GetMaterial(matHandle)->GetRenderingPath();
+    void QueryFrustum(const DirectX::BoundingFrustum& frustum, std::vector<EntityHandle>& out) const
+    {
+        m_spatialIndex.QueryFrustum(frustum, out);
+    }
 
-            if (renderingPath == RenderingPath::DEFERRED)
-                m_entityIndexInBucket[entity.selfHandle] += static_cast<UINT>(m_buckets[meshHandle].forward.size());
-        }
+    void RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, std::vector<DynamicAabbTree::RayHit>& out) const
+    {
+        m_spatialIndex.RayCast(origin, direction, maxDistance, out);
+    }
+
+    const DynamicAabbTree& GetSpatialIndex() const
+    {
+        return m_spatialIndex;
+    }
+
+    // Indexed by renderable index. Use GetRenderableEntity to get the entity.
+    const WorldBounds& GetWorldBounds() const
+    {
+        return m_worldBounds;
+    }
 
-        UINT currentOffset = 0;
+    EntityHandle GetRenderableEntity(UINT renderableIdx) const
+    {
+        return m_meshRenderers.GetOwners()[m_renderables[renderableIdx]];
+    }
 
-        // InstanceData도 버켓에 담긴 순으로 flat array만들고, 드로우 콜도 그냥 버켓 순으로 해버리기?
+    // Fill visible list of the view with renderables intersecting the frustum.
+    UINT CullView(UINT viewIdx, const DirectX::BoundingFrustum& frustum)
+    {
+        m_frustumCuller.SetFrustum(frustum);
+        return CullView(viewIdx);
+    }
 
-        std::vector<InstanceData> temp;
+    // Same as above, but the volume is given as view * projection. Used for orthographic shadow views.
+    UINT CullView(UINT viewIdx, DirectX::FXMMATRIX viewProjection)
+    {
+        m_frustumCuller.SetViewProjection(viewProjection);
+        return CullView(viewIdx);
+    }
 
-        for (const auto& [meshHandle, bucket] : m_buckets)
-        {
-            const auto& [forward, deferred] = bucket;
+    UINT GetVisibleCount(UINT viewIdx) const
+    {
+        return static_cast<UINT>(m_views[viewIdx].visibleEntities.size());
+    }
 
-            InstanceRange& range = m_instanceRanges[meshHandle];
-            range.offset = currentOffset;
-            range.forwardCount = static_cast<UINT>(forward.size());
-            range.deferredCount = static_cast<UINT>(deferred.size());
+    UINT GetRenderableCount() const
+    {
+        return static_cast<UINT>(m_renderables.size());
+    }
 
-            temp.insert(temp.end(), forward.begin(), forward.end());
-            temp.insert(temp.end(), deferred.begin(), deferred.end());
+    // Number of instances GatherInstances writes. Valid after all views are culled.
+    UINT GetInstanceCount() const
+    {
+        UINT count = 0;
+        for (const auto& view : m_views)
+            count += static_cast<UINT>(view.visibleEntities.size());
+        return count;
+    }
 
-            currentOffset += (range.forwardCount + range.deferredCount) * sizeof(InstanceData);
-        }
+    // Rebuild changed instances, then write instances of all views to pDest.
+    // Instances of each view are stored contiguously, grouped by mesh.
+    void GatherInstances(InstanceData* pDest, JobSystem& jobSystem)
+    {
+        m_rebuiltInstanceCount = RebuildDirtyInstances(jobSystem);
 
-        return temp;
+        for (UINT slot : m_recordedSlots)
+            m_indexInRange[slot] = UINT_MAX;
+        m_recordedSlots.clear();
+        m_indexInRange.resize(m_instanceTable.GetSlotCapacity(), UINT_MAX);
+
+        UINT written = 0;
+        for (UINT i = 0; i < static_cast<UINT>(m_views.size()); ++i)
+            GatherView(m_views[i], i == 0, pDest, written);
     }
 
-    InstanceRange GetInstanceRange(MeshHandle mesh)
+    // Instance data rebuilt in last GatherInstances
+    UINT GetRebuiltInstanceCount() const
     {
-        return m_instanceRanges[mesh];
+        return m_rebuiltInstanceCount;
     }
 
-    UINT GetEntityIndexInBucket(EntityHandle entity)
+    InstanceRange GetInstanceRange(UINT viewIdx, MeshHandle mesh) const
     {
-        return m_entityIndexInBucket[entity];
+        for (const auto& [meshHandle, range] : m_views[viewIdx].instanceRanges)
+        {
+            if (meshHandle == mesh)
+                return range;
+        }
+        return {};
     }
 
-    const std::unordered_map<MeshHandle, MeshBucket>& GetBuckets() const
+    // Ordered by mesh group, so the order is stable across frames.
+    // Use DrawList to order draws of a pass.
+    const std::vector<std::pair<MeshHandle, InstanceRange>>& GetInstanceRanges(UINT viewIdx) const
     {
-        return m_buckets;
+        return m_views[viewIdx].instanceRanges;
+    }
+
+    // Index of the entity in its mesh range of the first view. Empty if the entity was culled.
+    std::optional<UINT> GetEntityIndexInBucket(EntityHandle entity) const
+    {
+        const auto* pMeshRenderer = m_meshRenderers.Get(entity);
+        if (!pMeshRenderer || pMeshRenderer->instanceSlot >= m_indexInRange.size())
+            return std::nullopt;
+
+        UINT index = m_indexInRange[pMeshRenderer->instanceSlot];
+        if (index == UINT_MAX)
+            return std::nullopt;
+        return index;
     }
 
     DirectionalLightHandle AddDirectionalLight(
@@ -405,6 +585,7 @@ public:
         DescriptorAllocation&& cbvAllocation,
         UINT shadowMapResolution)
     {
+        ++m_lightVersion;
         return m_directionalLights.Add(DirectionalLight(
             pDevice,
             std::move(dsvAllocation),
@@ -421,6 +602,7 @@ public:
         DescriptorAllocation&& rtvAllocation,
         UINT shadowMapResolution)
     {
+        ++m_lightVersion;
         return m_pointLights.Add(PointLight(
             pDevice,
             std::move(dsvAllocation),
@@ -437,6 +619,7 @@ public:
         DescriptorAllocation&& cbvAllocation,
         UINT shadowMapResolution)
     {
+        ++m_lightVersion;
         return m_spotLights.Add(SpotLight(
             pDevice,
             std::move(dsvAllocation),
@@ -500,11 +683,17 @@ public:
         return m_directionalLights.GetCount() + m_pointLights.GetCount() + m_spotLights.GetCount();
     }
 
+    // Changes whenever a light is added or removed.
+    UINT64 GetLightVersion() const
+    {
+        return m_lightVersion;
+    }
+
     AssetTextureHandle AddAssetTexture(
         ID3D12Device10* pDevice,
         ID3D12GraphicsCommandList7* pCommandList,
         DescriptorAllocation&& srvAllocation,
-        TransientUploadAllocator& uploadAllocator,
+        UploadRingBuffer& uploadAllocator,
         const std::vector<UINT8>& textureSrc,
         UINT width,
         UINT height)
@@ -556,7 +745,7 @@ public:
         ID3D12Device10* pDevice,
         ID3D12GraphicsCommandList7* pCommandList,
         DescriptorAllocation&& srvAllocation,
-        TransientUploadAllocator& uploadAllocator,
+        UploadRingBuffer& uploadAllocator,
         const std::wstring& filePath,
         bool isSRGB,
         bool useBlockCompress,
@@ -690,6 +879,11 @@ public:
         return m_assetTextures.Add(AssetTexture{std::move(texture), std::move(srv)});
     }
 
+    AssetTexture* GetAssetTexture(AssetTextureHandle handle)
+    {
+        return m_assetTextures.Get(handle);
+    }
+
     const std::vector<AssetTexture>& GetAssetTextures() const
     {
         return m_assetTextures.GetDense();
@@ -716,29 +910,296 @@ public:
     }
 
 private:
+    struct RenderView
+    {
+        std::vector<UINT> visibleEntities; // dense indices of mesh renderers
+        std::vector<std::pair<MeshHandle, InstanceRange>> instanceRanges;
+
+        DirectX::XMFLOAT4 depthPlane = {};
+        bool sortByDepth = false;
+    };
+
+    // Sort transforms in breadth-first order and build parent index array.
+    // Entities without transform cut off their subtree, same as they have no world transform.
+    void RebuildHierarchy()
+    {
+        m_hierarchyTransforms.clear();
+        m_hierarchyParents.clear();
+        m_hierarchyLevels.clear();
+
+        const auto& transforms = m_transforms.GetDense();
+        const auto& owners = m_transforms.GetOwners();
+
+        for (UINT i = 0; i < m_transforms.GetCount(); ++i)
+        {
+            if (!m_entities.IsValid(m_hierarchies.Get(owners[i])->parent))
+            {
+                m_hierarchyTransforms.push_back(i);
+                m_hierarchyParents.push_back(UINT_MAX);
+            }
+        }
+
+        // m_hierarchyTransforms itself is the BFS queue. Each depth is appended as a whole.
+        UINT levelBegin = 0;
+        while (levelBegin < static_cast<UINT>(m_hierarchyTransforms.size()))
+        {
+            m_hierarchyLevels.push_back(levelBegin);
+
+            UINT levelEnd = static_cast<UINT>(m_hierarchyTransforms.size());
+            for (UINT i = levelBegin; i < levelEnd; ++i)
+            {
+                for (auto child : m_hierarchies.Get(owners[m_hierarchyTransforms[i]])->children)
+                {
+                    if (!m_transforms.Has(child))
+                        continue;
+
+                    m_hierarchyTransforms.push_back(m_transforms.GetDenseIndex(child));
+                    m_hierarchyParents.push_back(i);
+                }
+            }
+
+            levelBegin = levelEnd;
+        }
+        m_hierarchyLevels.push_back(levelBegin);
+
+        // Cached matrices are still valid for clean transforms. Dirty ones are recalculated in this frame anyway.
+        const UINT count = static_cast<UINT>(m_hierarchyTransforms.size());
+        m_localMatrices.resize(count);
+        m_worldMatrices.resize(count);
+        m_hierarchyDirty.assign(count, 0);
+
+        m_hierarchyIndices.assign(m_transforms.GetCount(), UINT_MAX);
+
+        for (UINT i = 0; i < count; ++i)
+        {
+            const auto& transform = transforms[m_hierarchyTransforms[i]];
+            m_localMatrices[i] = transform.GetLocalRenderTransform();
+            m_worldMatrices[i] = transform.GetWorldRenderTransform();
+            m_hierarchyIndices[m_hierarchyTransforms[i]] = i;
+        }
+
+        m_hierarchyChanged = false;
+
+        // Renderables refer to hierarchy indices.
+        m_renderablesChanged = true;
+    }
+
+    // Collect mesh renderers with a world matrix, and store their local bounds.
+    // Local bounds are only copied here, not every frame.
+    void RebuildRenderables()
+    {
+        m_renderables.clear();
+        m_worldBounds.Clear();
+
+        const auto& meshRenderers = m_meshRenderers.GetDense();
+        const auto& owners = m_meshRenderers.GetOwners();
+        m_worldBounds.Reserve(m_meshRenderers.GetCount());
+
+        for (UINT i = 0; i < m_meshRenderers.GetCount(); ++i)
+        {
+            if (!m_transforms.Has(owners[i]))
+                continue;
+
+            // Cut off from the hierarchy by an ancestor without transform
+            UINT hierarchyIdx = m_hierarchyIndices[m_transforms.GetDenseIndex(owners[i])];
+            if (hierarchyIdx == UINT_MAX)
+                continue;
+
+            const auto* pMesh = GetMesh(meshRenderers[i].mesh);
+
+            m_renderables.push_back(i);
+            m_worldBounds.Add(pMesh->GetBoundingBox(), pMesh->GetBoundingSphere(), hierarchyIdx);
+        }
+
+        m_renderablesChanged = false;
+    }
+
+    UINT CullView(UINT viewIdx)
+    {
+        auto& visible = m_views[viewIdx].visibleEntities;
+        visible.clear();
+
+        m_frustumCuller.Cull(m_worldBounds.GetSpheres(), m_worldBounds.GetCount(), visible);
+
+        // Renderable index -> mesh renderer dense index
+        for (auto& idx : visible)
+            idx = m_renderables[idx];
+
+        return static_cast<UINT>(visible.size());
+    }
+
+    // Instance data holds the material's per-frame bindless index from GetBindlessIndex(). The material owns it for its lifetime,
+    // and the slot is rewritten with the CBV of each frame, so the index never changes. A freed index is reused only after its fence.
+    UINT RebuildDirtyInstances(JobSystem& jobSystem)
+    {
+        const auto& dirtySlots = m_instanceTable.GetDirtySlots();
+
+        // Each job writes its own slots only.
+        std::atomic<UINT> rebuilt{0};
+        jobSystem.ParallelFor(
+            0,
+            static_cast<UINT>(dirtySlots.size()),
+            64,
+            [&](UINT i)
+            {
+                UINT slot = dirtySlots[i];
+                if (!m_instanceTable.IsAllocated(slot))
+                    return;
+
+                auto owner = m_instanceTable.GetOwner(slot);
+
+                // Slot is marked again when the transform is added.
+                const auto* pTransform = m_transforms.Get(owner);
+                if (!pTransform)
+                    return;
+
+                auto matIdx = m_materials.Get(m_meshRenderers.Get(owner)->material)->GetBindlessIndex();
+                m_instanceTable.SetData(slot, BuildInstanceData(pTransform->GetWorldRenderTransform(), matIdx));
+
+                rebuilt.fetch_add(1, std::memory_order_relaxed);
+            });
+        m_instanceTable.ClearDirtySlots();
+
+        return rebuilt;
+    }
+
+    // Radix sort visible instances by (mesh group, rendering path, view depth).
+    // Forward instances precede deferred ones in each mesh range.
+    void GatherView(RenderView& view, bool recordEntityIndex, InstanceData* pDest, UINT& written)
+    {
+        view.instanceRanges.clear();
+
+        const auto& meshRenderers = m_meshRenderers.GetDense();
+        const DirectX::XMVECTOR depthPlane = DirectX::XMLoadFloat4(&view.depthPlane);
+
+        m_instanceKeys.clear();
+        for (UINT i = 0; i < static_cast<UINT>(view.visibleEntities.size()); ++i)
+        {
+            const auto& meshRenderer = meshRenderers[view.visibleEntities[i]];
+            UINT slot = meshRenderer.instanceSlot;
+
+            UINT64 path = GetMaterial(meshRenderer.material)->GetRenderingPath() == RenderingPath::FORWARD ? 0 : 1;
+            UINT64 key = (static_cast<UINT64>(m_instanceTable.GetGroup(slot)) << 33) | (path << 32);
+
+            if (view.sortByDepth)
+            {
+                // World matrix is stored transposed, so translation is in the last column.
+                const auto& world = m_instanceTable.GetData(slot).world;
+                float depth = DirectX::XMVectorGetX(DirectX::XMPlaneDotCoord(depthPlane, DirectX::XMVectorSet(world._14, world._24, world._34, 1.0f)));
+
+                // Non-negative float bits sort the same as the value.
+                depth = (std::max)(depth, 0.0f);
+                UINT32 depthBits;
+                std::memcpy(&depthBits, &depth, sizeof(depthBits));
+                key |= depthBits;
+            }
+
+            m_instanceKeys.push_back({key, i});
+        }
+
+        DrawList::RadixSort(m_instanceKeys, m_instanceKeysScratch);
+
+        // Emit one range per run of the same group.
+        const UINT count = static_cast<UINT>(m_instanceKeys.size());
+        UINT runBegin = 0;
+        while (runBegin < count)
+        {
+            UINT group = static_cast<UINT>(m_instanceKeys[runBegin].key >> 33);
+
+            UINT runEnd = runBegin;
+            UINT forwardCount = 0;
+            while (runEnd < count && static_cast<UINT>(m_instanceKeys[runEnd].key >> 33) == group)
+            {
+                if (((m_instanceKeys[runEnd].key >> 32) & 1) == 0)
+                    ++forwardCount;
+                ++runEnd;
+            }
+
+            InstanceRange range;
+            range.offset = static_cast<UINT>((written + runBegin) * sizeof(InstanceData));
+            range.forwardCount = forwardCount;
+            range.deferredCount = runEnd - runBegin - forwardCount;
+            range.depth = FLT_MAX;
+
+            for (UINT i = runBegin; i < runEnd; ++i)
+            {
+                UINT slot = meshRenderers[view.visibleEntities[m_instanceKeys[i].index]].instanceSlot;
+
+                pDest[written + i] = m_instanceTable.GetData(slot);
+
+                if (recordEntityIndex)
+                {
+                    m_indexInRange[slot] = i - runBegin;
+                    m_recordedSlots.push_back(slot);
+                }
+
+                UINT32 depthBits = static_cast<UINT32>(m_instanceKeys[i].key);
+                float depth;
+                std::memcpy(&depth, &depthBits, sizeof(depth));
+                range.depth = (std::min)(range.depth, depth);
+            }
+
+            view.instanceRanges.emplace_back(m_instanceTable.GetGroupMesh(group), range);
+
+            runBegin = runEnd;
+        }
+
+        written += count;
+    }
+
     void Remove(DirectionalLightHandle handle)
     {
         m_directionalLights.Remove(handle);
+        ++m_lightVersion;
     }
 
     void Remove(PointLightHandle handle)
     {
         m_pointLights.Remove(handle);
+        ++m_lightVersion;
     }
 
     void Remove(SpotLightHandle handle)
     {
         m_spotLights.Remove(handle);
+        ++m_lightVersion;
     }
 
     SlotMap<Mesh> m_meshes;
     std::unordered_map<AssetID, MeshHandle> m_meshRegistry;
 
-    std::unordered_map<MeshHandle, MeshBucket> m_buckets;
+    // Instances
+    InstanceTable m_instanceTable;
+    UINT m_rebuiltInstanceCount = 0;
+
+    std::vector<RenderView> m_views;
+
+    // Scratch arrays reused for each view
+    std::vector<DrawList::SortEntry> m_instanceKeys;
+    std::vector<DrawList::SortEntry> m_instanceKeysScratch;
 
-    std::unordered_map<MeshHandle, InstanceRange> m_instanceRanges;
+    std::vector<UINT> m_indexInRange;  // per instance slot, index in mesh range of the first view
+    std::vector<UINT> m_recordedSlots; // slots written to m_indexInRange in last frame
 
-    std::unordered_map<EntityHandle, UINT> m_entityIndexInBucket;
+    // Culling
+    // Flattened transform hierarchy in breadth-first order
+    std::vector<UINT> m_hierarchyTransforms; // dense indices of transforms
+    std::vector<UINT> m_hierarchyParents;  // index in hierarchy arrays, UINT_MAX for roots
+    std::vector<DirectX::XMFLOAT4X4> m_localMatrices;
+    std::vector<DirectX::XMFLOAT4X4> m_worldMatrices;
+    std::vector<UINT> m_hierarchyLevels; // first index of each depth, followed by the total count
+    std::vector<UINT8> m_hierarchyDirty;
+    std::vector<UINT> m_hierarchyIndices; // dense index of transform -> index in hierarchy arrays, UINT_MAX if cut off
+    bool m_hierarchyChanged = true;
+
+    std::vector<UINT> m_renderables; // dense indices of mesh renderers with transform
+    WorldBounds m_worldBounds;        // per renderable
+    bool m_renderablesChanged = true;
+
+    // Spatial index
+    DynamicAabbTree m_spatialIndex;
+    std::unordered_map<EntityHandle, UINT> m_proxies;
+    FrustumCuller m_frustumCuller;
 
     SlotMap<Material> m_materials;
     std::unordered_map<AssetID, MaterialHandle> m_materialRegistry;
@@ -746,11 +1207,19 @@ private:
     SlotMap<DirectionalLight> m_directionalLights;
     SlotMap<PointLight> m_pointLights;
     SlotMap<SpotLight> m_spotLights;
+    UINT64 m_lightVersion = 0;
 
     SlotMap<AssetTexture> m_assetTextures;
 
     SlotMap<Entity> m_entities;
 
+    // Components, indexed by entity
+    ComponentPool<std::string> m_names;
+    ComponentPool<Hierarchy> m_hierarchies;
+    ComponentPool<Transform> m_transforms;
+    ComponentPool<MeshRenderer> m_meshRenderers;
+    ComponentPool<LightHandle> m_lights;
+
     std::vector<GpuResource> m_deferred; // List of resources requested to be removed
 
     struct DeferredResource
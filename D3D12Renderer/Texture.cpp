@@ -31,3 +31,22 @@ Texture::Texture(
         nullptr,
         IID_PPV_ARGS(&m_resource)));
 }
+
+Texture::Texture(
+    ID3D12Device10* pDevice,
+    ID3D12Heap* pHeap,
+    UINT64 heapOffset,
+    const D3D12_RESOURCE_DESC1& desc,
+    D3D12_BARRIER_LAYOUT initialLayout,
+    const D3D12_CLEAR_VALUE* pClearValue)
+{
+    ThrowIfFailed(pDevice->CreatePlacedResource2(
+        pHeap,
+        heapOffset,
+        &desc,
+        initialLayout,
+        pClearValue,
+        0,
+        nullptr,
+        IID_PPV_ARGS(&m_resource)));
+}
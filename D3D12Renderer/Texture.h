@@ -15,4 +15,13 @@ public:
         D3D12_BARRIER_LAYOUT initialLayout,
         const D3D12_CLEAR_VALUE* pClearValue = nullptr,
         D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT);
+
+    // Placed resource. Memory may be aliased with other placed resources in the heap.
+    Texture(
+        ID3D12Device10* pDevice,
+        ID3D12Heap* pHeap,
+        UINT64 heapOffset,
+        const D3D12_RESOURCE_DESC1& desc,
+        D3D12_BARRIER_LAYOUT initialLayout,
+        const D3D12_CLEAR_VALUE* pClearValue = nullptr);
 };
@@ -37,6 +37,13 @@ public:
         m_prevS = m_currS;
         m_prevR = m_currR;
         m_prevT = m_currT;
+
+        // Last local transform was interpolated. Recalculate once more with settled state.
+        if (m_interpolating)
+        {
+            m_dirty = true;
+            m_interpolating = false;
+        }
     }
 
     // Accumulate each component
@@ -57,11 +64,16 @@ public:
         m_currT.x += t.x;
         m_currT.y += t.y;
         m_currT.z += t.z;
+
+        m_interpolating = true;
     }
 
-    // Calculate local transform
-    void UpdateLocalRenderState(float alpha)
+    // Calculate local transform. Returns false if local transform is unchanged since last call.
+    bool UpdateLocalRenderState(float alpha)
     {
+        if (!IsDirty())
+            return false;
+
         DirectX::XMVECTOR prevS = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&m_prevS), 0.0f);
         DirectX::XMVECTOR currS = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&m_currS), 0.0f);
         DirectX::XMVECTOR prevR = DirectX::XMLoadFloat4(&m_prevR);
@@ -74,6 +86,22 @@ public:
         DirectX::XMVECTOR renderT = DirectX::XMVectorLerp(prevT, currT, alpha);
 
         DirectX::XMStoreFloat4x4(&m_localRenderTransform, DirectX::XMMatrixAffineTransformation(renderS, DirectX::XMVectorZero(), renderR, renderT));
+
+        m_dirty = false;
+
+        return true;
+    }
+
+    // Local state changed, or prev/curr state differ so that result depends on alpha.
+    bool IsDirty() const
+    {
+        return m_dirty || m_interpolating;
+    }
+
+    // Force recalculation, e.g. when parent is changed.
+    void MarkDirty()
+    {
+        m_dirty = true;
     }
 
     const DirectX::XMFLOAT4X4& GetLocalRenderTransform() const
@@ -100,6 +128,7 @@ public:
     {
         m_currS = s;
         m_prevS = s;
+        m_dirty = true;
     }
 
     // If selected entitiy changed, calculate euler angles from quaternion
@@ -123,6 +152,7 @@ public:
         DirectX::XMVECTOR r = DirectX::XMQuaternionRotationRollPitchYaw(pitch, yaw, roll);
         DirectX::XMStoreFloat4(&m_currR, r);
         DirectX::XMStoreFloat4(&m_prevR, r);
+        m_dirty = true;
     }
 
     DirectX::XMFLOAT3 GetTranslation() const
@@ -134,6 +164,7 @@ public:
     {
         m_currT = t;
         m_prevT = t;
+        m_dirty = true;
     }
 
     // Assume that order of rotation is roll -> pitch -> yaw
@@ -166,4 +197,7 @@ private:
     DirectX::XMFLOAT4X4 m_worldRenderTransform;
 
     DirectX::XMFLOAT3 m_eulerCache;
+
+    bool m_dirty = true;          // Local state changed by setters or construction
+    bool m_interpolating = false; // Apply() was called since last snapshot
 };
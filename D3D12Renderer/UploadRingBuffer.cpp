@@ -0,0 +1,199 @@
+#include "pch.h"
+
+#include "UploadRingBuffer.h"
+
+#include <algorithm>
+
+#include "CommandQueue.h"
+#include "UploadAllocation.h"
+
+UploadRingBuffer::~UploadRingBuffer() = default;
+
+void UploadRingBuffer::Init(ID3D12Device10* pDevice, UINT64 capacity)
+{
+    m_pDevice = pDevice;
+    m_ringBuffer = std::make_unique<MappedBuffer>(m_pDevice, capacity);
+    m_ring.Init(capacity);
+}
+
+void UploadRingBuffer::SetCommandQueue(CommandQueue* pCommandQueue)
+{
+    m_pCommandQueue = pCommandQueue;
+}
+
+// Only allocate space
+UploadAllocation UploadRingBuffer::Allocate(std::size_t size, std::size_t alignment)
+{
+    // Would waste most of the ring on wrapping
+    if (size > m_ring.GetCapacity() / 2)
+        return AllocateDedicated(size);
+
+    UINT64 offset = m_ring.Allocate(size, alignment);
+    if (offset == RingBufferAllocator::InvalidOffset)
+        offset = WaitForSpace(size, alignment);
+
+    if (offset == RingBufferAllocator::InvalidOffset)
+    {
+        // The frame being recorded fills the ring by itself. The ring grows at the end of the frame.
+        m_frameOverflowSize += size;
+        return AllocateDedicated(size);
+    }
+
+    UploadAllocation alloc = {
+        m_ringBuffer->uploadBuffer.Get(),
+        offset,
+        static_cast<UINT8*>(m_ringBuffer->cpuBasePtr) + offset,
+        m_ringBuffer->gpuBasePtr + offset};
+
+    return alloc;
+}
+
+// Allocate and copy data from src, returns Allocation
+UploadAllocation UploadRingBuffer::Push(const void* src, std::size_t size, std::size_t alignment)
+{
+    auto alloc = Allocate(size, alignment);
+    if (src)
+        std::memcpy(alloc.cpuPtr, src, size);
+    return alloc;
+}
+
+void UploadRingBuffer::QueueRetiredAllocations(UINT64 signaledFenceValue)
+{
+    m_ring.QueueRetiredAllocations(signaledFenceValue);
+
+    for (auto& buffer : m_dedicatedBuffers)
+        m_staleBuffers.push({signaledFenceValue, std::move(buffer)});
+    m_dedicatedBuffers.clear();
+
+    m_frameHighWaterMark = m_ring.GetHighWaterMark();
+    m_ring.ResetHighWaterMark();
+
+    UpdateCapacity(signaledFenceValue);
+    m_frameOverflowSize = 0;
+}
+
+void UploadRingBuffer::ReleaseStaleAllocations(UINT64 completedFenceValue)
+{
+    m_ring.ReleaseStaleAllocations(completedFenceValue);
+
+    while (!m_staleBuffers.empty() && m_staleBuffers.front().first <= completedFenceValue)
+        m_staleBuffers.pop();
+}
+
+UINT64 UploadRingBuffer::GetCapacity() const
+{
+    return m_ring.GetCapacity();
+}
+
+UINT64 UploadRingBuffer::GetUsedSize() const
+{
+    return m_ring.GetUsedSize();
+}
+
+UINT64 UploadRingBuffer::GetFrameHighWaterMark() const
+{
+    return m_frameHighWaterMark;
+}
+
+UINT64 UploadRingBuffer::GetWrapCount() const
+{
+    return m_ring.GetWrapCount();
+}
+
+UINT64 UploadRingBuffer::GetStallCount() const
+{
+    return m_stallCount;
+}
+
+UINT64 UploadRingBuffer::GetDedicatedCount() const
+{
+    return m_dedicatedCount;
+}
+
+UploadAllocation UploadRingBuffer::AllocateDedicated(std::size_t size)
+{
+    ++m_dedicatedCount;
+
+    // Placed at offset 0 of a committed resource, which satisfies any upload alignment
+    auto buffer = std::make_unique<MappedBuffer>(m_pDevice, size);
+
+    UploadAllocation alloc = {
+        buffer->uploadBuffer.Get(),
+        0,
+        buffer->cpuBasePtr,
+        buffer->gpuBasePtr};
+
+    m_dedicatedBuffers.push_back(std::move(buffer));
+
+    return alloc;
+}
+
+// Frees frames the GPU already finished, then waits for older frames one at a time until the request fits.
+UINT64 UploadRingBuffer::WaitForSpace(std::size_t size, std::size_t alignment)
+{
+    if (!m_pCommandQueue)
+        return RingBufferAllocator::InvalidOffset;
+
+    ReleaseStaleAllocations(m_pCommandQueue->GetCompletedFenceValue());
+    UINT64 offset = m_ring.Allocate(size, alignment);
+
+    while (offset == RingBufferAllocator::InvalidOffset && m_ring.HasStaleAllocations())
+    {
+        UINT64 fenceValue = m_ring.GetOldestFenceValue();
+        ++m_stallCount;
+        m_pCommandQueue->WaitForFenceValue(fenceValue);
+        ReleaseStaleAllocations(fenceValue);
+        offset = m_ring.Allocate(size, alignment);
+    }
+
+    return offset;
+}
+
+// Frames still in flight are part of the high-water mark, so the ring is sized for all of them.
+void UploadRingBuffer::UpdateCapacity(UINT64 signaledFenceValue)
+{
+    UINT64 capacity = m_ring.GetCapacity();
+    UINT64 demand = m_frameHighWaterMark + m_frameOverflowSize;
+    UINT64 newCapacity = capacity;
+
+    if (demand > capacity - capacity / 4)
+    {
+        // Leave the same room again
+        while (newCapacity < demand * 2 && newCapacity < MaxCapacity)
+            newCapacity *= 2;
+    }
+    else
+    {
+        m_windowHighWaterMark = std::max(m_windowHighWaterMark, demand);
+        if (++m_windowFrameCount < ShrinkWindowFrames)
+            return;
+
+        if (m_windowHighWaterMark < capacity / 4 && capacity > MinCapacity)
+            newCapacity = capacity / 2;
+    }
+
+    m_windowHighWaterMark = 0;
+    m_windowFrameCount = 0;
+
+    if (newCapacity == capacity)
+        return;
+
+    // Allocations in the old ring are all tagged with signaledFenceValue or earlier, so it retires as a whole.
+    m_staleBuffers.push({signaledFenceValue, std::move(m_ringBuffer)});
+    m_ringBuffer = std::make_unique<MappedBuffer>(m_pDevice, newCapacity);
+    m_ring.Init(newCapacity);
+}
+
+UploadRingBuffer::MappedBuffer::MappedBuffer(ID3D12Device10* pDevice, UINT64 size)
+{
+    uploadBuffer = Buffer(pDevice, size, D3D12_HEAP_TYPE_UPLOAD);
+
+    D3D12_RANGE readRange = {0, 0};
+    uploadBuffer.Get()->Map(0, &readRange, &cpuBasePtr);
+    gpuBasePtr = uploadBuffer.Get()->GetGPUVirtualAddress();
+}
+
+UploadRingBuffer::MappedBuffer::~MappedBuffer()
+{
+    uploadBuffer.Get()->Unmap(0, nullptr);
+}
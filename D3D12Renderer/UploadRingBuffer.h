@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <basetsd.h>
+#include <d3d12.h>
+#include <minwindef.h>
+
+#include "Buffer.h"
+#include "RingBufferAllocator.h"
+
+class CommandQueue;
+struct UploadAllocation;
+
+// Upload heap shared by every frame. Allocations are tagged with the fence value of the frame that submits them,
+// and the ring reuses their memory once that fence completes.
+// Requests larger than half of the ring get a buffer of their own, retired the same way.
+// The ring grows when a frame needs more than 3/4 of it, and shrinks when a window of frames used less than 1/4.
+// Not thread-safe.
+class UploadRingBuffer
+{
+public:
+    UploadRingBuffer(const UploadRingBuffer&) = delete;
+    UploadRingBuffer& operator=(const UploadRingBuffer&) = delete;
+    UploadRingBuffer(UploadRingBuffer&&) = delete;
+    UploadRingBuffer& operator=(UploadRingBuffer&&) = delete;
+
+    UploadRingBuffer() = default;
+    ~UploadRingBuffer();
+
+    void Init(ID3D12Device10* pDevice, UINT64 capacity = DefaultCapacity);
+    // Without a queue, a full ring falls back to dedicated buffers instead of waiting for the GPU.
+    void SetCommandQueue(CommandQueue* pCommandQueue);
+
+    UploadAllocation Allocate(std::size_t size, std::size_t alignment);
+    UploadAllocation Push(const void* src, std::size_t size, std::size_t alignment);
+
+    // Call after each submission. Allocations since the last call are reused once signaledFenceValue completes.
+    void QueueRetiredAllocations(UINT64 signaledFenceValue);
+    void ReleaseStaleAllocations(UINT64 completedFenceValue);
+
+    UINT64 GetCapacity() const;
+    UINT64 GetUsedSize() const;
+    UINT64 GetFrameHighWaterMark() const; // Peak of the last retired frame, frames still in flight included
+    UINT64 GetWrapCount() const;
+    UINT64 GetStallCount() const; // Waits for the GPU to free the ring
+    UINT64 GetDedicatedCount() const; // Oversized requests, and requests the ring could not hold even after waiting
+
+private:
+    static constexpr UINT64 DefaultCapacity = 16 * 1024 * 1024; // 16MB
+    static constexpr UINT64 MinCapacity = 4 * 1024 * 1024;
+    static constexpr UINT64 MaxCapacity = 256 * 1024 * 1024;
+    static constexpr UINT ShrinkWindowFrames = 256;
+
+    struct MappedBuffer
+    {
+        MappedBuffer(ID3D12Device10* pDevice, UINT64 size);
+        ~MappedBuffer();
+
+        Buffer uploadBuffer;
+        void* cpuBasePtr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuBasePtr;
+    };
+
+    UploadAllocation AllocateDedicated(std::size_t size);
+    UINT64 WaitForSpace(std::size_t size, std::size_t alignment);
+    void UpdateCapacity(UINT64 signaledFenceValue);
+
+    RingBufferAllocator m_ring;
+    std::unique_ptr<MappedBuffer> m_ringBuffer;
+
+    // Dedicated buffers of the frame being recorded, then buffers waiting for the GPU (old rings included)
+    std::vector<std::unique_ptr<MappedBuffer>> m_dedicatedBuffers;
+    std::queue<std::pair<UINT64, std::unique_ptr<MappedBuffer>>> m_staleBuffers;
+
+    UINT64 m_frameOverflowSize = 0; // Bytes the ring should have held this frame
+    UINT64 m_frameHighWaterMark = 0;
+    UINT64 m_windowHighWaterMark = 0;
+    UINT m_windowFrameCount = 0;
+
+    UINT64 m_stallCount = 0;
+    UINT64 m_dedicatedCount = 0;
+
+    ID3D12Device10* m_pDevice = nullptr;
+    CommandQueue* m_pCommandQueue = nullptr;
+};
@@ -0,0 +1,183 @@
+#include "pch.h"
+
+#include "WorldBounds.h"
+
+using namespace DirectX;
+
+namespace
+{
+// Lanes of m[r][c] hold element (r, c) of four matrices.
+using MatrixLanes = XMVECTOR[4][3];
+
+// Column c of (x, y, z, 1) * M
+XMVECTOR XM_CALLCONV TransformCoordLanes(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, const MatrixLanes& m, UINT c)
+{
+    XMVECTOR result = XMVectorMultiplyAdd(x, m[0][c], m[3][c]);
+    result = XMVectorMultiplyAdd(y, m[1][c], result);
+    return XMVectorMultiplyAdd(z, m[2][c], result);
+}
+
+// Column c of (x, y, z) * |M|
+XMVECTOR XM_CALLCONV TransformExtentLanes(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, const MatrixLanes& m, UINT c)
+{
+    XMVECTOR result = XMVectorMultiply(x, XMVectorAbs(m[0][c]));
+    result = XMVectorMultiplyAdd(y, XMVectorAbs(m[1][c]), result);
+    return XMVectorMultiplyAdd(z, XMVectorAbs(m[2][c]), result);
+}
+
+XMVECTOR XM_CALLCONV LengthSqLanes(FXMVECTOR x, FXMVECTOR y, FXMVECTOR z)
+{
+    return XMVectorMultiplyAdd(z, z, XMVectorMultiplyAdd(y, y, XMVectorMultiply(x, x)));
+}
+}
+
+void WorldBounds::Clear()
+{
+    m_localBatches.clear();
+    m_worldIndices.clear();
+    m_count = 0;
+}
+
+void WorldBounds::Reserve(UINT count)
+{
+    const UINT batchCount = (count + BatchSize - 1) / BatchSize;
+    m_localBatches.reserve(batchCount);
+    m_worldIndices.reserve(batchCount * BatchSize);
+}
+
+void WorldBounds::Add(const BoundingBox& localBox, const BoundingSphere& localSphere, UINT worldIdx)
+{
+    const UINT lane = m_count % BatchSize;
+
+    // Unused lanes of the last batch have empty bounds and reuse the first matrix of the batch.
+    if (lane == 0)
+    {
+        m_localBatches.push_back({});
+        m_worldIndices.insert(m_worldIndices.end(), BatchSize, worldIdx);
+    }
+
+    auto& batch = m_localBatches.back();
+    batch.boxCenterX[lane] = localBox.Center.x;
+    batch.boxCenterY[lane] = localBox.Center.y;
+    batch.boxCenterZ[lane] = localBox.Center.z;
+    batch.boxExtentX[lane] = localBox.Extents.x;
+    batch.boxExtentY[lane] = localBox.Extents.y;
+    batch.boxExtentZ[lane] = localBox.Extents.z;
+    batch.sphereCenterX[lane] = localSphere.Center.x;
+    batch.sphereCenterY[lane] = localSphere.Center.y;
+    batch.sphereCenterZ[lane] = localSphere.Center.z;
+    batch.sphereRadius[lane] = localSphere.Radius;
+
+    m_worldIndices[m_count] = worldIdx;
+    ++m_count;
+}
+
+void WorldBounds::Update(const XMFLOAT4X4* pWorlds)
+{
+    const UINT batchCount = static_cast<UINT>(m_localBatches.size());
+
+    m_spheres.resize(batchCount * BatchSize);
+    m_boxCenters.resize(batchCount * BatchSize);
+    m_boxExtents.resize(batchCount * BatchSize);
+
+    for (UINT b = 0; b < batchCount; ++b)
+    {
+        const LocalBatch& local = m_localBatches[b];
+        const UINT* pIndices = &m_worldIndices[b * BatchSize];
+        const UINT first = b * BatchSize;
+
+        // Gather four matrices. Transposing same rows of them puts each element in its own register.
+        MatrixLanes m;
+        for (UINT r = 0; r < 4; ++r)
+        {
+            XMMATRIX rows(
+                XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pWorlds[pIndices[0]].m[r])),
+                XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pWorlds[pIndices[1]].m[r])),
+                XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pWorlds[pIndices[2]].m[r])),
+                XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pWorlds[pIndices[3]].m[r])));
+            rows = XMMatrixTranspose(rows);
+
+            m[r][0] = rows.r[0];
+            m[r][1] = rows.r[1];
+            m[r][2] = rows.r[2];
+        }
+
+        // AABB : transform center, and project extents onto world axes with |M|.
+        XMVECTOR centerX = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxCenterX));
+        XMVECTOR centerY = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxCenterY));
+        XMVECTOR centerZ = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxCenterZ));
+        XMVECTOR extentX = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxExtentX));
+        XMVECTOR extentY = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxExtentY));
+        XMVECTOR extentZ = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.boxExtentZ));
+
+        XMMATRIX centers(
+            TransformCoordLanes(centerX, centerY, centerZ, m, 0),
+            TransformCoordLanes(centerX, centerY, centerZ, m, 1),
+            TransformCoordLanes(centerX, centerY, centerZ, m, 2),
+            XMVectorZero());
+        XMMATRIX extents(
+            TransformExtentLanes(extentX, extentY, extentZ, m, 0),
+            TransformExtentLanes(extentX, extentY, extentZ, m, 1),
+            TransformExtentLanes(extentX, extentY, extentZ, m, 2),
+            XMVectorZero());
+
+        // Sphere : scale radius by the largest axis scale.
+        XMVECTOR sphereX = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.sphereCenterX));
+        XMVECTOR sphereY = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.sphereCenterY));
+        XMVECTOR sphereZ = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.sphereCenterZ));
+        XMVECTOR radius = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(local.sphereRadius));
+
+        XMVECTOR scaleSq = XMVectorMax(
+            XMVectorMax(LengthSqLanes(m[0][0], m[0][1], m[0][2]), LengthSqLanes(m[1][0], m[1][1], m[1][2])),
+            LengthSqLanes(m[2][0], m[2][1], m[2][2]));
+
+        XMMATRIX spheres(
+            TransformCoordLanes(sphereX, sphereY, sphereZ, m, 0),
+            TransformCoordLanes(sphereX, sphereY, sphereZ, m, 1),
+            TransformCoordLanes(sphereX, sphereY, sphereZ, m, 2),
+            XMVectorMultiply(XMVectorSqrt(scaleSq), radius));
+
+        // Back to one entry per register
+        centers = XMMatrixTranspose(centers);
+        extents = XMMatrixTranspose(extents);
+        spheres = XMMatrixTranspose(spheres);
+
+        for (UINT lane = 0; lane < BatchSize; ++lane)
+        {
+            XMStoreFloat3(&m_boxCenters[first + lane], centers.r[lane]);
+            XMStoreFloat3(&m_boxExtents[first + lane], extents.r[lane]);
+            XMStoreFloat4(&m_spheres[first + lane], spheres.r[lane]);
+        }
+    }
+}
+
+UINT WorldBounds::GetCount() const
+{
+    return m_count;
+}
+
+const XMFLOAT4* WorldBounds::GetSpheres() const
+{
+    return m_spheres.data();
+}
+
+const XMFLOAT3* WorldBounds::GetBoxCenters() const
+{
+    return m_boxCenters.data();
+}
+
+const XMFLOAT3* WorldBounds::GetBoxExtents() const
+{
+    return m_boxExtents.data();
+}
+
+BoundingBox WorldBounds::GetBox(UINT idx) const
+{
+    return BoundingBox(m_boxCenters[idx], m_boxExtents[idx]);
+}
+
+BoundingSphere WorldBounds::GetSphere(UINT idx) const
+{
+    const XMFLOAT4& s = m_spheres[idx];
+    return BoundingSphere(XMFLOAT3(s.x, s.y, s.z), s.w);
+}
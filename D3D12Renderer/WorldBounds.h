@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <minwindef.h>
+
+// Dense world space bounds of renderables, refreshed every frame.
+// Local bounds are stored SoA with Add() when the renderable set changes, so a frame only reads world matrices.
+// Update() transforms four entries per iteration, one per SIMD lane.
+// Outputs are kept in separate arrays so each query only touches what it needs.
+class WorldBounds
+{
+public:
+    void Clear();
+    void Reserve(UINT count);
+
+    // worldIdx indexes the world matrix array passed to Update().
+    void Add(const DirectX::BoundingBox& localBox, const DirectX::BoundingSphere& localSphere, UINT worldIdx);
+
+    // Transform all local bounds to world space.
+    void Update(const DirectX::XMFLOAT4X4* pWorlds);
+
+    UINT GetCount() const;
+
+    // (center.xyz, radius)
+    const DirectX::XMFLOAT4* GetSpheres() const;
+    const DirectX::XMFLOAT3* GetBoxCenters() const;
+    const DirectX::XMFLOAT3* GetBoxExtents() const;
+
+    DirectX::BoundingBox GetBox(UINT idx) const;
+    DirectX::BoundingSphere GetSphere(UINT idx) const;
+
+private:
+    static constexpr UINT BatchSize = 4;
+
+    // Local bounds of four entries. Each array is one SIMD register.
+    struct alignas(16) LocalBatch
+    {
+        float boxCenterX[BatchSize];
+        float boxCenterY[BatchSize];
+        float boxCenterZ[BatchSize];
+        float boxExtentX[BatchSize];
+        float boxExtentY[BatchSize];
+        float boxExtentZ[BatchSize];
+        float sphereCenterX[BatchSize];
+        float sphereCenterY[BatchSize];
+        float sphereCenterZ[BatchSize];
+        float sphereRadius[BatchSize];
+    };
+
+    // Input
+    std::vector<LocalBatch> m_localBatches;
+    std::vector<UINT> m_worldIndices; // padded to whole batches
+    UINT m_count = 0;
+
+    // Output, padded to whole batches
+    std::vector<DirectX::XMFLOAT4> m_spheres;
+    std::vector<DirectX::XMFLOAT3> m_boxCenters;
+    std::vector<DirectX::XMFLOAT3> m_boxExtents;
+};
@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <new>
+
+#include "Test.h"
+
+// Global operator new is replaced for the whole test process, so tests can check that code does not allocate.
+// Array and nothrow versions forward to this one by default.
+namespace
+{
+std::size_t g_allocationCount = 0;
+}
+
+std::size_t GetAllocationCount()
+{
+    return g_allocationCount;
+}
+
+void* operator new(std::size_t size)
+{
+    ++g_allocationCount;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
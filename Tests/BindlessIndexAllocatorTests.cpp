@@ -0,0 +1,132 @@
+#include "pch.h"
+
+#include "BindlessIndexAllocator.h"
+#include "Test.h"
+
+namespace
+{
+// Freed index stays with the frame that freed it until the fence of that frame completes.
+void TestReuseAfterFence()
+{
+    BindlessIndexAllocator allocator;
+    allocator.Init(4);
+
+    UINT freedIndex;
+    {
+        BindlessIndex index = allocator.Allocate();
+        freedIndex = index.Get();
+    }
+
+    // Freed, but the frame is not submitted yet.
+    BindlessIndex beforeSubmit = allocator.Allocate();
+    CHECK(beforeSubmit.Get() != freedIndex);
+    allocator.ReleaseStaleIndices(UINT64_MAX);
+
+    allocator.QueueRetiredIndices(1);
+    allocator.ReleaseStaleIndices(0);
+    BindlessIndex beforeFence = allocator.Allocate();
+    CHECK(beforeFence.Get() != freedIndex);
+
+    allocator.ReleaseStaleIndices(1);
+    BindlessIndex afterFence = allocator.Allocate();
+    CHECK(afterFence.Get() == freedIndex);
+}
+
+void TestMoveAssignment()
+{
+    BindlessIndexAllocator allocator;
+    allocator.Init(4);
+
+    BindlessIndex a = allocator.Allocate();
+    BindlessIndex b = allocator.Allocate();
+    const UINT oldIndex = a.Get();
+    const UINT movedIndex = b.Get();
+
+    // Old index of a is freed, and b no longer owns anything.
+    a = std::move(b);
+    CHECK(a.Get() == movedIndex);
+    CHECK(b.IsNull());
+
+    allocator.QueueRetiredIndices(1);
+    allocator.ReleaseStaleIndices(1);
+    CHECK(allocator.GetAllocatedCount() == 1);
+    CHECK(allocator.Allocate().Get() == oldIndex);
+
+    // Moved-from index frees nothing when destroyed.
+    {
+        BindlessIndex c = std::move(a);
+        CHECK(a.IsNull());
+    }
+    allocator.QueueRetiredIndices(2);
+    allocator.ReleaseStaleIndices(2);
+    CHECK(allocator.GetAllocatedCount() == 0);
+}
+
+void TestExhaustion()
+{
+    BindlessIndexAllocator allocator;
+    allocator.Init(2);
+
+    BindlessIndex a = allocator.Allocate();
+    BindlessIndex b = allocator.Allocate();
+
+    bool hasThrown = false;
+    try
+    {
+        allocator.Allocate();
+    }
+    catch (const std::out_of_range&)
+    {
+        hasThrown = true;
+    }
+    CHECK(hasThrown);
+
+    // Still full while the freed index waits for the GPU.
+    b = BindlessIndex();
+    allocator.QueueRetiredIndices(1);
+    hasThrown = false;
+    try
+    {
+        allocator.Allocate();
+    }
+    catch (const std::out_of_range&)
+    {
+        hasThrown = true;
+    }
+    CHECK(hasThrown);
+
+    allocator.ReleaseStaleIndices(1);
+    CHECK(!allocator.Allocate().IsNull());
+}
+
+// Stale indices still count, since shaders of frames in flight may read them.
+void TestAllocatedCount()
+{
+    BindlessIndexAllocator allocator;
+    allocator.Init(8);
+
+    std::vector<BindlessIndex> indices;
+    for (UINT i = 0; i < 3; ++i)
+        indices.push_back(allocator.Allocate());
+    CHECK(allocator.GetAllocatedCount() == 3);
+
+    indices.clear();
+    CHECK(allocator.GetAllocatedCount() == 3);
+
+    allocator.QueueRetiredIndices(5);
+    allocator.ReleaseStaleIndices(4);
+    CHECK(allocator.GetAllocatedCount() == 3);
+
+    allocator.ReleaseStaleIndices(5);
+    CHECK(allocator.GetAllocatedCount() == 0);
+    CHECK(allocator.GetCapacity() == 8);
+}
+}
+
+void RunBindlessIndexAllocatorTests()
+{
+    TestReuseAfterFence();
+    TestMoveAssignment();
+    TestExhaustion();
+    TestAllocatedCount();
+}
@@ -0,0 +1,99 @@
+#include "pch.h"
+
+#include "DescriptorTableCache.h"
+#include "Test.h"
+
+namespace
+{
+// Handles are only compared, never dereferenced, so any values do.
+constexpr D3D12_CPU_DESCRIPTOR_HANDLE Table[] = {{0x1000}, {0x2000}, {0x3000}};
+constexpr UINT32 TableSize = 3;
+constexpr D3D12_GPU_DESCRIPTOR_HANDLE TableGpuHandle = {0x10000};
+
+bool Find(const DescriptorTableCache& cache, const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, D3D12_GPU_DESCRIPTOR_HANDLE& gpuHandle)
+{
+    return cache.Find(pHandles, numHandles, DescriptorTableCache::Hash(pHandles, numHandles), gpuHandle);
+}
+
+void Insert(DescriptorTableCache& cache, const D3D12_CPU_DESCRIPTOR_HANDLE* pHandles, UINT32 numHandles, D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle)
+{
+    cache.Insert(pHandles, numHandles, DescriptorTableCache::Hash(pHandles, numHandles), gpuHandle);
+}
+
+void TestHit()
+{
+    DescriptorTableCache cache;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+    CHECK(!Find(cache, Table, TableSize, gpuHandle));
+
+    Insert(cache, Table, TableSize, TableGpuHandle);
+
+    // Different array with the same handles
+    D3D12_CPU_DESCRIPTOR_HANDLE same[] = {Table[0], Table[1], Table[2]};
+    CHECK(Find(cache, same, TableSize, gpuHandle));
+    CHECK(gpuHandle.ptr == TableGpuHandle.ptr);
+}
+
+void TestMiss()
+{
+    DescriptorTableCache cache;
+    Insert(cache, Table, TableSize, TableGpuHandle);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+    D3D12_CPU_DESCRIPTOR_HANDLE changed[] = {Table[0], Table[1], {0x4000}};
+    CHECK(!Find(cache, changed, TableSize, gpuHandle));
+
+    D3D12_CPU_DESCRIPTOR_HANDLE reordered[] = {Table[1], Table[0], Table[2]};
+    CHECK(!Find(cache, reordered, TableSize, gpuHandle));
+
+    // Prefix of a cached table is a different table
+    CHECK(!Find(cache, Table, TableSize - 1, gpuHandle));
+}
+
+// Same hash forced for different handles. Handles are compared on a hit, so the cached range is not returned.
+void TestHashCollision()
+{
+    DescriptorTableCache cache;
+    const std::size_t hash = DescriptorTableCache::Hash(Table, TableSize);
+    cache.Insert(Table, TableSize, hash, TableGpuHandle);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+    D3D12_CPU_DESCRIPTOR_HANDLE colliding[] = {{0x5000}, {0x6000}, {0x7000}};
+    CHECK(!cache.Find(colliding, TableSize, hash, gpuHandle));
+    CHECK(!cache.Find(Table, TableSize - 1, hash, gpuHandle));
+
+    // Both tables live side by side under the same hash.
+    constexpr D3D12_GPU_DESCRIPTOR_HANDLE collidingGpuHandle = {0x20000};
+    cache.Insert(colliding, TableSize, hash, collidingGpuHandle);
+    CHECK(cache.Find(colliding, TableSize, hash, gpuHandle));
+    CHECK(gpuHandle.ptr == collidingGpuHandle.ptr);
+    CHECK(cache.Find(Table, TableSize, hash, gpuHandle));
+    CHECK(gpuHandle.ptr == TableGpuHandle.ptr);
+}
+
+// DynamicDescriptorHeap clears the cache when it retires the page cached ranges point into.
+void TestClear()
+{
+    DescriptorTableCache cache;
+    Insert(cache, Table, TableSize, TableGpuHandle);
+
+    cache.Clear();
+
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+    CHECK(!Find(cache, Table, TableSize, gpuHandle));
+
+    // Copied again into the new page
+    constexpr D3D12_GPU_DESCRIPTOR_HANDLE newPageGpuHandle = {0x30000};
+    Insert(cache, Table, TableSize, newPageGpuHandle);
+    CHECK(Find(cache, Table, TableSize, gpuHandle));
+    CHECK(gpuHandle.ptr == newPageGpuHandle.ptr);
+}
+}
+
+void RunDescriptorTableCacheTests()
+{
+    TestHit();
+    TestMiss();
+    TestHashCollision();
+    TestClear();
+}
@@ -0,0 +1,166 @@
+#include "pch.h"
+
+#include <limits>
+#include <random>
+#include <tuple>
+
+#include "DrawList.h"
+#include "Test.h"
+
+namespace
+{
+struct KeyFields
+{
+    UINT pass;
+    UINT pso;
+    UINT path;
+    UINT depth;
+    UINT material;
+    UINT mesh;
+
+    UINT64 MakeKey() const
+    {
+        return DrawList::MakeKey(static_cast<PassType>(pass), pso, static_cast<RenderingPath>(path), material, mesh, depth);
+    }
+
+    // Expected priority, from the most significant field
+    auto Tie() const
+    {
+        return std::tie(pass, pso, path, depth, material, mesh);
+    }
+};
+
+// Raising a field by one should outweigh any value of all lower fields.
+void TestFieldPriority()
+{
+    const KeyFields low = {1, 1, 0, 1, 1, 1};
+    const KeyFields lowWithMaxBelow[] = {
+        {1, 255, 1, (1u << 19) - 1, 0xFFFF, 0xFFFF}, // below pass
+        {1, 1, 1, (1u << 19) - 1, 0xFFFF, 0xFFFF},   // below pso
+        {1, 1, 0, (1u << 19) - 1, 0xFFFF, 0xFFFF},   // below path
+        {1, 1, 0, 1, 0xFFFF, 0xFFFF},                // below depth
+        {1, 1, 0, 1, 1, 0xFFFF},                     // below material
+    };
+    const KeyFields raised[] = {
+        {2, 0, 0, 0, 0, 0},
+        {1, 2, 0, 0, 0, 0},
+        {1, 1, 1, 0, 0, 0},
+        {1, 1, 0, 2, 0, 0},
+        {1, 1, 0, 1, 2, 0},
+    };
+
+    for (UINT i = 0; i < 5; ++i)
+        CHECK(lowWithMaxBelow[i].MakeKey() < raised[i].MakeKey());
+
+    CHECK(low.MakeKey() < KeyFields{1, 1, 0, 1, 1, 2}.MakeKey());
+}
+
+void TestQuantizeDepth()
+{
+    CHECK(DrawList::QuantizeDepth(0.0f) == 0);
+    CHECK(DrawList::QuantizeDepth(-0.0f) == 0);
+    CHECK(DrawList::QuantizeDepth(-1.0f) == 0);
+    CHECK(DrawList::QuantizeDepth(std::numeric_limits<float>::quiet_NaN()) == 0);
+    CHECK(DrawList::QuantizeDepth(std::numeric_limits<float>::max()) < (1u << 19));
+
+    // Monotonic, and resolves 1% steps over the whole view range
+    UINT prev = 0;
+    bool monotonic = true;
+    for (float depth = 0.01f; depth < 10000.0f; depth *= 1.01f)
+    {
+        UINT quantized = DrawList::QuantizeDepth(depth);
+        if (quantized <= prev)
+            monotonic = false;
+        prev = quantized;
+    }
+    CHECK(monotonic);
+}
+
+// Sorted order should match a stable comparison sort of field tuples.
+void TestRadixSortOrder(UINT count, UINT seed)
+{
+    std::mt19937 rng(seed);
+    auto random = [&](UINT range) { return static_cast<UINT>(rng() % range); };
+
+    std::vector<KeyFields> fields(count);
+    std::vector<DrawList::SortEntry> entries(count);
+    for (UINT i = 0; i < count; ++i)
+    {
+        // Narrow ranges produce many equal keys, which checks stability.
+        fields[i] = {random(3), random(4), random(2), random(8) * 4096, random(4), random(16)};
+        entries[i] = {fields[i].MakeKey(), i};
+    }
+
+    std::vector<UINT> expected(count);
+    for (UINT i = 0; i < count; ++i)
+        expected[i] = i;
+    std::stable_sort(expected.begin(), expected.end(), [&](UINT a, UINT b) { return fields[a].Tie() < fields[b].Tie(); });
+
+    std::vector<DrawList::SortEntry> scratch;
+    DrawList::RadixSort(entries, scratch);
+
+    CHECK(entries.size() == count);
+
+    bool matched = true;
+    for (UINT i = 0; i < count; ++i)
+    {
+        if (entries[i].index != expected[i])
+            matched = false;
+    }
+    CHECK(matched);
+}
+
+// Digits shared by all keys are skipped. Result should still end up in entries.
+void TestRadixSortSkippedDigits()
+{
+    std::vector<DrawList::SortEntry> scratch;
+
+    // Only the highest digit differs. One scatter pass, so data is in scratch before the final swap.
+    std::vector<DrawList::SortEntry> entries = {{3ull << 56, 0}, {1ull << 56, 1}, {2ull << 56, 2}, {1ull << 56, 3}};
+    DrawList::RadixSort(entries, scratch);
+    CHECK(entries[0].index == 1 && entries[1].index == 3 && entries[2].index == 2 && entries[3].index == 0);
+
+    // All keys equal. Nothing moves.
+    entries = {{42, 0}, {42, 1}, {42, 2}};
+    DrawList::RadixSort(entries, scratch);
+    CHECK(entries[0].index == 0 && entries[1].index == 1 && entries[2].index == 2);
+
+    // Two digits differ. Two scatter passes end in entries.
+    entries = {{0x0201, 0}, {0x0102, 1}, {0x0101, 2}, {0x0202, 3}};
+    DrawList::RadixSort(entries, scratch);
+    CHECK(entries[0].index == 2 && entries[1].index == 1 && entries[2].index == 0 && entries[3].index == 3);
+
+    entries.clear();
+    DrawList::RadixSort(entries, scratch);
+    CHECK(entries.empty());
+}
+
+void TestDrawListPackets()
+{
+    DrawList drawList;
+    for (UINT i = 0; i < 4; ++i)
+    {
+        DrawPacket packet = {};
+        packet.range.offset = i;
+        drawList.Add(KeyFields{0, 3 - i, 0, 0, 0, 0}.MakeKey(), packet);
+    }
+    drawList.Sort();
+
+    CHECK(drawList.GetCount() == 4);
+    for (UINT i = 0; i < 4; ++i)
+        CHECK(drawList.GetPacket(i).range.offset == 3 - i);
+
+    drawList.Clear();
+    CHECK(drawList.GetCount() == 0);
+}
+}
+
+void RunDrawListTests()
+{
+    TestFieldPriority();
+    TestQuantizeDepth();
+    TestRadixSortOrder(1000, 1);
+    TestRadixSortOrder(100000, 2);
+    TestRadixSortSkippedDigits();
+    TestDrawListPackets();
+}
@@ -0,0 +1,874 @@
+#include "pch.h"
+
+#include <random>
+
+#include "RenderGraph.h"
+#include "SharedConfig.h"
+#include "Test.h"
+
+namespace
+{
+// Only full subresource ranges are used, so resources are never dereferenced and fake addresses are enough.
+ID3D12Resource* FakeResource(UINT id)
+{
+    return reinterpret_cast<ID3D12Resource*>(static_cast<UINT_PTR>(0x1000 * (id + 1)));
+}
+
+constexpr TextureResourceUsage RenderTarget = {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET};
+constexpr TextureResourceUsage DepthWrite = {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE};
+constexpr TextureResourceUsage PixelShaderResource = {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE};
+constexpr TextureResourceUsage DepthReadAndShaderResource = {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE | D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ, D3D12_BARRIER_LAYOUT_DIRECT_QUEUE_GENERIC_READ};
+constexpr TextureResourceUsage Present = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_PRESENT};
+
+// Order passes were recorded in before the graph derived it from data flow.
+const std::vector<PassType> DefaultOrder = {
+    PassType::SHADOW_MAP,
+    PassType::GBUFFER,
+    PassType::DEFERRED_LIGHTING,
+    PassType::FORWARD_COLORING,
+    PassType::SELECTION_MASK,
+    PassType::HORIZONTAL_DILATE,
+    PassType::OUTLINE_DRAWING,
+    PassType::TONEMAP,
+};
+
+// Frame graph of Renderer::PrepareRenderGraph, without transient textures.
+// Passes are declared in the given order, and each pass declares its reads, writes and usages in random order.
+// Each pass starts a command list as in the renderer, unless all passes are recorded into one.
+class FrameGraph
+{
+public:
+    FrameGraph(const std::vector<PassType>& declarationOrder, UINT seed, bool isListPerPass = true)
+    {
+        graph.Init(nullptr);
+
+        backBuffer = RegisterTexture("BackBuffer", true, Present);
+        sceneColor = RegisterTexture("SceneColorBuffer0", true, RenderTarget);
+        depth = RegisterTexture("DepthStencilBuffer", false, DepthWrite);
+        gBuffer = RegisterTexture("GBuffer", true, RenderTarget);
+        selectionMask = RegisterTexture("SelectionMask", true, RenderTarget);
+        dilatedMask = RegisterTexture("HorizontalDilatedMask", true, RenderTarget);
+        directionalLight = RegisterLightTexture("DirectionalLight", {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}, MAX_CASCADES);
+        pointLight = RegisterLightTexture("PointLight", {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_RENDER_TARGET}, POINT_LIGHT_ARRAY_SIZE);
+        spotLight = RegisterLightTexture("SpotLight", {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}, SPOT_LIGHT_ARRAY_SIZE);
+
+        hasSelection = graph.RegisterPredicate("HasSelection");
+
+        std::mt19937 rng(seed);
+        for (PassType passType : declarationOrder)
+            DeclarePass(passType, rng);
+
+        for (auto& node : graph.m_nodes)
+            node.SetStartsCommandList(isListPerPass);
+
+        graph.MarkAsOutput(backBuffer);
+        graph.SetFrameEndUsage(backBuffer, Present);
+    }
+
+    RenderGraph graph;
+    RGPredicate hasSelection;
+
+    RGTexture backBuffer;
+    RGTexture sceneColor;
+    RGTexture depth;
+    RGTexture gBuffer;
+    RGTexture selectionMask;
+    RGTexture dilatedMask;
+    RGTexture directionalLight;
+    RGTexture pointLight;
+    RGTexture spotLight;
+
+    // Lights are provided like the renderer's, one fake resource per light.
+    // Bumping the version makes the graph call the providers again.
+    UINT lightCount = 2;
+    UINT64 lightVersion = 0;
+    UINT providerCallCount = 0;
+
+    // Per texture group. Every texture is accessed as a whole.
+    std::vector<TextureDimension> dimensions;
+
+private:
+    RGTexture RegisterTexture(const std::string& name, bool isPerFrame, TextureResourceUsage initialUsage)
+    {
+        RGTexture texture = graph.RegisterTexture(name, isPerFrame, initialUsage, 1);
+        dimensions.push_back({1, 0, 0, 0});
+        std::vector<ID3D12Resource*> pResources;
+        for (UINT i = 0; i < (isPerFrame ? FrameCount : 1); ++i)
+            pResources.push_back(FakeResource(m_resourceCount++));
+        graph.AddElement(texture, pResources);
+        return texture;
+    }
+
+    RGTexture RegisterLightTexture(const std::string& name, TextureResourceUsage initialUsage, UINT subresourceCount)
+    {
+        const UINT firstResource = m_resourceCount;
+        m_resourceCount += 16;
+        dimensions.push_back({subresourceCount, 0, 0, 0});
+
+        return graph.RegisterTexture(
+            name,
+            false,
+            initialUsage,
+            subresourceCount,
+            [this, firstResource]()
+            {
+                ++providerCallCount;
+                std::vector<ID3D12Resource*> pResources;
+                pResources.reserve(lightCount);
+                for (UINT i = 0; i < lightCount; ++i)
+                    pResources.push_back(FakeResource(firstResource + i));
+                return pResources;
+            },
+            [this]()
+            {
+                return lightVersion;
+            });
+    }
+
+    // Versions are written out, so passes can be declared before the ones producing what they read.
+    void DeclarePass(PassType passType, std::mt19937& rng)
+    {
+        auto& node = graph.m_nodes[static_cast<UINT>(passType)];
+        auto v = [](RGTexture texture, UINT version) { return RGTexture{texture.index, version}; };
+
+        std::vector<std::function<void()>> declarations;
+        switch (passType)
+        {
+        case PassType::SHADOW_MAP:
+            declarations = {
+                [&] { node.Write(v(directionalLight, 0)); },
+                [&] { node.Write(v(pointLight, 0)); },
+                [&] { node.Write(v(spotLight, 0)); },
+                [&] { node.AddTextureInput(directionalLight, DepthWrite); },
+                [&] { node.AddTextureInput(pointLight, RenderTarget); },
+                [&] { node.AddTextureInput(spotLight, DepthWrite); },
+            };
+            break;
+        case PassType::GBUFFER:
+            declarations = {
+                [&] { node.Write(v(depth, 0)); },
+                [&] { node.Write(v(gBuffer, 0)); },
+                [&] { node.AddTextureInput(depth, DepthWrite); },
+                [&] { node.AddTextureInput(gBuffer, RenderTarget); },
+            };
+            break;
+        case PassType::DEFERRED_LIGHTING:
+            declarations = {
+                [&] { node.Read(v(depth, 1)); },
+                [&] { node.Read(v(gBuffer, 1)); },
+                [&] { node.Read(v(directionalLight, 1)); },
+                [&] { node.Read(v(pointLight, 1)); },
+                [&] { node.Read(v(spotLight, 1)); },
+                [&] { node.Write(v(sceneColor, 0)); },
+                [&] { node.AddTextureInput(sceneColor, RenderTarget); },
+                [&] { node.AddTextureInput(depth, DepthReadAndShaderResource); },
+                [&] { node.AddTextureInput(gBuffer, PixelShaderResource); },
+                [&] { node.AddTextureInput(directionalLight, PixelShaderResource); },
+                [&] { node.AddTextureInput(pointLight, PixelShaderResource); },
+                [&] { node.AddTextureInput(spotLight, PixelShaderResource); },
+            };
+            break;
+        case PassType::FORWARD_COLORING:
+            declarations = {
+                [&] { node.Read(v(directionalLight, 1)); },
+                [&] { node.Read(v(pointLight, 1)); },
+                [&] { node.Read(v(spotLight, 1)); },
+                [&] { node.Write(v(depth, 1)); },
+                [&] { node.Write(v(sceneColor, 1)); },
+                [&] { node.AddTextureInput(sceneColor, RenderTarget); },
+                [&] { node.AddTextureInput(depth, DepthWrite); },
+                [&] { node.AddTextureInput(directionalLight, PixelShaderResource); },
+                [&] { node.AddTextureInput(pointLight, PixelShaderResource); },
+                [&] { node.AddTextureInput(spotLight, PixelShaderResource); },
+            };
+            break;
+        case PassType::SELECTION_MASK:
+            declarations = {
+                [&] { node.Write(v(selectionMask, 0)); },
+                [&] { node.AddTextureInput(selectionMask, RenderTarget); },
+            };
+            break;
+        case PassType::HORIZONTAL_DILATE:
+            declarations = {
+                [&] { node.Read(v(selectionMask, 1)); },
+                [&] { node.Write(v(dilatedMask, 0)); },
+                [&] { node.AddTextureInput(dilatedMask, RenderTarget); },
+                [&] { node.AddTextureInput(selectionMask, PixelShaderResource); },
+            };
+            break;
+        case PassType::OUTLINE_DRAWING:
+            declarations = {
+                [&] { node.Read(v(selectionMask, 1)); },
+                [&] { node.Read(v(dilatedMask, 1)); },
+                [&] { node.Write(v(sceneColor, 2)); },
+                [&] { node.AddTextureInput(sceneColor, RenderTarget); },
+                [&] { node.AddTextureInput(selectionMask, PixelShaderResource); },
+                [&] { node.AddTextureInput(dilatedMask, PixelShaderResource); },
+                [&] { node.SetCondition(hasSelection); },
+            };
+            break;
+        case PassType::TONEMAP:
+            declarations = {
+                [&] { node.Read(v(sceneColor, 3)); },
+                [&] { node.Write(v(backBuffer, 0)); },
+                [&] { node.AddTextureInput(backBuffer, RenderTarget); },
+                [&] { node.AddTextureInput(sceneColor, PixelShaderResource); },
+            };
+            break;
+        default:
+            break;
+        }
+
+        std::shuffle(declarations.begin(), declarations.end(), rng);
+        for (auto& declare : declarations)
+            declare();
+    }
+
+    UINT m_resourceCount = 0;
+};
+
+// Barriers of a pass in a canonical order, since declaration order may reorder them within the pass.
+std::vector<std::tuple<UINT, UINT, UINT, UINT, UINT, UINT, UINT, UINT, UINT>> SortedBarriers(const std::vector<CompiledTextureBarrier>& barriers)
+{
+    std::vector<std::tuple<UINT, UINT, UINT, UINT, UINT, UINT, UINT, UINT, UINT>> result;
+    for (const auto& b : barriers)
+    {
+        result.emplace_back(
+            b.texture.index,
+            b.before.sync, b.before.access, b.before.layout,
+            b.after.sync, b.after.access, b.after.layout,
+            b.subresourceRange.IndexOrFirstMipLevel,
+            static_cast<UINT>(b.split));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool HasSameBarriers(const RenderGraph& a, const RenderGraph& b)
+{
+    for (UINT pass = 0; pass < static_cast<UINT>(PassType::NUM_PASS_TYPES); ++pass)
+    {
+        if (SortedBarriers(a.GetCompiledTextureBarrier(static_cast<PassType>(pass))) != SortedBarriers(b.GetCompiledTextureBarrier(static_cast<PassType>(pass))))
+            return false;
+    }
+    return true;
+}
+
+bool IsSubsequence(const std::vector<PassType>& order, const std::vector<PassType>& of)
+{
+    auto it = of.begin();
+    for (PassType passType : order)
+    {
+        it = std::find(it, of.end(), passType);
+        if (it == of.end())
+            return false;
+        ++it;
+    }
+    return true;
+}
+
+// Passes each pass reads the output of, from Renderer::PrepareRenderGraph.
+const std::vector<std::pair<PassType, PassType>> Producers = {
+    {PassType::DEFERRED_LIGHTING, PassType::SHADOW_MAP},
+    {PassType::DEFERRED_LIGHTING, PassType::GBUFFER},
+    {PassType::FORWARD_COLORING, PassType::SHADOW_MAP},
+    {PassType::FORWARD_COLORING, PassType::DEFERRED_LIGHTING},
+    {PassType::HORIZONTAL_DILATE, PassType::SELECTION_MASK},
+    {PassType::OUTLINE_DRAWING, PassType::SELECTION_MASK},
+    {PassType::OUTLINE_DRAWING, PassType::HORIZONTAL_DILATE},
+    {PassType::OUTLINE_DRAWING, PassType::FORWARD_COLORING},
+    {PassType::TONEMAP, PassType::OUTLINE_DRAWING},
+};
+
+// Passes culled from the order are not checked.
+bool IsTopologicalOrder(const std::vector<PassType>& order)
+{
+    auto position = [&](PassType passType) { return std::find(order.begin(), order.end(), passType); };
+    for (const auto& [pass, producer] : Producers)
+    {
+        if (position(pass) != order.end() && position(producer) != order.end() && position(producer) > position(pass))
+            return false;
+    }
+    return true;
+}
+
+// Compiled order only depends on data flow, not on the order passes or their usages are declared in.
+void TestDeclarationOrder()
+{
+    FrameGraph reference(DefaultOrder, 0);
+    reference.graph.SetPredicate(reference.hasSelection, true);
+    reference.graph.Compile();
+
+    // Mask passes are interleaved with lighting to put distance between producers and consumers.
+    // Every pass still runs after the ones it reads from, as in the order they used to be recorded in.
+    const auto& order = reference.graph.GetCompiledOrder();
+    CHECK(order.size() == DefaultOrder.size());
+    CHECK(IsTopologicalOrder(order));
+    CHECK(IsSubsequence({PassType::SHADOW_MAP, PassType::GBUFFER, PassType::DEFERRED_LIGHTING, PassType::FORWARD_COLORING, PassType::OUTLINE_DRAWING, PassType::TONEMAP}, order));
+    CHECK(IsSubsequence({PassType::SELECTION_MASK, PassType::HORIZONTAL_DILATE, PassType::OUTLINE_DRAWING}, order));
+
+    // Mask passes only feed outline drawing, so they are culled with it.
+    FrameGraph culledReference(DefaultOrder, 0);
+    culledReference.graph.SetPredicate(culledReference.hasSelection, false);
+    culledReference.graph.Compile();
+
+    const auto& culledOrder = culledReference.graph.GetCompiledOrder();
+    CHECK(culledOrder.size() == 5);
+    CHECK(IsTopologicalOrder(culledOrder));
+    CHECK(std::find(culledOrder.begin(), culledOrder.end(), PassType::SELECTION_MASK) == culledOrder.end());
+    CHECK(std::find(culledOrder.begin(), culledOrder.end(), PassType::OUTLINE_DRAWING) == culledOrder.end());
+
+    std::mt19937 rng(7);
+    for (UINT trial = 0; trial < 20; ++trial)
+    {
+        std::vector<PassType> declarationOrder = DefaultOrder;
+        std::shuffle(declarationOrder.begin(), declarationOrder.end(), rng);
+
+        FrameGraph shuffled(declarationOrder, trial + 1);
+        shuffled.graph.SetPredicate(shuffled.hasSelection, true);
+        shuffled.graph.Compile();
+
+        CHECK(shuffled.graph.GetCompiledOrder() == reference.graph.GetCompiledOrder());
+        CHECK(HasSameBarriers(shuffled.graph, reference.graph));
+
+        shuffled.graph.SetPredicate(shuffled.hasSelection, false);
+        CHECK(shuffled.graph.GetCompiledOrder() == culledReference.graph.GetCompiledOrder());
+        CHECK(HasSameBarriers(shuffled.graph, culledReference.graph));
+    }
+}
+
+// Runs frames the way the renderer does, returning the number of barriers issued.
+std::size_t RunFrames(RenderGraph& graph, UINT frameCount)
+{
+    std::size_t barrierCount = 0;
+    for (UINT frame = 0; frame < frameCount; ++frame)
+    {
+        const UINT frameIndex = frame % FrameCount;
+        graph.PrepareBarriers(frameIndex);
+        barrierCount += graph.GetFrameBeginBarriers().textureBarriers.size();
+        for (PassType passType : graph.GetCompiledOrder())
+            barrierCount += graph.GetPassBarriers(passType, frameIndex).textureBarriers.size();
+    }
+    return barrierCount;
+}
+
+// Once every frame index has been patched, frames only call version providers and reuse barrier arrays.
+void TestSteadyStateAllocation()
+{
+    FrameGraph frameGraph(DefaultOrder, 0);
+    auto& graph = frameGraph.graph;
+    graph.SetPredicate(frameGraph.hasSelection, true);
+    graph.Compile();
+    RunFrames(graph, FrameCount);
+
+    std::size_t allocationCount = GetAllocationCount();
+    const UINT providerCallCount = frameGraph.providerCallCount;
+    CHECK(RunFrames(graph, 100) > 0);
+    CHECK(GetAllocationCount() == allocationCount);
+    CHECK(frameGraph.providerCallCount == providerCallCount);
+
+    // Switching between cached plans bridges texture states without allocating, once both plans have run.
+    graph.SetPredicate(frameGraph.hasSelection, false);
+    RunFrames(graph, FrameCount);
+    graph.SetPredicate(frameGraph.hasSelection, true);
+    RunFrames(graph, FrameCount);
+
+    allocationCount = GetAllocationCount();
+    for (UINT i = 0; i < 50; ++i)
+    {
+        graph.SetPredicate(frameGraph.hasSelection, i % 2 == 0);
+        RunFrames(graph, FrameCount);
+    }
+    CHECK(GetAllocationCount() == allocationCount);
+
+    // Changed version only allocates the lists the providers return. Barriers are patched in place.
+    allocationCount = GetAllocationCount();
+    ++frameGraph.lightVersion;
+    RunFrames(graph, FrameCount);
+    CHECK(frameGraph.providerCallCount == providerCallCount + 3);
+    CHECK(GetAllocationCount() == allocationCount + 3);
+}
+
+// Each predicate combination of a topology gets its own plan, and going back to one reuses it.
+void TestPlanCache()
+{
+    FrameGraph frameGraph(DefaultOrder, 0);
+    auto& graph = frameGraph.graph;
+    graph.SetPredicate(frameGraph.hasSelection, true);
+    graph.Compile();
+    const auto* pSelectedOrder = &graph.GetCompiledOrder();
+    const UINT missCount = graph.GetPlanCacheMissCount();
+    const UINT planCount = graph.GetCachedPlanCount();
+
+    graph.SetPredicate(frameGraph.hasSelection, false);
+    CHECK(graph.GetCompiledOrder().size() == 5);
+    CHECK(graph.GetPlanCacheMissCount() == missCount + 1);
+
+    graph.SetPredicate(frameGraph.hasSelection, true);
+    CHECK(&graph.GetCompiledOrder() == pSelectedOrder);
+    CHECK(graph.GetCompiledOrder().size() == DefaultOrder.size());
+    CHECK(graph.GetPlanCacheMissCount() == missCount + 1);
+    CHECK(graph.GetCachedPlanCount() == planCount + 1);
+
+    // Same topology compiled again hits the plan of the current predicates.
+    const UINT hitCount = graph.GetPlanCacheHitCount();
+    graph.Compile();
+    CHECK(&graph.GetCompiledOrder() == pSelectedOrder);
+    CHECK(graph.GetPlanCacheHitCount() == hitCount + 1);
+    CHECK(graph.GetCachedPlanCount() == planCount + 1);
+}
+
+using PassTextureBarriers = std::array<std::vector<CompiledTextureBarrier>, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)>;
+using PassNodes = std::array<RenderGraphNode, static_cast<std::size_t>(PassType::NUM_PASS_TYPES)>;
+
+// Transition of the texture into render target, issued before given pass.
+void AddSplitBarrier(PassTextureBarriers& barriers, PassType passType, RGTexture texture, BarrierSplit split, D3D12_BARRIER_SUBRESOURCE_RANGE range = {0xffff'ffff, 0, 0, 0, 0, 0})
+{
+    barriers[static_cast<UINT>(passType)].push_back({texture, PixelShaderResource, RenderTarget, range, D3D12_TEXTURE_BARRIER_FLAG_NONE, split});
+}
+
+// Synthetic plans of three passes. Shadow map reads the texture, tone mapping renders to it,
+// and the barrier between them is split around G-buffer.
+void TestSplitScheduleValidation()
+{
+    const std::vector<PassType> order = {PassType::SHADOW_MAP, PassType::GBUFFER, PassType::TONEMAP};
+    const RGTexture texture = {0};
+    const RGTexture other = {1};
+
+    // 2 mips x 2 array slices, then a texture accessed only as a whole.
+    const std::vector<TextureDimension> dimensions = {{4, 2, 2, 1}, {1, 0, 0, 0}};
+    const D3D12_BARRIER_SUBRESOURCE_RANGE firstMip = {0, 1, 0, 2, 0, 1};
+    const D3D12_BARRIER_SUBRESOURCE_RANGE secondMip = {1, 1, 0, 2, 0, 1};
+
+    PassNodes nodes;
+    nodes[static_cast<UINT>(PassType::SHADOW_MAP)].AddTextureInput(texture, PixelShaderResource);
+    nodes[static_cast<UINT>(PassType::GBUFFER)].AddTextureInput(other, RenderTarget);
+    nodes[static_cast<UINT>(PassType::TONEMAP)].AddTextureInput(texture, RenderTarget);
+
+    PassTextureBarriers barriers;
+    AddSplitBarrier(barriers, PassType::GBUFFER, texture, BarrierSplit::BEGIN);
+    AddSplitBarrier(barriers, PassType::TONEMAP, texture, BarrierSplit::END);
+    CHECK(RenderGraph::IsSplitScheduleValid(order, barriers, nodes, dimensions));
+
+    // BEGIN without END, and END without BEGIN
+    PassTextureBarriers unended;
+    AddSplitBarrier(unended, PassType::GBUFFER, texture, BarrierSplit::BEGIN);
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, unended, nodes, dimensions));
+
+    PassTextureBarriers unbegun;
+    AddSplitBarrier(unbegun, PassType::TONEMAP, texture, BarrierSplit::END);
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, unbegun, nodes, dimensions));
+
+    // END of another transition does not close the split.
+    PassTextureBarriers mismatched = barriers;
+    mismatched[static_cast<UINT>(PassType::TONEMAP)].back().after = DepthWrite;
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, mismatched, nodes, dimensions));
+
+    // Pass in between accesses the texture while it is in transition.
+    PassNodes accessedInBetween = nodes;
+    accessedInBetween[static_cast<UINT>(PassType::GBUFFER)].AddTextureOutput(texture, RenderTarget);
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, barriers, accessedInBetween, dimensions));
+
+    // Other subresources of the texture may be accessed in between.
+    PassTextureBarriers partial;
+    AddSplitBarrier(partial, PassType::GBUFFER, texture, BarrierSplit::BEGIN, firstMip);
+    AddSplitBarrier(partial, PassType::TONEMAP, texture, BarrierSplit::END, firstMip);
+
+    PassNodes secondMipInBetween = nodes;
+    secondMipInBetween[static_cast<UINT>(PassType::GBUFFER)].AddTextureInput(texture, PixelShaderResource, secondMip);
+    CHECK(RenderGraph::IsSplitScheduleValid(order, partial, secondMipInBetween, dimensions));
+
+    // Subresource 2 is the first mip of the second array slice.
+    PassNodes overlappingInBetween = nodes;
+    overlappingInBetween[static_cast<UINT>(PassType::GBUFFER)].AddTextureInput(texture, PixelShaderResource, {2, 0, 0, 0, 0, 0});
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, partial, overlappingInBetween, dimensions));
+
+    // END in another command list than its BEGIN. D3D12 does not pair them.
+    PassNodes listAtEnd = nodes;
+    listAtEnd[static_cast<UINT>(PassType::TONEMAP)].SetStartsCommandList(true);
+    CHECK(!RenderGraph::IsSplitScheduleValid(order, barriers, listAtEnd, dimensions));
+
+    // List starting at the BEGIN pass holds both halves.
+    PassNodes listAtBegin = nodes;
+    listAtBegin[static_cast<UINT>(PassType::GBUFFER)].SetStartsCommandList(true);
+    CHECK(RenderGraph::IsSplitScheduleValid(order, barriers, listAtBegin, dimensions));
+
+    auto compile = [](FrameGraph& frameGraph)
+    {
+        frameGraph.graph.SetPredicate(frameGraph.hasSelection, true);
+        frameGraph.graph.Compile();
+
+        PassTextureBarriers compiled;
+        for (UINT pass = 0; pass < static_cast<UINT>(PassType::NUM_PASS_TYPES); ++pass)
+            compiled[pass] = frameGraph.graph.GetCompiledTextureBarrier(static_cast<PassType>(pass));
+        return compiled;
+    };
+
+    // Renderer records every pass into lists of its own, so no pair may cross a pass.
+    FrameGraph listPerPass(DefaultOrder, 0);
+    auto compiled = compile(listPerPass);
+    CHECK(listPerPass.graph.GetSplitBarrierCount() == 0);
+    CHECK(RenderGraph::IsSplitScheduleValid(listPerPass.graph.GetCompiledOrder(), compiled, listPerPass.graph.m_nodes, listPerPass.dimensions));
+
+    // Recorded into one list, the same graph splits barriers.
+    FrameGraph singleList(DefaultOrder, 0, false);
+    compiled = compile(singleList);
+    CHECK(singleList.graph.GetSplitBarrierCount() > 0);
+    CHECK(RenderGraph::IsSplitScheduleValid(singleList.graph.GetCompiledOrder(), compiled, singleList.graph.m_nodes, singleList.dimensions));
+
+    // Lists starting at every other pass. Splits left are the ones within a list.
+    FrameGraph listPerTwoPasses(DefaultOrder, 0, false);
+    const auto& singleListOrder = singleList.graph.GetCompiledOrder();
+    for (UINT position = 0; position < static_cast<UINT>(singleListOrder.size()); position += 2)
+        listPerTwoPasses.graph.m_nodes[static_cast<UINT>(singleListOrder[position])].SetStartsCommandList(true);
+    compiled = compile(listPerTwoPasses);
+    CHECK(listPerTwoPasses.graph.GetSplitBarrierCount() < singleList.graph.GetSplitBarrierCount());
+    CHECK(RenderGraph::IsSplitScheduleValid(listPerTwoPasses.graph.GetCompiledOrder(), compiled, listPerTwoPasses.graph.m_nodes, listPerTwoPasses.dimensions));
+}
+
+// Union of the subresources of ranges
+std::vector<bool> MaskOf(const std::vector<D3D12_BARRIER_SUBRESOURCE_RANGE>& ranges, const TextureDimension& dimension)
+{
+    std::vector<bool> mask(dimension.subresourceCount);
+    for (const auto& range : ranges)
+    {
+        auto rangeMask = RenderGraph::GetSubresourceMask(range, dimension);
+        for (UINT i = 0; i < dimension.subresourceCount; ++i)
+            mask[i] = mask[i] || rangeMask[i];
+    }
+    return mask;
+}
+
+// Merged ranges cover the mask exactly, each subresource once.
+bool IsExactCover(const std::vector<D3D12_BARRIER_SUBRESOURCE_RANGE>& ranges, const std::vector<bool>& mask, const TextureDimension& dimension)
+{
+    std::vector<UINT> coverCounts(dimension.subresourceCount);
+    for (const auto& range : ranges)
+    {
+        auto rangeMask = RenderGraph::GetSubresourceMask(range, dimension);
+        for (UINT i = 0; i < dimension.subresourceCount; ++i)
+            coverCounts[i] += rangeMask[i];
+    }
+
+    for (UINT i = 0; i < dimension.subresourceCount; ++i)
+    {
+        if (coverCounts[i] != (mask[i] ? 1u : 0u))
+            return false;
+    }
+    return true;
+}
+
+bool IsSameRange(const D3D12_BARRIER_SUBRESOURCE_RANGE& a, const D3D12_BARRIER_SUBRESOURCE_RANGE& b)
+{
+    return a.IndexOrFirstMipLevel == b.IndexOrFirstMipLevel && a.NumMipLevels == b.NumMipLevels && a.FirstArraySlice == b.FirstArraySlice &&
+        a.NumArraySlices == b.NumArraySlices && a.FirstPlane == b.FirstPlane && a.NumPlanes == b.NumPlanes;
+}
+
+void TestMergeSubresourceRanges()
+{
+    // Cube map with a mip chain
+    const TextureDimension cube = {5 * 6, 5, 6, 1};
+
+    // Full mask becomes the all-subresources range.
+    std::vector<bool> mask(cube.subresourceCount, true);
+    auto ranges = RenderGraph::MergeSubresourceRanges(mask, cube.mipLevels, cube.arraySize, cube.planeCount);
+    CHECK(ranges.size() == 1);
+    CHECK(IsSameRange(ranges[0], {0xffff'ffff, 0, 0, 0, 0, 0}));
+
+    // One face across all mips
+    const D3D12_BARRIER_SUBRESOURCE_RANGE face = {0, 5, 2, 1, 0, 1};
+    mask = MaskOf({face}, cube);
+    ranges = RenderGraph::MergeSubresourceRanges(mask, cube.mipLevels, cube.arraySize, cube.planeCount);
+    CHECK(ranges.size() == 1);
+    CHECK(IsSameRange(ranges[0], face));
+
+    // One mip across all faces, and the mips below it
+    for (const D3D12_BARRIER_SUBRESOURCE_RANGE& box : {D3D12_BARRIER_SUBRESOURCE_RANGE{3, 1, 0, 6, 0, 1}, D3D12_BARRIER_SUBRESOURCE_RANGE{1, 4, 0, 6, 0, 1}})
+    {
+        mask = MaskOf({box}, cube);
+        ranges = RenderGraph::MergeSubresourceRanges(mask, cube.mipLevels, cube.arraySize, cube.planeCount);
+        CHECK(ranges.size() == 1);
+        CHECK(IsSameRange(ranges[0], box));
+    }
+
+    // Checkerboard has no two neighbors to merge, so every subresource is a range of its own.
+    mask.assign(cube.subresourceCount, false);
+    UINT setCount = 0;
+    for (UINT array = 0; array < cube.arraySize; ++array)
+    {
+        for (UINT mip = 0; mip < cube.mipLevels; ++mip)
+        {
+            if ((mip + array) % 2 == 0)
+            {
+                mask[D3DHelper::CalcSubresourceIndex(mip, array, 0, cube.mipLevels, cube.arraySize)] = true;
+                ++setCount;
+            }
+        }
+    }
+    ranges = RenderGraph::MergeSubresourceRanges(mask, cube.mipLevels, cube.arraySize, cube.planeCount);
+    CHECK(ranges.size() == setCount);
+    CHECK(IsExactCover(ranges, mask, cube));
+
+    // Two planes, as depth and stencil
+    const TextureDimension planar = {3 * 4 * 2, 3, 4, 2};
+
+    // Box across both planes
+    const D3D12_BARRIER_SUBRESOURCE_RANGE bothPlanes = {1, 2, 1, 2, 0, 2};
+    mask = MaskOf({bothPlanes}, planar);
+    ranges = RenderGraph::MergeSubresourceRanges(mask, planar.mipLevels, planar.arraySize, planar.planeCount);
+    CHECK(ranges.size() == 1);
+    CHECK(IsSameRange(ranges[0], bothPlanes));
+
+    // Whole second plane, and a box of the first plane that does not line up with it. Greedy extends the box into the
+    // second plane, which leaves the rest of that plane as two more boxes.
+    const D3D12_BARRIER_SUBRESOURCE_RANGE secondPlane = {0, 3, 0, 4, 1, 1};
+    const D3D12_BARRIER_SUBRESOURCE_RANGE firstPlaneBox = {0, 2, 0, 3, 0, 1};
+    mask = MaskOf({secondPlane, firstPlaneBox}, planar);
+    ranges = RenderGraph::MergeSubresourceRanges(mask, planar.mipLevels, planar.arraySize, planar.planeCount);
+    CHECK(ranges.size() == 3);
+    CHECK(IsSameRange(ranges[0], {0, 2, 0, 3, 0, 2}));
+    CHECK(IsExactCover(ranges, mask, planar));
+
+    // Boxes that only touch at a corner stay apart.
+    mask = MaskOf({{0, 1, 0, 1, 0, 1}, {1, 2, 1, 3, 0, 2}}, planar);
+    ranges = RenderGraph::MergeSubresourceRanges(mask, planar.mipLevels, planar.arraySize, planar.planeCount);
+    CHECK(ranges.size() == 2);
+    CHECK(IsExactCover(ranges, mask, planar));
+
+    // Empty mask needs no barrier.
+    mask.assign(planar.subresourceCount, false);
+    CHECK(RenderGraph::MergeSubresourceRanges(mask, planar.mipLevels, planar.arraySize, planar.planeCount).empty());
+}
+
+// Lifetimes are positions in the order. Requests of one size, as aliasing is decided by lifetimes.
+void TestTransientMemoryPlan()
+{
+    constexpr UINT64 Size = 0x10000;
+    constexpr UINT64 Alignment = 0x10000;
+
+    // Disjoint lifetimes share memory. The later one is placed after the earlier one.
+    TransientMemoryPlan plan = RenderGraph::PlanTransientMemory({{Size, Alignment, 0, 1}, {Size, Alignment, 2, 3}});
+    CHECK(plan.offsets[0] == plan.offsets[1]);
+    CHECK(plan.previousRequests[0] == UINT_MAX);
+    CHECK(plan.previousRequests[1] == 0);
+    CHECK(plan.isAliased == std::vector<bool>({true, true}));
+    CHECK(plan.heapSize == Size);
+    CHECK(plan.summedSize == 2 * Size);
+
+    // Overlapping lifetimes do not. One ending at the pass the other begins at overlaps it too.
+    for (UINT firstPass : {1u, 2u})
+    {
+        plan = RenderGraph::PlanTransientMemory({{Size, Alignment, 0, 2}, {Size, Alignment, firstPass, 3}});
+        CHECK(plan.offsets[0] != plan.offsets[1]);
+        CHECK(plan.previousRequests == std::vector<UINT>({UINT_MAX, UINT_MAX}));
+        CHECK(plan.isAliased == std::vector<bool>({false, false}));
+        CHECK(plan.heapSize == 2 * Size);
+    }
+
+    // Chain of three in one bucket, and one alongside them for their whole lifetime
+    plan = RenderGraph::PlanTransientMemory({{Size, Alignment, 0, 0}, {Size, Alignment, 0, 5}, {Size, Alignment, 1, 2}, {Size, Alignment, 3, 5}});
+    CHECK(plan.offsets[0] == plan.offsets[2] && plan.offsets[2] == plan.offsets[3]);
+    CHECK(plan.offsets[1] != plan.offsets[0]);
+    CHECK(plan.previousRequests == std::vector<UINT>({UINT_MAX, UINT_MAX, 0, 2}));
+    CHECK(plan.isAliased == std::vector<bool>({true, false, true, true}));
+    CHECK(plan.heapSize == 2 * Size);
+
+    // Bucket grows to its largest occupant, and the next bucket starts aligned after it.
+    plan = RenderGraph::PlanTransientMemory({{Size, Alignment, 0, 0}, {3 * Size, Alignment, 1, 1}, {Size / 2, Alignment / 2, 0, 1}});
+    CHECK(plan.offsets[0] == plan.offsets[1]);
+    CHECK(plan.offsets[2] % (Alignment / 2) == 0);
+    CHECK(plan.heapSize == 3 * Size + Size / 2);
+
+    // Never used requests get no bucket. They only need the heap to be large enough to be placed in.
+    plan = RenderGraph::PlanTransientMemory({{Size, Alignment, 0, 0}, {4 * Size, Alignment, UINT_MAX, 0}, {Size / 2, Alignment, UINT_MAX, 0}});
+    CHECK(plan.offsets == std::vector<UINT64>({0, 0, 0}));
+    CHECK(plan.previousRequests == std::vector<UINT>({UINT_MAX, UINT_MAX, UINT_MAX}));
+    CHECK(plan.isAliased == std::vector<bool>({false, false, false}));
+    CHECK(plan.heapSize == 4 * Size);
+    CHECK(plan.summedSize == 5 * Size + Alignment);
+}
+
+// Transient textures of Renderer::PrepareRenderGraph at 1920x1080, with lifetimes from the compiled order.
+void TestRendererTransientMemory()
+{
+    FrameGraph frameGraph(DefaultOrder, 0);
+    frameGraph.graph.SetPredicate(frameGraph.hasSelection, true);
+    frameGraph.graph.Compile();
+
+    const auto& order = frameGraph.graph.GetCompiledOrder();
+    auto position = [&](PassType passType) { return static_cast<UINT>(std::find(order.begin(), order.end(), passType) - order.begin()); };
+
+    constexpr UINT64 Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    auto size = [](UINT64 bytesPerPixel) { return static_cast<UINT64>(Utility::Align(1920 * 1080 * bytesPerPixel, Alignment)); };
+
+    const UINT gBufferBegin = position(PassType::GBUFFER);
+    const UINT gBufferEnd = position(PassType::DEFERRED_LIGHTING);
+    const std::vector<TransientAllocationRequest> requests = {
+        {size(4), Alignment, position(PassType::DEFERRED_LIGHTING), position(PassType::TONEMAP)},          // SceneColorBuffer0
+        {size(4), Alignment, UINT_MAX, 0},                                                                 // SceneColorBuffer1, not read or written by any pass
+        {size(4), Alignment, gBufferBegin, gBufferEnd},                                                    // Albedo
+        {size(8), Alignment, gBufferBegin, gBufferEnd},                                                    // Normal
+        {size(4), Alignment, gBufferBegin, gBufferEnd},                                                    // Material ambient
+        {size(4), Alignment, gBufferBegin, gBufferEnd},                                                    // Material specular
+        {size(1), Alignment, position(PassType::SELECTION_MASK), position(PassType::OUTLINE_DRAWING)},     // SelectionMask
+        {size(1), Alignment, position(PassType::HORIZONTAL_DILATE), position(PassType::OUTLINE_DRAWING)},  // HorizontalDilatedMask
+    };
+
+    TransientMemoryPlan plan = RenderGraph::PlanTransientMemory(requests);
+
+    UINT64 usedSummedSize = 0;
+    for (const auto& request : requests)
+    {
+        if (request.firstPass != UINT_MAX)
+            usedSummedSize += request.size;
+    }
+
+    // G-buffer dies at lighting, before the scene color is tonemapped, so later textures reuse its memory.
+    CHECK(plan.heapSize < plan.summedSize);
+    CHECK(plan.heapSize < usedSummedSize);
+    CHECK(std::find(plan.isAliased.begin(), plan.isAliased.end(), true) != plan.isAliased.end());
+
+    // Textures alive at the same time never share memory.
+    for (UINT a = 0; a < static_cast<UINT>(requests.size()); ++a)
+    {
+        for (UINT b = a + 1; b < static_cast<UINT>(requests.size()); ++b)
+        {
+            if (requests[a].firstPass == UINT_MAX || requests[b].firstPass == UINT_MAX)
+                continue;
+
+            bool isOverlappingLifetime = requests[a].firstPass <= requests[b].lastPass && requests[b].firstPass <= requests[a].lastPass;
+            bool isOverlappingMemory = plan.offsets[a] < plan.offsets[b] + requests[b].size && plan.offsets[b] < plan.offsets[a] + requests[a].size;
+            CHECK(!(isOverlappingLifetime && isOverlappingMemory));
+        }
+        CHECK(plan.offsets[a] + requests[a].size <= plan.heapSize);
+    }
+}
+
+// Synthetic orders of direct (D) and compute (C) passes.
+void TestQueueSync()
+{
+    constexpr QueueType D = QueueType::DIRECT;
+    constexpr QueueType C = QueueType::COMPUTE;
+
+    // Direct only. Nothing to wait for.
+    QueueSyncPlan plan = RenderGraph::PlanQueueSync({D, D, D}, {{}, {0}, {1}});
+    CHECK(plan.syncPointCount == 0);
+    CHECK(plan.coveredDependencyCount == 0);
+    CHECK(plan.frameEndWaits.empty());
+    CHECK(plan.signals == std::vector<bool>({false, false, false}));
+
+    // Two dependencies on the compute queue collapse to a wait for the latest one.
+    plan = RenderGraph::PlanQueueSync({C, C, D}, {{}, {}, {0, 1}});
+    CHECK(plan.waits[2] == std::vector<UINT>({1}));
+    CHECK(plan.signals == std::vector<bool>({false, true, false}));
+    CHECK(plan.frameEndWaits.empty());
+    CHECK(plan.syncPointCount == 1);
+    CHECK(plan.coveredDependencyCount == 1);
+
+    // Position 3 depends on 0, already covered by the wait of position 2 for 1, later on the same compute queue.
+    plan = RenderGraph::PlanQueueSync({C, C, D, D}, {{}, {0}, {1}, {0}});
+    CHECK(plan.waits[2] == std::vector<UINT>({1}));
+    CHECK(plan.waits[3].empty());
+    CHECK(plan.syncPointCount == 1);
+    CHECK(plan.coveredDependencyCount == 1);
+
+    // Dependency of position 3 on 0 is covered by the compute queue waiting for 1, as the direct queue runs in order.
+    // Its wait for 3 covers 2 too.
+    plan = RenderGraph::PlanQueueSync({D, D, C, C, D}, {{}, {0}, {1}, {0}, {2, 3}});
+    CHECK(plan.waits[2] == std::vector<UINT>({1}));
+    CHECK(plan.waits[3].empty());
+    CHECK(plan.waits[4] == std::vector<UINT>({3}));
+    CHECK(plan.signals == std::vector<bool>({false, true, false, true, false}));
+    CHECK(plan.frameEndWaits.empty());
+    CHECK(plan.syncPointCount == 2);
+    CHECK(plan.coveredDependencyCount == 2);
+
+    // Compute passes no direct pass waits for are joined at frame end, only the latest one.
+    plan = RenderGraph::PlanQueueSync({D, C, C, D}, {{}, {0}, {}, {1}});
+    CHECK(plan.waits[1] == std::vector<UINT>({0}));
+    CHECK(plan.waits[3] == std::vector<UINT>({1}));
+    CHECK(plan.frameEndWaits == std::vector<UINT>({2}));
+    CHECK(plan.signals == std::vector<bool>({true, true, true, false}));
+    CHECK(plan.syncPointCount == 3);
+    CHECK(plan.coveredDependencyCount == 0);
+
+    // Compute pass that is last in the order is joined at frame end even when nothing depends on it.
+    plan = RenderGraph::PlanQueueSync({D, C}, {{}, {}});
+    CHECK(plan.waits[1].empty());
+    CHECK(plan.frameEndWaits == std::vector<UINT>({1}));
+    CHECK(plan.syncPointCount == 1);
+}
+
+// Horizontal dilate moved to the compute queue. Mask textures are released to the common layout around it.
+void TestComputeQueueBarriers()
+{
+    FrameGraph frameGraph(DefaultOrder, 0);
+    auto& graph = frameGraph.graph;
+    graph.m_nodes[static_cast<UINT>(PassType::HORIZONTAL_DILATE)].SetQueue(QueueType::COMPUTE);
+    graph.SetPredicate(frameGraph.hasSelection, true);
+    graph.Compile();
+
+    const auto& order = graph.GetCompiledOrder();
+    auto position = [&](PassType passType) { return static_cast<UINT>(std::find(order.begin(), order.end(), passType) - order.begin()); };
+    const UINT maskPosition = position(PassType::SELECTION_MASK);
+    const UINT dilatePosition = position(PassType::HORIZONTAL_DILATE);
+    const UINT outlinePosition = position(PassType::OUTLINE_DRAWING);
+
+    auto contains = [](const std::vector<UINT>& positions, UINT value) { return std::find(positions.begin(), positions.end(), value) != positions.end(); };
+    const auto& dependencies = graph.GetCompiledDependencies();
+    CHECK(contains(dependencies[dilatePosition], maskPosition));
+    CHECK(contains(dependencies[outlinePosition], dilatePosition));
+
+    constexpr TextureResourceUsage Released = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_COMMON};
+    auto hasRelease = [&](PassType passType, RGTexture texture, const TextureResourceUsage& before)
+    {
+        const auto& barriers = graph.GetCompiledReleaseTextureBarriers(passType);
+        return std::any_of(
+            barriers.begin(),
+            barriers.end(),
+            [&](const CompiledTextureBarrier& barrier)
+            {
+                return barrier.texture.index == texture.index && barrier.before == before && barrier.after == Released && barrier.split == BarrierSplit::IMMEDIATE;
+            });
+    };
+
+    // Selection mask goes to compute after it is drawn, and both masks come back for outline drawing.
+    CHECK(graph.GetCompiledReleaseTextureBarriers(PassType::SELECTION_MASK).size() == 1);
+    CHECK(hasRelease(PassType::SELECTION_MASK, frameGraph.selectionMask, RenderTarget));
+    CHECK(graph.GetCompiledReleaseTextureBarriers(PassType::HORIZONTAL_DILATE).size() == 2);
+    CHECK(hasRelease(PassType::HORIZONTAL_DILATE, frameGraph.selectionMask, PixelShaderResource));
+    CHECK(hasRelease(PassType::HORIZONTAL_DILATE, frameGraph.dilatedMask, RenderTarget));
+
+    // Dilated mask is first used on compute, so it is left released at frame end for the next frame.
+    CHECK(graph.GetCompiledReleaseTextureBarriers(PassType::OUTLINE_DRAWING).size() == 1);
+    CHECK(hasRelease(PassType::OUTLINE_DRAWING, frameGraph.dilatedMask, PixelShaderResource));
+
+    // Passes on one queue release nothing.
+    for (PassType passType : {PassType::SHADOW_MAP, PassType::GBUFFER, PassType::DEFERRED_LIGHTING, PassType::FORWARD_COLORING, PassType::TONEMAP})
+        CHECK(graph.GetCompiledReleaseTextureBarriers(passType).empty());
+
+    // Compute pass transitions from the common layout, with nothing to wait for on its own queue.
+    for (const auto& barrier : graph.GetCompiledTextureBarrier(PassType::HORIZONTAL_DILATE))
+        CHECK(barrier.before == Released);
+
+    // Compute waits for the mask, and outline drawing waits for the dilate, which also joins compute for frame end.
+    const auto& sync = graph.GetQueueSyncPlan();
+    CHECK(sync.waits[dilatePosition] == std::vector<UINT>({maskPosition}));
+    CHECK(sync.waits[outlinePosition] == std::vector<UINT>({dilatePosition}));
+    CHECK(sync.frameEndWaits.empty());
+    CHECK(sync.syncPointCount == 2);
+}
+}
+
+void RunRenderGraphTests()
+{
+    TestDeclarationOrder();
+    TestSteadyStateAllocation();
+    TestPlanCache();
+    TestSplitScheduleValidation();
+    TestMergeSubresourceRanges();
+    TestTransientMemoryPlan();
+    TestRendererTransientMemory();
+    TestQueueSync();
+    TestComputeQueueBarriers();
+}
@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include "RingBufferAllocator.h"
+#include "Test.h"
+
+namespace
+{
+constexpr UINT64 Capacity = 256;
+
+// Allocation that does not fit before the end skips the rest of the ring, which is freed with the frame that skipped it.
+void TestWrap()
+{
+    RingBufferAllocator ring;
+    ring.Init(Capacity);
+
+    CHECK(ring.Allocate(200, 1) == 0);
+    ring.QueueRetiredAllocations(1);
+    CHECK(ring.Allocate(40, 1) == 200);
+    ring.QueueRetiredAllocations(2);
+    ring.ReleaseStaleAllocations(1);
+    CHECK(ring.GetUsedSize() == 40);
+
+    // 16 bytes left before the end
+    CHECK(ring.Allocate(32, 1) == 0);
+    CHECK(ring.GetWrapCount() == 1);
+    CHECK(ring.GetUsedSize() == 40 + 16 + 32);
+    ring.QueueRetiredAllocations(3);
+
+    ring.ReleaseStaleAllocations(2);
+    CHECK(ring.GetUsedSize() == 16 + 32);
+
+    ring.ReleaseStaleAllocations(3);
+    CHECK(ring.GetUsedSize() == 0);
+}
+
+void TestFull()
+{
+    RingBufferAllocator ring;
+    ring.Init(Capacity);
+
+    CHECK(ring.Allocate(128, 1) == 0);
+    ring.QueueRetiredAllocations(1);
+    CHECK(ring.Allocate(128, 1) == 128);
+    CHECK(ring.GetUsedSize() == Capacity);
+    CHECK(ring.Allocate(1, 1) == RingBufferAllocator::InvalidOffset);
+    ring.QueueRetiredAllocations(2);
+
+    // Free space is [0, 128) once the first frame is released. Wrapping needs room before the head.
+    ring.ReleaseStaleAllocations(1);
+    CHECK(ring.Allocate(129, 1) == RingBufferAllocator::InvalidOffset);
+    CHECK(ring.Allocate(32, 1) == 0);
+
+    // Free space is [32, 128). Alignment padding counts against it.
+    CHECK(ring.Allocate(80, 64) == RingBufferAllocator::InvalidOffset);
+    CHECK(ring.Allocate(32, 32) == 32);
+    CHECK(ring.Allocate(64, 1) == 64);
+    CHECK(ring.GetUsedSize() == Capacity);
+    CHECK(ring.Allocate(1, 1) == RingBufferAllocator::InvalidOffset);
+}
+
+// Head only moves past a frame once its fence completes, in the order frames were retired.
+void TestFenceOrder()
+{
+    RingBufferAllocator ring;
+    ring.Init(Capacity);
+
+    CHECK(!ring.HasStaleAllocations());
+    ring.Allocate(64, 1);
+    ring.QueueRetiredAllocations(1);
+    ring.Allocate(64, 1);
+    ring.QueueRetiredAllocations(2);
+
+    // Frame without allocations adds nothing to wait for.
+    ring.QueueRetiredAllocations(3);
+
+    CHECK(ring.HasStaleAllocations());
+    CHECK(ring.GetOldestFenceValue() == 1);
+
+    ring.ReleaseStaleAllocations(0);
+    CHECK(ring.GetUsedSize() == 128);
+
+    ring.ReleaseStaleAllocations(1);
+    CHECK(ring.GetUsedSize() == 64);
+    CHECK(ring.GetOldestFenceValue() == 2);
+
+    // Head is at 64. Of the 192 free bytes, only the 128 at the end are contiguous.
+    CHECK(ring.Allocate(160, 1) == RingBufferAllocator::InvalidOffset);
+    CHECK(ring.Allocate(128, 1) == 128);
+    ring.QueueRetiredAllocations(4);
+
+    ring.ReleaseStaleAllocations(3);
+    CHECK(ring.GetUsedSize() == 128);
+    CHECK(ring.GetOldestFenceValue() == 4);
+
+    ring.ReleaseStaleAllocations(4);
+    CHECK(!ring.HasStaleAllocations());
+}
+
+// Once nothing is in use, allocation starts from the front again instead of wrapping.
+void TestResetWhenEmpty()
+{
+    RingBufferAllocator ring;
+    ring.Init(Capacity);
+
+    ring.Allocate(200, 1);
+    ring.QueueRetiredAllocations(1);
+    ring.ReleaseStaleAllocations(1);
+    CHECK(ring.GetUsedSize() == 0);
+
+    CHECK(ring.Allocate(200, 1) == 0);
+    CHECK(ring.GetWrapCount() == 0);
+}
+
+void TestHighWaterMark()
+{
+    RingBufferAllocator ring;
+    ring.Init(Capacity);
+
+    ring.Allocate(100, 1);
+    ring.Allocate(20, 1);
+    ring.QueueRetiredAllocations(1);
+    CHECK(ring.GetHighWaterMark() == 120);
+
+    ring.ReleaseStaleAllocations(1);
+    CHECK(ring.GetHighWaterMark() == 120);
+
+    // Reset to what is still in use, which is nothing here.
+    ring.ResetHighWaterMark();
+    CHECK(ring.GetHighWaterMark() == 0);
+
+    ring.Allocate(10, 1);
+    ring.QueueRetiredAllocations(2);
+    ring.Allocate(30, 1);
+    CHECK(ring.GetHighWaterMark() == 40);
+
+    ring.ReleaseStaleAllocations(2);
+    ring.ResetHighWaterMark();
+    CHECK(ring.GetHighWaterMark() == 30);
+}
+}
+
+void RunRingBufferAllocatorTests()
+{
+    TestWrap();
+    TestFull();
+    TestFenceOrder();
+    TestResetWhenEmpty();
+    TestHighWaterMark();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// Failed checks are reported and counted, and the test keeps running.
+#define CHECK(...) CheckResult((__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+bool CheckResult(bool passed, const char* expression, const char* file, int line);
+
+// Heap allocations made by the process so far. Take the difference around code that should not allocate.
+std::size_t GetAllocationCount();
+
+// Test groups. Each one runs all of its cases.
+void RunBindlessIndexAllocatorTests();
+void RunDescriptorTableCacheTests();
+void RunDrawListTests();
+void RunRenderGraphTests();
+void RunRingBufferAllocatorTests();
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Test.h"
+
+namespace
+{
+struct TestEntry
+{
+    const char* name;
+    void (*run)();
+};
+
+constexpr TestEntry Tests[] = {
+    {"bindlessindexallocator", RunBindlessIndexAllocatorTests},
+    {"descriptortablecache", RunDescriptorTableCacheTests},
+    {"drawlist", RunDrawListTests},
+    {"rendergraph", RunRenderGraphTests},
+    {"ringbufferallocator", RunRingBufferAllocatorTests},
+};
+
+int g_failedCount = 0;
+}
+
+bool CheckResult(bool passed, const char* expression, const char* file, int line)
+{
+    if (!passed)
+    {
+        std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+        ++g_failedCount;
+    }
+    return passed;
+}
+
+// Runs every test group, or only the ones named in arguments.
+// Exit code is the number of failed checks.
+int main(int argc, char* argv[])
+{
+    for (const auto& test : Tests)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], test.name) == 0)
+                selected = true;
+        }
+
+        if (!selected)
+            continue;
+
+        const int failedBefore = g_failedCount;
+        test.run();
+        std::printf("[%s] %s\n", test.name, g_failedCount == failedBefore ? "passed" : "FAILED");
+    }
+
+    if (g_failedCount > 0)
+        std::printf("%d checks failed\n", g_failedCount);
+
+    return g_failedCount;
+}